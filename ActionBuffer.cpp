@@ -0,0 +1,255 @@
+#include "ActionBuffer.h"
+#include "BasicSc2Bot.h"
+
+ActionBuffer::ActionBuffer(BasicSc2Bot* agent_) {
+	agent = agent_;
+	num_issued = 0;
+	num_sent = 0;
+	last_step_issued = 0;
+	last_step_sent = 0;
+}
+
+bool ActionBuffer::replacesOrders(sc2::AbilityID ability_) {
+	// orders that replace whatever the unit was told to do before, unless queued
+	switch (ability_.ToType()) {
+	case sc2::ABILITY_ID::GENERAL_MOVE:
+	case sc2::ABILITY_ID::MOVE:
+	case sc2::ABILITY_ID::ATTACK:
+	case sc2::ABILITY_ID::ATTACK_ATTACK:
+	case sc2::ABILITY_ID::STOP:
+	case sc2::ABILITY_ID::STOP_STOP:
+	case sc2::ABILITY_ID::HOLDPOSITION:
+	case sc2::ABILITY_ID::PATROL:
+	case sc2::ABILITY_ID::SMART:
+	case sc2::ABILITY_ID::HARVEST_GATHER:
+	case sc2::ABILITY_ID::HARVEST_RETURN:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool ActionBuffer::isStructure(const sc2::Unit* unit_) {
+	auto it = structure_types.find((int)unit_->unit_type);
+	if (it != structure_types.end())
+		return it->second;
+	bool is_structure = false;
+	for (auto a : agent->getObservation()->GetUnitTypeData()[unit_->unit_type].attributes) {
+		if (a == sc2::Attribute::Structure) {
+			is_structure = true;
+		}
+	}
+	structure_types[(int)unit_->unit_type] = is_structure;
+	return is_structure;
+}
+
+bool ActionBuffer::sameCommand(const BufferedCommand& a, const BufferedCommand& b) {
+	if (a.ability != b.ability || a.target_kind != b.target_kind || a.queued != b.queued)
+		return false;
+	if (a.target_kind == TARGET::POINT)
+		return a.point.x == b.point.x && a.point.y == b.point.y;
+	if (a.target_kind == TARGET::UNIT)
+		return a.target == b.target;
+	return true;
+}
+
+void ActionBuffer::add(const sc2::Unit* unit_, sc2::AbilityID ability_, TARGET target_kind_, sc2::Point2D point_, const sc2::Unit* target_, bool queued_) {
+	if (!unit_)
+		return;
+	num_issued++;
+	command_tags.push_back(unit_->tag);
+
+	BufferedCommand command;
+	command.unit = unit_;
+	command.ability = ability_;
+	command.target_kind = target_kind_;
+	command.point = point_;
+	command.target = target_;
+	command.queued = queued_;
+	command.dropped = false;
+
+	if (isStructure(unit_)) {
+		commands.push_back(command);
+		return;
+	}
+
+	std::vector<int>& previous = unit_commands[unit_->tag];
+	for (auto it = previous.rbegin(); it != previous.rend(); ++it) {
+		// repeat of the unit's last command
+		if (!commands[*it].dropped) {
+			if (sameCommand(commands[*it], command))
+				return;
+			break;
+		}
+	}
+	if (!queued_ && replacesOrders(ability_)) {
+		for (auto i : previous) {
+			if (replacesOrders(commands[i].ability)) {
+				commands[i].dropped = true;
+			}
+		}
+	}
+	previous.push_back(commands.size());
+	commands.push_back(command);
+}
+
+void ActionBuffer::flush(sc2::ActionInterface* out_) {
+	// send this step's commands to out_, merging units left with the same single command
+	last_step_issued = command_tags.size();
+	last_step_sent = 0;
+
+	std::vector<bool> mergeable(commands.size(), false);
+	for (auto& uc : unit_commands) {
+		int live = -1;
+		int num_live = 0;
+		for (auto i : uc.second) {
+			if (!commands[i].dropped) {
+				live = i;
+				num_live++;
+			}
+		}
+		if (num_live == 1) {
+			mergeable[live] = true;
+		}
+	}
+
+	// group mergeable commands, the group is sent where its first command was issued
+	std::vector<int> group_of(commands.size(), -1);
+	std::vector<sc2::Units> groups;
+	std::unordered_map<uint32_t, std::vector<int>> groups_by_ability;
+	for (size_t i = 0; i < commands.size(); ++i) {
+		if (!mergeable[i])
+			continue;
+		std::vector<int>& candidates = groups_by_ability[commands[i].ability];	// first command of each group
+		int found = -1;
+		for (auto c : candidates) {
+			if (sameCommand(commands[c], commands[i])) {
+				found = group_of[c];
+				break;
+			}
+		}
+		if (found == -1) {
+			found = groups.size();
+			groups.push_back(sc2::Units());
+			candidates.push_back(i);
+		}
+		group_of[i] = found;
+		groups[found].push_back(commands[i].unit);
+	}
+
+	std::vector<bool> group_sent(groups.size(), false);
+	for (size_t i = 0; i < commands.size(); ++i) {
+		const BufferedCommand& command = commands[i];
+		if (command.dropped)
+			continue;
+		if (group_of[i] == -1) {
+			send(out_, sc2::Units{ command.unit }, command);
+		}
+		else if (!group_sent[group_of[i]]) {
+			send(out_, groups[group_of[i]], command);
+			group_sent[group_of[i]] = true;
+		}
+	}
+
+	for (auto& a : autocasts) {
+		out_->ToggleAutocast(a.first, a.second);
+	}
+	for (auto& c : chats) {
+		out_->SendChat(c.first, c.second);
+	}
+	clear();
+}
+
+void ActionBuffer::send(sc2::ActionInterface* out_, const sc2::Units& units_, const BufferedCommand& command_) {
+	switch (command_.target_kind) {
+	case TARGET::NONE:
+		out_->UnitCommand(units_, command_.ability, command_.queued);
+		break;
+	case TARGET::POINT:
+		out_->UnitCommand(units_, command_.ability, command_.point, command_.queued);
+		break;
+	case TARGET::UNIT:
+		out_->UnitCommand(units_, command_.ability, command_.target, command_.queued);
+		break;
+	}
+	num_sent++;
+	last_step_sent++;
+}
+
+void ActionBuffer::clear() {
+	// drop this step's commands without sending them
+	commands.clear();
+	unit_commands.clear();
+	command_tags.clear();
+	autocasts.clear();
+	chats.clear();
+}
+
+long long ActionBuffer::getNumIssued() {
+	// unit commands issued by the bot over the game
+	return num_issued;
+}
+
+long long ActionBuffer::getNumSent() {
+	// commands sent to the game over the game, after coalescing
+	return num_sent;
+}
+
+int ActionBuffer::getLastStepIssued() {
+	return last_step_issued;
+}
+
+int ActionBuffer::getLastStepSent() {
+	return last_step_sent;
+}
+
+void ActionBuffer::UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, bool queued_command) {
+	add(unit, ability, TARGET::NONE, sc2::Point2D(), nullptr, queued_command);
+}
+
+void ActionBuffer::UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Point2D& point, bool queued_command) {
+	add(unit, ability, TARGET::POINT, point, nullptr, queued_command);
+}
+
+void ActionBuffer::UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Unit* target, bool queued_command) {
+	add(unit, ability, TARGET::UNIT, sc2::Point2D(), target, queued_command);
+}
+
+void ActionBuffer::UnitCommand(const sc2::Units& units, sc2::AbilityID ability, bool queued_move) {
+	for (auto u : units) {
+		add(u, ability, TARGET::NONE, sc2::Point2D(), nullptr, queued_move);
+	}
+}
+
+void ActionBuffer::UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Point2D& point, bool queued_command) {
+	for (auto u : units) {
+		add(u, ability, TARGET::POINT, point, nullptr, queued_command);
+	}
+}
+
+void ActionBuffer::UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Unit* target, bool queued_command) {
+	for (auto u : units) {
+		add(u, ability, TARGET::UNIT, sc2::Point2D(), target, queued_command);
+	}
+}
+
+const std::vector<sc2::Tag>& ActionBuffer::Commands() const {
+	// tags of every unit commanded since the last flush
+	return command_tags;
+}
+
+void ActionBuffer::ToggleAutocast(sc2::Tag unit_tag, sc2::AbilityID ability) {
+	autocasts.push_back(std::make_pair(std::vector<sc2::Tag>{ unit_tag }, ability));
+}
+
+void ActionBuffer::ToggleAutocast(const std::vector<sc2::Tag>& unit_tags, sc2::AbilityID ability) {
+	autocasts.push_back(std::make_pair(unit_tags, ability));
+}
+
+void ActionBuffer::SendChat(const std::string& message, sc2::ChatChannel channel) {
+	chats.push_back(std::make_pair(message, channel));
+}
+
+void ActionBuffer::SendActions() {
+	// commands are sent by flush at the end of the bot's step
+}
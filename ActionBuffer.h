@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "sc2api/sc2_api.h"
+
+# define COALESCE_ACTIONS true // collect each step's commands and send them coalesced, false passes them straight through
+
+class BasicSc2Bot;
+
+class ActionBuffer : public sc2::ActionInterface {
+// Collects every command issued during a step and sends them together at the end of it.
+// Repeats of a unit's last command are dropped, a new unqueued move, attack, stop, hold or
+// gather order replaces the unit's earlier ones, and units left with the same single command
+// are sent as one multi-unit command. Commands to structures are passed on untouched, since
+// repeated train and research commands stack and a multi-unit train only trains one unit
+public:
+	ActionBuffer(BasicSc2Bot* agent_);
+	void flush(sc2::ActionInterface* out_);
+	void clear();
+	long long getNumIssued();
+	long long getNumSent();
+	int getLastStepIssued();
+	int getLastStepSent();
+
+	// sc2::ActionInterface
+	void UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, bool queued_command = false) override;
+	void UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Point2D& point, bool queued_command = false) override;
+	void UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Unit* target, bool queued_command = false) override;
+	void UnitCommand(const sc2::Units& units, sc2::AbilityID ability, bool queued_move = false) override;
+	void UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Point2D& point, bool queued_command = false) override;
+	void UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Unit* target, bool queued_command = false) override;
+	const std::vector<sc2::Tag>& Commands() const override;
+	void ToggleAutocast(sc2::Tag unit_tag, sc2::AbilityID ability) override;
+	void ToggleAutocast(const std::vector<sc2::Tag>& unit_tags, sc2::AbilityID ability) override;
+	void SendChat(const std::string& message, sc2::ChatChannel channel = sc2::ChatChannel::All) override;
+	void SendActions() override;
+
+private:
+	enum class TARGET { NONE, POINT, UNIT };
+
+	struct BufferedCommand {
+		const sc2::Unit* unit;
+		sc2::AbilityID ability;
+		TARGET target_kind;
+		sc2::Point2D point;
+		const sc2::Unit* target;
+		bool queued;
+		bool dropped;
+	};
+
+	void add(const sc2::Unit* unit_, sc2::AbilityID ability_, TARGET target_kind_, sc2::Point2D point_, const sc2::Unit* target_, bool queued_);
+	void send(sc2::ActionInterface* out_, const sc2::Units& units_, const BufferedCommand& command_);
+	bool sameCommand(const BufferedCommand& a, const BufferedCommand& b);
+	bool isStructure(const sc2::Unit* unit_);
+	static bool replacesOrders(sc2::AbilityID ability_);
+
+	BasicSc2Bot* agent;
+	std::vector<BufferedCommand> commands;							// in the order they were issued
+	std::unordered_map<sc2::Tag, std::vector<int>> unit_commands;	// indices into commands, per unit
+	std::vector<sc2::Tag> command_tags;
+	std::vector<std::pair<std::vector<sc2::Tag>, sc2::AbilityID>> autocasts;
+	std::vector<std::pair<std::string, sc2::ChatChannel>> chats;
+	std::unordered_map<int, bool> structure_types;					// cached by unit type
+
+	long long num_issued;
+	long long num_sent;
+	int last_step_issued;
+	int last_step_sent;
+};
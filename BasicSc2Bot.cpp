@@ -8,6 +8,7 @@
 #include "sc2lib/sc2_lib.h"
 #include "sc2utils/sc2_manage_process.h"
 #include "sc2utils/sc2_arg_parser.h"
+#include <algorithm>
 
 #define MINERAL_VALUE 2
 #define GAS_VALUE 3
@@ -22,6 +23,39 @@ class MobHandler;
 BasicSc2Bot::BasicSc2Bot() {
 	mobH = nullptr;
 	locH = nullptr;
+	prof = new Profiler();
+	tracer = new Tracer();
+	recorder = nullptr;
+	observation_override = nullptr;
+	query_override = nullptr;
+	actions_override = nullptr;
+	if (RECORD_OBSERVATIONS) {
+		recorder = new ObservationRecorder(this);
+		recorder->open(RECORDING_FILE);
+	}
+	capture = nullptr;
+	if (CAPTURE_UNITS) {
+		capture = new UnitCapture(this);
+		capture->open(CAPTURE_FILE);
+	}
+	pool = new TaskPool(TASK_POOL_WORKERS);
+	targeter = new TargetAssigner(this);
+	registerMicroRules();
+	enemies = new EnemyTracker(this);
+	thresholds = nullptr;
+	if (THRESHOLD_TABLES) {
+		thresholds = new ThresholdTable();
+	}
+	pipeline = nullptr;
+	if (PIPELINE_STEPS) {
+		pipeline = new StepPipeline(this);
+	}
+	scheduler = new StepScheduler(this);
+	registerStepTasks();
+	action_buffer = nullptr;
+	if (COALESCE_ACTIONS) {
+		action_buffer = new ActionBuffer(this);
+	}
 	proxy_worker = nullptr;
 	current_strategy = nullptr;
 	player_start_id = -1;
@@ -45,6 +79,10 @@ BasicSc2Bot::BasicSc2Bot() {
 	max_gas = 0;
 	townhalls_built = 0;
 	reset_shield_overcharge = 0;
+	last_stored_directive = nullptr;
+	directives_reclaimed = 0;
+	next_activation = 0;
+	precepts_retired = 0;
 }
 
 BasicSc2Bot::BasicSc2Bot(const BasicSc2Bot& rhs){
@@ -69,6 +107,10 @@ BasicSc2Bot::BasicSc2Bot(const BasicSc2Bot& rhs){
 	max_gas = rhs.max_gas;
 	townhalls_built = rhs.townhalls_built;
 	reset_shield_overcharge = rhs.reset_shield_overcharge;
+	last_stored_directive = nullptr;
+	directives_reclaimed = 0;
+	next_activation = 0;
+	precepts_retired = 0;
 	proxy_worker = rhs.proxy_worker;
 	current_strategy = rhs.current_strategy;
 	if (!rhs.mobH) {
@@ -86,6 +128,52 @@ BasicSc2Bot::BasicSc2Bot(const BasicSc2Bot& rhs){
 		locH = new LocationHandler(this);
 		*locH = *rhs.locH;
 	}
+
+	prof = new Profiler();
+	*prof = *rhs.prof;
+
+	// recorded spans are not copied
+	tracer = new Tracer();
+	tracer->setEnabled(rhs.tracer->isEnabled());
+
+	// only the original bot records observations and captures units
+	recorder = nullptr;
+	capture = nullptr;
+
+	// workers belong to the original bot
+	pool = new TaskPool(rhs.pool->getNumWorkers());
+
+	// rules capture this bot, so they are registered again rather than copied
+	targeter = new TargetAssigner(this);
+	registerMicroRules();
+
+	// remembered enemies are rebuilt from the next observation
+	enemies = new EnemyTracker(this);
+
+	// precepts are not copied, so neither are their thresholds
+	thresholds = nullptr;
+	if (rhs.thresholds) {
+		thresholds = new ThresholdTable();
+	}
+
+	// stages capture this bot too, and the worker belongs to the original bot
+	pipeline = nullptr;
+	if (rhs.pipeline) {
+		pipeline = new StepPipeline(this);
+	}
+
+	// tasks capture this bot, so they are registered again rather than copied
+	scheduler = new StepScheduler(this);
+	registerStepTasks();
+
+	// buffered commands belong to the original bot's step
+	action_buffer = nullptr;
+	if (rhs.action_buffer) {
+		action_buffer = new ActionBuffer(this);
+	}
+	observation_override = rhs.observation_override;
+	query_override = rhs.query_override;
+	actions_override = rhs.actions_override;
 }
 BasicSc2Bot& BasicSc2Bot::operator=(const BasicSc2Bot& rhs){
 	if (this == &rhs) return *this;
@@ -133,10 +221,20 @@ BasicSc2Bot& BasicSc2Bot::operator=(const BasicSc2Bot& rhs){
 		}
 		*locH = *rhs.locH;
 	}
+
+	*prof = *rhs.prof;
+	observation_override = rhs.observation_override;
+	query_override = rhs.query_override;
+	actions_override = rhs.actions_override;
 	return *this;
 }
 
 BasicSc2Bot::~BasicSc2Bot(){
+	// stops the pipeline worker before the handlers it works for are deleted
+	if (pipeline) {
+		delete pipeline;
+	}
+
 	if (locH) {
 		delete locH;
 	}
@@ -144,8 +242,89 @@ BasicSc2Bot::~BasicSc2Bot(){
 	if (mobH) {
 		delete mobH;
 	}
+
+	if (prof) {
+		delete prof;
+	}
+
+	if (tracer) {
+		delete tracer;
+	}
+
+	if (recorder) {
+		delete recorder;
+	}
+
+	if (capture) {
+		delete capture;
+	}
+
+	if (targeter) {
+		delete targeter;
+	}
+
+	if (enemies) {
+		delete enemies;
+	}
+
+	if (thresholds) {
+		delete thresholds;
+	}
+
+	if (action_buffer) {
+		delete action_buffer;
+	}
+
+	if (scheduler) {
+		delete scheduler;
+	}
+
+	if (pool) {
+		delete pool;
+	}
+}
+
+
+const sc2::ObservationInterface* BasicSc2Bot::getObservation() const {
+	// the client's observation, or the recorded one when replaying a game without the client
+	if (observation_override)
+		return observation_override;
+	return sc2::Agent::Observation();
 }
 
+sc2::QueryInterface* BasicSc2Bot::getQuery() {
+	if (query_override)
+		return query_override;
+	return sc2::Agent::Query();
+}
+
+sc2::ActionInterface* BasicSc2Bot::getActions() {
+	// commands are collected by the action buffer and sent at the end of the step
+	if (action_buffer)
+		return action_buffer;
+	if (actions_override)
+		return actions_override;
+	return sc2::Agent::Actions();
+}
+
+void BasicSc2Bot::flushActions() {
+	// send the step's buffered commands to the client's interface, or the replay stand-in
+	if (!action_buffer)
+		return;
+	if (actions_override) {
+		action_buffer->flush(actions_override);
+	}
+	else {
+		action_buffer->flush(sc2::Agent::Actions());
+	}
+}
+
+void BasicSc2Bot::setInterfaces(const sc2::ObservationInterface* observation_, sc2::QueryInterface* query_, sc2::ActionInterface* actions_) {
+	// used by the replay driver, passing nullptr restores the client's interface
+	observation_override = observation_;
+	query_override = query_;
+	actions_override = actions_;
+}
 
 void BasicSc2Bot::setLoadingProgress(int loaded_) {
 	// for sequential intialization 
@@ -166,20 +345,164 @@ void BasicSc2Bot::addStrat(Precept precept_) {
 	// queue in a precept
 	assert(precept_.hasDirective());
 	assert(precept_.hasTrigger());
+	precept_.setID(prof->registerPrecept(precept_.getName()));
+	tracer->setPreceptName(precept_.getID(), precept_.getName());
+	if (thresholds) {
+		precept_.useThresholdTable(thresholds);
+	}
 	precepts_onstep.push_back(precept_);
+
+	// place it on the timeline, after precepts that become active on the same game loop
+	PreceptWindow window;
+	precept_.getTimeWindow(&window.earliest, &window.latest);
+	precept_windows.push_back(window);
+	auto position = std::upper_bound(precept_timeline.begin() + next_activation, precept_timeline.end(), window.earliest,
+		[this](int earliest_, int index_) { return earliest_ < precept_windows[index_].earliest; });
+	precept_timeline.insert(position, (int)precepts_onstep.size() - 1);
 }
 
 void BasicSc2Bot::storeDirective(Directive directive_)
 {
-	// intended for directives, such as default directives to gather resources,
-	// which are not stored precepts vector.
-	if (directive_by_id[directive_.getID()])
+	// intended for directives, such as the directives of precepts, which live for the whole game
+	int storage_id = directive_.getStorageID();
+	if (storage_id >= 0 && storage_id < (int)directive_storage.size() && directive_storage[storage_id].getID() == directive_.getID()) {
+		last_stored_directive = &directive_storage[storage_id];
+		return;
+	}
+
+	allocateDirective(directive_);
+}
+
+int BasicSc2Bot::allocateDirective(Directive directive_) {
+	// store a copy of directive_, reusing the storage id of a reclaimed directive when there is one
+
+	int storage_id;
+	if (!free_directive_ids.empty()) {
+		storage_id = free_directive_ids.back();
+		free_directive_ids.pop_back();
+		directive_storage[storage_id] = directive_;
+	}
+	else {
+		storage_id = directive_storage.size();
+		directive_storage.push_back(directive_);
+		directive_slots.emplace_back();
+	}
+	directive_storage[storage_id].setStorageID(storage_id);
+	DirectiveSlot& slot = directive_slots[storage_id];
+	slot.refs = 0;
+	slot.pooled = false;
+	slot.interned = false;
+	slot.live = true;
+	last_stored_directive = &directive_storage[storage_id];
+	return storage_id;
+}
+
+Directive* BasicSc2Bot::getDirective(int storage_id_) {
+	return &directive_storage[storage_id_];
+}
+
+Directive* BasicSc2Bot::acquireDefaultDirective(Directive directive_) {
+	// returns the stored default directive matching directive_, storing it the first time
+	// each call holds a reference, which is given back by releaseDirective()
+
+	directive_.setDefault();
+	Directive::InternKey key = directive_.getInternKey();
+	auto it = interned_directives.find(key);
+	if (it != interned_directives.end()) {
+		directive_slots[it->second].refs++;
+		last_stored_directive = &directive_storage[it->second];
+		return last_stored_directive;
+	}
+
+	int storage_id = allocateDirective(directive_);
+	directive_slots[storage_id].refs = 1;
+	directive_slots[storage_id].pooled = true;
+	directive_slots[storage_id].interned = true;
+	interned_directives[key] = storage_id;
+	return &directive_storage[storage_id];
+}
+
+int BasicSc2Bot::storeBundleChain(const std::vector<Directive>& bundle_) {
+	// store a directive's bundle as a chain of stored directives, returning where it starts
+	// chains never change once stored, so any number of mobs can walk the same one
+
+	int start = bundle_chains.size();
+	for (auto& d : bundle_) {
+		bundle_chains.push_back(allocateDirective(d));
+	}
+	return start;
+}
+
+Directive* BasicSc2Bot::getBundledDirective(int index_) {
+	return &directive_storage[bundle_chains[index_]];
+}
+
+void BasicSc2Bot::setBundleRemainder(std::vector<std::pair<int, int>>& chains_) {
+	// hold the rest of a mob's bundles while the directive popped from them executes, chains_ is left empty
+	bundle_remainder.swap(chains_);
+	chains_.clear();
+}
+
+void BasicSc2Bot::takeBundleRemainder(std::vector<std::pair<int, int>>& chains_) {
+	// hand the held bundles to the mob carrying out the directive, chains_ is replaced
+	chains_.swap(bundle_remainder);
+	bundle_remainder.clear();
+}
+
+bool BasicSc2Bot::hasBundleRemainder() {
+	return !bundle_remainder.empty();
+}
+
+Directive* BasicSc2Bot::storeTransientDirective(Directive directive_) {
+	// store a directive that is executed once, it is reclaimed when no mob is carrying it out
+
+	int storage_id = allocateDirective(directive_);
+	directive_slots[storage_id].pooled = true;
+	return &directive_storage[storage_id];
+}
+
+void BasicSc2Bot::releaseDirective(Directive* directive_) {
+	// directives not created through the pool are kept for the whole game
+	int storage_id = directive_->getStorageID();
+	if (storage_id < 0 || !directive_slots[storage_id].pooled)
 		return;
+	if (directive_slots[storage_id].refs > 0) {
+		directive_slots[storage_id].refs--;
+	}
+}
 
-	directive_storage.emplace_back(std::make_unique<Directive>(directive_));
-	Directive* created_dir = directive_storage.back().get();
-	stored_directives.insert(created_dir);
-	directive_by_id[directive_.getID()] = created_dir;
+int BasicSc2Bot::reclaimDirectives() {
+	// free pooled directives that no mob holds as its default or current directive
+
+	std::unordered_set<Directive*> in_use;
+	for (auto m : mobH->getMobs()) {
+		if (m->hasCurrentDirective()) {
+			in_use.insert(m->getCurrentDirective());
+		}
+	}
+
+	int reclaimed = 0;
+	for (int i = 0; i < (int)directive_slots.size(); ++i) {
+		DirectiveSlot& slot = directive_slots[i];
+		Directive* dir = &directive_storage[i];
+		if (!slot.live || !slot.pooled || slot.refs > 0 || dir->hasAssignedMob() || in_use.count(dir))
+			continue;
+		if (slot.interned) {
+			interned_directives.erase(dir->getInternKey());
+		}
+		if (last_stored_directive == dir) {
+			last_stored_directive = nullptr;
+		}
+		// drop what it holds until the id is reused
+		directive_storage[i] = Directive(Directive::DEFAULT_DIRECTIVE, Directive::SIMPLE_ACTION);
+		slot.live = false;
+		slot.pooled = false;
+		slot.interned = false;
+		free_directive_ids.push_back(i);
+		reclaimed++;
+	}
+	directives_reclaimed += reclaimed;
+	return reclaimed;
 }
 
 void BasicSc2Bot::storeStrategy(Strategy strategy_)
@@ -196,7 +519,7 @@ void BasicSc2Bot::storeStrategy(Strategy strategy_)
 void BasicSc2Bot::setTimer1(int steps_) {
 	// sets timer1 only if its value is not already set
 	if (timer_1 == -1) {
-		const sc2::ObservationInterface* obs = Observation();
+		const sc2::ObservationInterface* obs = getObservation();
 		auto current_steps = obs->GetGameLoop();
 		timer_1 = current_steps + steps_;
 	}
@@ -205,7 +528,7 @@ void BasicSc2Bot::setTimer1(int steps_) {
 void BasicSc2Bot::setTimer2(int steps_) {
 	// sets timer2 only if its value is not already set
 	if (timer_2 == -1) {
-		const sc2::ObservationInterface* obs = Observation();
+		const sc2::ObservationInterface* obs = getObservation();
 		auto current_steps = obs->GetGameLoop();
 		timer_2 = current_steps + steps_;
 	}
@@ -214,7 +537,7 @@ void BasicSc2Bot::setTimer2(int steps_) {
 void BasicSc2Bot::setTimer3(int steps_) {
 	// sets timer3 only if its value is not already set
 	if (timer_3 == -1) {
-		const sc2::ObservationInterface* obs = Observation();
+		const sc2::ObservationInterface* obs = getObservation();
 		auto current_steps = obs->GetGameLoop();
 		timer_3 = current_steps + steps_;
 	}
@@ -225,7 +548,7 @@ int BasicSc2Bot::getStepsPastTimer1()
 	// get the amount of timesteps past timer_1
 
 	if (timer_1 != -1) {
-		const sc2::ObservationInterface* obs = Observation();
+		const sc2::ObservationInterface* obs = getObservation();
 		auto current_steps = obs->GetGameLoop();
 		return current_steps - timer_1;
 	}
@@ -236,7 +559,7 @@ int BasicSc2Bot::getStepsPastTimer2() {
 	// get the amount of timesteps past timer_2
 
 	if (timer_2 != -1) {
-		const sc2::ObservationInterface* obs = Observation();
+		const sc2::ObservationInterface* obs = getObservation();
 		auto current_steps = obs->GetGameLoop();
 		return current_steps - timer_2;
 	}
@@ -247,7 +570,7 @@ int BasicSc2Bot::getStepsPastTimer3() {
 	// get the amount of timesteps past timer_1
 
 	if (timer_3 != -1) {
-		const sc2::ObservationInterface* obs = Observation();
+		const sc2::ObservationInterface* obs = getObservation();
 		auto current_steps = obs->GetGameLoop();
 		return current_steps - timer_3;
 	}
@@ -294,7 +617,7 @@ void BasicSc2Bot::setInitialized()
 Directive* BasicSc2Bot::getLastStoredDirective()
 {
 	// used after storing a directive to get its exact pointer
-	return directive_storage.back().get();
+	return last_stored_directive;
 }
 
 void BasicSc2Bot::checkBuildingQueues() {
@@ -306,7 +629,7 @@ void BasicSc2Bot::checkBuildingQueues() {
 	// even if they are the only order... disabling this and just accepting sometimes double queues might happen
 	
 	/*
-	std::unordered_set <Mob*> buildings = mobH->filterByFlag(mobH->getMobs(), FLAGS::IS_STRUCTURE);
+	std::unordered_set <Mob*> buildings = mobH->getMobsWithFlags({ FLAGS::IS_STRUCTURE });
 	buildings = mobH->filterNotOnCooldown(buildings);
 	if (!buildings.empty()) {
 		for (auto m : buildings) {
@@ -318,7 +641,7 @@ void BasicSc2Bot::checkBuildingQueues() {
 					}
 				}
 				if (!any_different_orders) {
-					Actions()->UnitCommand(&m->unit, sc2::ABILITY_ID::CANCEL_LAST);
+					getActions()->UnitCommand(&m->unit, sc2::ABILITY_ID::CANCEL_LAST);
 					m->giveCooldown(this, 10);
 		
 		}
@@ -329,7 +652,7 @@ void BasicSc2Bot::checkBuildingQueues() {
 void BasicSc2Bot::listUnitSummary() {
 	// Currently unused, can help differentiate and diagnose strategy setups.
 	// Intended to be called OnGameEnd()
-	const sc2::ObservationInterface* obs = Observation();
+	const sc2::ObservationInterface* obs = getObservation();
 	auto utd = obs->GetUnitTypeData();
 	std::map<std::string, int> first_7000_steps;
 	
@@ -350,7 +673,7 @@ void BasicSc2Bot::listUnitSummary() {
 bool BasicSc2Bot::haveUpgrade(const sc2::UpgradeID upgrade_) {
 	// return true if the bot has fully researched the specified upgrade
 
-	const sc2::ObservationInterface* observation = Observation();
+	const sc2::ObservationInterface* observation = getObservation();
 	const std::vector<sc2::UpgradeID> upgrades = observation->GetUpgrades();
 	return (std::find(upgrades.begin(), upgrades.end(), upgrade_) != upgrades.end());
 }
@@ -359,8 +682,11 @@ bool BasicSc2Bot::haveUpgrade(const sc2::UpgradeID upgrade_) {
 bool BasicSc2Bot::canUnitUseAbility(const sc2::Unit& unit, const sc2::ABILITY_ID ability_) {
 	// check if a unit is able to use a given ability
 
-	sc2::QueryInterface* query_interface = Query();
+	sc2::QueryInterface* query_interface = getQuery();
+	prof->countQuery();
+	long long trace_start = tracer->now();
 	std::vector<sc2::AvailableAbility> abilities = (query_interface->GetAbilitiesForUnit(&unit)).abilities;
+	tracer->span("Query::GetAbilitiesForUnit", trace_start);
 	for (auto a : abilities) {
 		if (a.ability_id == ability_) {
 			return true;
@@ -434,18 +760,6 @@ sc2::Race BasicSc2Bot::getEnemyRace() {
 	return enemy_race;
 }
 
-std::unordered_set<const sc2::Unit*> BasicSc2Bot::getEnemyUnits()
-{
-	// gets an unordered set of pointers to enemy units
-	std::unordered_set<const sc2::Unit*> enemies;
-
-	for (auto it = enemy_unit_by_tag.begin(); it != enemy_unit_by_tag.end(); ++it) {
-		enemies.insert(it->second);
-	}
-
-	return enemies;
-}
-
 sc2::Point2D BasicSc2Bot::getStoredLocation(std::string identifier_)
 {
 	// gets a previously stored location using a string identifier
@@ -488,17 +802,7 @@ std::vector<sc2::Attribute> BasicSc2Bot::getAttributes(const sc2::Unit* unit) {
 sc2::UnitTypeData BasicSc2Bot::getUnitTypeData(const sc2::Unit* unit) {
 	// get UnitTypeData for a unit
 
-	return Observation()->GetUnitTypeData()[unit->unit_type];
-}
-
-bool BasicSc2Bot::addEnemyUnit(const sc2::Unit* unit) {
-	// adds an enemy unit to our unordered_map and unordered_set containers
-	if (std::addressof(enemy_unit_by_tag[unit->tag]) != std::addressof(unit)) {
-		enemy_units.erase(enemy_unit_by_tag[unit->tag]);
-	}
-	enemy_units.insert(unit);
-	enemy_unit_by_tag[unit->tag] = unit;
-	return true;
+	return getObservation()->GetUnitTypeData()[unit->unit_type];
 }
 
 bool BasicSc2Bot::flushOrders()
@@ -506,8 +810,8 @@ bool BasicSc2Bot::flushOrders()
 	// flushes any erroneous directives that might reference mobs that are no
 	// longer performing them, and vice versa
 	bool any_flushed = false;
-	std::unordered_set<Mob*> busy_mobs = mobH->getBusyMobs();
-	for (auto m : busy_mobs) {
+	mobH->copyBusyMobs(busy_snapshot);
+	for (auto m : busy_snapshot) {
 		if (!m->hasCurrentDirective()) {
 			mobH->setMobIdle(m);
 			any_flushed = true;
@@ -515,16 +819,15 @@ bool BasicSc2Bot::flushOrders()
 		}
 		Directive* current_dir = m->getCurrentDirective();
 		sc2::ABILITY_ID current_ability = current_dir->getAbilityID();
-		auto orders = m->unit.orders;
+		const std::vector<sc2::UnitOrder>& orders = m->unit.orders;
 		if (orders.empty()) {
 			current_dir->unassignMob(m);
 			mobH->setMobIdle(m);
 			any_flushed = true;
-			Actions()->UnitCommand(&m->unit, sc2::ABILITY_ID::STOP);
+			getActions()->UnitCommand(&m->unit, sc2::ABILITY_ID::STOP);
 			continue;
 		}
-		auto order = orders.front();
-		if (order.ability_id != current_ability) {
+		if (orders.front().ability_id != current_ability) {
 			current_dir->unassignMob(m);
 			mobH->setMobIdle(m);
 			any_flushed = true;
@@ -536,7 +839,7 @@ bool BasicSc2Bot::flushOrders()
 
 void BasicSc2Bot::checkBuildingsStatus() {
 	// record how building gateways and robotics facilities are
-	std::unordered_set<Mob*> structures = mobH->filterByFlag(mobH->getMobs(), FLAGS::IS_STRUCTURE);
+	std::unordered_set<Mob*> structures = mobH->getMobsWithFlags({ FLAGS::IS_STRUCTURE });
 	std::unordered_set<Mob*> gateways;
 	std::unordered_set<Mob*> robotics;
 
@@ -606,7 +909,7 @@ void BasicSc2Bot::OnGameStart() {
 
 void::BasicSc2Bot::loadStep_01() { 
 
-	const sc2::ObservationInterface* observation = Observation();
+	const sc2::ObservationInterface* observation = getObservation();
 	map_name = observation->GetGameInfo().map_name;
 
 	if (map_name.find("Proxima") != std::string::npos)
@@ -617,6 +920,9 @@ void::BasicSc2Bot::loadStep_01() {
 				map_index = 1; else
 				map_index = 0;
 
+	// threat is recalculated every step on the maps that need it
+	scheduler->setPeriod("OnStep::highestThreat", map_index >= 2 ? 1 : 25);
+
 	enemy_race = sc2::Race::Random;
 	setLoadingProgress(1);
 }
@@ -625,6 +931,7 @@ void::BasicSc2Bot::loadStep_02() {
 	// delegate mob and location responsibilities to helper classes
 	mobH = new MobHandler(this); // initialize mob handler 
 	locH = new LocationHandler(this); // initialize location handler
+	locH->startMapAnalysis(); // chunks are built on a worker thread while loading continues
 	setLoadingProgress(2);
 }
 
@@ -633,7 +940,7 @@ void::BasicSc2Bot::loadStep_03() {
 	Strategy* strategy = new Strategy(this);
 	setCurrentStrategy(strategy);
 	// add all starting units to their respective mobs
-	const sc2::ObservationInterface* observation = Observation();
+	const sc2::ObservationInterface* observation = getObservation();
 	sc2::Units units = observation->GetUnits(sc2::Unit::Alliance::Self);
 	for (const sc2::Unit* u : units) {
 		sc2::UNIT_TYPEID u_type = u->unit_type;
@@ -661,8 +968,8 @@ void::BasicSc2Bot::loadStep_03() {
 			mobH->addMob(townhall);
 		}
 	}
-	std::unordered_set<Mob*> workers = mobH->filterByFlag(mobH->getMobs(), FLAGS::IS_WORKER);
-	std::unordered_set<Mob*> townhalls = mobH->filterByFlag(mobH->getMobs(), FLAGS::IS_TOWNHALL);
+	std::unordered_set<Mob*> workers = mobH->getMobsWithFlags({ FLAGS::IS_WORKER });
+	std::unordered_set<Mob*> townhalls = mobH->getMobsWithFlags({ FLAGS::IS_TOWNHALL });
 	assert(townhalls.size() == 1);
 	Mob* townhall = *townhalls.begin();
 	for (auto w : workers) {
@@ -675,8 +982,7 @@ void::BasicSc2Bot::loadStep_03() {
 
 void::BasicSc2Bot::loadStep_04() { 
 	// handle building and location data
-	// setLoadingProgress(4) is set inside LocationHandler after chunks are loaded
-	const sc2::ObservationInterface* obs = Observation();
+	const sc2::ObservationInterface* obs = getObservation();
 	auto utd_fulldata = obs->GetUnitTypeData();
 	auto atd_fulldata = obs->GetAbilityData();
 
@@ -700,10 +1006,14 @@ void::BasicSc2Bot::loadStep_04() {
 	sc2::Point2D proxy_location = locH->getProxyLocation();
 
 	locH->initLocations(map_index, player_start_id);
+	setLoadingProgress(4);
 }
 
 void::BasicSc2Bot::loadStep_05() { 
 	// handle loading strategies
+	// strategies need the map chunks, so this waits until the map analysis worker has published them
+	if (!locH->collectMapAnalysis())
+		return;
 	current_strategy->loadStrategies();
 	setLoadingProgress(5);
 	setInitialized();
@@ -720,6 +1030,7 @@ void::BasicSc2Bot::onStep_100(const sc2::ObservationInterface* obs) {
 	*/
 	checkBuildingsStatus();
 	flushOrders();
+	reclaimDirectives();
 }
 
 void::BasicSc2Bot::onStep_1000(const sc2::ObservationInterface* obs) {
@@ -748,7 +1059,7 @@ void::BasicSc2Bot::onStep_1000(const sc2::ObservationInterface* obs) {
 }
 
 void BasicSc2Bot::OnGameEnd() {
-	const sc2::ObservationInterface* obs = Observation();
+	const sc2::ObservationInterface* obs = getObservation();
 	auto results = obs->GetResults();
 
 	std::string result = "L";
@@ -789,12 +1100,71 @@ void BasicSc2Bot::OnGameEnd() {
 
 	//listUnitSummary();
 
+	// getNumRuns() waits for the pipeline worker, which must be idle before its spans are flushed
+	if (pipeline) {
+		std::cout << "Pipelined stage runs: " << pipeline->getNumRuns() << ", time steps waited on them: " << pipeline->getWaitUs() << "us" << std::endl;
+	}
+
+	// export per-precept and per-condition evaluation costs
+	prof->writeCSV(PROFILER_CSV);
+	tracer->flush(TRACE_JSON);
+	if (recorder) {
+		recorder->finish();
+	}
+	if (capture) {
+		capture->finish();
+	}
+	std::cout << "Steps over budget: " << scheduler->getNumOverBudget() << ", background tasks deferred: " << scheduler->getNumDeferred() << std::endl;
+	std::cout << "Wall time per game loop: " << scheduler->getWallUsPerLoop() << "us" << std::endl;
+	locH->printLocationProviders();
+	std::cout << "Directives stored: " << directive_storage.size() - free_directive_ids.size() << ", default directives shared: " << interned_directives.size()
+		<< ", reclaimed: " << directives_reclaimed << std::endl;
+	std::cout << "Precepts: " << precepts_onstep.size() << ", active at the end: " << active_precepts.size() << ", retired: " << precepts_retired << std::endl;
+	// threshold conditions are checked in the table and never counted as evaluated, so counts are per check that got past it
+	long long trigger_checks = 0;
+	long long threshold_rejected = 0;
+	long long conditions_evaluated = 0;
+	long long conditions_declared = 0;
+	for (auto& p : precepts_onstep) {
+		p.countConditionChecks(&trigger_checks, &threshold_rejected, &conditions_evaluated, &conditions_declared);
+	}
+	long long checks_past_table = trigger_checks - threshold_rejected;
+	std::cout << "Trigger checks: " << trigger_checks << ", rejected by threshold tables: " << threshold_rejected << ", other conditions evaluated: "
+		<< conditions_evaluated << " (" << (checks_past_table > 0 ? (float)conditions_evaluated / checks_past_table : 0.0f)
+		<< " per check past the tables, RANK_CONDITIONS_EVERY " << RANK_CONDITIONS_EVERY << ")" << std::endl;
+	if (COUNT_DECLARED_ORDER) {
+		std::cout << "Conditions the same checks evaluate in the order they were added: " << conditions_declared << " ("
+			<< (checks_past_table > 0 ? (float)conditions_declared / checks_past_table : 0.0f) << " per check past the tables)" << std::endl;
+	}
+	if (thresholds) {
+		std::cout << "Threshold conditions: " << thresholds->getNumThresholds() << " in " << thresholds->getNumGroups() << " triggers, flipped "
+			<< thresholds->getNumFlips() << " times" << std::endl;
+	}
+	if (action_buffer && obs->GetGameLoop() > 0) {
+		std::cout << "Unit commands issued: " << action_buffer->getNumIssued() << " (" << (float)action_buffer->getNumIssued() / obs->GetGameLoop()
+			<< " per step), sent after coalescing: " << action_buffer->getNumSent() << " (" << (float)action_buffer->getNumSent() / obs->GetGameLoop()
+			<< " per step)" << std::endl;
+	}
+
 }
 
 void BasicSc2Bot::OnStep() {
 	// This function is executed on every frame
-	const sc2::ObservationInterface* observation = Observation();
+	const sc2::ObservationInterface* observation = getObservation();
 	int gameloop = observation->GetGameLoop();
+	tracer->setGameLoop(gameloop);
+	long long step_start = tracer->now();
+	if (recorder) {
+		recorder->recordStep();
+	}
+	if (capture) {
+		capture->recordStep();
+	}
+	long long phase_start = step_start;
+	scheduler->beginStep();
+	if (pipeline) {
+		pipeline->beginStep();
+	}
 
 	// this block of code allows the proxy worker to be sent immediately, without waiting for loading to complete on Bel'Shir VestigeLE and ProximStationLE
 	static bool proxy_sent = false;
@@ -817,7 +1187,7 @@ void BasicSc2Bot::OnStep() {
 		for (auto it = allied_units.begin(); it != allied_units.end(); ++it) {
 			if ((*it)->unit_type == sc2::UNIT_TYPEID::PROTOSS_NEXUS) {
 				if ((*it)->orders.empty()) {
-					Actions()->UnitCommand((*it), sc2::ABILITY_ID::TRAIN_PROBE);
+					getActions()->UnitCommand((*it), sc2::ABILITY_ID::TRAIN_PROBE);
 				}
 				break;
 			}
@@ -877,30 +1247,30 @@ void BasicSc2Bot::OnStep() {
 					}
 				}
 				if (send_decoy_to != INVALID_POINT) {
-					Actions()->UnitCommand(decoy_probe, sc2::ABILITY_ID::ATTACK, send_decoy_to);
+					getActions()->UnitCommand(decoy_probe, sc2::ABILITY_ID::ATTACK, send_decoy_to);
 				}
 				if (map_index == 2) {
 					if (send_proxy_to_1 != INVALID_POINT && send_proxy_to_2 != INVALID_POINT) {
-						Actions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::GENERAL_MOVE, send_proxy_to_1);
-						Actions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::GENERAL_MOVE, send_proxy_to_2, true);
+						getActions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::GENERAL_MOVE, send_proxy_to_1);
+						getActions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::GENERAL_MOVE, send_proxy_to_2, true);
 					}
 					if (send_proxy_to_1 != INVALID_POINT && send_proxy_to_2 == INVALID_POINT) {
-						Actions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::GENERAL_MOVE, send_proxy_to_1);
+						getActions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::GENERAL_MOVE, send_proxy_to_1);
 					}
 					if (send_proxy_to_1 == INVALID_POINT && send_proxy_to_2 != INVALID_POINT) {
-						Actions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::GENERAL_MOVE, send_proxy_to_2);
+						getActions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::GENERAL_MOVE, send_proxy_to_2);
 					}
 				}
 				if (map_index == 3) {
 					if (send_proxy_to_1 != INVALID_POINT && send_proxy_to_2 != INVALID_POINT) {
-						Actions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::ATTACK, send_decoy_to);
-						Actions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::ATTACK, send_proxy_to_2, true);
+						getActions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::ATTACK, send_decoy_to);
+						getActions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::ATTACK, send_proxy_to_2, true);
 					}
 					if (send_proxy_to_1 != INVALID_POINT && send_proxy_to_2 == INVALID_POINT) {
-						Actions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::ATTACK, send_proxy_to_1);
+						getActions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::ATTACK, send_proxy_to_1);
 					}
 					if (send_proxy_to_1 == INVALID_POINT && send_proxy_to_2 != INVALID_POINT) {
-						Actions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::ATTACK, send_proxy_to_2);
+						getActions()->UnitCommand(proxy_probe, sc2::ABILITY_ID::ATTACK, send_proxy_to_2);
 					}
 				}
 			}
@@ -908,6 +1278,7 @@ void BasicSc2Bot::OnStep() {
 		proxy_sent = true;
 	}
 
+	phase_start = tracer->now();
 	if (gameloop >= 1 && loading_progress == 0) {
 		loadStep_01();
 	}
@@ -924,190 +1295,211 @@ void BasicSc2Bot::OnStep() {
 		loadStep_05();
 	}
 
-	if (!initialized)
+	tracer->span("OnStep::loading", phase_start);
+
+	if (!initialized) {
+		flushActions();
+		tracer->span("OnStep", step_start);
 		return;
+	}
 
-	// update visibility data for chunks
-	locH->scanChunks(observation);
-	if (!enemy_units.empty()) {
-		for (auto it = enemy_units.begin(); it != enemy_units.end(); ) {
-			auto next = std::next(it);
-			if (!(*it)->is_alive) {
-				// we do not need to keep dead enemy units in set
-				enemy_units.erase(*it);
-				it = next;
-				continue;
+	// units morph in place, so bring the mob type index up to date before any condition or directive looks it up
+	mobH->syncUnitTypes();
+
+	// run this step's share of the work, see registerStepTasks
+	scheduler->runStep(gameloop);
+	if (pipeline) {
+		pipeline->endStep(gameloop);
+	}
+
+	phase_start = tracer->now();
+	flushActions();
+	tracer->span("OnStep::flushActions", phase_start);
+	tracer->span("OnStep", step_start);
+}
+
+void BasicSc2Bot::registerStepTasks() {
+	// work that keeps our units responsive runs every step, in this order
+	scheduler->registerTask("OnStep::scanChunks", TASK_PRIORITY::CRITICAL, 1, 500.0, [this]() {
+		// update visibility data for chunks, threat is decayed by the pipeline when there is one
+		locH->scanChunks(getObservation(), pipeline == nullptr);
+	});
+	scheduler->registerTask("OnStep::enemyThreat", TASK_PRIORITY::CRITICAL, 1, 200.0, [this]() { updateEnemyThreat(); });
+	scheduler->registerTask("OnStep::busyMobs", TASK_PRIORITY::CRITICAL, 1, 100.0, [this]() { checkBusyMobs(); });
+	scheduler->registerTask("OnStep::idleMobs", TASK_PRIORITY::CRITICAL, 1, 500.0, [this]() { checkIdleMobs(); });
+	scheduler->registerTask("OnStep::precepts", TASK_PRIORITY::CRITICAL, 1, 2000.0, [this]() { checkPrecepts(); });
+	scheduler->registerTask("OnStep::structures", TASK_PRIORITY::CRITICAL, 1, 200.0, [this]() {
+		checkGasStructures();
+		checkBuildingQueues();
+	});
+	scheduler->registerTask("OnStep::checkSiegeTanks", TASK_PRIORITY::CRITICAL, 1, 200.0, [this]() { checkSiegeTanks(); });
+
+	// background work is spread across steps, and put off when a step is running long
+	// the threat period is set once the map is known, see loadStep_01
+	if (pipeline) {
+		// threat decay, the threat queued by updateEnemyThreat, and the highest threats are worked out
+		// while the game simulates the next loop, and applied at the start of the next step
+		pipeline->registerStage("OnStep::threat", 1,
+			[this]() { return locH->snapshotThreat(); },
+			[this]() { locH->updateThreat(); },
+			[this]() { locH->applyThreat(); });
+	}
+	else {
+		scheduler->registerTask("OnStep::highestThreat", TASK_PRIORITY::BACKGROUND, 25, 2000.0, [this]() {
+			if (locH->chunksInitialized() && map_index >= 1) {
+				locH->calculateHighestThreatForChunks();
 			}
-			// if unit is currently visible to you
-			if ((*it)->last_seen_game_loop == gameloop) {
-				std::vector<MapChunk*> chunks = locH->getLocalChunks((*it)->pos);
-
-				// only increase threat for pathable chunks
-				// the closest chunk should increase by a scale of 1.0, while other nearby chunks
-				// increase by a lesser amount adjusted by NEARBY_THREAT_MODIFIER
-				bool found_pathable = false; //whether we have found a pathable chunk near the unit
-				for (auto chunk : chunks) {
-					if (chunk == nullptr) {
-						continue;
+		});
+	}
+	scheduler->registerTask("OnStep::bookkeeping", TASK_PRIORITY::BACKGROUND, 100, 1000.0, [this]() { onStep_100(getObservation()); });
+	scheduler->registerTask("OnStep::threatReport", TASK_PRIORITY::BACKGROUND, 1000, 100.0, [this]() { onStep_1000(getObservation()); });
+}
+
+void BasicSc2Bot::updateEnemyThreat() {
+	// refresh remembered enemies, and add threat to the chunks around those in vision
+	enemies->update();
+	for (auto e : enemies->getCurrentUnits()) {
+		// if unit is currently visible to you
+		if (e->is_alive && e->display_type == sc2::Unit::DisplayType::Visible) {
+			std::vector<MapChunk*> chunks = locH->getLocalChunks(e->pos);
+
+			// only increase threat for pathable chunks
+			// the closest chunk should increase by a scale of 1.0, while other nearby chunks
+			// increase by a lesser amount adjusted by NEARBY_THREAT_MODIFIER
+			bool found_pathable = false; //whether we have found a pathable chunk near the unit
+			for (auto chunk : chunks) {
+				if (chunk == nullptr) {
+					continue;
+				}
+				if (chunk->isPathable()) {
+					float modifier = found_pathable ? NEARBY_THREAT_MODIFIER : 1.0;
+					found_pathable = true;
+					if (pipeline) {
+						// added along with the decay on the pipeline worker, see LocationHandler::updateThreat
+						locH->queueThreat(chunk, getValue(e) * modifier);
 					}
-					if (chunk->isPathable()) {
-						if (!found_pathable) {
-							chunk->increaseThreat(this, *it, 1.0);
-							found_pathable = true;
-						}
-						else {
-							chunk->increaseThreat(this, *it, NEARBY_THREAT_MODIFIER);
-						}
+					else {
+						chunk->increaseThreat(this, e, modifier);
 					}
 				}
 			}
-			++it;
 		}
 	}
+}
 
+void BasicSc2Bot::checkBusyMobs() {
 	// clean up busy mobs on step
-	std::unordered_set<Mob*> busy_mobset = mobH->getBusyMobs();
-	if (!busy_mobset.empty()) {
-		for (auto it = busy_mobset.begin(); it != busy_mobset.end(); ) {
-			auto next = std::next(it);
-			Mob* m = *it;
-			auto orders = m->unit.orders;
-			if (m->hasCurrentDirective()) {
-				Directive* dir = m->getCurrentDirective();
-				if (dir) {
-					// if a busy mob has changed orders
-
-					if (!orders.empty()) {
-						auto order = orders.front();
-						if (dir->getAbilityID() != order.ability_id) {
-
-							// free up the directive it was previously assigned
-							dir->unassignMob(m);
-						}
+	// only mobs whose first order or directive changed since the last step need their directive checked
+	mobH->copyBusyMobs(busy_snapshot);
+	for (auto m : busy_snapshot) {
+		const std::vector<sc2::UnitOrder>& orders = m->unit.orders;
+		if (m->ordersChanged() && m->hasCurrentDirective()) {
+			Directive* dir = m->getCurrentDirective();
+			if (dir) {
+				// if a busy mob has changed orders
+
+				if (!orders.empty()) {
+					if (dir->getAbilityID() != orders.front().ability_id) {
+
+						// free up the directive it was previously assigned
+						dir->unassignMob(m);
 					}
 				}
 			}
-			if (orders.empty()) {
-				mobH->setMobBusy(m, false);
-				Actions()->UnitCommand(&m->unit, sc2::ABILITY_ID::STOP);
-			}
-			it = next;
+		}
+		if (orders.empty()) {
+			mobH->setMobBusy(m, false);
+			getActions()->UnitCommand(&m->unit, sc2::ABILITY_ID::STOP);
 		}
 	}
+}
 
+void BasicSc2Bot::checkIdleMobs() {
 	// tell idle mobs to process directives in their queue, if any
-	std::unordered_set<Mob*> idle_mobs = mobH->getIdleMobs();
-	if (!idle_mobs.empty()) {
-		for (auto it = idle_mobs.begin(); it != idle_mobs.end(); ) {
-			auto next = std::next(it);
-			if ((*it)->hasBundledDirective()) {
-				Directive bundled = (*it)->popBundledDirective();
-				bundled.execute(this);
-			}
-			else {
-				// Default behaviour
-				(*it)->executeDefaultDirective(this);
-			}
-			it = next;
+	// directives may change which mobs are idle, so work through a copy of the queue
+	mobH->copyIdleMobs(idle_snapshot);
+	for (auto m : idle_snapshot) {
+		if (m->hasBundledDirective()) {
+			// the rest of the bundle goes to the mob that takes this step, and is dropped if none does
+			Directive* bundled = m->popBundledDirective(this);
+			bundled->execute(this);
+			bundle_remainder.clear();
 		}
-	}
-
-	// execute directives that have their conditions satisfied
-	for (Precept s : precepts_onstep) {
-		if (s.checkTriggerConditions()) {
-			s.execute();
+		else {
+			// Default behaviour
+			m->executeDefaultDirective(this);
 		}
 	}
+}
 
-	if (gameloop % 100 == 0) {
-		onStep_100(observation);
-	}
-	if (gameloop % 1000 == 0) {
-		onStep_1000(observation);
-	}
-
-	// Filter for using sc2::GetUnits
-	sc2::Filter unseen_sieged = [this](const sc2::Unit& unit) {
-		if (unit.unit_type == sc2::UNIT_TYPEID::TERRAN_SIEGETANKSIEGED) {
-			return true;
-			if (enemy_unit_by_tag[unit.tag] == nullptr) {
-				return true;
+void BasicSc2Bot::checkPrecepts() {
+	// execute directives that have their conditions satisfied
+	// conditions on this step's observation cannot change while directives execute, so they are
+	// checked for every precept at once on the task pool. The rest are checked in order, right
+	// before each precept would execute, so the same precepts fire as when checked one by one
+	// only precepts whose time window includes this game loop are checked, and the resource
+	// conditions of every trigger are brought up to date at once
+	updateActivePrecepts(getObservation()->GetGameLoop());
+	if (thresholds) {
+		thresholds->update(getObservation());
+	}
+	precept_checks.resize(active_precepts.size());
+	long long phase_start = tracer->now();
+	pool->parallelFor(0, active_precepts.size(), PRECEPT_CHECK_GRAIN, [this](int begin_, int end_) {
+		for (int i = begin_; i < end_; ++i) {
+			Precept& p = precepts_onstep[active_precepts[i]];
+			if (!p.isDebug()) {
+				p.checkObservationConditions(precept_checks[i]);
 			}
 		}
-		return false;
-	};
+	});
+	tracer->span("OnStep::preceptsObserve", phase_start);
 
-	// sometimes siege tanks will attack from outside vision without triggering "OnUnitEnterVision"
-	auto unseen_siege_set = observation->GetUnits(sc2::Unit::Alliance::Enemy, unseen_sieged);
-	if (!unseen_siege_set.empty()) {
-		for (auto u : unseen_siege_set) {
-			addEnemyUnit(u);
+	for (size_t i = 0; i < active_precepts.size(); ++i) {
+		Precept& p = precepts_onstep[active_precepts[i]];
+		// debug output is only readable when a precept is checked in one go
+		bool met = p.isDebug() ? p.checkTriggerConditions() : p.checkTriggerConditions(precept_checks[i]);
+		if (met) {
+			p.execute();
 		}
 	}
+}
 
-	checkGasStructures();
-	checkBuildingQueues();
-	checkSiegeTanks();	
-	if (locH->chunksInitialized()) {
-		if (map_index >= 2) {
-			locH->calculateHighestThreatForChunks();
-		}
-		else if (map_index == 1 && gameloop % 25 == 0) {
-			locH->calculateHighestThreatForChunks();
-		}
+void BasicSc2Bot::updateActivePrecepts(int game_loop_) {
+	// activate precepts whose earliest game loop has come, and retire those whose latest has passed for good
+	bool activated = false;
+	while (next_activation < precept_timeline.size() && precept_windows[precept_timeline[next_activation]].earliest <= game_loop_) {
+		active_precepts.push_back(precept_timeline[next_activation]);
+		next_activation++;
+		activated = true;
+	}
+	if (activated) {
+		// precepts fire in the order they were added, which earlier ones may depend on
+		std::sort(active_precepts.begin(), active_precepts.end());
 	}
+
+	size_t before = active_precepts.size();
+	active_precepts.erase(std::remove_if(active_precepts.begin(), active_precepts.end(),
+		[this, game_loop_](int index_) { return precept_windows[index_].latest < game_loop_; }), active_precepts.end());
+	precepts_retired += before - active_precepts.size();
 }
 
 void BasicSc2Bot::checkSiegeTanks() {
 
-	// handle dealing with obnoxious siege tanks (and thors while we're at it)
+	// handle dealing with obnoxious siege tanks
 	// this function has evolved to making our stalkers, sentries and immortals
-	// move towards siege-tanks and thors in between shots, so they move out of
+	// move towards siege-tanks in between shots, so they move out of
 	// the way of other friendly units
 	// also handles phoenixes using graviton beam
 
-	// NOTE:  much of this functionality is commented out as it seems to make us lose more
-	// Leaving in the functionality for phoenixes to lift siege tanks and marauders
-	// And for stalkers to blink onto sieged tanks to get inside their minimum range
-
-	auto obs = Observation();
-	auto gameloop = obs->GetGameLoop();
-	//auto enemies = getEnemyUnits();
-	auto immortals = mobH->filterByUnitType(mobH->getMobs(), sc2::UNIT_TYPEID::PROTOSS_IMMORTAL);
-	auto stalkers = mobH->filterByUnitType(mobH->getMobs(), sc2::UNIT_TYPEID::PROTOSS_STALKER);
-	auto phoenixes = mobH->filterByUnitType(mobH->getMobs(), sc2::UNIT_TYPEID::PROTOSS_PHOENIX);
-	auto sentries = mobH->filterByUnitType(mobH->getMobs(), sc2::UNIT_TYPEID::PROTOSS_SENTRY);
-	immortals = mobH->filterNotOnCooldown(immortals);
-	stalkers = mobH->filterNotOnCooldown(stalkers);
-	phoenixes = mobH->filterNotOnCooldown(phoenixes);
-	sentries = mobH->filterNotOnCooldown(sentries);
-
-	// use the API's GetUnits instead because pointers to enemy units need to be current to function properly
-	auto enemies = obs->GetUnits(sc2::Unit::Alliance::Enemy);
-	
-	std::unordered_set<const sc2::Unit*> tanks_s;  // sieged
-	std::unordered_set<const sc2::Unit*> tanks_u;  // unsieged
-	std::unordered_set<const sc2::Unit*> thors; 
-	std::unordered_set<const sc2::Unit*> marauders;
-	for (auto e : enemies) {
-		auto disp_type = e->display_type;
-
-		if (disp_type == sc2::Unit::DisplayType::Visible) {
-			if (e->is_alive) {
-				if (e->unit_type == sc2::UNIT_TYPEID::TERRAN_SIEGETANKSIEGED) {
-					tanks_s.insert(e);
-				} else if (e->unit_type == sc2::UNIT_TYPEID::TERRAN_SIEGETANK) {
-					tanks_u.insert(e);
-				}
-				else if (e->unit_type == sc2::UNIT_TYPEID::TERRAN_THOR) {
-					thors.insert(e);
-				} 
-				else if (e->unit_type == sc2::UNIT_TYPEID::TERRAN_MARAUDER) {
-					marauders.insert(e);
-				}
-			}
-		}
-		if (disp_type == sc2::Unit::DisplayType::Snapshot) {
+	// the routines themselves are target rules, see registerMicroRules
+	// routines for thors and for kiting engaged targets were removed as they seemed to make us lose more
+
+	// the enemy tracker's current units are from this step's observation, so their pointers are current
+	const sc2::Units& current = enemies->getCurrentUnits();
+
+	for (auto e : current) {
+		if (e->display_type == sc2::Unit::DisplayType::Snapshot) {
 			// apply a small amount of threat to structures in snapshot so they will be searched
 			// before unseen locations
 
@@ -1126,607 +1518,92 @@ void BasicSc2Bot::checkSiegeTanks() {
 		}
 	}
 
-	bool have_blink = haveUpgrade(sc2::UPGRADE_ID::BLINKTECH);
-	
-	// if siege tanks in siege mode are visible
-	if (!tanks_s.empty()) {
-
-		// phoenixes prioritize using graviton beam on siege tanks in siege mode
-		if (!phoenixes.empty()) {
-			// popualte set of those not already affected by graviton beam
-			std::unordered_set<const sc2::Unit*> tanks_valid;
-			for (auto t : tanks_s) {
-				auto buffs = t->buffs;
-				if (buffs.empty()) {
-					tanks_valid.insert(t);
-					continue;
-				}
-				for (auto b : buffs) {
-					if (b.ToType() == sc2::BUFF_ID::GRAVITONBEAM) {
-						continue;
-					}
-				}
-				tanks_valid.insert(t);
-			}
-
-			if (!tanks_valid.empty()) {
-				std::unordered_set<Mob*> nearby_ph;
-				for (auto p : phoenixes) {
-					for (auto t : tanks_valid) {
-						if (sc2::DistanceSquared2D(t->pos, p->unit.pos) <= 144.0F) {
-							nearby_ph.insert(p);
-							break;
-						}
-					}
-				}
-				if (!nearby_ph.empty()) {
-					for (auto ph : nearby_ph) {
-						float dist_to_siege = std::numeric_limits<float>::max();
-						const sc2::Unit* closest = nullptr;
-						for (auto t : tanks_valid) {
-							float dist = (sc2::DistanceSquared2D(t->pos, ph->unit.pos));
-							if (dist < dist_to_siege) {
-								dist_to_siege = dist;
-								closest = t;
-							}
-						}
-						if (dist_to_siege > 16.0F && ph->unit.weapon_cooldown > std::max(STEP_SIZE, 3) && canUnitUseAbility(ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM)) {
-							Actions()->UnitCommand(&ph->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-							ph->giveCooldown(this, std::max(STEP_SIZE, 3)-1); // 22 steps is approx one second
-						}
-						if (dist_to_siege <= 16.0F) {
-							if (canUnitUseAbility(ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM)) {
-								Actions()->UnitCommand(&ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM, closest);
-								ph->giveCooldown(this, 160); // stop this mob from getting commands for the duration of beam
-							}
-						}
-					}
-				}
-			}
-		}
-
-		// player immortals exist
-		// have immortals move towards siege tanks in siege mode in between auto attacks so
-		// they can move inside their minimum range, and should automatically focus fire them once close enough
-		if (!immortals.empty()) {
-			std::unordered_set<Mob*> nearby_im;
-			for (auto i : immortals) {
-				for (auto t : tanks_s) {
-					if (sc2::DistanceSquared2D(t->pos, i->unit.pos) <= 144.0F) {
-						nearby_im.insert(i);
-						break;
-					}
-				}
-			}
-			if (!nearby_im.empty()) {
-				for (auto im : nearby_im) {
-					float dist_to_siege = std::numeric_limits<float>::max();
-					const sc2::Unit* closest = nullptr;
-					for (auto t : tanks_s) {
-						float dist = (sc2::DistanceSquared2D(t->pos, im->unit.pos));
-						if (dist < dist_to_siege) {
-							dist_to_siege = dist;
-							closest = t;
-						}
-					}
-					if (dist_to_siege > 36.0F && im->unit.weapon_cooldown > 3) {
-						Actions()->UnitCommand(&im->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-						im->giveCooldown(this, im->unit.weapon_cooldown * 0.8);
-						if (dist_to_siege <= 36.0F) {
-							if (im->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-								Actions()->UnitCommand(&im->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-								im->giveCooldown(this, im->unit.weapon_cooldown - 1);
-							}
-						}
-					}
-				}
-			}
-		}
-
-			
-		// player stalkers exist
-		// make stalkers move towards siege tanks in siege mode in between auto attacks
-		// also blink on top of them when within 10.0 range
-		if (!stalkers.empty()) {
-			std::unordered_set<Mob*> nearby_st;
-			for (auto s : stalkers) {
-				for (auto t : tanks_s) {
-					if (sc2::DistanceSquared2D(t->pos, s->unit.pos) <= 324.0F) {
-						nearby_st.insert(s);
-						break;
-					}
-				}
-			}
-			if (!nearby_st.empty()) {
-				for (auto st : nearby_st) {
-					float dist_to_siege = std::numeric_limits<float>::max();
-					const sc2::Unit* closest = nullptr;
-					for (auto t : tanks_s) {
-						float dist = (sc2::DistanceSquared2D(t->pos, st->unit.pos));
-						if (dist < dist_to_siege) {
-							dist_to_siege = dist;
-							closest = t;
-						}
-					}
-
-					if (st->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						if (dist_to_siege > 4.0F) {
-							if (have_blink && canUnitUseAbility(st->unit, sc2::ABILITY_ID::EFFECT_BLINK) && dist_to_siege > 4.5F && dist_to_siege <= 97.0F) {
-								Actions()->UnitCommand(&st->unit, sc2::ABILITY_ID::EFFECT_BLINK, closest->pos);
-							}
-							else {
-								Actions()->UnitCommand(&st->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-								st->giveCooldown(this, st->unit.weapon_cooldown - 1);
-							}
-						}
-					}
-				}
-			}
-		}
-			
-
-			
-			// player sentries exist
-		if (!sentries.empty()) {
-			std::unordered_set<Mob*> nearby_se;
-			for (auto s : sentries) {
-				for (auto t : tanks_s) {
-					if (sc2::DistanceSquared2D(t->pos, s->unit.pos) <= 324.0F) {
-						nearby_se.insert(s);
-						break;
-					}
-				}
-			}
-			if (!nearby_se.empty()) {
-				for (auto se : nearby_se) {
-					float dist_to_siege = std::numeric_limits<float>::max();
-					const sc2::Unit* closest = nullptr;
-					for (auto t : tanks_s) {
-						float dist = (sc2::DistanceSquared2D(t->pos, se->unit.pos));
-						if (dist < dist_to_siege) {
-							dist_to_siege = dist;
-							closest = t;
-						}
-					}
-					if (dist_to_siege > 36.0F && se->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						Actions()->UnitCommand(&se->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-						se->giveCooldown(this, se->unit.weapon_cooldown * 0.8);
-						if (dist_to_siege <= 36.0F) {
-							if (se->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-								Actions()->UnitCommand(&se->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-								se->giveCooldown(this, se->unit.weapon_cooldown - 1);
-							}
-						}
-					}
-				}
-			}
-		} 	
-	}
-
-	// remove those that have already been issued an order
-	immortals = mobH->filterNotOnCooldown(immortals);
-	stalkers = mobH->filterNotOnCooldown(stalkers);
-	phoenixes = mobH->filterNotOnCooldown(phoenixes);
-	sentries = mobH->filterNotOnCooldown(sentries);
-
-	// if unsieged siege tanks are visible
-	if (!tanks_u.empty()) {
-
-		
-		/*
-		// player immortals exist
-		if (!immortals.empty()) {
-			std::unordered_set<Mob*> nearby_im;
-			for (auto i : immortals) {
-				for (auto t : tanks_u) {
-					if (sc2::DistanceSquared2D(t->pos, i->unit.pos) <= 324.0F) {
-						nearby_im.insert(i);
-						break;
-					}
-				}
-			}
-			if (!nearby_im.empty()) {
-				for (auto im : nearby_im) {
-					float dist_to_siege = std::numeric_limits<float>::max();
-					const sc2::Unit* closest = nullptr;
-					for (auto t : tanks_u) {
-						float dist = (sc2::DistanceSquared2D(t->pos, im->unit.pos));
-						if (dist < dist_to_siege) {
-							dist_to_siege = dist;
-							closest = t;
-						}
-					}
-					if (dist_to_siege > 36.0F && im->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						Actions()->UnitCommand(&im->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-						im->giveCooldown(this, im->unit.weapon_cooldown - 1); // 22 steps is approx one second
-					}
-					if (dist_to_siege <= 36.0F) {
-						if (im->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-							Actions()->UnitCommand(&im->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-							im->giveCooldown(this, im->unit.weapon_cooldown - 1); // 22 steps is approx one second
-						}
-					}
-				}
-			}
-		}
-		*/
-		
-
-		// player stalkers exist
-		// get stalkers to move towards the siege tanks but not too close
-		// get in range to blink in if they go siege mode
-		if (!stalkers.empty()) {
-			std::unordered_set<Mob*> nearby_st;
-			for (auto s : stalkers) {
-				for (auto t : tanks_s) {
-					if (sc2::DistanceSquared2D(t->pos, s->unit.pos) <= 324.0F && sc2::DistanceSquared2D(t->pos, s->unit.pos) > 52.0F) {
-						nearby_st.insert(s);
-						break;
-					}
-				}
-			}
-			if (!nearby_st.empty()) {
-				for (auto st : nearby_st) {
-					float dist_to_siege = std::numeric_limits<float>::max();
-					const sc2::Unit* closest = nullptr;
-					for (auto t : tanks_s) {
-						float dist = (sc2::DistanceSquared2D(t->pos, st->unit.pos));
-						if (dist < dist_to_siege) {
-							dist_to_siege = dist;
-							closest = t;
-						}
-					}
+	targeter->update(current);
+	targeter->resolve();
+}
 
-					if (st->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						if (dist_to_siege > 4.0F) {
-
-							// commented this out, so that stalkers only blink onto siege tanks if they are sieged
-
-							/*
-							if (have_blink && canUnitUseAbility(st->unit, sc2::ABILITY_ID::EFFECT_BLINK) && dist_to_siege > 9.0F && dist_to_siege <= 100.0F) {
-								Actions()->UnitCommand(&st->unit, sc2::ABILITY_ID::EFFECT_BLINK, closest->pos);
-							}
-							else {
-								Actions()->UnitCommand(&st->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-								st->giveCooldown(this, st->unit.weapon_cooldown - 1); // 22 steps is approx one second
-							} */
-							Actions()->UnitCommand(&st->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-							st->giveCooldown(this, st->unit.weapon_cooldown - 1); // 22 steps is approx one second
-						}
-					}
-				}
-			}
-		}
+void BasicSc2Bot::registerMicroRules() {
+	// rules are resolved in this order, and a mob given an order by one rule is skipped by the rest this step
+	std::vector<sc2::UNIT_TYPEID> tanks_s = { sc2::UNIT_TYPEID::TERRAN_SIEGETANKSIEGED };
+	std::vector<sc2::UNIT_TYPEID> tanks_u = { sc2::UNIT_TYPEID::TERRAN_SIEGETANK };
+	std::vector<sc2::UNIT_TYPEID> marauders = { sc2::UNIT_TYPEID::TERRAN_MARAUDER };
 
-		/*
-		// player sentries exist
-		if (!sentries.empty()) {
-			std::unordered_set<Mob*> nearby_se;
-			for (auto s : sentries) {
-				for (auto t : tanks_u) {
-					if (sc2::DistanceSquared2D(t->pos, s->unit.pos) <= 144.0F) {
-						nearby_se.insert(s);
-						break;
-					}
-				}
-			}
-			if (!nearby_se.empty()) {
-				for (auto se : nearby_se) {
-					float dist_to_siege = std::numeric_limits<float>::max();
-					const sc2::Unit* closest = nullptr;
-					for (auto t : tanks_u) {
-						float dist = (sc2::DistanceSquared2D(t->pos, se->unit.pos));
-						if (dist < dist_to_siege) {
-							dist_to_siege = dist;
-							closest = t;
-						}
-					}
-					if (dist_to_siege > 36.0F && se->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						Actions()->UnitCommand(&se->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-						se->giveCooldown(this, se->unit.weapon_cooldown - 1);
-						if (dist_to_siege <= 36.0F) {
-							if (se->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-								Actions()->UnitCommand(&se->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-								se->giveCooldown(this, se->unit.weapon_cooldown - 1);
-							}
-						}
-					}
-				}
+	// phoenixes move towards a target in between shots and lift it with graviton beam once close enough
+	auto graviton = [this](int move_cooldown_) {
+		return [this, move_cooldown_](Mob* ph, const sc2::Unit* target, float dist) {
+			if (!canUnitUseAbility(ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM))
+				return false;
+			if (dist > 16.0F && ph->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
+				getActions()->UnitCommand(&ph->unit, sc2::ABILITY_ID::GENERAL_MOVE, target->pos);
+				ph->giveCooldown(this, move_cooldown_); // 22 steps is approx one second
+				return true;
 			}
-		}
-		*/
-
-		if (!phoenixes.empty()) {
-
-			// populate set of those not already affected by graviton beam
-			std::unordered_set<const sc2::Unit*> tanks_valid;
-			for (auto t : tanks_u) {
-				auto buffs = t->buffs;
-				if (buffs.empty()) {
-					tanks_valid.insert(t);
-					continue;
-				}
-				for (auto b : buffs) {
-					if (b.ToType() == sc2::BUFF_ID::GRAVITONBEAM) {
-						continue;
-					}
-				}
-				tanks_valid.insert(t);
+			if (dist <= 16.0F) {
+				getActions()->UnitCommand(&ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM, target);
+				ph->giveCooldown(this, 160); // stop this mob from getting commands for the duration of beam
+				return true;
 			}
+			return false;
+		};
+	};
 
-			if (!tanks_valid.empty()) {
-				std::unordered_set<Mob*> nearby_ph;
-				for (auto p : phoenixes) {
-					for (auto t : tanks_valid) {
-						if (sc2::DistanceSquared2D(t->pos, p->unit.pos) <= 144.0F) {
-							nearby_ph.insert(p);
-							break;
-						}
-					}
-				}
-				if (!nearby_ph.empty()) {
-					for (auto ph : nearby_ph) {
-						float dist_to_siege = std::numeric_limits<float>::max();
-						const sc2::Unit* closest = nullptr;
-						for (auto t : tanks_valid) {
-							float dist = (sc2::DistanceSquared2D(t->pos, ph->unit.pos));
-							if (dist < dist_to_siege) {
-								dist_to_siege = dist;
-								closest = t;
-							}
-						}
-						if (dist_to_siege > 16.0F && ph->unit.weapon_cooldown > std::max(STEP_SIZE, 3) && canUnitUseAbility(ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM)) {
-							Actions()->UnitCommand(&ph->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-							ph->giveCooldown(this, 5); // 22 steps is approx one second
-						}
-						if (dist_to_siege <= 16.0F) {
-							if (canUnitUseAbility(ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM)) {
-								Actions()->UnitCommand(&ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM, closest);
-								ph->giveCooldown(this, 160); // stop this mob from getting commands for the duration of beam
-							}
-						}
-					}
-				}
-			}
-		}
-	}
+	// phoenixes prioritize using graviton beam on siege tanks in siege mode
+	targeter->registerRule("phoenix_sieged", sc2::UNIT_TYPEID::PROTOSS_PHOENIX, tanks_s, 12.0F, graviton(std::max(STEP_SIZE, 3) - 1));
 
-	// remove those that have already been issued an order
-	immortals = mobH->filterNotOnCooldown(immortals);
-	stalkers = mobH->filterNotOnCooldown(stalkers);
-	phoenixes = mobH->filterNotOnCooldown(phoenixes);
-	sentries = mobH->filterNotOnCooldown(sentries);
-	
-	
-	// leaving this next block commented in case we want to use it
-	// for now it seems like we are losing more often with it
-	
-	/*   
-	if (!thors.empty()) {
-
-		// player immortals exist
-		if (!immortals.empty()) {
-			std::unordered_set<Mob*> nearby_im;
-			for (auto i : immortals) {
-				for (auto t : thors) {
-					if (sc2::DistanceSquared2D(t->pos, i->unit.pos) <= 144.0F) {
-						nearby_im.insert(i);
-						break;
-					}
-				}
-			}
-			if (!nearby_im.empty()) {
-				for (auto im : nearby_im) {
-					float dist_to_thor = std::numeric_limits<float>::max();
-					const sc2::Unit* closest = nullptr;
-					for (auto t : thors) {
-						float dist = (sc2::DistanceSquared2D(t->pos, im->unit.pos));
-						if (dist < dist_to_thor) {
-							dist_to_thor = dist;
-							closest = t;
-						}
-					}
-					if (dist_to_thor > 36.0F && im->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						Actions()->UnitCommand(&im->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-						im->giveCooldown(this, im->unit.weapon_cooldown - 1); // 22 steps is approx one second
-					}
-					if (dist_to_thor <= 36.0F) {
-						if (im->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-							Actions()->UnitCommand(&im->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-							im->giveCooldown(this, im->unit.weapon_cooldown - 1); // 22 steps is approx one second
-						}
-					}
-				}
-			}
-		}
-		// player sentries exist
-		if (!sentries.empty()) {
-			std::unordered_set<Mob*> nearby_se;
-			for (auto s : sentries) {
-				for (auto t : thors) {
-					if (sc2::DistanceSquared2D(t->pos, s->unit.pos) <= 144.0F) {
-						nearby_se.insert(s);
-						break;
-					}
-				}
+	// have immortals move towards siege tanks in siege mode in between auto attacks so
+	// they can move inside their minimum range, and should automatically focus fire them once close enough
+	targeter->registerRule("immortal_sieged", sc2::UNIT_TYPEID::PROTOSS_IMMORTAL, tanks_s, 12.0F,
+		[this](Mob* im, const sc2::Unit* target, float dist) {
+			if (dist > 36.0F && im->unit.weapon_cooldown > 3) {
+				getActions()->UnitCommand(&im->unit, sc2::ABILITY_ID::GENERAL_MOVE, target->pos);
+				im->giveCooldown(this, im->unit.weapon_cooldown * 0.8);
+				return true;
 			}
-			if (!nearby_se.empty()) {
-				for (auto se : nearby_se) {
-					float dist_to_thor = std::numeric_limits<float>::max();
-					const sc2::Unit* closest = nullptr;
-					for (auto t : thors) {
-						float dist = (sc2::DistanceSquared2D(t->pos, se->unit.pos));
-						if (dist < dist_to_thor) {
-							dist_to_thor = dist;
-							closest = t;
-						}
-					}
-					if (dist_to_thor > 36.0F && se->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						Actions()->UnitCommand(&se->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-						se->giveCooldown(this, se->unit.weapon_cooldown - 1);
-						if (dist_to_thor <= 36.0F) {
-							if (se->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-								Actions()->UnitCommand(&se->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-								se->giveCooldown(this, se->unit.weapon_cooldown - 1);
-							}
-						}
-					}
-				}
+			return false;
+		});
+
+	// make stalkers move towards siege tanks in siege mode in between auto attacks
+	// also blink on top of them when within 10.0 range
+	targeter->registerRule("stalker_sieged", sc2::UNIT_TYPEID::PROTOSS_STALKER, tanks_s, 18.0F,
+		[this](Mob* st, const sc2::Unit* target, float dist) {
+			if (st->unit.weapon_cooldown <= std::max(STEP_SIZE, 3) || dist <= 4.0F)
+				return false;
+			if (haveUpgrade(sc2::UPGRADE_ID::BLINKTECH) && canUnitUseAbility(st->unit, sc2::ABILITY_ID::EFFECT_BLINK) && dist > 4.5F && dist <= 97.0F) {
+				getActions()->UnitCommand(&st->unit, sc2::ABILITY_ID::EFFECT_BLINK, target->pos);
 			}
-		}
-	}
-
-	*/
-
-	// remove those that have already been issued an order
-	immortals = mobH->filterNotOnCooldown(immortals);
-	stalkers = mobH->filterNotOnCooldown(stalkers);
-	phoenixes = mobH->filterNotOnCooldown(phoenixes);
-	sentries = mobH->filterNotOnCooldown(sentries);
-
-	if (!marauders.empty()) {
-
-		// have phoenixes target marauders with graivton if there are no siege tanks. There will usually be one or the other.
-
-		if (!phoenixes.empty()) {
-			// popualte set of those not already affected by graviton beam
-			std::unordered_set<const sc2::Unit*> mar_valid;
-			for (auto m : marauders) {
-				auto buffs = m->buffs;
-				if (buffs.empty()) {
-					mar_valid.insert(m);
-					continue;
-				}
-				for (auto b : buffs) {
-					if (b.ToType() == sc2::BUFF_ID::GRAVITONBEAM) {
-						continue;
-					}
-				}
-				mar_valid.insert(m);
-			}
-
-			if (!mar_valid.empty()) {
-
-				std::unordered_set<Mob*> nearby_ph;
-				for (auto p : phoenixes) {
-					for (auto m : mar_valid) {
-						if (sc2::DistanceSquared2D(m->pos, p->unit.pos) <= 144.0F) {
-							nearby_ph.insert(p);
-							break;
-						}
-					}
-				}
-				if (!nearby_ph.empty()) {
-					for (auto ph : nearby_ph) {
-						float dist_to_mar = std::numeric_limits<float>::max();
-						const sc2::Unit* closest = nullptr;
-						for (auto m : mar_valid) {
-							float dist = (sc2::DistanceSquared2D(m->pos, ph->unit.pos));
-							if (dist < dist_to_mar) {
-								dist_to_mar = dist;
-								closest = m;
-							}
-						}
-						if (dist_to_mar > 16.0F && ph->unit.weapon_cooldown > std::max(STEP_SIZE, 3) && canUnitUseAbility(ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM)) {
-							Actions()->UnitCommand(&ph->unit, sc2::ABILITY_ID::GENERAL_MOVE, closest->pos);
-							ph->giveCooldown(this, 5); // 22 steps is approx one second
-						}
-						if (dist_to_mar <= 16.0F) {
-							if (canUnitUseAbility(ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM)) {
-								Actions()->UnitCommand(&ph->unit, sc2::ABILITY_ID::EFFECT_GRAVITONBEAM, closest);
-								ph->giveCooldown(this, 160); // stop this mob from getting commands for the duration of beam
-							}
-						}
-					}
-				}
+			else {
+				getActions()->UnitCommand(&st->unit, sc2::ABILITY_ID::GENERAL_MOVE, target->pos);
+				st->giveCooldown(this, st->unit.weapon_cooldown - 1);
 			}
-		}
-	}
-	immortals = mobH->filterNotOnCooldown(immortals);
-	stalkers = mobH->filterNotOnCooldown(stalkers);
-	phoenixes = mobH->filterNotOnCooldown(phoenixes);
-	sentries = mobH->filterNotOnCooldown(sentries);
+			return true;
+		});
 
-	// make these units move towards their targets in between auto attacks
-	/*
-	if (!sentries.empty()) {
-		for (auto se : sentries) {
-			sc2::Tag engaged_tag = se->unit.engaged_target_tag;
-			if (engaged_tag != 0) {
-				auto target = obs->GetUnit(engaged_tag);
-				if (target != nullptr) {
-					if (se->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						Actions()->UnitCommand(&se->unit, sc2::ABILITY_ID::GENERAL_MOVE, target->pos);
-						se->giveCooldown(this, se->unit.weapon_cooldown - 1);
-					}
-				}
-			}
-		}
-	}
-	if (!stalkers.empty()) {
-		for (auto st : stalkers) {
-			sc2::Tag engaged_tag = st->unit.engaged_target_tag;
-			if (engaged_tag != 0) {
-				auto target = obs->GetUnit(engaged_tag);
-				if (target != nullptr) {
-					if (st->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						Actions()->UnitCommand(&st->unit, sc2::ABILITY_ID::GENERAL_MOVE, target->pos);
-						st->giveCooldown(this, st->unit.weapon_cooldown - 1);
-					}
-				}
+	targeter->registerRule("sentry_sieged", sc2::UNIT_TYPEID::PROTOSS_SENTRY, tanks_s, 18.0F,
+		[this](Mob* se, const sc2::Unit* target, float dist) {
+			if (dist > 36.0F && se->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
+				getActions()->UnitCommand(&se->unit, sc2::ABILITY_ID::GENERAL_MOVE, target->pos);
+				se->giveCooldown(this, se->unit.weapon_cooldown * 0.8);
+				return true;
 			}
-		}
-	}
-	if (!immortals.empty()) {
-		for (auto im : immortals) {
-			sc2::Tag engaged_tag = im->unit.engaged_target_tag;
-			if (engaged_tag != 0) {
-				auto target = obs->GetUnit(engaged_tag);
-				if (target != nullptr) {
-					if (im->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-						Actions()->UnitCommand(&im->unit, sc2::ABILITY_ID::GENERAL_MOVE, target->pos);
-						im->giveCooldown(this, im->unit.weapon_cooldown - 1);
-					}
-				}
+			return false;
+		});
+
+	// get stalkers to move towards unsieged siege tanks but not too close
+	// get in range to blink in if they go siege mode, they only blink onto siege tanks if they are sieged
+	targeter->registerRule("stalker_unsieged", sc2::UNIT_TYPEID::PROTOSS_STALKER, tanks_u, 18.0F,
+		[this](Mob* st, const sc2::Unit* target, float dist) {
+			if (st->unit.weapon_cooldown > std::max(STEP_SIZE, 3) && dist > 4.0F) {
+				getActions()->UnitCommand(&st->unit, sc2::ABILITY_ID::GENERAL_MOVE, target->pos);
+				st->giveCooldown(this, st->unit.weapon_cooldown - 1); // 22 steps is approx one second
+				return true;
 			}
-		}
-	}
+			return false;
+		}, std::sqrt(52.0F));
 
-	// make collosus move back to max range if possible
-
-	auto collossi = mobH->filterByUnitType(mobH->getMobs(), sc2::UNIT_TYPEID::PROTOSS_COLOSSUS);
-	collossi = mobH->filterNotOnCooldown(collossi);
-
-	float co_range = 7.0;
-	if (haveUpgrade(sc2::UPGRADE_ID::EXTENDEDTHERMALLANCE)) {
-		co_range = 9.0;
-	}
+	targeter->registerRule("phoenix_unsieged", sc2::UNIT_TYPEID::PROTOSS_PHOENIX, tanks_u, 12.0F, graviton(5));
 
-	if (!collossi.empty()) {
-		for (auto co : collossi) {
-			sc2::Tag engaged_tag = co->unit.engaged_target_tag;
-			if (engaged_tag != 0) {
-				auto target = obs->GetUnit(engaged_tag);
-				if (target != nullptr) {
-					if (co->unit.weapon_cooldown > std::max(STEP_SIZE, 3)) {
-
-						// if engaged target is not at max range, move backward if pathable
-						if (sc2::DistanceSquared2D(co->unit.pos, target->pos) < pow(co_range, 2)) {
-							sc2::Point2D pos = co->unit.pos;
-							float facing = co->unit.facing;
-							sc2::Point2D offset(0.5 * cos(facing), 0.5 * sin(facing)); // calculate point 0.5 behind the unit
-							sc2::Point2D behind = pos + offset;
-							if (obs->IsPathable(behind)) {
-								Actions()->UnitCommand(&co->unit, sc2::ABILITY_ID::GENERAL_MOVE, behind);
-								co->giveCooldown(this, co->unit.weapon_cooldown - 1);
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-	*/
+	// have phoenixes target marauders with graviton if there are no siege tanks. There will usually be one or the other.
+	targeter->registerRule("phoenix_marauder", sc2::UNIT_TYPEID::PROTOSS_PHOENIX, marauders, 12.0F, graviton(5));
 }
 
 void BasicSc2Bot::checkGasStructures() {
@@ -1760,13 +1637,13 @@ void BasicSc2Bot::checkGasStructures() {
 	}
 
 	// if there are less than 6 mineral gatherers, don't assign them to gas. We don't want the economy to stall.
-	std::unordered_set<Mob*> mineral_gatherers = mobH->filterByFlag(mobH->getMobs(), FLAGS::IS_MINERAL_GATHERER);
+	std::unordered_set<Mob*> mineral_gatherers = mobH->getMobsWithFlags({ FLAGS::IS_MINERAL_GATHERER });
 	if (mineral_gatherers.size() < 6)
 		return;
 
 	for (auto g : gas_structures) {
 		if (g->getHarvesterCount() < 3) {
-			if (mobH->filterByFlag(mobH->getMobs(), FLAGS::IS_MINERAL_GATHERER).size() > 3) {
+			if (mobH->getMobsWithFlags({ FLAGS::IS_MINERAL_GATHERER }).size() > 3) {
 				g->grabNearbyGasHarvester(this);
 			}
 		}
@@ -1797,7 +1674,10 @@ std::string BasicSc2Bot::gameTime(int steps_)
 }
 
 void BasicSc2Bot::OnUnitCreated(const sc2::Unit* unit) {
-	const sc2::ObservationInterface* observation = Observation();
+	const sc2::ObservationInterface* observation = getObservation();
+	if (recorder) {
+		recorder->recordEvent("CREATED", unit);
+	}
 
 	// keep a record of the order and time in which units were created for evaluation purposes
 	units_created.push_back(std::make_pair<int, sc2::UNIT_TYPEID>(observation->GetGameLoop(), unit->unit_type)); 
@@ -1842,10 +1722,10 @@ void BasicSc2Bot::OnUnitCreated(const sc2::Unit* unit) {
 				|*   while the assimilator is under construction.                                           *|
 				|*   For some reason it does not trigger as idle after building this particular structure   */
 
-				std::unordered_set<Mob*> gas_builders = mobH->filterByFlag(mobH->getMobs(), FLAGS::BUILDING_GAS);
+				std::unordered_set<Mob*> gas_builders = mobH->getMobsWithFlags({ FLAGS::BUILDING_GAS });
 				Mob* gas_builder = Directive::getClosestToLocation(gas_builders, unit->pos);
 				gas_builder->removeFlag(FLAGS::BUILDING_GAS);
-				Actions()->UnitCommand(&gas_builder->unit, sc2::ABILITY_ID::STOP);
+				getActions()->UnitCommand(&gas_builder->unit, sc2::ABILITY_ID::STOP);
 			}
 		}
 	}
@@ -1877,8 +1757,7 @@ void BasicSc2Bot::OnUnitCreated(const sc2::Unit* unit) {
 		new_mob.setAssignedLocation(new_mob.getHomeLocation());
 		Directive directive_get_minerals_near_birth(Directive::DEFAULT_DIRECTIVE, Directive::GET_MINERALS_NEAR_LOCATION,
 			new_mob.unit.unit_type, sc2::ABILITY_ID::HARVEST_GATHER, ASSIGNED_LOCATION);
-		storeDirective(directive_get_minerals_near_birth);
-		Directive* dir = getLastStoredDirective();
+		Directive* dir = acquireDefaultDirective(directive_get_minerals_near_birth);
 		new_mob.assignDefaultDirective(this, dir);
 	}
 	else {
@@ -1900,6 +1779,9 @@ void BasicSc2Bot::OnUnitCreated(const sc2::Unit* unit) {
 }
 
 void BasicSc2Bot::OnBuildingConstructionComplete(const sc2::Unit* unit) {
+	if (recorder) {
+		recorder->recordEvent("COMPLETE", unit);
+	}
 
 	if (!initialized)
 		return;
@@ -1912,7 +1794,7 @@ void BasicSc2Bot::OnBuildingConstructionComplete(const sc2::Unit* unit) {
 		unit_type == sc2::UNIT_TYPEID::ZERG_HATCHERY) {
 		int base_index = locH->getIndexOfClosestBase(unit->pos);
 		is_townhall = true;
-		std::cout << "[" << Observation()->GetGameLoop() << "] Expansion " << base_index << " has been activated." << std::endl;
+		std::cout << "[" << getObservation()->GetGameLoop() << "] Expansion " << base_index << " has been activated." << std::endl;
 		locH->bases[base_index].setActive();
 		
 		// after an expansion is created, it will grab workers from a nearby townhall to instantly mine its minerals
@@ -1935,16 +1817,19 @@ void BasicSc2Bot::OnBuildingConstructionComplete(const sc2::Unit* unit) {
 	if (!is_townhall) {
 		int nearest_base_idx = locH->getIndexOfClosestBase(unit->pos);
 		sc2::Point2D rally_point = locH->bases[nearest_base_idx].getRallyPoint();
-		Actions()->UnitCommand(unit, sc2::ABILITY_ID::SMART, rally_point);
+		getActions()->UnitCommand(unit, sc2::ABILITY_ID::SMART, rally_point);
 	}
 }
 
 void BasicSc2Bot::OnUnitDamaged(const sc2::Unit* unit, float health, float shields) {
+	if (recorder) {
+		recorder->recordEvent("DAMAGED", unit, health, shields);
+	}
 
 	if (!initialized)
 		return;
 
-	const sc2::ObservationInterface* observation = Observation();
+	const sc2::ObservationInterface* observation = getObservation();
 	// make Stalkers Blink away if low health
 	// can turn the tide of a close battle as opponents will target healthier units instead
 	if (unit->unit_type == sc2::UNIT_TYPEID::PROTOSS_STALKER) {
@@ -1953,7 +1838,7 @@ void BasicSc2Bot::OnUnitDamaged(const sc2::Unit* unit, float health, float shiel
 				// check if Blink is on cooldown
 				if (canUnitUseAbility(*unit, sc2::ABILITY_ID::EFFECT_BLINK)) {
 					//std::cout << "(blink)";
-					Actions()->UnitCommand(unit, sc2::ABILITY_ID::EFFECT_BLINK, locH->bases[0].getTownhall());
+					getActions()->UnitCommand(unit, sc2::ABILITY_ID::EFFECT_BLINK, locH->bases[0].getTownhall());
 				}
 			}
 		}
@@ -1978,7 +1863,7 @@ void BasicSc2Bot::OnUnitDamaged(const sc2::Unit* unit, float health, float shiel
 				[this](Mob* m) { return canUnitUseAbility(m->unit, sc2::ABILITY_ID::EFFECT_GUARDIANSHIELD); });
 			if (!sentries_filter.empty()) {
 				Mob* sentry = *sentries_filter.begin();
-				Actions()->UnitCommand(&sentry->unit, sc2::ABILITY_ID::EFFECT_GUARDIANSHIELD);
+				getActions()->UnitCommand(&sentry->unit, sc2::ABILITY_ID::EFFECT_GUARDIANSHIELD);
 			}
 		}
 	}
@@ -2005,6 +1890,9 @@ void BasicSc2Bot::OnUnitDamaged(const sc2::Unit* unit, float health, float shiel
 }
 
 void BasicSc2Bot::OnUnitIdle(const sc2::Unit* unit) {
+	if (recorder) {
+		recorder->recordEvent("IDLE", unit);
+	}
 
 	if (!initialized)
 		return;
@@ -2025,7 +1913,10 @@ void BasicSc2Bot::OnUnitIdle(const sc2::Unit* unit) {
 }
 
 void BasicSc2Bot::OnUnitDestroyed(const sc2::Unit* unit) {
-	
+	if (recorder) {
+		recorder->recordEvent("DESTROYED", unit);
+	}
+
 	if (!initialized)
 		return;
 
@@ -2059,26 +1950,28 @@ void BasicSc2Bot::OnUnitDestroyed(const sc2::Unit* unit) {
 
 		if (time_first_attacked == -1) {
 			if (sc2::DistanceSquared2D(unit->pos, locH->getStartLocation()) <= 50.0F) {
-				int gameloop = Observation()->GetGameLoop();
+				int gameloop = getObservation()->GetGameLoop();
 				time_first_attacked = gameloop;
 				/*std::cout << "[" << gameloop << "] First attack by opponent at " << gameTime(gameloop) << "." << std::endl; */
 			}
 		}
 	}
 	if (unit->alliance == sc2::Unit::Alliance::Enemy) {
-		enemy_unit_by_tag.erase(unit->tag);
+		enemies->remove(unit->tag);
 	}
 }
 
 void BasicSc2Bot::OnUnitEnterVision(const sc2::Unit* unit) {
+	if (recorder) {
+		recorder->recordEvent("VISION", unit);
+	}
 
 	if (!initialized)
 		return;
 
 	// figure out enemy race when we first see an enemy units
-	addEnemyUnit(unit);
 	if (enemy_race == sc2::Race::Random) {
-		const sc2::ObservationInterface* obs = Observation();
+		const sc2::ObservationInterface* obs = getObservation();
 		auto utd_vector = obs->GetUnitTypeData();
 		auto utd = utd_vector[unit->unit_type];
 		enemy_race = utd.race;
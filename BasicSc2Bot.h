@@ -13,14 +13,40 @@
 #include "sc2utils/sc2_manage_process.h"
 #include "sc2utils/sc2_arg_parser.h"
 #include "MobHandler.h"
+#include "Profiler.h"
+#include "Tracer.h"
+#include "ObservationRecorder.h"
+#include "UnitCapture.h"
+#include "TargetAssigner.h"
+#include "EnemyTracker.h"
+#include "ActionBuffer.h"
+#include "StepScheduler.h"
+#include "TaskPool.h"
+#include "StepPipeline.h"
+#include "ThresholdTable.h"
+#include <deque>
+#include <map>
+#include <tuple>
 
 class Precept;
 class Mob;
 class Base;
 class Strategy;
 class MobHandler; 
+class Profiler;
+class Tracer;
+class ObservationRecorder;
+class UnitCapture;
+class TargetAssigner;
+class EnemyTracker;
+class ActionBuffer;
+class StepScheduler;
+class TaskPool;
+class StepPipeline;
+class ReplayDriver;
 
 #define STEP_SIZE 1 // should be 1 when submitted
+#define PRECEPT_CHECK_GRAIN 8 // precepts whose observation conditions are checked per pool job
 
 
 class Human : public sc2::Agent {
@@ -32,6 +58,7 @@ public:
 };
 
 class BasicSc2Bot : public sc2::Agent {
+	friend class ReplayDriver; // drives the sc2 callbacks directly when replaying a recorded game
 public:
 
 	// public functions
@@ -45,6 +72,16 @@ public:
 	void setCurrentStrategy(Strategy* strategy_);
 	void BasicSc2Bot::addStrat(Precept precept_);
 	void storeDirective(Directive directive_);
+	Directive* acquireDefaultDirective(Directive directive_);
+	Directive* storeTransientDirective(Directive directive_);
+	int storeBundleChain(const std::vector<Directive>& bundle_);
+	Directive* getBundledDirective(int index_);
+	void setBundleRemainder(std::vector<std::pair<int, int>>& chains_);
+	void takeBundleRemainder(std::vector<std::pair<int, int>>& chains_);
+	bool hasBundleRemainder();
+	Directive* getDirective(int storage_id_);
+	void releaseDirective(Directive* directive_);
+	int reclaimDirectives();
 	void storeStrategy(Strategy strategy_);
 	void storeUnitType(std::string identifier_, sc2::UNIT_TYPEID unit_type_);
 	void storeLocation(std::string identifier_, sc2::Point2D location_);
@@ -87,13 +124,29 @@ public:
 	void checkBuildingQueues();
 	void listUnitSummary();
 	sc2::Race getEnemyRace();
-	std::unordered_set<const sc2::Unit*> getEnemyUnits();
+
+	// sc2 interfaces, which are replaced with stand-ins when replaying a recorded game
+	// the bot reaches the game only through these, never through sc2::Client::Observation() and the like
+	const sc2::ObservationInterface* getObservation() const;
+	sc2::QueryInterface* getQuery();
+	sc2::ActionInterface* getActions();
+	void setInterfaces(const sc2::ObservationInterface* observation_, sc2::QueryInterface* query_, sc2::ActionInterface* actions_);
 
 	// public variables 
 	MobHandler* mobH;
 	LocationHandler* locH;
+	Profiler* prof;
+	Tracer* tracer;
+	ObservationRecorder* recorder;
+	UnitCapture* capture;
+	TargetAssigner* targeter;
+	EnemyTracker* enemies;
+	ThresholdTable* thresholds;
+	ActionBuffer* action_buffer;
+	StepScheduler* scheduler;
+	TaskPool* pool;
+	StepPipeline* pipeline;
 	Mob* proxy_worker;
-	std::unordered_map<size_t, Directive*> directive_by_id;
 	Strategy* current_strategy;
 	int time_of_first_attack; // recorded for data gathering purposes
 	int time_first_attacked;   // recorded for data gathering purposes
@@ -109,10 +162,18 @@ private:
 	void loadStep_05();
 	void onStep_100(const sc2::ObservationInterface* obs);
 	void onStep_1000(const sc2::ObservationInterface* obs);
-	bool addEnemyUnit(const sc2::Unit* unit);
 	bool flushOrders();
 	void checkBuildingsStatus();
 	void checkGasStructures();
+	void registerMicroRules();
+	void flushActions();
+	void registerStepTasks();
+	void updateEnemyThreat();
+	void checkBusyMobs();
+	void checkIdleMobs();
+	void checkPrecepts();
+	void updateActivePrecepts(int game_loop_);
+	int allocateDirective(Directive directive_);
 
 	// virtual functions 
 	// These functions must use PascalCase instead of camelCase since they must match the sc2 api's function names
@@ -129,16 +190,38 @@ private:
 
 
 	// data containers
-	std::vector<Precept> precepts_onstep;
-	std::vector<std::unique_ptr<Directive>> directive_storage;
-	std::unordered_set<Directive*> stored_directives;
+	std::vector<Precept> precepts_onstep;	// every precept, in the order they were added
+	struct PreceptWindow {
+		int earliest;	// first game loop any trigger can be met at
+		int latest;		// last game loop any trigger can be met at, the precept is retired after it
+	};
+	std::vector<PreceptWindow> precept_windows;	// per precept in precepts_onstep
+	std::vector<int> precept_timeline;	// indices into precepts_onstep, by earliest game loop from next_activation on
+	std::vector<int> active_precepts;	// indices into precepts_onstep of those that can be met now, in the order they were added
+	size_t next_activation;				// first entry of precept_timeline not yet active
+	int precepts_retired;
+	std::vector<std::vector<char>> precept_checks;	// per precept in active_precepts, refilled every step
+	std::vector<Mob*> idle_snapshot;	// reused every step to walk the idle and busy queues
+	std::vector<Mob*> busy_snapshot;
+	std::deque<Directive> directive_storage;	// indexed by storage id, a deque so stored directives never move
+	struct DirectiveSlot {
+		int refs;			// mobs holding it as their default directive
+		bool pooled;		// created while the game runs, reclaimed once nothing refers to it
+		bool interned;
+		bool live;
+	};
+	std::vector<DirectiveSlot> directive_slots;	// by storage id
+	std::map<std::tuple<int, int, int, int, float, float>, int> interned_directives;	// by Directive::InternKey, spelled out as Directive is incomplete here when reached through Directive.h
+	std::vector<int> free_directive_ids;
+	Directive* last_stored_directive;
+	std::vector<int> bundle_chains;	// storage ids of the bundled directives of every bundle, each bundle contiguous and in order
+	std::vector<std::pair<int, int>> bundle_remainder;	// rest of the bundles of the bundled directive being executed, see Mob::popBundledDirective()
+	int directives_reclaimed;
 	std::unordered_map<std::string, sc2::UNIT_TYPEID> special_units;
 	std::unordered_map<std::string, sc2::Point2D> special_locations;
 	std::unordered_map<std::string, int> special_ints;
 	std::vector<std::unique_ptr<Strategy>> strategy_storage;
 	std::vector<sc2::UNIT_TYPEID> data_buildings;
-	std::unordered_set<const sc2::Unit*> enemy_units;
-	std::unordered_map<sc2::Tag, const sc2::Unit*> enemy_unit_by_tag;
 	std::unordered_map<int, int> mineral_cost;
 	std::unordered_map<int, int> gas_cost;
 	std::unordered_map<int, int> food_cost;
@@ -164,4 +247,7 @@ private:
 	int max_minerals;
 	int max_gas;	
 	int map_index; // 1 = CactusValleyLE,  2 = BelShirVestigeLE,  3 = ProximaStationLE
+	const sc2::ObservationInterface* observation_override; // nullptr unless replaying
+	sc2::QueryInterface* query_override;
+	sc2::ActionInterface* actions_override;
 };
\ No newline at end of file
@@ -4,6 +4,15 @@
 #include "BasicSc2Bot.h"
 #include "Mob.h"
 
+struct Directive::Config {
+	std::vector<Directive> directive_bundle;
+	int bundle_start;		// where directive_bundle was stored in the bot's bundle chains, -1 until first applied
+	std::string group_name;
+	bool debug;
+	std::function<sc2::Point2D(void)> target_location_function;
+	std::function<sc2::Point2D(void)> assignee_location_function;
+};
+
 Directive::Directive(ASSIGNEE assignee_, ACTION_TYPE action_type_, sc2::UNIT_TYPEID unit_type_, sc2::ABILITY_ID ability_, sc2::Point2D assignee_location_,
 	sc2::Point2D target_location_, float assignee_proximity_, float target_proximity_, std::unordered_set<FLAGS> flags_, sc2::Unit* unit_, std::string group_name_, FLAGS set_flag_, int steps_) {
 	// genertic private constructor delegated by others
@@ -20,19 +29,22 @@ Directive::Directive(ASSIGNEE assignee_, ACTION_TYPE action_type_, sc2::UNIT_TYP
 	target_location = target_location_;			// default: INVALID_POINT
 	assignee_proximity = assignee_proximity_;   // default: INVALID_RADIUS
 	proximity = target_proximity_;				// default: INVALID_RADIUS
-	flags = flags_;								// default: empty
+	flags = flagMask(flags_);					// default: empty
 	target_unit = unit_;						// default: nullptr
-	group_name = group_name_;					// default: ""
 	set_flag = set_flag_;						// default: FLAGS::INVALID_FLAG
 	steps = steps_;								// default: 0
 	update_assignee_location = false;
 	update_target_location = false;
-	exclude_flags = std::unordered_set<FLAGS>();
+	exclude_flags = 0;
 	continuous_update = false;
 	target_update_iter_id = 0;
 	assignee_update_iter_id = 0;
 	ignore_distance = -1.0;
-	debug = false;
+	storage_id = -1;
+	config = std::make_shared<Config>();
+	config->bundle_start = -1;
+	config->group_name = group_name_;			// default: ""
+	config->debug = false;
 
 
 	// assignee using match flags assigns multiple units, so force `allow_multiple = true`
@@ -108,18 +120,40 @@ Directive::Directive(ASSIGNEE assignee_, ACTION_TYPE action_type_, std::unordere
 	Directive(assignee_, action_type_, sc2::UNIT_TYPEID::INVALID, sc2::ABILITY_ID::INVALID, assignee_location_, INVALID_POINT, assignee_proximity_, INVALID_RADIUS, flags_, nullptr, "", set_flag_, 0) {}
 
 bool Directive::bundleDirective(Directive directive_) {
-	if (!locked)
-		directive_bundle.push_back(directive_);
+	if (!locked) {
+		Config& c = editConfig();
+		c.directive_bundle.push_back(directive_);
+		c.bundle_start = -1;
+	}
 	return !locked;
 }
 
+Directive::Config& Directive::editConfig() {
+	// copies share their configuration until one of them changes it
+	if (config.use_count() > 1) {
+		config = std::make_shared<Config>(*config);
+	}
+	return *config;
+}
+
 bool Directive::execute(BasicSc2Bot* agent) {
+	// handle execution of a directive, recording its cost with the profiler
+
+	long long trace_start = agent->tracer->now();
+	agent->prof->beginDirective();
+	bool executed = _execute(agent);
+	agent->prof->endDirective(executed);
+	agent->tracer->span("directive", trace_start, (int)id);
+	return executed;
+}
+
+bool Directive::_execute(BasicSc2Bot* agent) {
 	// handle execution of a directive
 
-	const sc2::ObservationInterface* obs = agent->Observation();
+	const sc2::ObservationInterface* obs = agent->getObservation();
 	bool found_valid_unit = false; // ensure unit has been assigned before issuing order
 	const sc2::AbilityData ability_data = obs->GetAbilityData()[(int)ability]; // various info about the ability
-	sc2::QueryInterface* query_interface = agent->Query(); // used to query data
+	sc2::QueryInterface* query_interface = agent->getQuery(); // used to query data
 	std::unordered_set<Mob*> mobs = agent->mobH->getMobs(); // unordered_set of all friendly units
 	Mob* mob; // used to store temporary mob
 	if (update_assignee_location) {
@@ -131,7 +165,7 @@ bool Directive::execute(BasicSc2Bot* agent) {
 		//std::cout << "order targetting " << target_location.x << "," << target_location.y << std::endl;
 	}
 
-	if (debug) {
+	if (config->debug) {
 		// if a directive has been marked as setDebug(true), output "(exe)" whenever it is executed
 		std::cout << "(exe)";
 	}
@@ -139,7 +173,7 @@ bool Directive::execute(BasicSc2Bot* agent) {
 	if (id == agent->getStoredInt("ATTACK_DIR_ID")) {
 		int time = agent->time_of_first_attack; // recorded for testing purposes
 		if (time == -1) {
-			agent->time_of_first_attack = agent->Observation()->GetGameLoop();
+			agent->time_of_first_attack = agent->getObservation()->GetGameLoop();
 			std::cout << "[" << agent->time_of_first_attack << "] First attack sent at " << agent->gameTime(agent->time_of_first_attack) << "." << std::endl;
 		}
 	}
@@ -153,7 +187,7 @@ bool Directive::execute(BasicSc2Bot* agent) {
 	}
 
 	if (assignee == ASSIGNEE::MATCH_FLAGS || assignee == ASSIGNEE::MATCH_FLAGS_NEAR_LOCATION) {
-		assert(flags.size() > 0);
+		assert(flags != 0);
 	}
 
 	if (assignee == ASSIGNEE::UNIT_TYPE_NEAR_LOCATION || assignee == ASSIGNEE::MATCH_FLAGS_NEAR_LOCATION) {
@@ -183,6 +217,10 @@ bool Directive::execute(BasicSc2Bot* agent) {
 		assert(set_flag != FLAGS::INVALID_FLAG);
 	}
 
+	if (action_type == ACTION_TYPE::ADD_TO_GROUP || action_type == ACTION_TYPE::REMOVE_FROM_GROUP) {
+		assert(!config->group_name.empty());
+	}
+
 	if (assignee == ASSIGNEE::UNIT_TYPE || assignee == ASSIGNEE::UNIT_TYPE_NEAR_LOCATION) {
 		if (action_type == SIMPLE_ACTION || action_type == DISABLE_DEFAULT_DIRECTIVE) {
 			return executeSimpleActionForUnitType(agent);
@@ -301,7 +339,7 @@ bool Directive::executeForMob(BasicSc2Bot* agent, Mob* mob_) {
 
 		/* ORDER IS EXECUTED */
 		return issueOrder(agent, mob, mineral_target, false, sc2::ABILITY_ID::HARVEST_GATHER);
-		//agent->Actions()->UnitCommand(&mob->unit, ability, mineral_target);
+		//agent->getActions()->UnitCommand(&mob->unit, ability, mineral_target);
 		/* * * * * * * * * * */
 	}
 	if (action_type == GET_GAS_NEAR_LOCATION) {
@@ -507,7 +545,7 @@ bool Directive::executeProtossNexusBatteryOvercharge(BasicSc2Bot* agent) {
 	// use battery overcharge on the nearest shield_battery within range of a nexus
 
 
-	if (agent->Observation()->GetGameLoop() < agent->reset_shield_overcharge) {
+	if (agent->getObservation()->GetGameLoop() < agent->reset_shield_overcharge) {
 		return false;
 	}
 
@@ -543,7 +581,7 @@ bool Directive::executeProtossNexusBatteryOvercharge(BasicSc2Bot* agent) {
 	}
 
 	// get all structures
-	std::unordered_set<Mob*> structures = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_STRUCTURE);
+	std::unordered_set<Mob*> structures = agent->mobH->getMobsWithFlags({ FLAGS::IS_STRUCTURE });
 
 	std::unordered_set<Mob*> valid_shields;
 	std::copy_if(structures.begin(), structures.end(), std::inserter(valid_shields, valid_shields.begin()),
@@ -555,7 +593,7 @@ bool Directive::executeProtossNexusBatteryOvercharge(BasicSc2Bot* agent) {
 
 	std::unordered_set<Mob*> near_a_nexus;
 
-	std::unordered_set<Mob*> townhalls = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_TOWNHALL);
+	std::unordered_set<Mob*> townhalls = agent->mobH->getMobsWithFlags({ FLAGS::IS_TOWNHALL });
 
 	for (auto m : valid_shields) {
 		for (auto t : townhalls) {
@@ -611,7 +649,7 @@ bool Directive::executeProtossNexusBatteryOvercharge(BasicSc2Bot* agent) {
 		return false;
 	}
 
-	agent->reset_shield_overcharge = agent->Observation()->GetGameLoop() + 100;
+	agent->reset_shield_overcharge = agent->getObservation()->GetGameLoop() + 100;
 	/* ORDER IS EXECUTED */
 	return issueOrder(agent, mob, &overcharge_target->unit);
 	/* * * * * * * * * * */
@@ -676,7 +714,7 @@ bool Directive::executeProtossNexusChronoboost(BasicSc2Bot* agent) {
 		return false;
 
 	// get all structures
-	std::unordered_set<Mob*> structures = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_STRUCTURE);
+	std::unordered_set<Mob*> structures = agent->mobH->getMobsWithFlags({ FLAGS::IS_STRUCTURE });
 
 	// if a special chronotarget structure was specified in the strategy, filter by that structure
 	if (_special_chronotarget) {
@@ -721,14 +759,9 @@ bool Directive::executeMatchFlags(BasicSc2Bot* agent) {
 	// issue an order to units matching the provided flags
 
 	
-	std::unordered_set<Mob*> mobs = agent->mobH->getMobs(); // vector of all friendly units
-	std::unordered_set<Mob*> matching_mobs = agent->mobH->filterByFlags(mobs, flags);
+	std::unordered_set<Mob*> matching_mobs = agent->mobH->getMobsWithFlags(flags, exclude_flags);
 	matching_mobs = agent->mobH->filterNotOnCooldown(matching_mobs);
 
-	if (!exclude_flags.empty()) {
-		matching_mobs = agent->mobH->filterByFlags(matching_mobs, exclude_flags, false);
-	}
-
 	// get only units near the assignee_location parameter
 	if (assignee == MATCH_FLAGS_NEAR_LOCATION) {
 		matching_mobs = filterNearLocation(matching_mobs, assignee_location, assignee_proximity);
@@ -807,23 +840,17 @@ bool Directive::executeMatchFlags(BasicSc2Bot* agent) {
 		/* * * * * * * * * * */
 	}
 	if (action_type == ACTION_TYPE::TARGET_UNIT_NEAR_LOCATION) {
-		std::unordered_set<const sc2::Unit*> enemies = agent->getEnemyUnits();
-		
-		float lowest_distance = std::numeric_limits<float>::max();
-		const sc2::Unit* closest_unit = nullptr;
-		for (auto it = enemies.begin(); it != enemies.end(); ++it) {
-			float dist = sc2::DistanceSquared2D((*it)->pos, location);
-			if (dist < lowest_distance) {
-				closest_unit = (*it);
-				lowest_distance = dist;
-			}
-		}
-		if (closest_unit == nullptr) {
+		// remembered enemies count too, those out of vision are targeted where they were last seen
+		const EnemyRecord* closest = agent->enemies->getClosestRecord(location);
+		if (closest == nullptr) {
 			return false;
 		}
 
 		/* ORDER IS EXECUTED */
-		return issueOrder(agent, filtered_mobs, closest_unit);
+		if (!agent->enemies->isCurrent(closest)) {
+			return issueOrder(agent, filtered_mobs, closest->pos);
+		}
+		return issueOrder(agent, filtered_mobs, closest->unit);
 		/* * * * * * * * * * */
 	}
 	if (action_type == ACTION_TYPE::SET_FLAG) {
@@ -841,6 +868,24 @@ bool Directive::executeMatchFlags(BasicSc2Bot* agent) {
 		return true;
 		/* * * * * * * * * * * * * * */
 	}
+	if (action_type == ACTION_TYPE::ADD_TO_GROUP || action_type == ACTION_TYPE::REMOVE_FROM_GROUP) {
+		// filter those that would not change
+		matching_mobs = filterByGroup(agent, matching_mobs, action_type == ACTION_TYPE::REMOVE_FROM_GROUP);
+
+		if (matching_mobs.empty()) {
+			return false;
+		}
+
+		/* GROUP ORDER IS EXECUTED */
+		for (auto m : matching_mobs) {
+			if (action_type == ACTION_TYPE::ADD_TO_GROUP)
+				agent->mobH->addMobToGroup(config->group_name, m);
+			else
+				agent->mobH->removeMobFromGroup(config->group_name, m);
+		}
+		return true;
+		/* * * * * * * * * * * * */
+	}
 
 	return false;
 }
@@ -851,21 +896,18 @@ bool Directive::executeOrderForUnitType(BasicSc2Bot* agent) {
 
 	sc2::AbilityData ability_data;
 	if (ability != sc2::ABILITY_ID::INVALID) {
-		ability_data = agent->Observation()->GetAbilityData()[(int)ability]; // various info about the ability
+		ability_data = agent->getObservation()->GetAbilityData()[(int)ability]; // various info about the ability
 	}
-	sc2::QueryInterface* query_interface = agent->Query(); // used to query data
+	sc2::QueryInterface* query_interface = agent->getQuery(); // used to query data
 	sc2::Point2D location = target_location;
-	std::unordered_set<Mob*> mobs = agent->mobH->getMobs();
+	std::unordered_set<Mob*> mobs = agent->mobH->getMobsWithFlags(0, exclude_flags);
 
 	mobs = agent->mobH->filterNotOnCooldown(mobs);
 
 	Mob* mob = nullptr;
 
-	if (!exclude_flags.empty()) {
-		mobs = agent->mobH->filterByFlags(mobs, exclude_flags, false);
-		if (mobs.empty()) {
-			return false;
-		}
+	if (exclude_flags != 0 && mobs.empty()) {
+		return false;
 	}
 
 	if (assignee == UNIT_TYPE_NEAR_LOCATION) {
@@ -901,17 +943,26 @@ bool Directive::executeOrderForUnitType(BasicSc2Bot* agent) {
 
 		int i = 0;
 		if (action_type == ACTION_TYPE::NEAR_LOCATION) {
+			long long trace_start = agent->tracer->now();
+			agent->prof->countQuery();
 			while (!query_interface->Placement(ability, location)) {
 				location = uniform_random_point_in_circle(target_location, proximity);
+				agent->prof->countQuery();
 				++i;
 				if (i > 20) {
 					// can't find a suitable spot to build
+					agent->tracer->span("Query::Placement", trace_start);
 					return false;
 				}
 			}
+			agent->tracer->span("Query::Placement", trace_start);
 		}
 		else {
-			if (!query_interface->Placement(ability, location)) {
+			long long trace_start = agent->tracer->now();
+			agent->prof->countQuery();
+			bool placeable = query_interface->Placement(ability, location);
+			agent->tracer->span("Query::Placement", trace_start);
+			if (!placeable) {
 				return false;
 			}
 		}
@@ -970,6 +1021,11 @@ bool Directive::executeOrderForUnitType(BasicSc2Bot* agent) {
 		mobs = agent->mobH->filterByFlag(mobs, set_flag, false);
 	}
 
+	if (action_type == ADD_TO_GROUP || action_type == REMOVE_FROM_GROUP) {
+		// filter those that would not change
+		mobs = filterByGroup(agent, mobs, action_type == REMOVE_FROM_GROUP);
+	}
+
 	if (mobs.size() == 0) {
 		return false;
 	}
@@ -996,6 +1052,20 @@ bool Directive::executeOrderForUnitType(BasicSc2Bot* agent) {
 		/* * * * * * * * * * * * * * */
 	}
 
+	if (action_type == ADD_TO_GROUP) {
+		/* GROUP ORDER IS EXECUTED */
+		agent->mobH->addMobToGroup(config->group_name, mob);
+		return true;
+		/* * * * * * * * * * * * */
+	}
+
+	if (action_type == REMOVE_FROM_GROUP) {
+		/* GROUP ORDER IS EXECUTED */
+		agent->mobH->removeMobFromGroup(config->group_name, mob);
+		return true;
+		/* * * * * * * * * * * * */
+	}
+
 	if (action_type == GET_MINERALS_NEAR_LOCATION) {
 
 		// Note: this order should not have further queued directives attached,
@@ -1048,7 +1118,38 @@ bool Directive::executeOrderForUnitType(BasicSc2Bot* agent) {
 
 bool Directive::haveBundle() {
 	// if this directive has other directives bundled with it
-	return (directive_bundle.size() > 0);
+	return (config->directive_bundle.size() > 0);
+}
+
+void Directive::storeBundleChain(BasicSc2Bot* agent) {
+	// the bundle is stored once, the first time it is given to a mob, after which mobs only hold a cursor into it
+	// copies sharing this bundle share where it was stored, so the shared config is written directly
+	if (config->bundle_start == -1) {
+		config->bundle_start = agent->storeBundleChain(config->directive_bundle);
+	}
+}
+
+void Directive::handBundle(BasicSc2Bot* agent, Mob* mob_) {
+	// the mob carrying out this directive takes over the rest of the bundle it was popped from, if any,
+	// and runs this directive's own bundle before it
+	mob_->takeBundleChains(agent);
+	if (haveBundle()) {
+		storeBundleChain(agent);
+		mob_->setBundleChain(config->bundle_start, config->directive_bundle.size());
+	}
+}
+
+Directive::InternKey Directive::getInternKey() {
+	// directives made only of these fields, such as default gathering directives, behave the same when the keys match
+	return std::make_tuple((int)assignee, (int)action_type, (int)unit_type, (int)ability, target_location.x, target_location.y);
+}
+
+int Directive::getStorageID() {
+	return storage_id;
+}
+
+void Directive::setStorageID(int storage_id_) {
+	storage_id = storage_id_;
 }
 
 size_t Directive::getID()
@@ -1061,7 +1162,7 @@ size_t Directive::getID()
 bool Directive::ifAnyOnRouteToBuild(BasicSc2Bot* agent, std::unordered_set<Mob*> mobs_) {
 	// check if any of our units is on its way to build something
 
-	const sc2::ObservationInterface* obs = agent->Observation();
+	const sc2::ObservationInterface* obs = agent->getObservation();
 
 	for (auto it = mobs_.begin(); it != mobs_.end(); ++it) {
 		for (const auto& order : (*it)->unit.orders) {
@@ -1076,8 +1177,8 @@ bool Directive::ifAnyOnRouteToBuild(BasicSc2Bot* agent, std::unordered_set<Mob*>
 bool Directive::isBuildingStructure(BasicSc2Bot* agent, Mob* mob_) {
 	// check if a specific unit is building a structure
 
-	sc2::QueryInterface* query_interface = agent->Query();
-	const sc2::ObservationInterface* obs = agent->Observation();
+	sc2::QueryInterface* query_interface = agent->getQuery();
+	const sc2::ObservationInterface* obs = agent->getObservation();
 	std::vector<sc2::AbilityData> ability_data = obs->GetAbilityData();
 
 	// check if unit is on its way to build a structure
@@ -1089,7 +1190,10 @@ bool Directive::isBuildingStructure(BasicSc2Bot* agent, Mob* mob_) {
 	}
 	
 	// check if unit is in the process of building a structure
+	agent->prof->countQuery();
+	long long trace_start = agent->tracer->now();
 	std::vector<sc2::AvailableAbility> abilities = (query_interface->GetAbilitiesForUnit(&mob_->unit)).abilities;
+	agent->tracer->span("Query::GetAbilitiesForUnit", trace_start);
 	bool match = false;
 	for (auto a : abilities) {
 		if (a.ability_id == sc2::ABILITY_ID::HALT) {
@@ -1177,7 +1281,7 @@ bool Directive::allowMultiple(bool is_true) {
 void Directive::excludeFlag(FLAGS exclude_flag_) {
 	// set a flag to exclude when choosing mobs to give orders to
 
-	exclude_flags.insert(exclude_flag_);
+	exclude_flags |= flagBit(exclude_flag_);
 }
 
 void Directive::setContinuous(bool is_true) {
@@ -1249,6 +1353,16 @@ std::unordered_set<Mob*> Directive::filterIdle(std::unordered_set<Mob*> mobs_set
 	return filtered;
 }
 
+std::unordered_set<Mob*> Directive::filterByGroup(BasicSc2Bot* agent, std::unordered_set<Mob*> mobs_set, bool in_group_) {
+	// filter a set of mobs by whether they are in this directive's group
+
+	std::unordered_set<Mob*> group = agent->mobH->getMobGroupByName(config->group_name);
+	std::unordered_set<Mob*> filtered;
+	std::copy_if(mobs_set.begin(), mobs_set.end(), std::inserter(filtered, filtered.begin()),
+		[&group, in_group_](Mob* m) { return (group.count(m) > 0) == in_group_; });
+	return filtered;
+}
+
 std::unordered_set<Mob*> Directive::filterNotAssignedToThis(std::unordered_set<Mob*> mobs_set) {
 	// filter a set of mobs by those not currently assigned to this directive
 
@@ -1281,7 +1395,7 @@ Mob* Directive::getRandomMobFromSet(std::unordered_set<Mob*> mob_set) {
 void Directive::setDebug(bool is_true) {
 	// enable debug outputs on this directive
 
-	debug = is_true;
+	editConfig().debug = is_true;
 }
 
 void Directive::setIgnoreDistance(float range_) {
@@ -1305,12 +1419,12 @@ bool Directive::_genericIssueOrder(BasicSc2Bot* agent, std::unordered_set<Mob*>
 	if (ability_ == USE_DEFINED_ABILITY)
 		ability_ = ability;
 
-	if (debug) {
+	if (config->debug) {
 		std::cout << "{*}";
 	}
 	sc2::Point2D location = target_loc_;
 
-	bool apply_bundle = haveBundle();
+	bool apply_bundle = haveBundle() || agent->hasBundleRemainder();
 	
 	// handle case where more than one mob is being assigned the order
 	if (mobs_.size() > 1) {
@@ -1389,7 +1503,7 @@ bool Directive::_genericIssueOrder(BasicSc2Bot* agent, std::unordered_set<Mob*>
 
 		// target location is specified, continued
 		if (target_loc_ != INVALID_POINT && target_unit_ == nullptr) {
-			agent->Actions()->UnitCommand(units, ability_, target_loc_, queued_);
+			agent->getActions()->UnitCommand(units, ability_, target_loc_, queued_);
 			action_success = true;
 		}
 
@@ -1397,13 +1511,13 @@ bool Directive::_genericIssueOrder(BasicSc2Bot* agent, std::unordered_set<Mob*>
 
 		// no target is specified
 		if (target_loc_ == INVALID_POINT && target_unit_ == nullptr) {
-			agent->Actions()->UnitCommand(units, ability_, queued_);
+			agent->getActions()->UnitCommand(units, ability_, queued_);
 			action_success = true;
 		}
 
 		// target unit is specified
 		if (target_loc_ == INVALID_POINT && target_unit_ != nullptr) {
-			agent->Actions()->UnitCommand(units, ability_, target_unit_, queued_);
+			agent->getActions()->UnitCommand(units, ability_, target_unit_, queued_);
 			action_success = true;
 		}
 		if (action_success) {
@@ -1412,7 +1526,7 @@ bool Directive::_genericIssueOrder(BasicSc2Bot* agent, std::unordered_set<Mob*>
 					assignMob(m_);
 					agent->mobH->setMobBusy(m_);
 					if (apply_bundle) {
-						m_->bundleDirectives(directive_bundle);
+						handBundle(agent, m_);
 						apply_bundle = false;  // bundle is only given to one mob
 					}
 				}
@@ -1440,7 +1554,7 @@ bool Directive::_genericIssueOrder(BasicSc2Bot* agent, std::unordered_set<Mob*>
 	
 		// no target is specified
 		if (target_loc_ == INVALID_POINT && target_unit_ == nullptr) {
-			agent->Actions()->UnitCommand(&mob_->unit, ability_, queued_);
+			agent->getActions()->UnitCommand(&mob_->unit, ability_, queued_);
 			mob_->giveCooldown(agent, 5);
 			action_success = true;
 		}
@@ -1468,13 +1582,13 @@ bool Directive::_genericIssueOrder(BasicSc2Bot* agent, std::unordered_set<Mob*>
 			}
 
 
-			agent->Actions()->UnitCommand(&mob_->unit, ability_, target_loc_, queued_);
+			agent->getActions()->UnitCommand(&mob_->unit, ability_, target_loc_, queued_);
 			action_success = true;
 		}
 
 		// target unit is specified
 		if (target_loc_ == INVALID_POINT && target_unit_ != nullptr) {
-			agent->Actions()->UnitCommand(&mob_->unit, ability_, target_unit_, queued_);
+			agent->getActions()->UnitCommand(&mob_->unit, ability_, target_unit_, queued_);
 			action_success = true;
 		}
 
@@ -1494,8 +1608,9 @@ bool Directive::_genericIssueOrder(BasicSc2Bot* agent, std::unordered_set<Mob*>
 				agent->mobH->setMobBusy(mob_);
 				mob_->assignDirective(this);
 
-				if (apply_bundle)
-					mob_->bundleDirectives(directive_bundle);
+				if (apply_bundle) {
+					handBundle(agent, mob_);
+				}
 
 				return true;
 			}
@@ -1589,7 +1704,7 @@ void Directive::setTargetLocationFunction(Strategy* strat_, BasicSc2Bot* agent_,
 
 	strategy_ref = strat_;
 	update_target_location = true;
-	target_location_function = function_;
+	editConfig().target_location_function = function_;
 	
 }
 
@@ -1599,7 +1714,7 @@ void Directive::setAssigneeLocationFunction(BasicSc2Bot* agent_, std::function<s
 
 	update_assignee_location = true;
 	BasicSc2Bot* bot = agent_;
-	assignee_location_function = function_;
+	editConfig().assignee_location_function = function_;
 }
 
 void Directive::updateAssigneeLocation(BasicSc2Bot* agent_) {
@@ -1607,7 +1722,7 @@ void Directive::updateAssigneeLocation(BasicSc2Bot* agent_) {
 
 	static int a_iter_id = 0;
 	sc2::Point2D prev_location = assignee_location;
-	assignee_location = assignee_location_function();
+	assignee_location = config->assignee_location_function();
 	if (prev_location != assignee_location) {
 		assignee_update_iter_id = a_iter_id++;
 	}
@@ -1618,7 +1733,7 @@ void Directive::updateTargetLocation(BasicSc2Bot* agent_) {
 
 	static int t_iter_id = 0;
 	sc2::Point2D prev_location = target_location;
-	target_location = target_location_function();
+	target_location = config->target_location_function();
 	if (target_location == NO_POINT_FOUND) {
 		target_location == SEND_HOME;
 	}
@@ -6,7 +6,10 @@
 #include "sc2utils/sc2_manage_process.h"
 #include "sc2utils/sc2_arg_parser.h"
 #include "Mob.h"
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <tuple>
 #include "Strategy.h"  // temp
 //#include "LocationHandler.h"
 
@@ -24,12 +27,14 @@
 class BasicSc2Bot;
 class Mob;
 enum class FLAGS;
+typedef uint32_t FlagMask;	// one bit per FLAGS value, see flagBit() in Mob.h
 class Strategy; // temp
 
 
 
 class Directive {
 	// An order which is executed upon a Trigger being met
+	friend class StrategyFile; // builds directives from records through the generic constructor
 public:
 	enum ASSIGNEE {
 		// who the action should be assigned to
@@ -108,6 +113,10 @@ public:
 	static Mob* getClosestToLocation(std::unordered_set<Mob*> mobs_set, sc2::Point2D pos_);
 	static std::unordered_set<Mob*> filterNearLocation(std::unordered_set<Mob*> mobs_set, sc2::Point2D pos_, float radius_);
 	size_t getID();
+	int getStorageID();
+	void setStorageID(int storage_id_);
+	typedef std::tuple<int, int, int, int, float, float> InternKey;	// assignee, action type, unit type, ability and target location
+	InternKey getInternKey();
 	Strategy* strategy_ref;    // testing this pointer
 	
 private:
@@ -116,6 +125,7 @@ private:
 	Directive(ASSIGNEE assignee_, ACTION_TYPE action_type_, sc2::UNIT_TYPEID unit_type_, sc2::ABILITY_ID ability_, sc2::Point2D assignee_location_,
 		sc2::Point2D target_location_, float assignee_proximity_, float target_proximity_, std::unordered_set<FLAGS> flags_, sc2::Unit* unit_, std::string group_name_, FLAGS set_flag_, int steps_);
 
+	bool _execute(BasicSc2Bot* agent);
 	bool executeSimpleActionForUnitType(BasicSc2Bot* agent);
 	bool executeBuildGasStructure(BasicSc2Bot* agent);
 	bool executeProtossNexusBatteryOvercharge(BasicSc2Bot* agent);
@@ -124,6 +134,8 @@ private:
 	bool executeOrderForUnitType(BasicSc2Bot* agent);
 	bool executeModifyTimer(BasicSc2Bot* agent);
 	bool haveBundle();
+	void storeBundleChain(BasicSc2Bot* agent);
+	void handBundle(BasicSc2Bot* agent, Mob* mob_);
 	bool ifAnyOnRouteToBuild(BasicSc2Bot* agent, std::unordered_set<Mob*> mobs_);
 	bool isBuildingStructure(BasicSc2Bot* agent, Mob* mob_);
 	bool hasBuildOrder(Mob* mob_);
@@ -133,6 +145,7 @@ private:
 	std::unordered_set<Mob*> filterNotBuildingStructure(BasicSc2Bot* agent, std::unordered_set<Mob*> mobs_set);
 	std::unordered_set<Mob*> filterIdle(std::unordered_set<Mob*> mobs_set);
 	std::unordered_set<Mob*> filterNotAssignedToThis(std::unordered_set<Mob*> mobs_set);
+	std::unordered_set<Mob*> filterByGroup(BasicSc2Bot* agent, std::unordered_set<Mob*> mobs_set, bool in_group_);
 	Mob* getRandomMobFromSet(std::unordered_set<Mob*> mob_set);
 
 	void updateTargetLocation(BasicSc2Bot* agent_);
@@ -146,37 +159,36 @@ private:
 	bool issueOrder(BasicSc2Bot* agent, std::unordered_set<Mob*> mobs_, sc2::Point2D target_loc_, bool queued_=false, sc2::ABILITY_ID ability_ = USE_DEFINED_ABILITY);
 	bool issueOrder(BasicSc2Bot* agent, std::unordered_set<Mob*> mobs_, const sc2::Unit* target_unit_, bool queued_=false, sc2::ABILITY_ID ability_ = USE_DEFINED_ABILITY);
 
-	bool locked;
-	bool allow_multiple;
-	bool override_directive;
-	bool update_target_location;
-	bool update_assignee_location;
-	bool continuous_update;
-	int target_update_iter_id;		// increments by one whenever target location updates to a new value
-	int assignee_update_iter_id;	// increments by one whenever target location updates to a new value
-
-	std::function<sc2::Point2D(void)> target_location_function;
-	std::function<sc2::Point2D(void)> assignee_location_function;
-
-	bool debug;
+	struct Config;
+	Config& editConfig();
 
+	// read on every execution, kept together at the front of the object
 	ASSIGNEE assignee;
 	ACTION_TYPE action_type;
 	sc2::UNIT_TYPEID unit_type;
 	sc2::ABILITY_ID ability;
-	size_t id; // unique identifier
-	
+	FlagMask flags;
+	FlagMask exclude_flags;
+	FLAGS set_flag;
+	int steps;
 	sc2::Point2D assignee_location;
 	sc2::Point2D target_location;
-	sc2::Unit* target_unit;
 	float assignee_proximity;
 	float proximity;
 	float ignore_distance;
-	FLAGS set_flag;
-	int steps;
-	std::unordered_set<FLAGS> flags;
-	std::unordered_set<FLAGS> exclude_flags;
-	std::vector<Directive> directive_bundle;
+	sc2::Unit* target_unit;
+	bool locked;
+	bool allow_multiple;
+	bool override_directive;
+	bool update_target_location;
+	bool update_assignee_location;
+	bool continuous_update;
+	int target_update_iter_id;		// increments by one whenever target location updates to a new value
+	int assignee_update_iter_id;	// increments by one whenever target location updates to a new value
+	size_t id; // unique identifier
+	int storage_id;	// index into the bot's directive storage, -1 until stored
 	std::unordered_set<Mob*> assigned_mobs;
-	std::string group_name;
+
+	// rarely used configuration (bundle, group name, debug, location functions), shared by copies until one changes it
+	std::shared_ptr<Config> config;
 };
@@ -0,0 +1,194 @@
+#include "EnemyTracker.h"
+#include "BasicSc2Bot.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+EnemyTracker::EnemyTracker(BasicSc2Bot* agent_) {
+	agent = agent_;
+	current_loop = -1;
+	cols = 0;
+	rows = 0;
+}
+
+void EnemyTracker::update() {
+	// refresh records from the current observation, should be called once per step
+	const sc2::ObservationInterface* obs = agent->getObservation();
+	current_loop = obs->GetGameLoop();
+	current_units = obs->GetUnits(sc2::Unit::Alliance::Enemy);
+	for (auto u : current_units) {
+		observe(u, current_loop);
+	}
+	expire(current_loop);
+	buildGrid();
+}
+
+void EnemyTracker::observe(const sc2::Unit* unit_, int game_loop_) {
+	auto it = index_by_tag.find(unit_->tag);
+	if (it == index_by_tag.end()) {
+		EnemyRecord record;
+		record.tag = unit_->tag;
+		record.is_structure = false;
+		for (auto a : agent->getObservation()->GetUnitTypeData()[unit_->unit_type].attributes) {
+			if (a == sc2::Attribute::Structure) {
+				record.is_structure = true;
+			}
+		}
+		index_by_tag[unit_->tag] = records.size();
+		records.push_back(record);
+		it = index_by_tag.find(unit_->tag);
+	}
+	EnemyRecord& record = records[it->second];
+	record.type = unit_->unit_type;
+	record.pos = unit_->pos;
+	record.last_seen = game_loop_;
+	record.is_snapshot = (unit_->display_type == sc2::Unit::DisplayType::Snapshot);
+	record.unit = unit_;
+}
+
+void EnemyTracker::expire(int game_loop_) {
+	// forget dead enemies, mobile enemies unseen for ENEMY_MEMORY_LOOPS, and the longest unseen past ENEMY_MEMORY_MAX
+	size_t kept = 0;
+	for (size_t i = 0; i < records.size(); ++i) {
+		const EnemyRecord& r = records[i];
+		if (r.last_seen == game_loop_ && !r.unit->is_alive)
+			continue;
+		if (!r.is_structure && game_loop_ - r.last_seen > ENEMY_MEMORY_LOOPS)
+			continue;
+		records[kept++] = r;
+	}
+	records.resize(kept);
+
+	if (records.size() > ENEMY_MEMORY_MAX) {
+		std::nth_element(records.begin(), records.begin() + ENEMY_MEMORY_MAX, records.end(),
+			[](const EnemyRecord& a, const EnemyRecord& b) { return a.last_seen > b.last_seen; });
+		records.resize(ENEMY_MEMORY_MAX);
+	}
+
+	index_by_tag.clear();
+	for (size_t i = 0; i < records.size(); ++i) {
+		index_by_tag[records[i].tag] = i;
+	}
+}
+
+void EnemyTracker::remove(sc2::Tag tag_) {
+	// forget a destroyed enemy straight away, swapping the last record into its place
+	auto it = index_by_tag.find(tag_);
+	if (it == index_by_tag.end())
+		return;
+	int i = it->second;
+	index_by_tag.erase(it);
+	if (i != (int)records.size() - 1) {
+		records[i] = records.back();
+		index_by_tag[records[i].tag] = i;
+	}
+	records.pop_back();
+	buildGrid();
+}
+
+int EnemyTracker::cellIndex(int col_, int row_) {
+	col_ = std::min(std::max(col_, 0), cols - 1);
+	row_ = std::min(std::max(row_, 0), rows - 1);
+	return col_ + row_ * cols;
+}
+
+void EnemyTracker::buildGrid() {
+	// counting sort of record indices by cell
+	const sc2::GameInfo& game_info = agent->getObservation()->GetGameInfo();
+	cols = std::max(1, (int)std::ceil(game_info.width / ENEMY_GRID_CELL));
+	rows = std::max(1, (int)std::ceil(game_info.height / ENEMY_GRID_CELL));
+
+	std::vector<int> record_cells(records.size());
+	cell_start.assign(cols * rows + 1, 0);
+	for (size_t i = 0; i < records.size(); ++i) {
+		record_cells[i] = cellIndex((int)(records[i].pos.x / ENEMY_GRID_CELL), (int)(records[i].pos.y / ENEMY_GRID_CELL));
+		cell_start[record_cells[i] + 1]++;
+	}
+	for (size_t i = 1; i < cell_start.size(); ++i) {
+		cell_start[i] += cell_start[i - 1];
+	}
+	std::vector<int> next(cell_start.begin(), cell_start.end() - 1);
+	cell_records.resize(records.size());
+	for (size_t i = 0; i < records.size(); ++i) {
+		cell_records[next[record_cells[i]]++] = i;
+	}
+}
+
+const EnemyRecord* EnemyTracker::getRecord(sc2::Tag tag_) {
+	// last known state of an enemy, or nullptr if it is not remembered
+	auto it = index_by_tag.find(tag_);
+	if (it == index_by_tag.end())
+		return nullptr;
+	return &records[it->second];
+}
+
+const std::vector<EnemyRecord>& EnemyTracker::getRecords() {
+	return records;
+}
+
+const sc2::Units& EnemyTracker::getCurrentUnits() {
+	// enemies in this step's observation, both visible and snapshots
+	return current_units;
+}
+
+bool EnemyTracker::isCurrent(const EnemyRecord* record_) {
+	// whether the record is in this step's observation, so its unit pointer can be used
+	return record_->last_seen == current_loop;
+}
+
+const sc2::Unit* EnemyTracker::getClosestUnit(sc2::Point2D pos_) {
+	// closest enemy in this step's observation
+	if (current_units.empty())
+		return nullptr;
+	const EnemyRecord* closest = findClosest(pos_, true);
+	return closest ? closest->unit : nullptr;
+}
+
+const EnemyRecord* EnemyTracker::getClosestRecord(sc2::Point2D pos_) {
+	// closest remembered enemy, in the observation or not, at its last known position
+	return findClosest(pos_, false);
+}
+
+const EnemyRecord* EnemyTracker::findClosest(sc2::Point2D pos_, bool current_only_) {
+	// searches rings of cells outwards from pos_
+	if (records.empty() || cell_start.empty())
+		return nullptr;
+
+	int col = std::min(std::max((int)(pos_.x / ENEMY_GRID_CELL), 0), cols - 1);
+	int row = std::min(std::max((int)(pos_.y / ENEMY_GRID_CELL), 0), rows - 1);
+	const EnemyRecord* closest = nullptr;
+	float closest_sq = std::numeric_limits<float>::max();
+	int max_ring = std::max(cols, rows);
+	for (int ring = 0; ring <= max_ring; ++ring) {
+		// every cell of this ring is at least (ring - 1) cells away from pos_
+		float ring_dist = (ring - 1) * ENEMY_GRID_CELL;
+		if (closest && ring_dist > 0 && ring_dist * ring_dist >= closest_sq)
+			break;
+		for (int r = row - ring; r <= row + ring; ++r) {
+			if (r < 0 || r >= rows)
+				continue;
+			// inner rows of the ring only have their two end cells
+			int step = (r == row - ring || r == row + ring) ? 1 : std::max(2 * ring, 1);
+			for (int c = col - ring; c <= col + ring; c += step) {
+				if (c < 0 || c >= cols)
+					continue;
+				int cell = c + r * cols;
+				for (int i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+					const EnemyRecord& record = records[cell_records[i]];
+					if (current_only_ && record.last_seen != current_loop)
+						continue;
+					float dist = sc2::DistanceSquared2D(record.pos, pos_);
+					if (dist < closest_sq) {
+						closest_sq = dist;
+						closest = &record;
+					}
+				}
+			}
+		}
+	}
+	return closest;
+}
+
+int EnemyTracker::size() {
+	return records.size();
+}
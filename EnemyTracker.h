@@ -0,0 +1,57 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "sc2api/sc2_api.h"
+
+# define ENEMY_MEMORY_LOOPS 1344 // mobile enemies not seen for this long are forgotten, 22.4 loops is approx one second
+# define ENEMY_MEMORY_MAX 512 // most enemies remembered at once, the longest unseen are forgotten first
+# define ENEMY_GRID_CELL 8.0F // side of a cell of the grid remembered enemies are bucketed into
+
+class BasicSc2Bot;
+
+struct EnemyRecord {
+	sc2::Tag tag;
+	sc2::UNIT_TYPEID type;
+	sc2::Point2D pos;		// last known position
+	int last_seen;			// game loop the unit was last in an observation
+	bool is_snapshot;		// last seen as a snapshot, e.g. a structure under the fog of war
+	bool is_structure;		// structures are not forgotten by age, since they do not move
+	const sc2::Unit* unit;	// only current if last_seen is the current game loop
+};
+
+class EnemyTracker {
+// Remembers every enemy unit we have seen by tag: where it was, what it was and when, so that
+// enemies that leave vision are kept as ghosts instead of as unit pointers that may be stale.
+// The observation is scanned once per step in update(), and the rest of the bot reads from here
+public:
+	EnemyTracker(BasicSc2Bot* agent_);
+	void update();
+	void remove(sc2::Tag tag_);
+	const EnemyRecord* getRecord(sc2::Tag tag_);
+	const std::vector<EnemyRecord>& getRecords();
+	const sc2::Units& getCurrentUnits();
+	const sc2::Unit* getClosestUnit(sc2::Point2D pos_);
+	const EnemyRecord* getClosestRecord(sc2::Point2D pos_);
+	bool isCurrent(const EnemyRecord* record_);
+	int size();
+
+private:
+	void observe(const sc2::Unit* unit_, int game_loop_);
+	void expire(int game_loop_);
+	void buildGrid();
+	int cellIndex(int col_, int row_);
+	const EnemyRecord* findClosest(sc2::Point2D pos_, bool current_only_);
+
+	BasicSc2Bot* agent;
+	std::vector<EnemyRecord> records;					// flat storage, order is not meaningful
+	std::unordered_map<sc2::Tag, int> index_by_tag;		// index into records
+	sc2::Units current_units;							// enemies in this step's observation
+	int current_loop;
+
+	// record indices bucketed by cell, cell i holds cell_records[cell_start[i]] up to cell_records[cell_start[i + 1]]
+	int cols;
+	int rows;
+	std::vector<int> cell_start;
+	std::vector<int> cell_records;
+};
@@ -87,24 +87,35 @@ bool MapChunk::isNearStart() {
     return dist_squared_from_start < threshold;
 }
 
-void MapChunk::checkVision(const sc2::ObservationInterface* obs) {
+void MapChunk::checkVision(int game_loop_, bool decay_) {
 
     // checks the status of the chunk. If the chunk is visible, it updates the data for nearby enemy units.
+    // reads the visibility copied by LocationHandler::copyVisibility(), so it may run off the game thread
+    // decay_ is false when the step pipeline decays threat instead, see LocationHandler::updateThreat()
 
-    last_visibility = obs->GetVisibility(location);
+    last_visibility = agent->locH->getVisibility(location);
     if (last_visibility == sc2::Visibility::Visible) {
-        last_seen = obs->GetGameLoop();
+        last_seen = game_loop_;
 
         // decay threat when in vision
-        if (threat > 0) {
-            threat *= (1.0 - THREAT_DECAY);
-            threat -= .1;
-            if (threat < 0)
-                threat = 0.0f;
+        if (decay_) {
+            threat = decayedThreat(threat);
         }
     }
 }
 
+double MapChunk::decayedThreat(double threat_) {
+    // return what a threat value decays to after a step in vision
+
+    if (threat_ > 0) {
+        threat_ *= (1.0 - THREAT_DECAY);
+        threat_ -= .1;
+        if (threat_ < 0)
+            threat_ = 0.0f;
+    }
+    return threat_;
+}
+
 bool MapChunk::inVision(const sc2::ObservationInterface* obs) {
     // return whether this MapChunk is currently in vision
 
@@ -261,6 +272,7 @@ LocationHandler::LocationHandler(BasicSc2Bot* agent_){
     agent = agent_;
     enemy_start_location_index = 0;
     chunks_initialized = false;
+    map_analysis = std::make_shared<MapAnalysis>();
     highest_threat = 0;
     highest_pathable_threat = 0;
     highest_threat_away_from_start = 0;
@@ -273,12 +285,16 @@ LocationHandler::LocationHandler(BasicSc2Bot* agent_){
     center_chunk = nullptr;
     next_unseen_chunk = nullptr;
     next_unseen_pathable_chunk = nullptr;
+    visibility_width = 0;
+    visibility_height = 0;
+    registerLocationProviders();
 }
 
 LocationHandler::LocationHandler(const LocationHandler& rhs) {
 	agent = rhs.agent;
     enemy_start_location_index = rhs.enemy_start_location_index;
     chunks_initialized = rhs.chunks_initialized;
+    map_analysis = rhs.map_analysis;
     highest_threat = rhs.highest_threat;
     highest_pathable_threat = rhs.highest_pathable_threat;
     highest_threat_away_from_start = rhs.highest_pathable_threat_away_from_start;
@@ -291,6 +307,9 @@ LocationHandler::LocationHandler(const LocationHandler& rhs) {
     center_chunk = rhs.center_chunk;
     next_unseen_chunk = rhs.next_unseen_chunk;
     next_unseen_pathable_chunk = rhs.next_unseen_pathable_chunk;
+
+    // providers capture this handler, so they are registered again rather than copied
+    registerLocationProviders();
 }
 
 LocationHandler& LocationHandler::operator=(const LocationHandler& rhs) {
@@ -298,6 +317,7 @@ LocationHandler& LocationHandler::operator=(const LocationHandler& rhs) {
     agent = rhs.agent;
     enemy_start_location_index = rhs.enemy_start_location_index;
     chunks_initialized = rhs.chunks_initialized;
+    map_analysis = rhs.map_analysis;
     highest_threat = rhs.highest_threat;
     highest_pathable_threat = rhs.highest_pathable_threat;
     highest_threat_away_from_start = rhs.highest_pathable_threat_away_from_start;
@@ -310,9 +330,108 @@ LocationHandler& LocationHandler::operator=(const LocationHandler& rhs) {
     center_chunk = rhs.center_chunk;
     next_unseen_chunk = rhs.next_unseen_chunk;
     next_unseen_pathable_chunk = rhs.next_unseen_pathable_chunk;
+
+    // this handler keeps its own providers, but their values are recomputed
+    for (auto& p : location_providers) {
+        p.computed_loop = -1;
+    }
 	return *this;
 }
 
+void LocationHandler::registerLocationProviders() {
+    // locations that directives commonly target, see locationProvider()
+
+    location_providers.clear();
+    location_provider_by_name.clear();
+    registerLocationProvider("CENTER_OF_ARMY", [this]() { return getCenterOfArmy(); });
+    registerLocationProvider("ATTACKING_FORCE", [this]() { return getAttackingForceLocation(); });
+    registerLocationProvider("HIGHEST_THREAT", [this]() { return getHighestThreatLocation(); });
+    registerLocationProvider("SMART_ATTACK", [this]() { return smartAttackLocation(); });
+    registerLocationProvider("SMART_ATTACK_FLYING", [this]() { return smartAttackFlyingLocation(); });
+    registerLocationProvider("SMART_PRIORITY_ATTACK", [this]() { return smartPriorityAttack(); });
+    registerLocationProvider("SMART_STAY_HOME_AND_DEFEND", [this]() { return smartStayHomeAndDefend(); });
+    registerLocationProvider("RALLY_POINT_BEFORE_RALLY_POINT", [this]() { return getRallyPointBeforeRallyPoint(); });
+    registerLocationProvider("RALLY_POINT_TOWARDS_THREAT", [this]() { return getRallyPointTowardsThreat(); });
+}
+
+int LocationHandler::registerLocationProvider(std::string name_, std::function<sc2::Point2D()> compute_) {
+    // returns the id to pass to provideLocation(), registering a name again replaces its function
+
+    auto found = location_provider_by_name.find(name_);
+    if (found != location_provider_by_name.end()) {
+        location_providers[found->second].compute = compute_;
+        location_providers[found->second].computed_loop = -1;
+        return found->second;
+    }
+    LocationProvider provider;
+    provider.name = name_;
+    provider.compute = compute_;
+    provider.computed_loop = -1;
+    provider.value = NO_POINT_FOUND;
+    provider.evaluations = 0;
+    provider.requests = 0;
+    location_providers.push_back(provider);
+    location_provider_by_name[name_] = location_providers.size() - 1;
+    return location_providers.size() - 1;
+}
+
+int LocationHandler::getLocationProviderID(std::string name_) {
+    // -1 if no provider has that name
+
+    auto found = location_provider_by_name.find(name_);
+    if (found == location_provider_by_name.end())
+        return -1;
+    return found->second;
+}
+
+sc2::Point2D LocationHandler::provideLocation(int provider_id_) {
+    // the provider's location for this game loop, only computed by the first request in a loop
+
+    if (provider_id_ < 0 || provider_id_ >= (int)location_providers.size())
+        return NO_POINT_FOUND;
+    LocationProvider& provider = location_providers[provider_id_];
+    provider.requests++;
+    int game_loop = agent->getObservation()->GetGameLoop();
+    if (provider.computed_loop != game_loop) {
+        provider.value = provider.compute();
+        provider.computed_loop = game_loop;
+        provider.evaluations++;
+    }
+    return provider.value;
+}
+
+std::function<sc2::Point2D()> LocationHandler::locationProvider(std::string name_) {
+    // a location function for directives, reading the shared value of the named provider
+    // the handler is looked up through the agent when called, so it follows copies of the bot
+
+    int id = getLocationProviderID(name_);
+    assert(id != -1);
+    BasicSc2Bot* bot = agent;
+    return [bot, id]() { return bot->locH->provideLocation(id); };
+}
+
+long long LocationHandler::getProviderEvaluations(int provider_id_) {
+    if (provider_id_ < 0 || provider_id_ >= (int)location_providers.size())
+        return 0;
+    return location_providers[provider_id_].evaluations;
+}
+
+long long LocationHandler::getProviderRequests(int provider_id_) {
+    if (provider_id_ < 0 || provider_id_ >= (int)location_providers.size())
+        return 0;
+    return location_providers[provider_id_].requests;
+}
+
+void LocationHandler::printLocationProviders() {
+    // how often each provider was asked for its location, and how often it had to compute it
+
+    for (auto& p : location_providers) {
+        if (p.requests > 0) {
+            std::cout << "Location provider " << p.name << ": " << p.requests << " requests, " << p.evaluations << " evaluations" << std::endl;
+        }
+    }
+}
+
 LocationHandler::~LocationHandler(){
 }
 
@@ -362,7 +481,9 @@ MapChunk* LocationHandler::getNextUnseenChunk(bool pathable_) {
 void LocationHandler::setNextUnseenChunk(bool pathable_) {
     // sets the next unseen chunk to be the closest unseen chunk to the center of mass of our army
 
-    sc2::Point2D center_of_mass = getCenterOfArmy();
+    // without an army, explore from home
+    const ArmyStats& stats = agent->mobH->getArmyStats();
+    sc2::Point2D center_of_mass = stats.num_attackers > 0 ? stats.attacker_center : start_location;
 
     MapChunk* nearest_chunk = nullptr;
 
@@ -435,7 +556,7 @@ sc2::Point2D LocationHandler::getNearestStartLocation(sc2::Point2D spot) {
     float nearest_distance = 10000.0f;
     sc2::Point2D nearest_point;
 
-    for (auto& iter : agent->Observation()->GetGameInfo().start_locations) {
+    for (auto& iter : agent->getObservation()->GetGameInfo().start_locations) {
         float dist = sc2::Distance2D(spot, iter);
         if (dist <= nearest_distance) {
             nearest_distance = dist;
@@ -460,20 +581,64 @@ int LocationHandler::getIndexOfClosestBase(sc2::Point2D location_) {
     return lowest_index;
 }
 
-void LocationHandler::scanChunks(const sc2::ObservationInterface* obs) {
+void LocationHandler::scanChunks(const sc2::ObservationInterface* obs, bool decay_) {
     // iterate through all MapChunks and call the checkVision() function
     // updating their visibility status and threat values
+    // each chunk only updates itself, so they are split across the task pool
+    // the pool jobs only read the copied visibility, never the observation
+
+    copyVisibility(obs);
+    int game_loop = obs->GetGameLoop();
+    agent->pool->parallelFor(0, map_chunk_storage.size(), CHUNK_SCAN_GRAIN, [this, game_loop, decay_](int begin_, int end_) {
+        for (int i = begin_; i < end_; ++i) {
+            map_chunk_storage[i]->checkVision(game_loop, decay_);
+        }
+    });
+}
+
+void LocationHandler::copyVisibility(const sc2::ObservationInterface* obs) {
+    // copy the visibility grid from the raw observation, on the game thread
+
+    const SC2APIProtocol::Observation* raw = obs->GetRawObservation();
+    if (raw != nullptr) {
+        const SC2APIProtocol::ImageData& grid = raw->raw_data().map_state().visibility();
+        visibility_width = grid.size().x();
+        visibility_height = grid.size().y();
+        visibility.assign(grid.data().begin(), grid.data().end());
+        return;
+    }
 
-    for (auto it = map_chunks.begin(); it != map_chunks.end(); ++it) {
-        (*it)->checkVision(obs);
+    // the replay tools have no raw observation, so the grid is sampled one cell at a time
+    const sc2::GameInfo& game_info = obs->GetGameInfo();
+    visibility_width = game_info.width;
+    visibility_height = game_info.height;
+    visibility.resize(visibility_width * visibility_height);
+    for (int y = 0; y < visibility_height; ++y) {
+        for (int x = 0; x < visibility_width; ++x) {
+            visibility[x + y * visibility_width] = (char)obs->GetVisibility(sc2::Point2D(x + 0.5F, y + 0.5F));
+        }
     }
 }
 
+sc2::Visibility LocationHandler::getVisibility(sc2::Point2D point_) {
+    // visibility at a point as of the last copyVisibility(), Hidden outside the grid
+
+    int x = (int)point_.x;
+    int y = (int)point_.y;
+    if (x < 0 || x >= visibility_width || y < 0 || y >= visibility_height)
+        return sc2::Visibility::Hidden;
+    size_t i = x + y * visibility_width;
+    if (i >= visibility.size())
+        return sc2::Visibility::Hidden;
+    return (sc2::Visibility)visibility[i];
+}
+
 const sc2::Unit* LocationHandler::getNearestMineralPatch(sc2::Point2D location) {
     // get the nearest mineral patch to a given location
 
-    const sc2::ObservationInterface* obs = agent->Observation();
-    sc2::Units units = agent->Observation()->GetUnits(sc2::Unit::Alliance::Neutral);
+    const sc2::ObservationInterface* obs = agent->getObservation();
+    agent->prof->countGetUnits();
+    sc2::Units units = agent->getObservation()->GetUnits(sc2::Unit::Alliance::Neutral);
     float distance = std::numeric_limits<float>::max();
     const sc2::Unit* target = nullptr;
     for (const auto& u : units) {
@@ -491,7 +656,8 @@ const sc2::Unit* LocationHandler::getNearestMineralPatch(sc2::Point2D location)
 const sc2::Unit* LocationHandler::getNearestGeyser(sc2::Point2D location) {
     // get the nearest vespene geyser to a given location
 
-    const sc2::ObservationInterface* obs = agent->Observation();
+    const sc2::ObservationInterface* obs = agent->getObservation();
+    agent->prof->countGetUnits();
     sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Neutral);
     float distance = std::numeric_limits<float>::max();
     const sc2::Unit* target = nullptr;
@@ -521,12 +687,14 @@ const sc2::Unit* LocationHandler::getNearestGasStructure(sc2::Point2D location,
     // get the nearest gas structure to a given point
     // if bool allied is specified to be false, then include not just those owned by the player
 
-    const sc2::ObservationInterface* obs = agent->Observation();
+    const sc2::ObservationInterface* obs = agent->getObservation();
     sc2::Units units;
     if (allied) {
+        agent->prof->countGetUnits();
         units = obs->GetUnits(sc2::Unit::Alliance::Self);
     }
     else {
+        agent->prof->countGetUnits();
         units = obs->GetUnits();
     }
     
@@ -553,7 +721,7 @@ const sc2::Unit* LocationHandler::getNearestGasStructure(sc2::Point2D location,
 const sc2::Unit* LocationHandler::getNearestTownhall(const sc2::Point2D location) {
     // find nearest townhall to location
 
-    std::unordered_set<Mob*> townhalls = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_TOWNHALL);
+    std::unordered_set<Mob*> townhalls = agent->mobH->getMobsWithFlags({ FLAGS::IS_TOWNHALL });
     for (auto m : townhalls) {
         return &(m->unit);
     }
@@ -566,56 +734,133 @@ void LocationHandler::calculateHighestThreatForChunks() {
     // away: the chunk is away from the start location
     // Can be called periodically instead of constantly to be less
     // expensive on computation
+    // when steps are pipelined the three parts run separately, see StepPipeline
 
-    double max_threat = 0;
-    double max_pathable_threat = 0;
-    double max_threat_away = 0;
-    double max_pathable_threat_away = 0;
-    int max_id = -99;
-    int max_pathable_id = -99;
-    int max_id_away = -99;
-    int max_pathable_id_away = -99;
+    if (snapshotThreat()) {
+        findHighestThreats();
+        applyHighestThreats();
+    }
+}
 
-    for (auto chunk : map_chunks) {
-        int id = chunk->getID();
-        float chunk_threat = chunk->getThreat();
-        bool pathable = chunk->isPathable();
-        bool away = !chunk->isNearStart();
-        if (chunk_threat > max_threat) {
-            max_threat = chunk_threat;
-            max_id = id;
+bool LocationHandler::snapshotThreat() {
+    // copy what findHighestThreats() needs, returns false before the chunks exist
+
+    if (!chunks_initialized)
+        return false;
+    size_t num_chunks = map_chunk_storage.size();
+    if (threat_snapshot.pathable.size() != num_chunks) {
+        threat_snapshot.pathable.resize(num_chunks);
+        threat_snapshot.away.resize(num_chunks);
+        for (size_t i = 0; i < num_chunks; ++i) {
+            threat_snapshot.pathable[i] = map_chunk_storage[i]->isPathable();
+            threat_snapshot.away[i] = !map_chunk_storage[i]->isNearStart();
+        }
+    }
+    threat_snapshot.threat.resize(num_chunks);
+    threat_snapshot.visible.resize(num_chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+        MapChunk* chunk = map_chunk_storage[i].get();
+        threat_snapshot.threat[i] = chunk->getThreat();
+        threat_snapshot.visible[i] = chunk->inVision(nullptr);
+    }
+    return true;
+}
+
+void LocationHandler::queueThreat(MapChunk* chunk_, double amount_) {
+    // add threat to a chunk on the next updateThreat(), instead of right away
+    // only called on the game thread while the pipeline worker is idle
+
+    auto it = chunk_index.find(chunk_);
+    if (it != chunk_index.end()) {
+        threat_snapshot.added.emplace_back(it->second, amount_);
+    }
+}
+
+void LocationHandler::updateThreat() {
+    // decay threat for chunks in vision, add the queued threat, then find the highest threats
+    // in the same order scanChunks() and updateEnemyThreat() do it within a step
+    // only reads and writes the snapshot, so it may run off the game thread
+
+    ThreatSnapshot& snap = threat_snapshot;
+    for (size_t i = 0; i < snap.threat.size(); ++i) {
+        if (snap.visible[i]) {
+            snap.threat[i] = MapChunk::decayedThreat(snap.threat[i]);
+        }
+    }
+    for (auto& a : snap.added) {
+        snap.threat[a.first] += a.second;
+    }
+    snap.added.clear();
+    findHighestThreats();
+}
+
+void LocationHandler::applyThreat() {
+    // write the updated threat back to the chunks, nothing changes their threat between the snapshot and now
+
+    ThreatSnapshot& snap = threat_snapshot;
+    for (size_t i = 0; i < snap.threat.size(); ++i) {
+        map_chunk_storage[i]->setThreat(snap.threat[i]);
+    }
+    applyHighestThreats();
+}
+
+void LocationHandler::findHighestThreats() {
+    // only reads and writes the snapshot, so it may run off the game thread
+    // chunks are visited in storage order, so ties always go to the same chunk
+
+    ThreatSnapshot& snap = threat_snapshot;
+    snap.max_threat = 0;
+    snap.max_pathable_threat = 0;
+    snap.max_threat_away = 0;
+    snap.max_pathable_threat_away = 0;
+    snap.max_index = -1;
+    snap.max_pathable_index = -1;
+    snap.max_index_away = -1;
+    snap.max_pathable_index_away = -1;
+
+    for (int i = 0; i < (int)snap.threat.size(); ++i) {
+        double chunk_threat = snap.threat[i];
+        bool pathable = snap.pathable[i];
+        bool away = snap.away[i];
+        if (chunk_threat > snap.max_threat) {
+            snap.max_threat = chunk_threat;
+            snap.max_index = i;
         }
-        if (pathable && chunk_threat > max_pathable_threat) {
-            max_pathable_threat = chunk_threat;
-            max_pathable_id = id;
+        if (pathable && chunk_threat > snap.max_pathable_threat) {
+            snap.max_pathable_threat = chunk_threat;
+            snap.max_pathable_index = i;
         }
-        if (away && chunk_threat > max_threat_away) {
-            max_threat_away = chunk_threat;
-            max_id_away = id;
+        if (away && chunk_threat > snap.max_threat_away) {
+            snap.max_threat_away = chunk_threat;
+            snap.max_index_away = i;
         }
-        if (pathable && away && chunk_threat > max_pathable_threat_away) {
-            max_pathable_threat_away = chunk_threat;
-            max_pathable_id_away = id;
+        if (pathable && away && chunk_threat > snap.max_pathable_threat_away) {
+            snap.max_pathable_threat_away = chunk_threat;
+            snap.max_pathable_index_away = i;
         }
     }
+}
+
+void LocationHandler::applyHighestThreats() {
+    // keep the previous highest threats where no chunk has any
 
-    if (max_id != -99) {
-        high_threat_chunk = map_chunk_by_id[max_id];
-        highest_threat = max_threat;
+    ThreatSnapshot& snap = threat_snapshot;
+    if (snap.max_index != -1) {
+        high_threat_chunk = map_chunk_storage[snap.max_index].get();
+        highest_threat = snap.max_threat;
     }
-    if (max_pathable_id != -99) {
-        high_threat_pathable_chunk = map_chunk_by_id[max_pathable_id];
-        highest_pathable_threat = max_pathable_threat;
+    if (snap.max_pathable_index != -1) {
+        high_threat_pathable_chunk = map_chunk_storage[snap.max_pathable_index].get();
+        highest_pathable_threat = snap.max_pathable_threat;
     }
-    if (max_id_away != -99) {
-        high_threat_chunk_away_from_start = map_chunk_by_id[max_id_away];
-        highest_threat_away_from_start = max_threat_away;
+    if (snap.max_index_away != -1) {
+        high_threat_chunk_away_from_start = map_chunk_storage[snap.max_index_away].get();
+        highest_threat_away_from_start = snap.max_threat_away;
     }
-    if (max_pathable_id_away != -99) {
-        high_threat_pathable_chunk_away_from_start = map_chunk_by_id[max_pathable_id_away];
-        highest_pathable_threat_away_from_start = max_pathable_threat_away;
+    if (snap.max_pathable_index_away != -1) {
+        high_threat_pathable_chunk_away_from_start = map_chunk_storage[snap.max_pathable_index_away].get();
+        highest_pathable_threat_away_from_start = snap.max_pathable_threat_away;
     }
-
 }
 
 
@@ -694,36 +939,19 @@ sc2::Point2D LocationHandler::getAttackingForceLocation() {
     // in between 2 clumps of mobs.
     // Very useful for keeping flyers in position with your attacking force.
 
-    auto coa = getCenterOfArmy();
-    auto mobs = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_FLYING, false);
-    if (mobs.empty())
-        return NO_POINT_FOUND;
-
-    float dist = std::numeric_limits<float>::max();
-    Mob* closest = nullptr;
-    for (auto m : mobs) {
-        auto d = sc2::DistanceSquared2D(m->unit.pos, coa);
-        if (d < dist) {
-            closest = m;
-            dist = d;
-        }
-    }
+    Mob* closest = agent->mobH->getArmyStats().nearest_to_center;
     if (closest == nullptr)
         return NO_POINT_FOUND;
     return closest->unit.pos;
 }
 
 sc2::Point2D LocationHandler::getCenterOfArmy() {
-    // returns the "center of mass" of army units
-
-    sc2::Point2D point_sum(0.0f, 0.0f);
+    // returns the "center of mass" of army units, or NO_POINT_FOUND without any
 
-    std::unordered_set<Mob*> attackers = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_ATTACKER);
-    for (auto it = attackers.begin(); it != attackers.end(); ++it) {
-        point_sum += (*it)->unit.pos;
-    }
-    int army_size = attackers.size();
-    return point_sum / army_size;
+    const ArmyStats& stats = agent->mobH->getArmyStats();
+    if (stats.num_attackers == 0)
+        return NO_POINT_FOUND;
+    return stats.attacker_center;
 }
 
 sc2::Point2D LocationHandler::getEnemyLocation()
@@ -790,7 +1018,11 @@ sc2::Point2D LocationHandler::smartPriorityAttack(bool pathable_) {
             return threat_away;
         }
         else {
-            sc2::Point2D center_of_mass = getCenterOfArmy();
+            const ArmyStats& stats = agent->mobH->getArmyStats();
+            if (stats.num_attackers == 0) {
+                return threat_away;
+            }
+            sc2::Point2D center_of_mass = stats.attacker_center;
             if (sc2::DistanceSquared2D(threat_home, center_of_mass) < sc2::DistanceSquared2D(threat_away, center_of_mass)) {
                 return threat_home;
             }
@@ -887,11 +1119,8 @@ sc2::Point2D LocationHandler::getFurthestUnseenLocation(bool pathable_) {
         return NO_POINT_FOUND;
     }
 
-    std::unordered_set<Mob*> mobs = agent->mobH->getMobs();
-    std::unordered_set<Mob*> flying_mobs = agent->mobH->filterByFlag(mobs, FLAGS::IS_FLYING);
-
     // should not happen, but lets make sure... this would mean game over
-    if (mobs.empty())
+    if (agent->mobH->getArmyStats().num_mobs == 0)
         return NO_POINT_FOUND;
 
     float furthest_dist = 0;
@@ -1016,7 +1245,7 @@ int LocationHandler::getPlayerIDForMap(int map_index, sc2::Point2D location) {
 void LocationHandler::initLocations(int map_index, int p_id) {
     // initialize location values
 
-    const sc2::ObservationInterface* observation = agent->Observation();
+    const sc2::ObservationInterface* observation = agent->getObservation();
     initSetStartLocation();
     
     if (map_index == 1) {
@@ -1406,9 +1635,6 @@ void LocationHandler::initLocations(int map_index, int p_id) {
     }
 
     sq_dist_threshold = (closest_sq_dist * .4);
-
-    initMapChunks();
-    scanChunks(agent->Observation());
 }
 
 void LocationHandler::initAddEnemyStartLocation(sc2::Point2D location_) {
@@ -1416,7 +1642,11 @@ void LocationHandler::initAddEnemyStartLocation(sc2::Point2D location_) {
 }
 
 float LocationHandler::pathDistFromStartLocation(sc2::QueryInterface* query_, sc2::Point2D location_) {
-    return query_->PathingDistance(start_location, location_);
+    agent->prof->countQuery();
+    long long trace_start = agent->tracer->now();
+    float dist = query_->PathingDistance(start_location, location_);
+    agent->tracer->span("Query::PathingDistance", trace_start);
+    return dist;
 }
 
 float LocationHandler::getSqDistThreshold() {
@@ -1427,82 +1657,44 @@ bool LocationHandler::spotReachable(const sc2::ObservationInterface* obs_, sc2::
     bool reachable = true;
     if (!obs_->IsPathable(to_loc_))
         return false;
-    if (query_->PathingDistance(from_loc_, to_loc_) == 0)
+    agent->prof->countQuery();
+    long long trace_start = agent->tracer->now();
+    float dist = query_->PathingDistance(from_loc_, to_loc_);
+    agent->tracer->span("Query::PathingDistance", trace_start);
+    if (dist == 0)
         return false;
     return true;
 }
 
-void LocationHandler::initMapChunks() {
-    std::cout << "initializing map chunks";
-    int pathable_count = 0;
-
-    const sc2::ObservationInterface* obs = agent->Observation();
-
-    sc2::GameInfo game_info = obs->GetGameInfo();
-    float chunk_size = CHUNK_SIZE;
-    float min_x = game_info.playable_min.x + chunk_size;
-    float min_y = game_info.playable_min.x + chunk_size;
-    float max_x;
-    float max_y;
-    map_center = sc2::Point2D((game_info.playable_max.x - game_info.playable_min.x) / 2 + game_info.playable_min.x, (game_info.playable_max.y - game_info.playable_min.y) / 2 + game_info.playable_min.y);
-
-    // chunk matrix size
-    int width = 0;
-    int height = 0;   
+void LocationHandler::startMapAnalysis() {
+    // start working out the chunk grid on a worker thread, see collectMapAnalysis
+    initSetStartLocation();
+    map_analysis->start(agent->getObservation(), start_location, CHUNK_SIZE);
+}
 
-    // set maximums to correspond to chunk locations
-    for (float x_ = min_x; x_ < game_info.playable_max.x; x_ += chunk_size) { 
-        max_x = x_;
-        ++width;
-    }
-    for (float y_ = min_y; y_ < game_info.playable_max.y; y_ += chunk_size) { 
-        max_y = y_; 
-        ++height;
-    }
+bool LocationHandler::collectMapAnalysis() {
+    // build the chunks once the worker has published the chunk grid, returns whether chunks are initialized
+    if (chunks_initialized)
+        return true;
+    const MapAnalysisResult* result = map_analysis->getResult();
+    if (!result)
+        return false;
 
     // store information
-    chunk_spread = chunk_size;
-    chunk_min_x = min_x;
-    chunk_min_y = min_y;
-    chunk_max_x = max_x;
-    chunk_max_y = max_y;
-    chunk_cols = width;
-    chunk_rows = height;
+    map_center = result->map_center;
+    chunk_spread = result->chunk_size;
+    chunk_min_x = result->min_x;
+    chunk_min_y = result->min_y;
+    chunk_max_x = result->max_x;
+    chunk_max_y = result->max_y;
+    chunk_cols = result->cols;
+    chunk_rows = result->rows;
+
+    for (int j = 0; j < chunk_rows; ++j) {
+        for (int i = 0; i < chunk_cols; ++i) {
+            sc2::Point2D loc_ = sc2::Point2D(chunk_min_x + (i * chunk_spread), chunk_min_y + (j * chunk_spread));
+            bool pathable_ = result->pathable[i + j * chunk_cols] != 0;
 
-    sc2::QueryInterface* query = agent->Query();
-
-
-    
-    // offsets to ensure a spot is fully reachable
-    std::vector<sc2::Point2D> offsets;
-
-    offsets.push_back(sc2::Point2D(0, 0));
-    for (float x_off = -1.0; x_off <= 1.0; x_off += 2.0) {
-        for (float y_off = -1.0; y_off <= 1.0; y_off += 2.0) {
-            offsets.push_back(sc2::Point2D(x_off, y_off));
-        }
-    }
-    
-    assert(offsets.size() == 5);
-
-    for (int j = 0; j < height; ++j) {
-        if (j % 2 == 0)
-            std::cout << ".";
-        for (int i = 0; i < width; ++i) {
-            sc2::Point2D loc_ = sc2::Point2D(min_x + (i * chunk_size), min_y + (j * chunk_size));
-            bool pathable_ = true;
-
-           
-            for (auto off_ : offsets) {
-                if (!spotReachable(obs, query, start_location, loc_ + off_)) {
-                    pathable_ = false;
-                    break;
-                }
-            }
-
-            if (pathable_)
-                ++pathable_count;
-                
             MapChunk chunk(agent, loc_, pathable_);
             map_chunk_storage.emplace_back(std::make_unique<MapChunk>(chunk));
             MapChunk* chunk_ptr = map_chunk_storage.back().get();
@@ -1511,12 +1703,12 @@ void LocationHandler::initMapChunks() {
                 pathable_map_chunks.insert(chunk_ptr);
             }
             map_chunk_by_id[chunk_ptr->getID()] = chunk_ptr;
+            chunk_index[chunk_ptr] = map_chunk_storage.size() - 1;
             sc2::Point2D chunk_loc = chunk_ptr->getLocation();
             map_chunk_by_coords[std::pair<float, float>(chunk_loc.x, chunk_loc.y)] = chunk_ptr;
         }
     }
 
-
     if (!enemy_start_locations.empty()) {
         double threat_amt = enemy_start_locations.size() * 2000 + 2000;
         for (auto esl : enemy_start_locations) {
@@ -1527,8 +1719,9 @@ void LocationHandler::initMapChunks() {
     }
 
     chunks_initialized = true;
-    std::cout << " " << map_chunks.size() << " chunks initialized (" << pathable_count << " pathable)" << std::endl;
-    agent->setLoadingProgress(4);
+    std::cout << "[" << agent->getObservation()->GetGameLoop() << "] " << map_chunks.size() << " chunks initialized (" << result->pathable_count << " pathable)" << std::endl;
+    scanChunks(agent->getObservation());
+    return true;
 }
 
 void LocationHandler::setEnemyStartLocation(sc2::Point2D location_)
@@ -1946,7 +2139,7 @@ float LocationHandler::distSquaredFromStart(sc2::Point2D loc_) {
         return (sc2::DistanceSquared2D(bases[0].getTownhall(), loc_));
     }
     else {
-        return(sc2::DistanceSquared2D(agent->Observation()->GetStartLocation(), loc_));
+        return(sc2::DistanceSquared2D(agent->getObservation()->GetStartLocation(), loc_));
     }
 }
 
@@ -1960,14 +2153,14 @@ void LocationHandler::setProxyLocation(sc2::Point2D location_) {
 
 void LocationHandler::initSetStartLocation()
 {
-    start_location = agent->Observation()->GetStartLocation();
+    start_location = agent->getObservation()->GetStartLocation();
 }
 
 sc2::Point2D LocationHandler::getEnemyStartLocationByIndex(int index_) {
     // it is important to ensure this still functions with indices out of range
     // as Strategy source files may not be able to know the number of indices
 
-    int num_locs = agent->Observation()->GetGameInfo().start_locations.size();
+    int num_locs = agent->getObservation()->GetGameInfo().start_locations.size();
     return enemy_start_locations.at(index_ % num_locs);
 }
 
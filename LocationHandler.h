@@ -6,11 +6,13 @@
 #include "sc2api/sc2_interfaces.h"
 #include "sc2api/sc2_typeenums.h"
 #include "Base.h"
+#include "MapAnalysis.h"
 
 # define NO_POINT_FOUND sc2::Point2D(-2.5252, -2.5252) // value indicating no point found
 # define CHUNK_SIZE 5.0f // the distance between adjacent chunks
 # define THREAT_DECAY 0.50 // the amount threat decays for a chunk when in vision
 # define NEARBY_THREAT_MODIFIER 0.05 // how much threat should increase for nearby chunks when enemies near
+# define CHUNK_SCAN_GRAIN 64 // chunks checked per pool job in scanChunks()
 
 class BasicSc2Bot;
 
@@ -28,9 +30,10 @@ public:
     bool isNearStart();
     bool inVision(const sc2::ObservationInterface* obs);
     void increaseThreat(BasicSc2Bot* agent_, float amount);
-    void checkVision(const sc2::ObservationInterface* obs);
+    void checkVision(int game_loop_, bool decay_ = true);
     void increaseThreat(BasicSc2Bot* agent_, const sc2::Unit* unit, float modifier_);
     void setThreat(double amt_);
+    static double decayedThreat(double threat_);
     sc2::Point2D getLocation();
 
 private:
@@ -47,6 +50,34 @@ private:
     double threat;                          // the calculated threat of this chunk
 };
 
+struct ThreatSnapshot {
+    // chunk threat copied on the game thread, so it can be decayed, added to, and searched off it
+    // indexed like the chunk storage, the max_ indexes are -1 when no chunk has threat
+    std::vector<double> threat;
+    std::vector<char> pathable;     // pathable and away never change, so they are only copied once
+    std::vector<char> away;
+    std::vector<char> visible;
+    std::vector<std::pair<int, double>> added;  // threat queued by queueThreat() since the last update, by chunk index
+    float max_threat;
+    float max_pathable_threat;
+    float max_threat_away;
+    float max_pathable_threat_away;
+    int max_index;
+    int max_pathable_index;
+    int max_index_away;
+    int max_pathable_index_away;
+};
+
+struct LocationProvider {
+    // a named location shared by every directive that targets it, computed at most once per game loop
+    std::string name;
+    std::function<sc2::Point2D()> compute;
+    int computed_loop;  // -1 until first computed
+    sc2::Point2D value;
+    long long evaluations;
+    long long requests;
+};
+
 class LocationHandler {
 public:
     LocationHandler(BasicSc2Bot* agent_);
@@ -58,7 +89,9 @@ public:
     sc2::Point2D getNearestValidRallyLocation(sc2::Point2D spot);
     sc2::Point2D getNearestStartLocation(sc2::Point2D spot);
     int getIndexOfClosestBase(sc2::Point2D location_);
-    void scanChunks(const sc2::ObservationInterface* obs);
+    void scanChunks(const sc2::ObservationInterface* obs, bool decay_ = true);
+    void copyVisibility(const sc2::ObservationInterface* obs);
+    sc2::Visibility getVisibility(sc2::Point2D point_);
     const sc2::Unit* getNearestMineralPatch(sc2::Point2D location);
     const sc2::Unit* getNearestGeyser(sc2::Point2D location);
     const sc2::Unit* getNearestGasStructure(sc2::Point2D location, bool allied=true);
@@ -72,9 +105,25 @@ public:
     sc2::Point2D smartAttackFlyingLocation();
     sc2::Point2D smartStayHomeAndDefend();
 
+    int registerLocationProvider(std::string name_, std::function<sc2::Point2D()> compute_);
+    int getLocationProviderID(std::string name_);
+    sc2::Point2D provideLocation(int provider_id_);
+    std::function<sc2::Point2D()> locationProvider(std::string name_);
+    long long getProviderEvaluations(int provider_id_);
+    long long getProviderRequests(int provider_id_);
+    void printLocationProviders();
+
     void calculateHighestThreatForChunks();
+    bool snapshotThreat();
+    void findHighestThreats();
+    void applyHighestThreats();
+    void queueThreat(MapChunk* chunk_, double amount_);
+    void updateThreat();
+    void applyThreat();
     int getPlayerIDForMap(int map_index, sc2::Point2D location);
     void initLocations(int map_index, int p_id);
+    void startMapAnalysis();
+    bool collectMapAnalysis();
     void setEnemyStartLocation(sc2::Point2D location_);
     void setProxyLocation(sc2::Point2D);
     sc2::Point2D getEnemyStartLocationByIndex(int index_);
@@ -127,9 +176,9 @@ public:
     float getSqDistThreshold();
 
 private:
+    void registerLocationProviders();
     void initSetStartLocation();
     void initAddEnemyStartLocation(sc2::Point2D location_);
-    void initMapChunks();
     sc2::Point2D getClosestUnseenLocation(bool pathable_=true);
     sc2::Point2D getFurthestUnseenLocation(bool pathable_=true);
     sc2::Point2D getClosestUnseenLocationToLastThreat(bool pathable_=true);
@@ -139,6 +188,7 @@ private:
     std::unordered_set<MapChunk*> map_chunks;
     std::unordered_set<MapChunk*> pathable_map_chunks;
     std::unordered_map<int, MapChunk*> map_chunk_by_id;
+    std::unordered_map<MapChunk*, int> chunk_index;  // position in map_chunk_storage
     std::map<std::pair<float, float>, MapChunk*> map_chunk_by_coords;
     std::vector<sc2::Point2D> enemy_start_locations;
     sc2::Point2D enemy_start_location;
@@ -146,6 +196,13 @@ private:
     sc2::Point2D start_location;
     int enemy_start_location_index;
     bool chunks_initialized;
+    std::shared_ptr<MapAnalysis> map_analysis;  // chunk grid worked out off the game thread
+    std::vector<LocationProvider> location_providers;
+    std::unordered_map<std::string, int> location_provider_by_name;
+    std::vector<char> visibility;  // copied by copyVisibility() once a step, indexed x + y * visibility_width
+    int visibility_width;
+    int visibility_height;
+    ThreatSnapshot threat_snapshot;  // only touched by updateThreat() and findHighestThreats() between the snapshot and applying it
     int chunk_rows;
     int chunk_cols;
     float chunk_spread;
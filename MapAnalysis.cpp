@@ -0,0 +1,162 @@
+#include "MapAnalysis.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+MapAnalysis::MapAnalysis() {
+	ready.store(false);
+	width = 0;
+	height = 0;
+	result.chunk_size = 0.0F;
+	result.cols = 0;
+	result.rows = 0;
+	result.pathable_count = 0;
+}
+
+MapAnalysis::~MapAnalysis() {
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+void MapAnalysis::start(const sc2::ObservationInterface* obs_, sc2::Point2D start_location_, float chunk_size_) {
+	// snapshot what the worker needs, then hand it off
+	if (isStarted())
+		return;
+	const sc2::GameInfo& game_info = obs_->GetGameInfo();
+	width = game_info.width;
+	height = game_info.height;
+	playable_min = game_info.playable_min;
+	playable_max = game_info.playable_max;
+	start_location = start_location_;
+	result.chunk_size = chunk_size_;
+
+	pathing.assign(width * height, 0);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			pathing[x + y * width] = obs_->IsPathable(sc2::Point2D(x + 0.5F, y + 0.5F));
+		}
+	}
+	worker = std::thread(&MapAnalysis::run, this);
+}
+
+bool MapAnalysis::isStarted() {
+	return worker.joinable() || ready.load(std::memory_order_acquire);
+}
+
+const MapAnalysisResult* MapAnalysis::getResult() {
+	// nullptr until the worker has finished
+	if (!ready.load(std::memory_order_acquire))
+		return nullptr;
+	if (worker.joinable()) {
+		worker.join();
+	}
+	return &result;
+}
+
+bool MapAnalysis::isReachable(sc2::Point2D point_) {
+	int x = (int)std::floor(point_.x);
+	int y = (int)std::floor(point_.y);
+	if (x < 0 || y < 0 || x >= width || y >= height)
+		return false;
+	return reachable[x + y * width] != 0;
+}
+
+void MapAnalysis::run() {
+	// flood fill the pathing grid from the pathable cell nearest our start location,
+	// which is itself covered by our townhall
+	reachable.assign(width * height, 0);
+	int seed = -1;
+	int sx = (int)start_location.x;
+	int sy = (int)start_location.y;
+	for (int r = 0; r < std::max(width, height) && seed == -1; ++r) {
+		for (int y = sy - r; y <= sy + r && seed == -1; ++y) {
+			for (int x = sx - r; x <= sx + r; ++x) {
+				if (x < 0 || y < 0 || x >= width || y >= height)
+					continue;
+				if (pathing[x + y * width]) {
+					seed = x + y * width;
+					break;
+				}
+			}
+		}
+	}
+	if (seed != -1) {
+		std::deque<int> open;
+		open.push_back(seed);
+		reachable[seed] = 1;
+		const int dx[] = { 1, -1, 0, 0 };
+		const int dy[] = { 0, 0, 1, -1 };
+		while (!open.empty()) {
+			int cell = open.front();
+			open.pop_front();
+			int x = cell % width;
+			int y = cell / width;
+			for (int d = 0; d < 4; ++d) {
+				int nx = x + dx[d];
+				int ny = y + dy[d];
+				if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+					continue;
+				int next = nx + ny * width;
+				if (pathing[next] && !reachable[next]) {
+					reachable[next] = 1;
+					open.push_back(next);
+				}
+			}
+		}
+	}
+
+	// chunk grid, laid out as LocationHandler has always laid it out
+	float chunk_size = result.chunk_size;
+	float min_x = playable_min.x + chunk_size;
+	float min_y = playable_min.x + chunk_size;
+	float max_x = min_x;
+	float max_y = min_y;
+	int cols = 0;
+	int rows = 0;
+	for (float x_ = min_x; x_ < playable_max.x; x_ += chunk_size) {
+		max_x = x_;
+		++cols;
+	}
+	for (float y_ = min_y; y_ < playable_max.y; y_ += chunk_size) {
+		max_y = y_;
+		++rows;
+	}
+	result.min_x = min_x;
+	result.min_y = min_y;
+	result.max_x = max_x;
+	result.max_y = max_y;
+	result.cols = cols;
+	result.rows = rows;
+	result.map_center = sc2::Point2D((playable_max.x - playable_min.x) / 2 + playable_min.x, (playable_max.y - playable_min.y) / 2 + playable_min.y);
+
+	// offsets to ensure a spot is fully reachable
+	std::vector<sc2::Point2D> offsets;
+	offsets.push_back(sc2::Point2D(0, 0));
+	for (float x_off = -1.0; x_off <= 1.0; x_off += 2.0) {
+		for (float y_off = -1.0; y_off <= 1.0; y_off += 2.0) {
+			offsets.push_back(sc2::Point2D(x_off, y_off));
+		}
+	}
+
+	result.pathable.assign(cols * rows, 0);
+	result.pathable_count = 0;
+	for (int j = 0; j < rows; ++j) {
+		for (int i = 0; i < cols; ++i) {
+			sc2::Point2D loc = sc2::Point2D(min_x + (i * chunk_size), min_y + (j * chunk_size));
+			bool pathable = true;
+			for (auto off : offsets) {
+				if (!isReachable(loc + off)) {
+					pathable = false;
+					break;
+				}
+			}
+			if (pathable) {
+				result.pathable[i + j * cols] = 1;
+				result.pathable_count++;
+			}
+		}
+	}
+
+	ready.store(true, std::memory_order_release);
+}
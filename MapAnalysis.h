@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "sc2api/sc2_api.h"
+
+struct MapAnalysisResult {
+	// chunk grid, chunk (i, j) is at (min_x + i * chunk_size, min_y + j * chunk_size)
+	float chunk_size;
+	float min_x;
+	float min_y;
+	float max_x;
+	float max_y;
+	int cols;
+	int rows;
+	sc2::Point2D map_center;
+	std::vector<char> pathable;	// per chunk, row by row
+	int pathable_count;
+};
+
+class MapAnalysis {
+// Works out the chunk grid and which chunks are reachable from our start location on a worker
+// thread, so the game thread keeps stepping while it runs. The pathing grid is copied on the game
+// thread in start(), since the sc2 interfaces may only be used from there, and reachability comes
+// from a flood fill of that copy instead of a pathing query per chunk. The result is published
+// with a release store, and getResult() returns it once it is complete
+public:
+	MapAnalysis();
+	~MapAnalysis();
+	void start(const sc2::ObservationInterface* obs_, sc2::Point2D start_location_, float chunk_size_);
+	bool isStarted();
+	const MapAnalysisResult* getResult();
+
+private:
+	MapAnalysis(const MapAnalysis&);
+	MapAnalysis& operator=(const MapAnalysis&);
+	void run();
+	bool isReachable(sc2::Point2D point_);
+
+	std::thread worker;
+	std::atomic<bool> ready;
+	MapAnalysisResult result;	// only written by the worker until ready is set
+
+	// copied from the game thread before the worker starts
+	int width;
+	int height;
+	std::vector<char> pathing;	// per map cell, 1 if pathable
+	std::vector<char> reachable;	// per map cell, 1 if reachable from the start location
+	sc2::Point2D playable_min;
+	sc2::Point2D playable_max;
+	sc2::Point2D start_location;
+};
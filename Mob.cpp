@@ -32,7 +32,6 @@ void Mob::initVars() {
 	tag = unit.tag;
 	cooldown = 0;
 	has_default_directive = false;
-	has_bundled_directive = false;
 	has_current_directive = false;
 	is_harvesting_gas = false;
 	is_harvesting_minerals = false;
@@ -40,10 +39,19 @@ void Mob::initVars() {
 	home_location = unit.pos;
 	assigned_location = unit.pos;
 	current_directive = nullptr;
+	default_directive = nullptr;
 	std::unordered_set<FLAGS> flags;
 	std::unordered_set<Mob*> harvesters;
 	gas_structure_harvested = nullptr;
 	townhall_for_minerals = nullptr;
+	handler = nullptr;
+	index = -1;
+	state = MOB_STATE::ANY;
+	state_prev = nullptr;
+	state_next = nullptr;
+	seen_ability = sc2::ABILITY_ID::INVALID;
+	seen_target = 0;
+	seen_directive = nullptr;
 }
 
 bool Mob::isIdle() {
@@ -55,14 +63,22 @@ bool Mob::hasFlag(FLAGS flag) {
 }
 
 void Mob::assignDefaultDirective(BasicSc2Bot* agent, Directive* directive_) {
-	if (has_default_directive) {
-		delete default_directive;
-	}
+	// directive_ should come from agent->acquireDefaultDirective(), whose reference is handed to this mob
+	releaseDefaultDirective(agent);
 	directive_->setDefault(); // change directive type to default directive
-	default_directive = agent->directive_by_id[directive_->getID()];
+	default_directive = agent->getDirective(directive_->getStorageID());
 	has_default_directive = true;
 }
 
+void Mob::releaseDefaultDirective(BasicSc2Bot* agent) {
+	// give back this mob's reference to its default directive, shared default directives are reclaimed once unused
+	if (default_directive != nullptr) {
+		agent->releaseDirective(default_directive);
+	}
+	default_directive = nullptr;
+	has_default_directive = false;
+}
+
 void Mob::assignDirective(Directive* directive_) {
 	// set the mob's current directive
 	current_directive = directive_;
@@ -81,7 +97,7 @@ bool Mob::hasDefaultDirective() {
 
 bool Mob::hasBundledDirective() {
 	// Return whether the mob has bundled directives in queue 
-	return has_bundled_directive;
+	return !bundle_chains.empty();
 }
 
 bool Mob::hasCurrentDirective() {
@@ -101,45 +117,82 @@ void Mob::disableDefaultDirective()
 	has_default_directive = false;
 }
 
-void Mob::bundleDirectives(std::vector<Directive> dir_vec) {
-	// bundle the orders to be executed after this unit is 
-	// completed its current order
-	if (hasBundledDirective())
-		delete bundled_directive;
-
-	Directive* direc = new Directive(dir_vec.front());
-	dir_vec.erase(dir_vec.begin());
+void Mob::setBundleChain(int start_, int length_) {
+	// bundle the orders to be executed, one each time this unit is idle, after it has completed its current order
+	// they run before any bundle this mob already carries, which resumes once they are done
+	if (length_ > 0)
+		bundle_chains.emplace_back(start_, start_ + length_);
+}
 
-	if (dir_vec.size() > 0) {
-		for (auto d : dir_vec) {
-			direc->bundleDirective(d);
-		}
-	}
-	has_bundled_directive = true;
-	bundled_directive = direc;
+void Mob::takeBundleChains(BasicSc2Bot* agent) {
+	// take over what is left of the bundles another mob was walking, replacing any orders left from a previous bundle
+	agent->takeBundleRemainder(bundle_chains);
 }
 
 
 void Mob::setFlag(FLAGS flag) {
-	flags.insert(flag);
+	if (flags.insert(flag).second && handler)
+		handler->flagChanged(this, flag, true);
 }
 
 void Mob::removeFlag(FLAGS flag) {
-	flags.erase(flag);
+	if (flags.erase(flag) && handler)
+		handler->flagChanged(this, flag, false);
+}
+
+void Mob::setHandler(MobHandler* handler_, int index_) {
+	handler = handler_;
+	index = index_;
+}
+
+int Mob::getIndex() {
+	return index;
+}
+
+MOB_STATE Mob::getState() {
+	return state;
+}
+
+bool Mob::ordersChanged() {
+	// whether the first order or the current directive differ from the last call
+	// only the first order is compared, so this is cheap enough to call for every busy mob on every step
+
+	sc2::ABILITY_ID ability = sc2::ABILITY_ID::INVALID;
+	sc2::Tag target = 0;
+	sc2::Point2D target_pos;
+	if (!unit.orders.empty()) {
+		const sc2::UnitOrder& order = unit.orders.front();
+		ability = order.ability_id;
+		target = order.target_unit_tag;
+		target_pos = order.target_pos;
+	}
+	Directive* directive = getCurrentDirective();
+	if (ability == seen_ability && target == seen_target && target_pos == seen_target_pos && directive == seen_directive)
+		return false;
+	seen_ability = ability;
+	seen_target = target;
+	seen_target_pos = target_pos;
+	seen_directive = directive;
+	return true;
 }
 
 void Mob::giveCooldown(BasicSc2Bot* agent, int amt)
 {
 	// put this mob on cooldown
-	cooldown = agent->Observation()->GetGameLoop() + amt;
+	cooldown = agent->getObservation()->GetGameLoop() + amt;
 }
 
-Directive Mob::popBundledDirective() {
-	// get the directive bundled on this mob and simultaneously remove it from this mob
-	Directive bundled = *bundled_directive;
-	delete bundled_directive;
-	has_bundled_directive = false;
-	return bundled;
+Directive* Mob::popBundledDirective(BasicSc2Bot* agent) {
+	// get the next directive bundled on this mob and hand the rest of its bundles to the bot,
+	// they follow whichever mob carries out the directive, see Directive::handBundle()
+	if (!hasBundledDirective())
+		return nullptr;
+	std::pair<int, int>& chain = bundle_chains.back();
+	Directive* next = agent->getBundledDirective(chain.first++);
+	if (chain.first == chain.second)
+		bundle_chains.pop_back();
+	agent->setBundleRemainder(bundle_chains);
+	return next;
 }
 
 bool Mob::isCarryingMinerals() {
@@ -171,7 +224,7 @@ bool Mob::isOnCooldown(BasicSc2Bot* agent)
 {
 	// returns whether this unit is on cooldown (i.e. should not take commands)
 
-	return (agent->Observation()->GetGameLoop() < cooldown);
+	return (agent->getObservation()->GetGameLoop() < cooldown);
 }
 
 void Mob::setHomeLocation(sc2::Point2D location) {
@@ -336,7 +389,7 @@ bool Mob::harvestNearbyTownhall(BasicSc2Bot* agent)
 		stopHarvestingMinerals();
 	}
 
-	auto townhalls = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_TOWNHALL);
+	auto townhalls = agent->mobH->getMobsWithFlags({ FLAGS::IS_TOWNHALL });
 	if (townhalls.empty()) {
 		return false;
 	}
@@ -350,8 +403,7 @@ bool Mob::harvestNearbyTownhall(BasicSc2Bot* agent)
 	setHarvestingMinerals(townhall);
 	setAssignedLocation(townhall->unit.pos);
 	Directive directive_get_minerals(Directive::DEFAULT_DIRECTIVE, Directive::GET_MINERALS_NEAR_LOCATION, unit.unit_type, sc2::ABILITY_ID::HARVEST_GATHER, unit.pos);
-	agent->storeDirective(directive_get_minerals);
-	Directive* dir = agent->getLastStoredDirective();
+	Directive* dir = agent->acquireDefaultDirective(directive_get_minerals);
 	if (hasDefaultDirective()) {
 		if (default_directive != nullptr) {
 			default_directive->unassignMob(this);
@@ -360,11 +412,11 @@ bool Mob::harvestNearbyTownhall(BasicSc2Bot* agent)
 	assignDefaultDirective(agent, dir);
 	
 	if (isCarryingMinerals()) {
-		agent->Actions()->UnitCommand(&unit, sc2::ABILITY_ID::HARVEST_RETURN, &townhall->unit);
-		agent->Actions()->UnitCommand(&unit, sc2::ABILITY_ID::GENERAL_MOVE, mineral_target->pos, true);
+		agent->getActions()->UnitCommand(&unit, sc2::ABILITY_ID::HARVEST_RETURN, &townhall->unit);
+		agent->getActions()->UnitCommand(&unit, sc2::ABILITY_ID::GENERAL_MOVE, mineral_target->pos, true);
 	}
 	else {
-		agent->Actions()->UnitCommand(&unit, sc2::ABILITY_ID::GENERAL_MOVE, mineral_target->pos);
+		agent->getActions()->UnitCommand(&unit, sc2::ABILITY_ID::GENERAL_MOVE, mineral_target->pos);
 	}
 	return true;
 
@@ -375,7 +427,7 @@ bool Mob::grabNearbyMineralHarvester(BasicSc2Bot* agent, bool grab_from_gas, boo
 	// called from a townhall to grab a nearby mob from gas and assign to minerals
 	assert(hasFlag(FLAGS::IS_TOWNHALL));
 
-	std::unordered_set<Mob*> nearby_workers = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_WORKER);
+	std::unordered_set<Mob*> nearby_workers = agent->mobH->getMobsWithFlags({ FLAGS::IS_WORKER });
 	if (nearby_workers.empty()) {
 		return false;
 	}
@@ -429,22 +481,21 @@ bool Mob::grabNearbyMineralHarvester(BasicSc2Bot* agent, bool grab_from_gas, boo
 	nearest->setHarvestingMinerals(this);
 	nearest->setAssignedLocation(unit.pos);
 	Directive directive_get_minerals(Directive::DEFAULT_DIRECTIVE, Directive::GET_MINERALS_NEAR_LOCATION, nearest->unit.unit_type, sc2::ABILITY_ID::HARVEST_GATHER, unit.pos);
-	agent->storeDirective(directive_get_minerals);
-	Directive* dir = agent->getLastStoredDirective();
+	Directive* dir = agent->acquireDefaultDirective(directive_get_minerals);
 	nearest->assignDefaultDirective(agent, dir);
 	const sc2::Unit* mineral_target = agent->locH->getNearestMineralPatch(unit.pos);
 	if (grab_from_other_townhall) {
 		if (nearest->isCarryingMinerals()) {
 			auto town = agent->locH->getNearestTownhall(nearest->unit.pos);
-			agent->Actions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::HARVEST_RETURN, &town);
-			agent->Actions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::GENERAL_MOVE, mineral_target->pos, true);
+			agent->getActions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::HARVEST_RETURN, &town);
+			agent->getActions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::GENERAL_MOVE, mineral_target->pos, true);
 		}
 		else {
-			agent->Actions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::GENERAL_MOVE, mineral_target->pos);
+			agent->getActions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::GENERAL_MOVE, mineral_target->pos);
 		}
 	}
 	else {
-		agent->Actions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::HARVEST_GATHER, &mineral_target);
+		agent->getActions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::HARVEST_GATHER, &mineral_target);
 	}
 	return true;
 
@@ -455,8 +506,7 @@ bool Mob::grabNearbyGasHarvester(BasicSc2Bot* agent) {
 	// called from a gas structure to take a nearby mob off of minerals
 	assert(hasFlag(FLAGS::IS_GAS_STRUCTURE));
 
-	std::unordered_set<Mob*> nearby_workers = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_WORKER);
-	nearby_workers = agent->mobH->filterByFlag(nearby_workers, FLAGS::IS_MINERAL_GATHERER);
+	std::unordered_set<Mob*> nearby_workers = agent->mobH->getMobsWithFlags({ FLAGS::IS_WORKER, FLAGS::IS_MINERAL_GATHERER });
 	nearby_workers = Directive::filterNearLocation(nearby_workers, unit.pos, 30.0F);
 	std::unordered_set<Mob*> filtered;
 	std::copy_if(nearby_workers.begin(), nearby_workers.end(), std::inserter(filtered, filtered.begin()),
@@ -477,10 +527,9 @@ bool Mob::grabNearbyGasHarvester(BasicSc2Bot* agent) {
 	nearest->setHarvestingGas(this);
 
 	Directive directive_get_gas(Directive::DEFAULT_DIRECTIVE, Directive::GET_GAS_NEAR_LOCATION, nearest->unit.unit_type, sc2::ABILITY_ID::HARVEST_GATHER, unit.pos);
-	agent->storeDirective(directive_get_gas);
-	Directive* dir = agent->getLastStoredDirective();
+	Directive* dir = agent->acquireDefaultDirective(directive_get_gas);
 	nearest->assignDefaultDirective(agent, dir);
-	agent->Actions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::HARVEST_GATHER, &unit);
+	agent->getActions()->UnitCommand(&(nearest->unit), sc2::ABILITY_ID::HARVEST_GATHER, &unit);
 	return true;
 }
 
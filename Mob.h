@@ -1,10 +1,11 @@
 #pragma once
 #include "sc2api/sc2_api.h"
-#include "Directive.h"
-#include "BasicSc2Bot.h"
+#include <cstdint>
+#include <unordered_set>
 
 class Directive;
 class BasicSc2Bot;
+class MobHandler;
 
 enum class MOB {
 	MOB_STRUCTURE,
@@ -42,6 +43,39 @@ enum class FLAGS {
 	GROUND
 };
 
+typedef uint32_t FlagMask;	// one bit per FLAGS value
+
+inline FlagMask flagBit(FLAGS flag) {
+	return (FlagMask)1 << (int)flag;
+}
+
+inline FlagMask flagMask(const std::unordered_set<FLAGS>& flags) {
+	FlagMask mask = 0;
+	for (auto f : flags) {
+		mask |= flagBit(f);
+	}
+	return mask;
+}
+
+inline std::unordered_set<FLAGS> flagSet(FlagMask mask) {
+	std::unordered_set<FLAGS> flags;
+	for (int i = 0; mask != 0; ++i, mask >>= 1) {
+		if (mask & 1)
+			flags.insert((FLAGS)i);
+	}
+	return flags;
+}
+
+enum class MOB_STATE {
+	ANY,	// neither idle nor busy, when describing a mob
+	IDLE,
+	BUSY
+};
+
+// after the flags and states, which MobHandler.h needs when it is reached through these
+#include "Directive.h"
+#include "BasicSc2Bot.h"
+
 class Mob {
 public:
 	Mob(const sc2::Unit& unit_, MOB mobs_type);
@@ -49,6 +83,7 @@ public:
 	bool isIdle();
 	bool hasFlag(FLAGS flag);
 	void assignDefaultDirective(BasicSc2Bot* agent, Directive* directive_);
+	void releaseDefaultDirective(BasicSc2Bot* agent);
 	void assignDirective(Directive* directive_);
 	void unassignDirective();
 	bool hasDefaultDirective();
@@ -56,7 +91,7 @@ public:
 	bool hasCurrentDirective();
 	bool executeDefaultDirective(BasicSc2Bot* agent);
 	void disableDefaultDirective();
-	Directive popBundledDirective();
+	Directive* popBundledDirective(BasicSc2Bot* agent);
 	bool isCarryingMinerals();
 	bool isCarryingGas();
 	bool isOnCooldown(BasicSc2Bot* agent);
@@ -68,7 +103,8 @@ public:
 	sc2::Point2D getAssignedLocation();
 	void setHomeLocation(sc2::Point2D location);
 	void setAssignedLocation(sc2::Point2D location);
-	void bundleDirectives(std::vector<Directive> dir_vec);
+	void setBundleChain(int start_, int length_);
+	void takeBundleChains(BasicSc2Bot* agent);
 	std::unordered_set<FLAGS> getFlags();
 	sc2::Tag getTag();
 	bool setCurrentDirective(Directive* directive_);
@@ -89,17 +125,22 @@ public:
 	bool harvestNearbyTownhall(BasicSc2Bot* agent);
 	bool grabNearbyMineralHarvester(BasicSc2Bot* agent, bool grab_from_gas=true, bool grab_from_other_townhall=false);
 	bool grabNearbyGasHarvester(BasicSc2Bot* agent);
+	void setHandler(MobHandler* handler_, int index_);
+	int getIndex();
+	MOB_STATE getState();
+	bool ordersChanged();
 	bool operator<(const Mob& mob) const { return tag < mob.tag; }
 	const sc2::Unit& unit;
 	
 private:
+	friend class MobHandler;	// links mobs into its idle and busy queues
+
 	std::unordered_set<FLAGS> flags;
 	sc2::Point2D birth_location;
 	sc2::Point2D home_location;
 	sc2::Point2D assigned_location;
 	sc2::Tag tag; // a unique identifier given to units
 	bool has_default_directive;
-	bool has_bundled_directive;
 	bool has_current_directive;
 	bool is_harvesting_gas;
 	bool is_harvesting_minerals;
@@ -108,6 +149,15 @@ private:
 	Mob* gas_structure_harvested;
 	Mob* townhall_for_minerals;
 	Directive* default_directive;
-	Directive* bundled_directive;
+	std::vector<std::pair<int, int>> bundle_chains;	// (cursor, end) into the bot's bundle chains, innermost bundle last, see BasicSc2Bot::storeBundleChain()
 	Directive* current_directive;
+	MobHandler* handler;	// told about flag changes so it can keep its indexes, nullptr for mobs not in storage
+	int index;				// slot in the handler's storage
+	MOB_STATE state;		// which of the handler's queues the mob is linked into
+	Mob* state_prev;
+	Mob* state_next;
+	sc2::ABILITY_ID seen_ability;	// first order and directive as of the last ordersChanged()
+	sc2::Tag seen_target;
+	sc2::Point2D seen_target_pos;
+	Directive* seen_directive;
 };
\ No newline at end of file
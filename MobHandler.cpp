@@ -5,13 +5,17 @@
 #include "sc2api/sc2_unit_filters.h"
 #include "sc2api/sc2_interfaces.h"
 #include "sc2api/sc2_typeenums.h"
+#include <algorithm>
+#include <limits>
 
 MobHandler::MobHandler(BasicSc2Bot* agent) {
     this->agent = agent;
+    army_stats.game_loop = -1;
 }
 
 MobHandler::MobHandler(const MobHandler& rhs) {
 	this->agent = rhs.agent;
+    army_stats.game_loop = -1;
 }
 
 MobHandler& MobHandler::operator=(const MobHandler& rhs) {
@@ -32,11 +36,14 @@ void MobHandler::setMobIdle(Mob* mob_, bool is_true) {
 		mob_->setFlag(FLAGS::IS_IDLE);
 		mob_->removeFlag(FLAGS::IS_BUILDING_STRUCTURE);
 		setMobBusy(mob_, false);
-		idle_mobs.insert(mob);
+		linkMob(mob, MOB_STATE::IDLE);
+		setBit(idle_index, mob->getIndex(), true);
 	}
 	else {
 		mob_->removeFlag(FLAGS::IS_IDLE);
-		idle_mobs.erase(mob);
+		if (mob->getState() == MOB_STATE::IDLE)
+			unlinkMob(mob);
+		setBit(idle_index, mob->getIndex(), false);
 	}
 }
 
@@ -47,10 +54,13 @@ void MobHandler::setMobBusy(Mob* mob_, bool is_true) {
 	Mob* mob = &getMob(mob_->unit); // ensure we are pointing to the mob in our storage
 	if (is_true) {
 		setMobIdle(mob_, false);
-		busy_mobs.insert(mob);
+		linkMob(mob, MOB_STATE::BUSY);
+		setBit(busy_index, mob->getIndex(), true);
 	}
 	else {
-		busy_mobs.erase(mob);
+		if (mob->getState() == MOB_STATE::BUSY)
+			unlinkMob(mob);
+		setBit(busy_index, mob->getIndex(), false);
 	}
 }
 
@@ -61,9 +71,22 @@ bool MobHandler::addMob(Mob mob_) {
 		return false;
 
 	mobs_storage.emplace_back(std::make_unique<Mob>(mob_));
+	Mob* mob = mobs_storage.back().get();
+	int index = mobs_storage.size() - 1;
 
-	mobs.insert(mobs_storage.back().get());
-	mob_by_tag[mob_.unit.tag] = mobs_storage.back().get();
+	mobs.insert(mob);
+	mob_by_tag[mob_.unit.tag] = mob;
+	army_stats.game_loop = -1;
+
+	// index the flags the mob starts with, later changes are reported through flagChanged()
+	mob->setHandler(this, index);
+	setBit(alive_index, index, true);
+	for (auto f : mob->getFlags()) {
+		flagChanged(mob, f, true);
+	}
+	indexed_type.resize(mobs_storage.size());
+	indexed_type[index] = (int)mob->unit.unit_type.ToType();
+	setBit(type_index[indexed_type[index]], index, true);
 
 	return true;
 }
@@ -84,13 +107,16 @@ void MobHandler::mobDeath(Mob* mob_)
 {
 	Mob* mob = &getMob(mob_->unit);
 	setMobIdle(mob, false);
-	setMobIdle(mob, false);
+	setMobBusy(mob, false);
 	for (auto f : mob->getFlags()) {
 		mob->removeFlag(f);
 	}
 	mob->stopHarvestingGas();
+	mob->releaseDefaultDirective(agent);
 	dead_mobs.insert(mob);
 	mobs.erase(mob);
+	army_stats.game_loop = -1;
+	setBit(alive_index, mob->getIndex(), false);
 }
 
 int MobHandler::getNumDeadMobs() {
@@ -101,13 +127,18 @@ bool MobHandler::nearbyMobsWithFlagsAttackTarget(std::unordered_set<FLAGS> flags
 	Directive d(Directive::MATCH_FLAGS_NEAR_LOCATION, Directive::TARGET_UNIT_NEAR_LOCATION, flags, sc2::ABILITY_ID::ATTACK, unit->pos, unit->pos, range, 1.0F);
 	d.allowMultiple();
 	d.setDebug(true);
-	agent->storeDirective(d);
-	return d.execute(agent);
+
+	// execute the stored copy, mobs carrying it out keep a pointer to it
+	Directive* stored = agent->storeTransientDirective(d);
+	return stored->execute(agent);
 }
 
 std::unordered_set<Mob*> MobHandler::getIdleWorkers() {
 	// get idle mobs, but specifically those that are workers
-	return filterByFlag(idle_mobs, FLAGS::IS_WORKER);
+	MobQuery query;
+	query.flags = flagBit(FLAGS::IS_WORKER);
+	query.state = MOB_STATE::IDLE;
+	return queryMobs(query);
 }
 
 std::unordered_set<Mob*> MobHandler::filterByFlag(std::unordered_set<Mob*> mobs_set, FLAGS flag, bool is_true) {
@@ -169,13 +200,310 @@ std::unordered_set<Mob*> MobHandler::getMobs() {
 }
 
 std::unordered_set<Mob*> MobHandler::getIdleMobs() {
+    std::unordered_set<Mob*> idle_mobs;
+    for (Mob* m = idle_queue.head; m != nullptr; m = m->state_next) {
+        idle_mobs.insert(m);
+    }
     return idle_mobs;
 }
 
 std::unordered_set<Mob*> MobHandler::getBusyMobs() {
+	std::unordered_set<Mob*> busy_mobs;
+	for (Mob* m = busy_queue.head; m != nullptr; m = m->state_next) {
+		busy_mobs.insert(m);
+	}
 	return busy_mobs;
 }
 
+void MobHandler::copyIdleMobs(std::vector<Mob*>& mobs_) {
+	// fills mobs_ with the idle mobs, oldest first, reusing its memory
+	mobs_.clear();
+	for (Mob* m = idle_queue.head; m != nullptr; m = m->state_next) {
+		mobs_.push_back(m);
+	}
+}
+
+void MobHandler::copyBusyMobs(std::vector<Mob*>& mobs_) {
+	// fills mobs_ with the busy mobs, oldest first, reusing its memory
+	mobs_.clear();
+	for (Mob* m = busy_queue.head; m != nullptr; m = m->state_next) {
+		mobs_.push_back(m);
+	}
+}
+
+int MobHandler::getNumIdleMobs() {
+	return idle_queue.size;
+}
+
+int MobHandler::getNumBusyMobs() {
+	return busy_queue.size;
+}
+
+void MobHandler::linkMob(Mob* mob_, MOB_STATE state_) {
+	// move mob_ to the back of the queue for state_, a mob is in at most one queue
+
+	if (mob_->state == state_)
+		return;
+	if (mob_->state != MOB_STATE::ANY) {
+		unlinkMob(mob_);
+	}
+	MobQueue& queue = state_ == MOB_STATE::IDLE ? idle_queue : busy_queue;
+	mob_->state = state_;
+	mob_->state_prev = queue.tail;
+	mob_->state_next = nullptr;
+	if (queue.tail)
+		queue.tail->state_next = mob_;
+	else
+		queue.head = mob_;
+	queue.tail = mob_;
+	queue.size++;
+}
+
+void MobHandler::unlinkMob(Mob* mob_) {
+	if (mob_->state == MOB_STATE::ANY)
+		return;
+	MobQueue& queue = mob_->state == MOB_STATE::IDLE ? idle_queue : busy_queue;
+	if (mob_->state_prev)
+		mob_->state_prev->state_next = mob_->state_next;
+	else
+		queue.head = mob_->state_next;
+	if (mob_->state_next)
+		mob_->state_next->state_prev = mob_->state_prev;
+	else
+		queue.tail = mob_->state_prev;
+	mob_->state = MOB_STATE::ANY;
+	mob_->state_prev = nullptr;
+	mob_->state_next = nullptr;
+	queue.size--;
+}
+
 std::unordered_set<Mob*> MobHandler::getMobGroupByName(std::string mobName) {
 	return mob_group_by_name[mobName];
 }
+
+void MobHandler::addMobToGroup(std::string group_, Mob* mob_) {
+	Mob* mob = &getMob(mob_->unit); // ensure we are pointing to the mob in our storage
+	mob_group_by_name[group_].insert(mob);
+	setBit(group_index[group_], mob->getIndex(), true);
+}
+
+void MobHandler::removeMobFromGroup(std::string group_, Mob* mob_) {
+	Mob* mob = &getMob(mob_->unit); // ensure we are pointing to the mob in our storage
+	mob_group_by_name[group_].erase(mob);
+	setBit(group_index[group_], mob->getIndex(), false);
+}
+
+void MobHandler::syncUnitTypes() {
+	// move mobs whose unit has morphed (e.g. a gateway to a warp gate, or a lowered supply depot) to the index of their new type
+	// called on the game thread at the start of each step, before anything looks mobs up by type
+
+	for (auto m : mobs) {
+		int index = m->getIndex();
+		int unit_type = (int)m->unit.unit_type.ToType();
+		if (indexed_type[index] != unit_type) {
+			setBit(type_index[indexed_type[index]], index, false);
+			setBit(type_index[unit_type], index, true);
+			indexed_type[index] = unit_type;
+		}
+	}
+}
+
+void MobHandler::flagChanged(Mob* mob_, FLAGS flag_, bool is_true) {
+	// called by mobs in storage whenever one of their flags changes
+
+	int index = mob_->getIndex();
+	if (index < 0 || index >= (int)mobs_storage.size() || mobs_storage[index].get() != mob_)
+		return; // a copy of a stored mob, not the mob itself
+	if ((int)flag_ >= (int)flag_index.size()) {
+		flag_index.resize((int)flag_ + 1);
+	}
+	setBit(flag_index[(int)flag_], index, is_true);
+}
+
+void MobHandler::setBit(MobBits& bits_, int index_, bool is_true) {
+	if (index_ < 0)
+		return;
+	size_t word = index_ / 64;
+	if (word >= bits_.size()) {
+		if (!is_true)
+			return;
+		bits_.resize(word + 1, 0);
+	}
+	uint64_t mask = (uint64_t)1 << (index_ % 64);
+	if (is_true)
+		bits_[word] |= mask;
+	else
+		bits_[word] &= ~mask;
+}
+
+bool MobHandler::intersectQuery(const MobQuery& query_, MobBits& result_) {
+	// AND together the index of every part of the query, returns false as soon as nothing can match
+
+	result_ = alive_index;
+	auto intersect = [&result_](const MobBits& bits_) {
+		for (size_t i = 0; i < result_.size(); ++i) {
+			result_[i] &= i < bits_.size() ? bits_[i] : 0;
+		}
+	};
+	auto subtract = [&result_](const MobBits& bits_) {
+		for (size_t i = 0; i < result_.size() && i < bits_.size(); ++i) {
+			result_[i] &= ~bits_[i];
+		}
+	};
+
+	for (int f = 0; (query_.flags >> f) != 0; ++f) {
+		if (!((query_.flags >> f) & 1))
+			continue;
+		if (f >= (int)flag_index.size())
+			return false;
+		intersect(flag_index[f]);
+	}
+	for (int f = 0; (query_.exclude_flags >> f) != 0 && f < (int)flag_index.size(); ++f) {
+		if ((query_.exclude_flags >> f) & 1) {
+			subtract(flag_index[f]);
+		}
+	}
+	if (query_.unit_type != sc2::UNIT_TYPEID::INVALID) {
+		auto it = type_index.find((int)query_.unit_type);
+		if (it == type_index.end())
+			return false;
+		intersect(it->second);
+	}
+	if (query_.state == MOB_STATE::IDLE) {
+		intersect(idle_index);
+	}
+	else if (query_.state == MOB_STATE::BUSY) {
+		intersect(busy_index);
+	}
+	if (!query_.group.empty()) {
+		auto it = group_index.find(query_.group);
+		if (it == group_index.end())
+			return false;
+		intersect(it->second);
+	}
+	return true;
+}
+
+std::unordered_set<Mob*> MobHandler::queryMobs(const MobQuery& query_) {
+	// living mobs matching every part of query_, found through the indexes without visiting other mobs
+
+	std::unordered_set<Mob*> matching;
+	MobBits bits;
+	if (!intersectQuery(query_, bits))
+		return matching;
+	for (size_t i = 0; i < bits.size(); ++i) {
+		uint64_t word = bits[i];
+		for (int b = 0; word != 0; ++b, word >>= 1) {
+			if (word & 1) {
+				matching.insert(mobs_storage[i * 64 + b].get());
+			}
+		}
+	}
+	return matching;
+}
+
+std::unordered_set<Mob*> MobHandler::getMobsWithFlags(std::unordered_set<FLAGS> flags_, std::unordered_set<FLAGS> exclude_flags_) {
+	return getMobsWithFlags(flagMask(flags_), flagMask(exclude_flags_));
+}
+
+std::unordered_set<Mob*> MobHandler::getMobsWithFlags(FlagMask flags_, FlagMask exclude_flags_) {
+	MobQuery query;
+	query.flags = flags_;
+	query.exclude_flags = exclude_flags_;
+	return queryMobs(query);
+}
+
+int MobHandler::countMobs(const MobQuery& query_) {
+	MobBits bits;
+	if (!intersectQuery(query_, bits))
+		return 0;
+	int count = 0;
+	for (auto word : bits) {
+		for (; word != 0; word &= word - 1) {
+			++count;
+		}
+	}
+	return count;
+}
+
+const ArmyStats& MobHandler::getArmyStats() {
+    // army aggregates for this game loop, recomputed when mobs are added or die
+    // flags changed by directives later in the loop are picked up in the next one
+
+    if (army_stats.game_loop != (int)agent->getObservation()->GetGameLoop()) {
+        updateArmyStats();
+    }
+    return army_stats;
+}
+
+void MobHandler::updateArmyStats() {
+    ArmyStats& stats = army_stats;
+    stats.game_loop = agent->getObservation()->GetGameLoop();
+    stats.num_mobs = mobs.size();
+    stats.num_attackers = 0;
+    stats.num_flying_attackers = 0;
+    stats.num_ground_attackers = 0;
+    stats.attackers_by_type.clear();
+    stats.food = 0;
+    stats.mineral_value = 0;
+    stats.gas_value = 0;
+    stats.nearest_to_center = nullptr;
+
+    sc2::Point2D attacker_sum(0.0f, 0.0f);
+    sc2::Point2D flying_sum(0.0f, 0.0f);
+    sc2::Point2D ground_sum(0.0f, 0.0f);
+    std::vector<Mob*> ground_mobs;
+    ground_mobs.reserve(mobs.size());
+    for (auto m : mobs) {
+        bool flying = m->hasFlag(FLAGS::IS_FLYING);
+        if (!flying) {
+            ground_mobs.push_back(m);
+        }
+        if (!m->hasFlag(FLAGS::IS_ATTACKER))
+            continue;
+
+        sc2::Point2D pos = m->unit.pos;
+        if (stats.num_attackers == 0) {
+            stats.attacker_min = pos;
+            stats.attacker_max = pos;
+        }
+        else {
+            stats.attacker_min.x = std::min(stats.attacker_min.x, pos.x);
+            stats.attacker_min.y = std::min(stats.attacker_min.y, pos.y);
+            stats.attacker_max.x = std::max(stats.attacker_max.x, pos.x);
+            stats.attacker_max.y = std::max(stats.attacker_max.y, pos.y);
+        }
+        stats.num_attackers++;
+        attacker_sum += pos;
+        if (flying) {
+            stats.num_flying_attackers++;
+            flying_sum += pos;
+        }
+        else {
+            stats.num_ground_attackers++;
+            ground_sum += pos;
+        }
+        stats.attackers_by_type[(int)m->unit.unit_type]++;
+        stats.food += agent->getFoodCost(&m->unit);
+        stats.mineral_value += agent->getMineralCost(&m->unit);
+        stats.gas_value += agent->getGasCost(&m->unit);
+    }
+
+    stats.attacker_center = stats.num_attackers > 0 ? attacker_sum / stats.num_attackers : attacker_sum;
+    stats.flying_center = stats.num_flying_attackers > 0 ? flying_sum / stats.num_flying_attackers : flying_sum;
+    stats.ground_center = stats.num_ground_attackers > 0 ? ground_sum / stats.num_ground_attackers : ground_sum;
+    if (stats.num_attackers == 0) {
+        stats.attacker_min = attacker_sum;
+        stats.attacker_max = attacker_sum;
+        return;
+    }
+
+    float closest_dist = std::numeric_limits<float>::max();
+    for (auto m : ground_mobs) {
+        float d = sc2::DistanceSquared2D(m->unit.pos, stats.attacker_center);
+        if (d < closest_dist) {
+            stats.nearest_to_center = m;
+            closest_dist = d;
+        }
+    }
+}
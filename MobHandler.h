@@ -6,10 +6,41 @@
 #include "sc2api/sc2_unit_filters.h"
 #include "sc2api/sc2_interfaces.h"
 #include "sc2api/sc2_typeenums.h"
+#include <cstdint>
 
 class Mob;
 class BasicSc2Bot;
 
+struct ArmyStats {
+    // army aggregates, computed in one pass over the mobs the first time they are needed in a game loop
+    // centers are only meaningful when the matching count is not zero
+    int game_loop;                      // -1 until computed
+    int num_mobs;
+    int num_attackers;
+    int num_flying_attackers;
+    int num_ground_attackers;
+    sc2::Point2D attacker_center;
+    sc2::Point2D flying_center;
+    sc2::Point2D ground_center;
+    sc2::Point2D attacker_min;          // bounding box of the attackers
+    sc2::Point2D attacker_max;
+    std::unordered_map<int, int> attackers_by_type;
+    int food;                           // food, mineral and gas value of the attackers
+    int mineral_value;
+    int gas_value;
+    Mob* nearest_to_center;             // the mob that is not flying nearest the attacker center
+};
+
+struct MobQuery {
+    // mobs matching every part of the query, see MobHandler::queryMobs()
+    MobQuery() : flags(0), exclude_flags(0), unit_type(sc2::UNIT_TYPEID::INVALID), state(MOB_STATE::ANY) {}
+    FlagMask flags;                             // must have all of these
+    FlagMask exclude_flags;                     // must have none of these
+    sc2::UNIT_TYPEID unit_type;                 // INVALID matches any type
+    MOB_STATE state;
+    std::string group;                          // empty matches any group
+};
+
 class MobHandler {
 public:
     MobHandler(BasicSc2Bot* agent);
@@ -33,19 +64,58 @@ public:
     std::unordered_set<Mob*> getMobs();
     std::unordered_set<Mob*> getIdleMobs();
     std::unordered_set<Mob*> getBusyMobs();
+    void copyIdleMobs(std::vector<Mob*>& mobs_);
+    void copyBusyMobs(std::vector<Mob*>& mobs_);
+    int getNumIdleMobs();
+    int getNumBusyMobs();
     std::unordered_set<Mob*> getMobGroupByName(std::string mobName);
+    void addMobToGroup(std::string group_, Mob* mob_);
+    void removeMobFromGroup(std::string group_, Mob* mob_);
+    void syncUnitTypes();
+    std::unordered_set<Mob*> queryMobs(const MobQuery& query_);
+    std::unordered_set<Mob*> getMobsWithFlags(std::unordered_set<FLAGS> flags_, std::unordered_set<FLAGS> exclude_flags_ = std::unordered_set<FLAGS>());
+    std::unordered_set<Mob*> getMobsWithFlags(FlagMask flags_, FlagMask exclude_flags_);
+    int countMobs(const MobQuery& query_);
+    void flagChanged(Mob* mob_, FLAGS flag_, bool is_true);
+    const ArmyStats& getArmyStats();
     
 private:
+    // one bit per slot of mobs_storage, so lookups on several keys are a few word-wise ANDs
+    typedef std::vector<uint64_t> MobBits;
+
+    struct MobQueue {
+        // intrusive doubly linked list through Mob::state_prev and Mob::state_next
+        MobQueue() : head(nullptr), tail(nullptr), size(0) {}
+        Mob* head;
+        Mob* tail;
+        int size;
+    };
+
+    void updateArmyStats();
+    void setBit(MobBits& bits_, int index_, bool is_true);
+    bool intersectQuery(const MobQuery& query_, MobBits& result_);
+    void linkMob(Mob* mob_, MOB_STATE state_);
+    void unlinkMob(Mob* mob_);
+
     BasicSc2Bot* agent;
     //data containers
     std::vector<std::shared_ptr<Mob>> mobs_storage; 
     std::unordered_map<std::string, std::unordered_set<Mob*>> mob_group_by_name;
     std::set<std::unordered_set<Mob*>> mob_groups;
 	std::unordered_set<Mob*> mobs; 
-	std::unordered_set<Mob*> idle_mobs;
-    std::unordered_set<Mob*> busy_mobs;
+    MobQueue idle_queue;    // mobs move between the queues as their state changes, so keeping them costs nothing per step
+    MobQueue busy_queue;
 	std::unordered_map<sc2::Tag, Mob*> mob_by_tag;
     std::unordered_set<Mob*> dead_mobs;
+    ArmyStats army_stats;
+    //indexes, kept up to date as mobs are added, die, change flags, state or group
+    MobBits alive_index;
+    MobBits idle_index;
+    MobBits busy_index;
+    std::vector<MobBits> flag_index;                        // by (int)FLAGS
+    std::unordered_map<int, MobBits> type_index;            // by (int)UNIT_TYPEID, see syncUnitTypes()
+    std::unordered_map<std::string, MobBits> group_index;
+    std::vector<int> indexed_type;                          // the type each slot is indexed under
 };
 
 
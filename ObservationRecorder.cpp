@@ -0,0 +1,203 @@
+#include "ObservationRecorder.h"
+#include "BasicSc2Bot.h"
+#include <iomanip>
+#include <iostream>
+
+ObservationRecorder::ObservationRecorder(BasicSc2Bot* agent_) {
+	agent = agent_;
+	header_written = false;
+	steps_recorded = 0;
+}
+
+ObservationRecorder::~ObservationRecorder() {
+	if (out.is_open()) {
+		out.close();
+	}
+}
+
+bool ObservationRecorder::open(std::string filename_) {
+	out.open(filename_);
+	if (!out.is_open()) {
+		std::cout << "Unable to record observations to " << filename_ << std::endl;
+		return false;
+	}
+	// positions are written with enough precision to reproduce distance checks exactly
+	out << std::setprecision(9);
+	return true;
+}
+
+bool ObservationRecorder::isOpen() {
+	return out.is_open();
+}
+
+void ObservationRecorder::recordStep() {
+	// write everything the bot can observe during this step
+	if (!out.is_open())
+		return;
+
+	const sc2::ObservationInterface* obs = agent->getObservation();
+	if (!header_written) {
+		writeHeader(obs);
+		header_written = true;
+	}
+
+	out << "STEP " << obs->GetGameLoop() << " " << obs->GetMinerals() << " " << obs->GetVespene() << " "
+		<< obs->GetFoodCap() << " " << obs->GetFoodUsed() << " " << obs->GetFoodArmy() << " " << obs->GetFoodWorkers() << "\n";
+
+	const std::vector<sc2::UpgradeID>& upgrades = obs->GetUpgrades();
+	out << "UPGRADES " << upgrades.size();
+	for (auto u : upgrades) {
+		out << " " << (int)u;
+	}
+	out << "\n";
+
+	writeVisibility(obs);
+
+	sc2::Units units = obs->GetUnits();
+	for (auto u : units) {
+		writeUnit(u);
+	}
+	writeAvailableAbilities(obs);
+	for (auto& e : pending_events) {
+		out << e << "\n";
+	}
+	pending_events.clear();
+	out << "END\n";
+	steps_recorded++;
+}
+
+void ObservationRecorder::recordEvent(std::string kind_, const sc2::Unit* unit_, float health_, float shields_) {
+	// kind_ is one of CREATED, COMPLETE, DAMAGED, IDLE, DESTROYED, VISION
+	if (!out.is_open() || !unit_)
+		return;
+	pending_events.push_back("EVENT " + kind_ + " " + std::to_string(unit_->tag) + " " + std::to_string(health_) + " " + std::to_string(shields_));
+}
+
+void ObservationRecorder::finish() {
+	// record the result and close the file, intended to be called OnGameEnd()
+	if (!out.is_open())
+		return;
+
+	const sc2::ObservationInterface* obs = agent->getObservation();
+	auto results = obs->GetResults();
+	for (auto r : results) {
+		out << "RESULT " << r.player_id << " " << (int)r.result << "\n";
+	}
+	out.close();
+	std::cout << "Recorded " << steps_recorded << " steps of observations." << std::endl;
+}
+
+void ObservationRecorder::writeHeader(const sc2::ObservationInterface* obs) {
+	const sc2::GameInfo& game_info = obs->GetGameInfo();
+	sc2::Point3D start = obs->GetStartLocation();
+
+	out << "SC2REC " << RECORDING_VERSION << "\n";
+	out << "MAP " << game_info.map_name << "\n";
+	out << "INFO " << obs->GetPlayerID() << " " << game_info.width << " " << game_info.height << " "
+		<< game_info.playable_min.x << " " << game_info.playable_min.y << " "
+		<< game_info.playable_max.x << " " << game_info.playable_max.y << " "
+		<< start.x << " " << start.y << " " << start.z << "\n";
+	for (auto& s : game_info.start_locations) {
+		out << "START " << s.x << " " << s.y << "\n";
+	}
+
+	// sampled through the interface, so the replay answers exactly what the client would have
+	std::vector<int> pathable;
+	std::vector<int> placable;
+	for (int y = 0; y < game_info.height; ++y) {
+		for (int x = 0; x < game_info.width; ++x) {
+			sc2::Point2D cell(x + 0.5F, y + 0.5F);
+			pathable.push_back(obs->IsPathable(cell));
+			placable.push_back(obs->IsPlacable(cell));
+		}
+	}
+	writeRunLength("PATHING", pathable);
+	writeRunLength("PLACEMENT", placable);
+
+	// only the fields the bot reads are recorded
+	const sc2::UnitTypes& unit_types = obs->GetUnitTypeData();
+	for (auto& t : unit_types) {
+		if (t.name.empty())
+			continue;
+		out << "UNITTYPE " << (int)t.unit_type_id << " " << t.mineral_cost << " " << t.vespene_cost << " "
+			<< t.food_required << " " << t.food_provided << " " << (int)t.race << " " << t.attributes.size();
+		for (auto a : t.attributes) {
+			out << " " << (int)a;
+		}
+		out << " " << t.name << "\n";
+	}
+
+	const sc2::Abilities& abilities = obs->GetAbilityData();
+	for (auto& a : abilities) {
+		if (!a.available)
+			continue;
+		out << "ABILITY " << (int)a.ability_id << " " << a.is_building << " " << a.footprint_radius << "\n";
+	}
+}
+
+void ObservationRecorder::writeRunLength(std::string name_, const std::vector<int>& cells_) {
+	// grids are run-length encoded row by row from (0,0), as pairs of <value> <count>
+	out << name_;
+	int run_value = -1;
+	int run_length = 0;
+	for (int v : cells_) {
+		if (v == run_value) {
+			run_length++;
+			continue;
+		}
+		if (run_length > 0) {
+			out << " " << run_value << " " << run_length;
+		}
+		run_value = v;
+		run_length = 1;
+	}
+	if (run_length > 0) {
+		out << " " << run_value << " " << run_length;
+	}
+	out << "\n";
+}
+
+void ObservationRecorder::writeVisibility(const sc2::ObservationInterface* obs) {
+	const sc2::GameInfo& game_info = obs->GetGameInfo();
+	std::vector<int> visibility;
+	visibility.reserve(game_info.width * game_info.height);
+	for (int y = 0; y < game_info.height; ++y) {
+		for (int x = 0; x < game_info.width; ++x) {
+			visibility.push_back((int)obs->GetVisibility(sc2::Point2D(x + 0.5F, y + 0.5F)));
+		}
+	}
+	writeRunLength("VIS", visibility);
+}
+
+void ObservationRecorder::writeUnit(const sc2::Unit* u) {
+	out << "UNIT " << u->tag << " " << (int)u->unit_type << " " << (int)u->alliance << " " << (int)u->display_type << " "
+		<< u->owner << " " << u->pos.x << " " << u->pos.y << " " << u->pos.z << " " << u->facing << " " << u->radius << " "
+		<< u->build_progress << " " << u->health << " " << u->health_max << " " << u->shield << " " << u->shield_max << " "
+		<< u->energy << " " << u->energy_max << " " << u->is_flying << " " << u->is_burrowed << " " << u->is_alive << " "
+		<< u->weapon_cooldown << " " << u->last_seen_game_loop << " " << u->mineral_contents << " " << u->vespene_contents << " "
+		<< u->assigned_harvesters << " " << u->ideal_harvesters << " " << (int)u->cloak << " " << u->is_powered << " "
+		<< u->add_on_tag << " " << u->engaged_target_tag << " " << u->orders.size();
+	for (auto& o : u->orders) {
+		out << " " << (int)o.ability_id << " " << o.target_unit_tag << " " << o.target_pos.x << " " << o.target_pos.y << " " << o.progress;
+	}
+	out << " " << u->buffs.size();
+	for (auto b : u->buffs) {
+		out << " " << (int)b;
+	}
+	out << "\n";
+}
+
+void ObservationRecorder::writeAvailableAbilities(const sc2::ObservationInterface* obs) {
+	// one batched query per step, so the replay can answer GetAbilitiesForUnit
+	sc2::Units own_units = obs->GetUnits(sc2::Unit::Alliance::Self);
+	if (own_units.empty())
+		return;
+	std::vector<sc2::AvailableAbilities> available = agent->getQuery()->GetAbilitiesForUnits(own_units);
+	for (auto& a : available) {
+		out << "ABILITIES " << a.unit_tag << " " << a.abilities.size();
+		for (auto& ab : a.abilities) {
+			out << " " << (int)ab.ability_id;
+		}
+		out << "\n";
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "sc2api/sc2_api.h"
+
+# define RECORD_OBSERVATIONS false // dump every observation to RECORDING_FILE, for offline replay with ReplayDriver
+# define RECORDING_FILE "observations.rec" // file observations are recorded to
+# define RECORDING_VERSION 1 // bumped whenever the recording layout changes
+
+class BasicSc2Bot;
+
+class ObservationRecorder {
+// Writes what the bot saw during a real game, one step at a time, so that it can be fed
+// back into the bot by tools/replay/ReplayDriver without launching the SC2 client
+//
+// The recording is line based text:
+//   header:  SC2REC, MAP, INFO, START, PATHING, PLACEMENT, UNITTYPE, ABILITY
+//   per step: STEP, UPGRADES, VIS, UNIT..., ABILITIES..., EVENT..., END
+//   footer:  RESULT
+public:
+	ObservationRecorder(BasicSc2Bot* agent_);
+	~ObservationRecorder();
+	bool open(std::string filename_);
+	bool isOpen();
+	void recordStep();
+	void recordEvent(std::string kind_, const sc2::Unit* unit_, float health_=0.0F, float shields_=0.0F);
+	void finish();
+
+private:
+	void writeHeader(const sc2::ObservationInterface* obs);
+	void writeRunLength(std::string name_, const std::vector<int>& cells_);
+	void writeUnit(const sc2::Unit* u);
+	void writeAvailableAbilities(const sc2::ObservationInterface* obs);
+	void writeVisibility(const sc2::ObservationInterface* obs);
+
+	BasicSc2Bot* agent;
+	std::ofstream out;
+	std::vector<std::string> pending_events; // unit callbacks arrive before OnStep, so they are written with the next step
+	bool header_written;
+	int steps_recorded;
+};
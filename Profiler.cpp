@@ -0,0 +1,409 @@
+#include "Profiler.h"
+#include "Triggers.h"
+#include <atomic>
+#include <fstream>
+#include <iostream>
+
+Profiler::CostRecord::CostRecord(std::string name_) {
+	name = name_;
+	evaluations = 0;
+	passed = 0;
+	eval_ns = 0;
+	executions = 0;
+	exec_ns = 0;
+	get_units_calls = 0;
+	query_calls = 0;
+}
+
+// each thread caches its scope, so tracking what it evaluates never takes the lock
+static thread_local Profiler* scope_owner = nullptr;
+static thread_local int scope_owner_serial = -1;
+static thread_local Profiler::ThreadScope* local_scope = nullptr;
+
+Profiler::Profiler() : unscoped_directives("DEFAULT_AND_BUNDLED_DIRECTIVES") {
+	static std::atomic<int> next_serial(0);
+	enabled = PROFILER_ENABLED;
+	serial = next_serial++;
+}
+
+Profiler& Profiler::operator=(const Profiler& rhs) {
+	// thread scopes stay with their profiler, the conditions rhs recorded are moved into this thread's scope
+	if (this == &rhs)
+		return *this;
+	std::vector<CostRecord> conditions = rhs.conditionCosts();
+	enabled = rhs.enabled;
+	precept_costs = rhs.precept_costs;
+	unscoped_directives = rhs.unscoped_directives;
+	{
+		std::lock_guard<std::mutex> lock(scopes_mutex);
+		for (auto& scope : scopes) {
+			scope->condition_costs.clear();
+		}
+	}
+	localScope()->condition_costs = conditions;
+	return *this;
+}
+
+void Profiler::setEnabled(bool is_true) {
+	enabled = is_true;
+}
+
+bool Profiler::isEnabled() {
+	return enabled;
+}
+
+Profiler::ThreadScope* Profiler::localScope() {
+	// a thread gets its scope the first time it records anything with this profiler
+	if (scope_owner == this && scope_owner_serial == serial) {
+		return local_scope;
+	}
+
+	std::lock_guard<std::mutex> lock(scopes_mutex);
+	std::thread::id thread = std::this_thread::get_id();
+	ThreadScope* found = nullptr;
+	for (auto& scope : scopes) {
+		if (scope->thread == thread) {
+			found = scope.get();
+		}
+	}
+	if (!found) {
+		std::unique_ptr<ThreadScope> scope(new ThreadScope());
+		scope->thread = thread;
+		scope->current_precept = NO_SCOPE;
+		scope->current_condition = NO_SCOPE;
+		scope->directive_depth = 0;
+		found = scope.get();
+		scopes.push_back(std::move(scope));
+	}
+	scope_owner = this;
+	scope_owner_serial = serial;
+	local_scope = found;
+	return local_scope;
+}
+
+std::vector<Profiler::CostRecord> Profiler::conditionCosts() const {
+	// condition records summed over every thread
+	std::vector<CostRecord> totals;
+	std::lock_guard<std::mutex> lock(scopes_mutex);
+	for (auto& scope : scopes) {
+		if (scope->condition_costs.size() > totals.size()) {
+			totals.resize(scope->condition_costs.size());
+		}
+		for (size_t i = 0; i < scope->condition_costs.size(); ++i) {
+			const CostRecord& record = scope->condition_costs[i];
+			CostRecord& total = totals[i];
+			if (!record.name.empty())
+				total.name = record.name;
+			total.evaluations += record.evaluations;
+			total.passed += record.passed;
+			total.eval_ns += record.eval_ns;
+			total.executions += record.executions;
+			total.exec_ns += record.exec_ns;
+			total.get_units_calls += record.get_units_calls;
+			total.query_calls += record.query_calls;
+		}
+	}
+	return totals;
+}
+
+int Profiler::registerPrecept(std::string name_) {
+	// returns the id used to attribute costs to this precept
+	int id = precept_costs.size();
+	if (name_.empty()) {
+		name_ = "precept_" + std::to_string(id);
+	}
+	precept_costs.push_back(CostRecord(name_));
+	return id;
+}
+
+long long Profiler::elapsedSince(std::chrono::steady_clock::time_point start_) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+}
+
+void Profiler::beginPreceptCheck(int precept_id_) {
+	if (!enabled || precept_id_ < 0 || precept_id_ >= (int)precept_costs.size())
+		return;
+	ThreadScope* scope = localScope();
+	scope->current_precept = precept_id_;
+	scope->precept_start = std::chrono::steady_clock::now();
+}
+
+void Profiler::endPreceptCheck(bool passed_, bool counted_) {
+	// counted_ is false for partial checks, whose time adds to the check that decides the precept
+	if (!enabled)
+		return;
+	ThreadScope* scope = localScope();
+	if (scope->current_precept == NO_SCOPE)
+		return;
+	CostRecord& record = precept_costs[scope->current_precept];
+	if (counted_) {
+		record.evaluations++;
+		if (passed_)
+			record.passed++;
+	}
+	record.eval_ns += elapsedSince(scope->precept_start);
+	scope->current_precept = NO_SCOPE;
+}
+
+void Profiler::beginPreceptExecute(int precept_id_) {
+	if (!enabled || precept_id_ < 0 || precept_id_ >= (int)precept_costs.size())
+		return;
+	ThreadScope* scope = localScope();
+	scope->current_precept = precept_id_;
+	scope->precept_start = std::chrono::steady_clock::now();
+}
+
+void Profiler::endPreceptExecute(bool executed_) {
+	// executions only counts precepts where at least one directive issued an order
+	if (!enabled)
+		return;
+	ThreadScope* scope = localScope();
+	if (scope->current_precept == NO_SCOPE)
+		return;
+	CostRecord& record = precept_costs[scope->current_precept];
+	if (executed_)
+		record.executions++;
+	record.exec_ns += elapsedSince(scope->precept_start);
+	scope->current_precept = NO_SCOPE;
+}
+
+void Profiler::beginCondition(COND cond_type_) {
+	if (!enabled)
+		return;
+	ThreadScope* scope = localScope();
+	scope->current_condition = (int)cond_type_;
+	if (scope->current_condition >= (int)scope->condition_costs.size()) {
+		scope->condition_costs.resize(scope->current_condition + 1);
+	}
+	if (scope->condition_costs[scope->current_condition].name.empty()) {
+		scope->condition_costs[scope->current_condition].name = condName(cond_type_);
+	}
+	scope->condition_start = std::chrono::steady_clock::now();
+}
+
+void Profiler::endCondition(bool met_) {
+	if (!enabled)
+		return;
+	ThreadScope* scope = localScope();
+	if (scope->current_condition == NO_SCOPE)
+		return;
+	CostRecord& record = scope->condition_costs[scope->current_condition];
+	record.evaluations++;
+	if (met_)
+		record.passed++;
+	record.eval_ns += elapsedSince(scope->condition_start);
+	scope->current_condition = NO_SCOPE;
+}
+
+void Profiler::beginDirective() {
+	// directives run inside Precept::execute are already timed against their precept
+	if (!enabled)
+		return;
+	ThreadScope* scope = localScope();
+	if (scope->directive_depth++ == 0 && scope->current_precept == NO_SCOPE) {
+		scope->directive_start = std::chrono::steady_clock::now();
+	}
+}
+
+void Profiler::endDirective(bool executed_) {
+	if (!enabled)
+		return;
+	ThreadScope* scope = localScope();
+	if (scope->directive_depth == 0)
+		return;
+	if (--scope->directive_depth == 0 && scope->current_precept == NO_SCOPE) {
+		unscoped_directives.evaluations++;
+		if (executed_)
+			unscoped_directives.executions++;
+		unscoped_directives.exec_ns += elapsedSince(scope->directive_start);
+	}
+}
+
+void Profiler::countGetUnits() {
+	if (!enabled)
+		return;
+	ThreadScope* scope = localScope();
+	if (scope->current_precept != NO_SCOPE)
+		precept_costs[scope->current_precept].get_units_calls++;
+	if (scope->current_condition != NO_SCOPE)
+		scope->condition_costs[scope->current_condition].get_units_calls++;
+	if (scope->current_precept == NO_SCOPE && scope->directive_depth > 0)
+		unscoped_directives.get_units_calls++;
+}
+
+void Profiler::countQuery() {
+	if (!enabled)
+		return;
+	ThreadScope* scope = localScope();
+	if (scope->current_precept != NO_SCOPE)
+		precept_costs[scope->current_precept].query_calls++;
+	if (scope->current_condition != NO_SCOPE)
+		scope->condition_costs[scope->current_condition].query_calls++;
+	if (scope->current_precept == NO_SCOPE && scope->directive_depth > 0)
+		unscoped_directives.query_calls++;
+}
+
+void Profiler::writeRecord(std::ofstream& out, std::string scope_, int id_, const CostRecord& record_) {
+	double true_rate = record_.evaluations > 0 ? (double)record_.passed / (double)record_.evaluations : 0.0;
+	double eval_us = record_.eval_ns / 1000.0;
+	double mean_eval_us = record_.evaluations > 0 ? eval_us / record_.evaluations : 0.0;
+	out << scope_ << "," << id_ << "," << record_.name << "," << record_.evaluations << "," << record_.passed << "," << true_rate << ","
+		<< eval_us << "," << mean_eval_us << "," << record_.executions << "," << record_.exec_ns / 1000.0 << ","
+		<< record_.get_units_calls << "," << record_.query_calls << std::endl;
+}
+
+bool Profiler::writeCSV(std::string filename_) {
+	// one row per precept and per condition kind, intended to be sorted in a spreadsheet
+	if (!enabled)
+		return false;
+
+	std::ofstream out(filename_);
+	if (!out.is_open()) {
+		std::cout << "Unable to write profiler output to " << filename_ << std::endl;
+		return false;
+	}
+
+	out << "scope,id,name,evaluations,passed,true_rate,eval_us,mean_eval_us,executions,exec_us,get_units_calls,query_calls" << std::endl;
+	for (int i = 0; i < (int)precept_costs.size(); ++i) {
+		writeRecord(out, "precept", i, precept_costs[i]);
+	}
+	std::vector<CostRecord> condition_costs = conditionCosts();
+	for (int i = 0; i < (int)condition_costs.size(); ++i) {
+		if (condition_costs[i].evaluations > 0)
+			writeRecord(out, "condition", i, condition_costs[i]);
+	}
+	writeRecord(out, "directive", NO_SCOPE, unscoped_directives);
+	return true;
+}
+
+std::string Profiler::condName(COND cond_type_) {
+	switch (cond_type_) {
+	case COND::MIN_MINERALS:
+		return "MIN_MINERALS";
+	case COND::MIN_GAS:
+		return "MIN_GAS";
+	case COND::MIN_TIME:
+		return "MIN_TIME";
+	case COND::MIN_FOOD:
+		return "MIN_FOOD";
+	case COND::MIN_FOOD_USED:
+		return "MIN_FOOD_USED";
+	case COND::MIN_FOOD_CAP:
+		return "MIN_FOOD_CAP";
+	case COND::MIN_FOOD_ARMY:
+		return "MIN_FOOD_ARMY";
+	case COND::MAX_FOOD_ARMY:
+		return "MAX_FOOD_ARMY";
+	case COND::MAX_MINERALS:
+		return "MAX_MINERALS";
+	case COND::MAX_GAS:
+		return "MAX_GAS";
+	case COND::MAX_TIME:
+		return "MAX_TIME";
+	case COND::MAX_FOOD:
+		return "MAX_FOOD";
+	case COND::MAX_FOOD_USED:
+		return "MAX_FOOD_USED";
+	case COND::MAX_FOOD_CAP:
+		return "MAX_FOOD_CAP";
+	case COND::MIN_MINERALS_MINED:
+		return "MIN_MINERALS_MINED";
+	case COND::MAX_MINERALS_MINED:
+		return "MAX_MINERALS_MINED";
+	case COND::MAX_UNIT_OF_TYPE:
+		return "MAX_UNIT_OF_TYPE";
+	case COND::MIN_UNIT_OF_TYPE:
+		return "MIN_UNIT_OF_TYPE";
+	case COND::MAX_UNIT_OF_TYPE_NEAR_LOCATION:
+		return "MAX_UNIT_OF_TYPE_NEAR_LOCATION";
+	case COND::MIN_UNIT_OF_TYPE_NEAR_LOCATION:
+		return "MIN_UNIT_OF_TYPE_NEAR_LOCATION";
+	case COND::MAX_UNIT_OF_TYPE_TOTAL:
+		return "MAX_UNIT_OF_TYPE_TOTAL";
+	case COND::MIN_UNIT_OF_TYPE_TOTAL:
+		return "MIN_UNIT_OF_TYPE_TOTAL";
+	case COND::MAX_UNIT_OF_TYPE_UNDER_CONSTRUCTION:
+		return "MAX_UNIT_OF_TYPE_UNDER_CONSTRUCTION";
+	case COND::MIN_UNIT_OF_TYPE_UNDER_CONSTRUCTION:
+		return "MIN_UNIT_OF_TYPE_UNDER_CONSTRUCTION";
+	case COND::MAX_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION:
+		return "MAX_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION";
+	case COND::MIN_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION:
+		return "MIN_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION";
+	case COND::MAX_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION:
+		return "MAX_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION";
+	case COND::MIN_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION:
+		return "MIN_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION";
+	case COND::MIN_UNIT_WITH_FLAGS:
+		return "MIN_UNIT_WITH_FLAGS";
+	case COND::MAX_UNIT_WITH_FLAGS:
+		return "MAX_UNIT_WITH_FLAGS";
+	case COND::MIN_UNIT_WITH_FLAGS_NEAR_LOCATION:
+		return "MIN_UNIT_WITH_FLAGS_NEAR_LOCATION";
+	case COND::MAX_UNIT_WITH_FLAGS_NEAR_LOCATION:
+		return "MAX_UNIT_WITH_FLAGS_NEAR_LOCATION";
+	case COND::HAS_ABILITY_READY:
+		return "HAS_ABILITY_READY";
+	case COND::BASE_IS_ACTIVE:
+		return "BASE_IS_ACTIVE";
+	case COND::HAVE_UPGRADE:
+		return "HAVE_UPGRADE";
+	case COND::MAX_UNITS_IN_GROUP:
+		return "MAX_UNITS_IN_GROUP";
+	case COND::MIN_UNITS_IN_GROUP:
+		return "MIN_UNITS_IN_GROUP";
+	case COND::MAX_UNITS_OF_TYPE_IN_GROUP:
+		return "MAX_UNITS_OF_TYPE_IN_GROUP";
+	case COND::MIN_UNITS_OF_TYPE_IN_GROUP:
+		return "MIN_UNITS_OF_TYPE_IN_GROUP";
+	case COND::MAX_UNITS_IN_GROUP_NEAR_LOCATION:
+		return "MAX_UNITS_IN_GROUP_NEAR_LOCATION";
+	case COND::MIN_UNITS_IN_GROUP_NEAR_LOCATION:
+		return "MIN_UNITS_IN_GROUP_NEAR_LOCATION";
+	case COND::MAX_UNITS_USING_ABILITY:
+		return "MAX_UNITS_USING_ABILITY";
+	case COND::MIN_UNITS_USING_ABILITY:
+		return "MIN_UNITS_USING_ABILITY";
+	case COND::MAX_DEAD_MOBS:
+		return "MAX_DEAD_MOBS";
+	case COND::MIN_DEAD_MOBS:
+		return "MIN_DEAD_MOBS";
+	case COND::ENEMY_RACE_ZERG:
+		return "ENEMY_RACE_ZERG";
+	case COND::ENEMY_RACE_PROTOSS:
+		return "ENEMY_RACE_PROTOSS";
+	case COND::ENEMY_RACE_TERRAN:
+		return "ENEMY_RACE_TERRAN";
+	case COND::ENEMY_RACE_UNKNOWN:
+		return "ENEMY_RACE_UNKNOWN";
+	case COND::THREAT_EXISTS_NEAR_LOCATION:
+		return "THREAT_EXISTS_NEAR_LOCATION";
+	case COND::MAX_NEUTRAL_UNIT_OF_TYPE:
+		return "MAX_NEUTRAL_UNIT_OF_TYPE";
+	case COND::MIN_NEUTRAL_UNIT_OF_TYPE:
+		return "MIN_NEUTRAL_UNIT_OF_TYPE";
+	case COND::MAX_ENEMY_UNITS_NEAR_LOCATION:
+		return "MAX_ENEMY_UNITS_NEAR_LOCATION";
+	case COND::MIN_ENEMY_UNITS_NEAR_LOCATION:
+		return "MIN_ENEMY_UNITS_NEAR_LOCATION";
+	case COND::TIMER_1_SET:
+		return "TIMER_1_SET";
+	case COND::TIMER_2_SET:
+		return "TIMER_2_SET";
+	case COND::TIMER_3_SET:
+		return "TIMER_3_SET";
+	case COND::TIMER_1_MIN_STEPS_PAST:
+		return "TIMER_1_MIN_STEPS_PAST";
+	case COND::TIMER_1_MAX_STEPS_PAST:
+		return "TIMER_1_MAX_STEPS_PAST";
+	case COND::TIMER_2_MIN_STEPS_PAST:
+		return "TIMER_2_MIN_STEPS_PAST";
+	case COND::TIMER_2_MAX_STEPS_PAST:
+		return "TIMER_2_MAX_STEPS_PAST";
+	case COND::TIMER_3_MIN_STEPS_PAST:
+		return "TIMER_3_MIN_STEPS_PAST";
+	case COND::TIMER_3_MAX_STEPS_PAST:
+		return "TIMER_3_MAX_STEPS_PAST";
+	}
+	return "UNKNOWN_COND";
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+# define PROFILER_ENABLED false // record per-precept and per-condition evaluation costs
+# define PROFILER_CSV "precept_costs.csv" // file the cost table is written to at game end
+# define NO_SCOPE -1 // no precept or condition is currently being evaluated
+
+enum class COND;
+
+class Profiler {
+// Records how often each precept and each kind of trigger condition is evaluated,
+// how often it passes, how long it takes, and how many GetUnits/Query calls it makes.
+// What is being evaluated is tracked per thread, so precepts can be checked on the task pool;
+// a precept's record is only written by the thread checking it, and condition records are
+// kept per thread and summed when written
+public:
+	struct CostRecord {
+		std::string name;
+		long long evaluations;
+		long long passed;
+		long long eval_ns;
+		long long executions;
+		long long exec_ns;
+		long long get_units_calls;
+		long long query_calls;
+		CostRecord(std::string name_ = "");
+	};
+
+	struct ThreadScope {
+		std::thread::id thread;
+		int current_precept;
+		int current_condition;
+		int directive_depth;
+		std::chrono::steady_clock::time_point precept_start;
+		std::chrono::steady_clock::time_point condition_start;
+		std::chrono::steady_clock::time_point directive_start;
+		std::vector<CostRecord> condition_costs; // indexed by (int)COND
+	};
+
+	Profiler();
+	Profiler& operator=(const Profiler& rhs);
+	void setEnabled(bool is_true=true);
+	bool isEnabled();
+	int registerPrecept(std::string name_);
+	void beginPreceptCheck(int precept_id_);
+	void endPreceptCheck(bool passed_, bool counted_=true);
+	void beginPreceptExecute(int precept_id_);
+	void endPreceptExecute(bool executed_);
+	void beginCondition(COND cond_type_);
+	void endCondition(bool met_);
+	void beginDirective();
+	void endDirective(bool executed_);
+	void countGetUnits();
+	void countQuery();
+	bool writeCSV(std::string filename_);
+	static std::string condName(COND cond_type_);
+
+private:
+	Profiler(const Profiler&);
+	long long elapsedSince(std::chrono::steady_clock::time_point start_);
+	void writeRecord(std::ofstream& out, std::string scope_, int id_, const CostRecord& record_);
+	ThreadScope* localScope();
+	std::vector<CostRecord> conditionCosts() const;
+
+	bool enabled;
+	int serial;                              // tells apart profilers allocated at the same address
+	std::vector<CostRecord> precept_costs;   // indexed by precept id
+	CostRecord unscoped_directives;          // default and bundled directives executed outside of a precept, game thread only
+	mutable std::mutex scopes_mutex;
+	std::vector<std::unique_ptr<ThreadScope>> scopes;
+};
@@ -0,0 +1,124 @@
+#include "StepPipeline.h"
+#include "BasicSc2Bot.h"
+#include <algorithm>
+#include <cstring>
+
+StepPipeline::StepPipeline(BasicSc2Bot* agent_) {
+	agent = agent_;
+	has_work = false;
+	stopping = false;
+	wait_us = 0;
+	num_runs = 0;
+	worker = std::thread(&StepPipeline::workerLoop, this);
+}
+
+StepPipeline::~StepPipeline() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	worker.join();
+}
+
+int StepPipeline::registerStage(const char* name_, int period_, PrepareFunction prepare_, StageFunction run_, StageFunction apply_) {
+	// period_ is in game loops
+	PipelineStage stage;
+	stage.name = name_;
+	stage.period = std::max(period_, 1);
+	stage.last_prepared = 0;
+	stage.pending = false;
+	stage.prepare = prepare_;
+	stage.run = run_;
+	stage.apply = apply_;
+	stages.push_back(stage);
+	return stages.size() - 1;
+}
+
+void StepPipeline::setPeriod(const char* name_, int period_) {
+	for (auto& s : stages) {
+		if (std::strcmp(s.name, name_) == 0) {
+			s.period = std::max(period_, 1);
+		}
+	}
+}
+
+void StepPipeline::wait() {
+	// block until the worker has run everything it was handed
+	std::unique_lock<std::mutex> lock(mutex);
+	wake.wait(lock, [this]() { return !has_work; });
+}
+
+void StepPipeline::beginStep() {
+	// apply what the worker worked out while the game simulated
+	auto start = std::chrono::steady_clock::now();
+	long long phase_start = agent->tracer->now();
+	wait();
+	wait_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	agent->tracer->span("Pipeline::wait", phase_start);
+
+	for (auto& s : stages) {
+		if (s.pending) {
+			s.apply();
+			s.pending = false;
+		}
+	}
+}
+
+void StepPipeline::endStep(int game_loop_) {
+	// copy what due stages need and hand them to the worker
+	bool any = false;
+	for (auto& s : stages) {
+		if (game_loop_ - s.last_prepared < s.period)
+			continue;
+		if (s.prepare()) {
+			s.pending = true;
+			s.last_prepared = game_loop_;
+			any = true;
+		}
+	}
+	if (!any)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		has_work = true;
+	}
+	wake.notify_all();
+}
+
+void StepPipeline::workerLoop() {
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this]() { return stopping || has_work; });
+			if (stopping)
+				return;
+		}
+
+		// stages are only changed by the game thread while the worker is idle
+		for (auto& s : stages) {
+			if (s.pending) {
+				long long trace_start = agent->tracer->now();
+				s.run();
+				agent->tracer->span(s.name, trace_start);
+				num_runs++;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			has_work = false;
+		}
+		wake.notify_all();
+	}
+}
+
+long long StepPipeline::getWaitUs() {
+	return wait_us;
+}
+
+int StepPipeline::getNumRuns() {
+	wait();
+	return num_runs;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+# define PIPELINE_STEPS false // run analysis for the next step on a worker while the game simulates, false runs it within OnStep
+
+class BasicSc2Bot;
+
+class StepPipeline {
+// Runs analysis on a worker thread between steps, while the game simulates the next loop.
+// Each stage copies what it needs at the end of OnStep (prepare), works only on that copy on
+// the worker (run), and hands back its result at the start of the next OnStep (apply). The
+// worker never touches the sc2 interfaces, so results are always one step behind the observation
+public:
+	typedef std::function<bool()> PrepareFunction;	// returns false to skip the stage this step
+	typedef std::function<void()> StageFunction;
+
+	StepPipeline(BasicSc2Bot* agent_);
+	~StepPipeline();
+	int registerStage(const char* name_, int period_, PrepareFunction prepare_, StageFunction run_, StageFunction apply_);
+	void setPeriod(const char* name_, int period_);
+	void beginStep();
+	void endStep(int game_loop_);
+	long long getWaitUs();
+	int getNumRuns();
+
+private:
+	struct PipelineStage {
+		const char* name;		// must be a string literal, it is used as the tracer's span name
+		int period;
+		int last_prepared;
+		bool pending;			// prepared and handed to the worker, not yet applied
+		PrepareFunction prepare;
+		StageFunction run;
+		StageFunction apply;
+	};
+
+	StepPipeline(const StepPipeline&);
+	StepPipeline& operator=(const StepPipeline&);
+	void workerLoop();
+	void wait();
+
+	BasicSc2Bot* agent;
+	std::vector<PipelineStage> stages;
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool has_work;			// guarded by mutex, set by endStep and cleared by the worker
+	bool stopping;
+	long long wait_us;		// time steps spent waiting for the worker to finish
+	int num_runs;
+};
@@ -0,0 +1,118 @@
+#include "StepScheduler.h"
+#include "BasicSc2Bot.h"
+#include <algorithm>
+#include <cstring>
+
+StepScheduler::StepScheduler(BasicSc2Bot* agent_) {
+	agent = agent_;
+	budget_us = STEP_BUDGET_US;
+	step_start = std::chrono::steady_clock::now();
+	num_deferred = 0;
+	num_over_budget = 0;
+	first_loop = -1;
+	last_loop = -1;
+}
+
+int StepScheduler::registerTask(const char* name_, TASK_PRIORITY priority_, int period_, double cost_us_, TaskFunction func_) {
+	// period_ is in game loops, cost_us_ is the estimate used until the task has been measured
+	StepTask task;
+	task.name = name_;
+	task.priority = priority_;
+	task.period = std::max(period_, 1);
+	task.cost_us = cost_us_;
+	task.last_run = 0;
+	task.func = func_;
+	tasks.push_back(task);
+	return tasks.size() - 1;
+}
+
+void StepScheduler::setPeriod(const char* name_, int period_) {
+	for (auto& t : tasks) {
+		if (std::strcmp(t.name, name_) == 0) {
+			t.period = std::max(period_, 1);
+		}
+	}
+}
+
+void StepScheduler::setBudget(long long budget_us_) {
+	budget_us = budget_us_;
+}
+
+void StepScheduler::beginStep() {
+	// the budget is counted from here, so work done before the tasks counts against it
+	step_start = std::chrono::steady_clock::now();
+}
+
+long long StepScheduler::elapsedUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - step_start).count();
+}
+
+bool StepScheduler::isDue(const StepTask& task_, int game_loop_) {
+	return game_loop_ - task_.last_run >= task_.period;
+}
+
+void StepScheduler::runTask(StepTask& task_, int game_loop_) {
+	long long phase_start = agent->tracer->now();
+	auto start = std::chrono::steady_clock::now();
+	task_.func();
+	double cost = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	agent->tracer->span(task_.name, phase_start);
+
+	task_.cost_us += TASK_COST_SMOOTHING * (cost - task_.cost_us);
+	task_.last_run = game_loop_;
+}
+
+void StepScheduler::runStep(int game_loop_) {
+	// run critical tasks that are due, then fit in as much background work as the budget allows
+	if (first_loop == -1) {
+		first_loop = game_loop_;
+		first_start = step_start;
+	}
+	last_loop = game_loop_;
+	last_start = step_start;
+
+	std::vector<int> background;
+	for (size_t i = 0; i < tasks.size(); ++i) {
+		if (!isDue(tasks[i], game_loop_))
+			continue;
+		if (tasks[i].priority == TASK_PRIORITY::CRITICAL) {
+			runTask(tasks[i], game_loop_);
+		}
+		else {
+			background.push_back(i);
+		}
+	}
+
+	// most overdue first, relative to their period
+	std::stable_sort(background.begin(), background.end(), [this, game_loop_](int a, int b) {
+		return (double)(game_loop_ - tasks[a].last_run) / tasks[a].period > (double)(game_loop_ - tasks[b].last_run) / tasks[b].period;
+	});
+	for (auto i : background) {
+		StepTask& task = tasks[i];
+		bool starving = game_loop_ - task.last_run >= task.period * TASK_MAX_DELAY;
+		if (!starving && elapsedUs() + task.cost_us > budget_us) {
+			num_deferred++;
+			continue;
+		}
+		runTask(task, game_loop_);
+	}
+
+	if (elapsedUs() > budget_us) {
+		num_over_budget++;
+	}
+}
+
+int StepScheduler::getNumDeferred() {
+	return num_deferred;
+}
+
+int StepScheduler::getNumOverBudget() {
+	return num_over_budget;
+}
+
+double StepScheduler::getWallUsPerLoop() {
+	// wall-clock time between the first and last steps, including the time spent outside of OnStep
+	if (last_loop <= first_loop)
+		return 0.0;
+	return std::chrono::duration<double, std::micro>(last_start - first_start).count() / (last_loop - first_loop);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+# define STEP_BUDGET_US 25000 // wall-clock time a step may take, a realtime game loop at faster speed is approx 44600us
+# define TASK_COST_SMOOTHING 0.2 // weight of the latest measurement when updating a task's cost estimate
+# define TASK_MAX_DELAY 2 // background tasks run regardless of the budget once this many periods late
+
+class BasicSc2Bot;
+
+enum class TASK_PRIORITY {
+	CRITICAL,	// runs whenever it is due
+	BACKGROUND	// runs when it is due and its estimated cost fits in what is left of the step's budget
+};
+
+class StepScheduler {
+// Runs the work of OnStep as registered tasks. Each task has a priority, a target period in
+// game loops and a cost estimate, which is replaced by a moving average of its measured cost.
+// Critical tasks run in registration order whenever they are due. Background tasks that are due
+// then run most overdue first while their estimated cost fits in the rest of the step budget,
+// and are deferred to a later step otherwise
+public:
+	typedef std::function<void()> TaskFunction;
+
+	StepScheduler(BasicSc2Bot* agent_);
+	int registerTask(const char* name_, TASK_PRIORITY priority_, int period_, double cost_us_, TaskFunction func_);
+	void setPeriod(const char* name_, int period_);
+	void setBudget(long long budget_us_);
+	void beginStep();
+	void runStep(int game_loop_);
+	int getNumDeferred();
+	int getNumOverBudget();
+	double getWallUsPerLoop();
+
+private:
+	struct StepTask {
+		const char* name;		// must be a string literal, it is used as the tracer's span name
+		TASK_PRIORITY priority;
+		int period;
+		double cost_us;
+		int last_run;
+		TaskFunction func;
+	};
+
+	bool isDue(const StepTask& task_, int game_loop_);
+	void runTask(StepTask& task_, int game_loop_);
+	long long elapsedUs();
+
+	BasicSc2Bot* agent;
+	std::vector<StepTask> tasks;
+	long long budget_us;
+	std::chrono::steady_clock::time_point step_start;
+	int num_deferred;		// times a due background task was put off to a later step
+	int num_over_budget;	// steps that went over the budget
+	int first_loop;			// game loop of the first step run, -1 before then
+	int last_loop;
+	std::chrono::steady_clock::time_point first_start;
+	std::chrono::steady_clock::time_point last_start;
+};
@@ -1,4 +1,6 @@
 #include "Strategy.h"
+#include "StrategyFile.h"
+#include <iostream>
 
 Strategy::Strategy(BasicSc2Bot* bot_) {
 	bot = bot_;
@@ -48,7 +50,27 @@ void Strategy::loadGameSettings(int* map_index, sc2::Race* bot_race, sc2::Race*
 
 void Strategy::loadStrategies() {
 	map_index = bot->getMapIndex();
-	p_id = bot->locH->getPlayerIDForMap(map_index, bot->Observation()->GetStartLocation());
+	p_id = bot->locH->getPlayerIDForMap(map_index, bot->getObservation()->GetStartLocation());
+
+	// a configured strategy file replaces the built-in strategy below, its compiled image is used when there is one
+	std::string strategy_path = StrategyFile::configuredPath();
+	if (!strategy_path.empty()) {
+		StrategyFile file;
+		std::string image_path = StrategyFile::imagePath(strategy_path, map_index, p_id);
+		if (file.loadImage(image_path, strategy_path, map_index, p_id)) {
+			strategy_path = image_path;
+		}
+		else if (!file.load(strategy_path)) {
+			strategy_path.clear();
+		}
+		if (!strategy_path.empty()) {
+			int added = file.apply(bot, this, map_index, p_id);
+			std::cout << "Strategy " << strategy_path << ": " << file.getNumPrecepts() << " precepts and " << file.getNumConditions()
+				<< " conditions loaded in " << file.getLoadUs() << "us, " << added << " precepts for this map" << std::endl;
+			return;
+		}
+		std::cout << "Using the built-in strategy" << std::endl;
+	}
 
 	// Cactus Valley Strategy
 	if (map_index == 1) {
@@ -112,7 +134,7 @@ void Strategy::loadStrategies() {
 		bot->storeLocation("DEBUG_TEST", sc2::Point2D(-777, -777));
 
 		{	// Train Probes at our main Nexus
-			Precept base_probe(bot);
+			Precept base_probe(bot, "base_probe");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->bases[0].getTownhall(), Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_NEXUS, sc2::ABILITY_ID::TRAIN_PROBE);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 50);
@@ -131,7 +153,7 @@ void Strategy::loadStrategies() {
 		bot->storeInt("_GRAB_WORKERS_ON_EXPAND", 15); // identifier use to determine number of workers to grab after expansion is built
 
 		{	// Expand to the first expansion almost immediately
-			Precept first_expansion(bot);
+			Precept first_expansion(bot, "first_expansion");
 			Directive d(Directive::UNIT_TYPE, Directive::EXACT_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_NEXUS, bot->locH->bases[1].getTownhall());
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 400);
@@ -149,7 +171,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(first_expansion);
 		}
 		{	// Train Probes at Expansion
-			Precept exp_probe(bot);
+			Precept exp_probe(bot, "exp_probe");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->bases[1].getTownhall(), Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_NEXUS, sc2::ABILITY_ID::TRAIN_PROBE);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 50);
@@ -161,7 +183,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(exp_probe);
 		}
 		{	// build pylon #1 at our pre-defined wall location
-			Precept pylon_1(bot);
+			Precept pylon_1(bot, "pylon_1");
 			Directive d(Directive::UNIT_TYPE, Directive::EXACT_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PYLON, bot->getStoredLocation("PYLON_1"));
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 100);
@@ -179,7 +201,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(pylon_1);
 		}
 		{	// build forge #1 at our pre-defined wall location
-			Precept forge_1(bot);
+			Precept forge_1(bot, "forge_1");
 			Directive d(Directive::UNIT_TYPE, Directive::EXACT_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_FORGE, bot->getStoredLocation("FORGE_1"));
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -199,7 +221,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(forge_1);
 		}
 		{	// build forge #1 inside main base if the first forge falls
-			Precept forge_backup(bot);
+			Precept forge_backup(bot, "forge_backup");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_FORGE, bot->locH->bases[0].getBuildArea(0));
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -219,7 +241,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(forge_backup);
 		}
 		{	// build gateway #1 at our pre-defined wall location
-			Precept gateway_1(bot);
+			Precept gateway_1(bot, "gateway_1");
 			Directive d(Directive::UNIT_TYPE, Directive::EXACT_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_GATEWAY, bot->getStoredLocation("GATEWAY_1"));
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -237,7 +259,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(gateway_1);
 		}
 		{	// build pylon #2 in our pre-defined wall location
-			Precept pylon_2(bot);
+			Precept pylon_2(bot, "pylon_2");
 			Directive d(Directive::UNIT_TYPE, Directive::EXACT_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PYLON, bot->getStoredLocation("PYLON_2"));
 			Trigger t(bot);
 			d.allowMultiple();
@@ -251,7 +273,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(pylon_2);
 		}
 		{	// build cannon #1 at our pre-defined wall location
-			Precept cannon_1(bot);
+			Precept cannon_1(bot, "cannon_1");
 			Directive d(Directive::UNIT_TYPE, Directive::EXACT_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PHOTONCANNON, bot->getStoredLocation("CANNON_1"));
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -263,7 +285,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(cannon_1);
 		}
 		{	// build cannon #2 at our pre-defined wall location
-			Precept cannon_2(bot);
+			Precept cannon_2(bot, "cannon_2");
 			Directive d(Directive::UNIT_TYPE, Directive::EXACT_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PHOTONCANNON, bot->getStoredLocation("CANNON_2"));
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -280,7 +302,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(cannon_2);
 		}
 		{	// build our cybernetics core at our pre-defined wall location
-			Precept cyber_1(bot);
+			Precept cyber_1(bot, "cyber_1");
 			Directive d(Directive::UNIT_TYPE, Directive::EXACT_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_CYBERNETICSCORE, bot->getStoredLocation("CYBER_1"));
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -292,7 +314,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(cyber_1);
 		}
 		{	// Ensure there is at least one pylon at main base build area 0
-			Precept main_pylon(bot);
+			Precept main_pylon(bot, "main_pylon");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PYLON, bot->locH->bases[0].getBuildArea(0), 4.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 100);
@@ -303,7 +325,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(main_pylon);
 		}
 		{	// Continuously build pylons in main base build area 0 when low on food (after first 4 are built)
-			Precept main_pylon_2(bot);
+			Precept main_pylon_2(bot, "main_pylon_2");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PYLON, bot->locH->bases[0].getBuildArea(0), 12.0F);
 			d.allowMultiple();
 			Trigger t(bot);
@@ -317,7 +339,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(main_pylon_2);
 		}
 		{	// Ensure there is at least one pylon at main base build area 1
-			Precept main_pylon_3(bot);
+			Precept main_pylon_3(bot, "main_pylon_3");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PYLON, bot->locH->bases[0].getBuildArea(1), 4.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 100);
@@ -328,7 +350,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(main_pylon_3);
 		}
 		{	// Build 10th to 14th pylon at main base build area 2
-			Precept main_pylon_4(bot);
+			Precept main_pylon_4(bot, "main_pylon_4");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PYLON, bot->locH->bases[0].getBuildArea(2), 12.0F);
 			d.allowMultiple();
 			Trigger t(bot);
@@ -342,7 +364,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(main_pylon_4);
 		}
 		{	// build gateways at main base build area 0
-			Precept main_gateway(bot);
+			Precept main_gateway(bot, "main_gateway");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_GATEWAY, bot->locH->bases[0].getBuildArea(0));
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 100);
@@ -362,7 +384,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(main_gateway);
 		}
 		{	// build gateways at main base build area 1
-			Precept gateway_2(bot);
+			Precept gateway_2(bot, "gateway_2");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_GATEWAY, bot->locH->bases[0].getBuildArea(1), 10.0F);
 			Trigger t(bot);
 			d.allowMultiple();
@@ -385,7 +407,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(gateway_2);
 		}
 		{	// build robotics facilities in main base build area 1
-			Precept robotics_1(bot);
+			Precept robotics_1(bot, "robotics_1");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_ROBOTICSFACILITY, bot->locH->bases[0].getBuildArea(1), 10.0F);
 			Trigger t(bot);
 			d.allowMultiple();
@@ -436,7 +458,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(robotics_1);
 		}
 		{	// build robotics facilities in main base build area 2
-			Precept robotics_2(bot);
+			Precept robotics_2(bot, "robotics_2");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_ROBOTICSFACILITY, bot->locH->bases[0].getBuildArea(2), 10.0F);
 			Trigger t(bot);
 			d.allowMultiple();
@@ -455,7 +477,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(robotics_2);
 		}
 		{	// build a robotics bay in main base build area 2
-			Precept robotics_bay(bot);
+			Precept robotics_bay(bot, "robotics_bay");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_ROBOTICSBAY, bot->locH->bases[0].getBuildArea(2), 10.0F);
 			Trigger t(bot);
 			d.allowMultiple();
@@ -470,7 +492,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(robotics_bay);
 		}
 		{	// train immortals
-			Precept train_immortal(bot);
+			Precept train_immortal(bot, "train_immortal");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY, sc2::ABILITY_ID::TRAIN_IMMORTAL);
 			d.allowMultiple();
 			train_immortal.addDirective(d);
@@ -545,7 +567,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(train_immortal);
 		}
 		{	// train an observer
-			Precept train_observer(bot);
+			Precept train_observer(bot, "train_observer");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY, sc2::ABILITY_ID::TRAIN_OBSERVER);
 			d.allowMultiple();
 			train_observer.addDirective(d);
@@ -574,7 +596,7 @@ void Strategy::loadStrategies() {
 		startup_base_conds.push_back(Trigger::TriggerCondition(bot, COND::MIN_UNIT_OF_TYPE_TOTAL, 1, sc2::UNIT_TYPEID::PROTOSS_CYBERNETICSCORE));
 
 		{	// train collosus
-			Precept train_colossus(bot);
+			Precept train_colossus(bot, "train_colossus");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_ROBOTICSFACILITY, sc2::ABILITY_ID::TRAIN_COLOSSUS);
 			d.allowMultiple();
 			train_colossus.addDirective(d);
@@ -612,7 +634,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(train_colossus);
 		}
 		{	// build assimilators at main base
-			Precept assim_1(bot);
+			Precept assim_1(bot, "assim_1");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_ASSIMILATOR, bot->locH->bases[0].getTownhall());
 			Trigger t(bot);
 			d.allowMultiple();
@@ -630,7 +652,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(assim_1);
 		}
 		{	// build pylon near cannons
-			Precept defense_pylon(bot);
+			Precept defense_pylon(bot, "defense_pylon");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PYLON, bot->locH->bases[1].getDefendPoint(0), 2.0F);
 			Trigger t(bot);
 			for (auto tc : startup_base_conds)
@@ -645,7 +667,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(defense_pylon);
 		}
 		{	// build more cannons at our defense point
-			Precept more_cannons(bot);
+			Precept more_cannons(bot, "more_cannons");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PHOTONCANNON, bot->getStoredLocation("CANNON_1"), 4.0F);
 			//d.allowMultiple();
 			Trigger t(bot);
@@ -660,7 +682,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(more_cannons);
 		}
 		{	// handle training stalkers
-			Precept train_stalker(bot);
+			Precept train_stalker(bot, "train_stalker");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_GATEWAY, sc2::ABILITY_ID::TRAIN_STALKER);
 			d.allowMultiple();
 			Trigger t(bot); // get 2 stalkers out asap
@@ -750,7 +772,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(train_stalker);
 		}
 		{	// handle training sentries
-			Precept train_sentry(bot);
+			Precept train_sentry(bot, "train_sentry");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_GATEWAY, sc2::ABILITY_ID::TRAIN_SENTRY);
 			d.allowMultiple();
 			Trigger t(bot);
@@ -776,7 +798,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(train_sentry);
 		}
 		{	// use a forcefield at the base entry when units are swarming in. Ideally it will trap one or two inside.
-			Precept force_field(bot);
+			Precept force_field(bot, "force_field");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->bases[1].getRallyPoint(), Directive::EXACT_LOCATION, sc2::UNIT_TYPEID::PROTOSS_SENTRY, sc2::ABILITY_ID::EFFECT_FORCEFIELD, bot->getStoredLocation("FORCE_FIELD"), 8.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_UNIT_OF_TYPE, 1, sc2::UNIT_TYPEID::PROTOSS_SENTRY);
@@ -788,7 +810,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(force_field);
 		}
 		{
-			Precept hallucination(bot);
+			Precept hallucination(bot, "hallucination");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_SENTRY, sc2::ABILITY_ID::HALLUCINATION_COLOSSUS);
 			Trigger t(bot);
 			t.addCondition(COND::TIMER_1_MIN_STEPS_PAST, 850);
@@ -797,7 +819,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(hallucination);
 		}
 		{	// handle training zealots
-			Precept train_zealot(bot);
+			Precept train_zealot(bot, "train_zealot");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_GATEWAY, sc2::ABILITY_ID::TRAIN_ZEALOT);
 			d.allowMultiple();
 			Trigger t(bot); // always build zealots if gas is low
@@ -836,7 +858,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(train_zealot);
 		}
 		{	// build twilight council at main base build area 0
-			Precept twilight_council(bot);
+			Precept twilight_council(bot, "twilight_council");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_TWILIGHTCOUNCIL, bot->locH->bases[0].getBuildArea(0), 14.0F);
 			Trigger t(bot);
 			d.allowMultiple();
@@ -849,7 +871,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(twilight_council);
 		}
 		{	// research extended lance for collossus to outrange defenses
-			Precept research_lance(bot);
+			Precept research_lance(bot, "research_lance");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_ROBOTICSBAY, sc2::ABILITY_ID::RESEARCH_EXTENDEDTHERMALLANCE);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -861,7 +883,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(research_lance);
 		}
 		{	// research charge for zealots
-			Precept research_charge(bot);
+			Precept research_charge(bot, "research_charge");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_TWILIGHTCOUNCIL, sc2::ABILITY_ID::RESEARCH_CHARGE);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 100);
@@ -874,7 +896,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(research_charge);
 		}
 		{	// research blink for stalkers (they will automatically blink away when taking damage that puts their health low)
-			Precept research_blink(bot);
+			Precept research_blink(bot, "research_blink");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_TWILIGHTCOUNCIL, sc2::ABILITY_ID::RESEARCH_BLINK);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -887,7 +909,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(research_blink);
 		}
 		{	// build assimilators at expansion
-			Precept assim_2(bot);
+			Precept assim_2(bot, "assim_2");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_ASSIMILATOR, bot->locH->bases[1].getTownhall());
 			d.allowMultiple();
 			Trigger t(bot);
@@ -909,7 +931,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(assim_2);
 		}
 		{	// continuously upgrade attack at forge when possible
-			Precept upgrade_attack(bot);
+			Precept upgrade_attack(bot, "upgrade_attack");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_FORGE, sc2::ABILITY_ID::RESEARCH_PROTOSSGROUNDWEAPONS);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 100);
@@ -935,7 +957,7 @@ void Strategy::loadStrategies() {
 		}
 		{	// upgrade shields at forge when attack is full upgraded
 			// DISABLED this because the game ends before it would ever be worth it.
-			Precept upgrade_shields(bot);
+			Precept upgrade_shields(bot, "upgrade_shields");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_FORGE, sc2::ABILITY_ID::RESEARCH_PROTOSSSHIELDS);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -961,7 +983,7 @@ void Strategy::loadStrategies() {
 			//bot->addStrat(upgrade_shields);
 		}
 		{	// handle our nexus using chronoboost
-			Precept use_chrono(bot);
+			Precept use_chrono(bot, "use_chrono");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_NEXUS, sc2::ABILITY_ID::EFFECT_CHRONOBOOSTENERGYCOST, bot->locH->bases[0].getTownhall());
 			Trigger t(bot);
 			t.addCondition(COND::MIN_FOOD_CAP, 16);
@@ -971,10 +993,10 @@ void Strategy::loadStrategies() {
 			bot->addStrat(use_chrono);
 		}
 		{	// send our scout to the highest threat locations (pre-defined as the enemy start locations)
-			Precept scout_bases(bot);
+			Precept scout_bases(bot, "scout_bases");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_SCOUT}, sc2::ABILITY_ID::ATTACK, bot->getStoredLocation("CANNON_1"), 4.0F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->getHighestThreatLocation(); };
+			auto func = bot->locH->locationProvider("HIGHEST_THREAT");
 			d.setTargetLocationFunction(this, bot, func);
 			t.addCondition(COND::MIN_UNIT_WITH_FLAGS, 1, std::unordered_set<FLAGS>{FLAGS::IS_SCOUT});
 			scout_bases.addDirective(d);
@@ -982,7 +1004,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(scout_bases);
 		}
 		{	// set our first unit (a zealot) to be a scout
-			Precept set_scout(bot);
+			Precept set_scout(bot, "set_scout");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::SET_FLAG, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, FLAGS::IS_SCOUT);
 			Trigger t(bot);
 			t.addCondition(COND::MAX_DEAD_MOBS, 0);
@@ -992,10 +1014,10 @@ void Strategy::loadStrategies() {
 			bot->addStrat(set_scout);
 		}
 		{	// set all army units to use the smartStayHomeAndDefend() function until it is time to attack
-			Precept defend_home(bot);
+			Precept defend_home(bot, "defend_home");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, sc2::ABILITY_ID::ATTACK, bot->locH->bases[1].getRallyPoint(), 2.5F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->smartStayHomeAndDefend(); };
+			auto func = bot->locH->locationProvider("SMART_STAY_HOME_AND_DEFEND");
 			d.setTargetLocationFunction(this, bot, func);
 			d.setIgnoreDistance(2.5F);
 			d.excludeFlag(FLAGS::IS_SCOUT);
@@ -1009,7 +1031,7 @@ void Strategy::loadStrategies() {
 
 
 		{	// designate 4 probes to not defend at all times, so our economy still runs
-			Precept assign_non_defender(bot);
+			Precept assign_non_defender(bot, "assign_non_defender");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->bases[0].getTownhall(), Directive::ACTION_TYPE::SET_FLAG, sc2::UNIT_TYPEID::PROTOSS_PROBE, FLAGS::NON_DEFENDER, 20.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MAX_UNIT_WITH_FLAGS, 4, std::unordered_set<FLAGS>{FLAGS::NON_DEFENDER});
@@ -1019,7 +1041,7 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// set timer to send workers to defend expansion when army is insufficient
-			Precept workers_defend_init_timer(bot);
+			Precept workers_defend_init_timer(bot, "workers_defend_init_timer");
 			Directive d(Directive::GAME_VARIABLES, Directive::SET_TIMER_2, 0);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_ENEMY_UNITS_NEAR_LOCATION, 2, bot->locH->bases[1].getTownhall(), 15.0F);
@@ -1034,7 +1056,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(workers_defend_init_timer);
 		}
 		{	// reset the defense timer once enemies are cleared or defense army is sufficient
-			Precept reset_worker_defense_timer(bot);
+			Precept reset_worker_defense_timer(bot, "reset_worker_defense_timer");
 			Directive d(Directive::GAME_VARIABLES, Directive::RESET_TIMER_2);
 			Trigger t(bot);
 			t.addCondition(COND::MAX_ENEMY_UNITS_NEAR_LOCATION, 0, bot->locH->bases[1].getTownhall(), 15.0F);
@@ -1051,10 +1073,10 @@ void Strategy::loadStrategies() {
 			bot->addStrat(reset_worker_defense_timer);
 		}
 		{	// send workers to defend expansion when defense timer is initialized
-			Precept workers_defend_expansion(bot);
+			Precept workers_defend_expansion(bot, "workers_defend_expansion");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_WORKER}, sc2::ABILITY_ID::ATTACK, bot->locH->bases[1].getRallyPoint(), 3.0F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->smartStayHomeAndDefend(); };
+			auto func = bot->locH->locationProvider("SMART_STAY_HOME_AND_DEFEND");
 			d.setTargetLocationFunction(this, bot, func);
 			d.excludeFlag(FLAGS::NON_DEFENDER);
 			t.addCondition(COND::TIMER_2_SET, 0, true);
@@ -1067,10 +1089,10 @@ void Strategy::loadStrategies() {
 		// previously sent all workers - but often let to wrecking our economy when unnecessary
 		/*
 		{	// send workers to defend expansion when defense timer is initialized
-			Precept workers_defend_expansion(bot);
+			Precept workers_defend_expansion(bot, "workers_defend_expansion");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_WORKER}, sc2::ABILITY_ID::ATTACK, bot->locH->bases[1].getRallyPoint(), 3.0F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->smartStayHomeAndDefend(); };
+			auto func = bot->locH->locationProvider("SMART_STAY_HOME_AND_DEFEND");
 			d.setTargetLocationFunction(this, bot, func);
 			t.addCondition(COND::TIMER_2_SET, 0, true);
 			//t.addCondition(COND::MAX_UNIT_WITH_FLAGS_NEAR_LOCATION, 3, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, bot->locH->bases[1].getTownhall(), 16.0F);
@@ -1079,7 +1101,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(workers_defend_expansion);
 		} */
 		{	// initialize the timer for grouping up at a rally point en route to attacking
-			Precept init_group_timer(bot);
+			Precept init_group_timer(bot, "init_group_timer");
 			Directive d(Directive::GAME_VARIABLES, Directive::ACTION_TYPE::SET_TIMER_1, 0);
 			Trigger t(bot);
 			t.addCondition(COND::TIMER_1_SET, 0, false);
@@ -1106,7 +1128,7 @@ void Strategy::loadStrategies() {
 
 
 		{	// send all army units to the pre-group area outside of the base before sending the attack
-			Precept group_at_pre_pre_prep_area(bot);
+			Precept group_at_pre_pre_prep_area(bot, "group_at_pre_pre_prep_area");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, sc2::ABILITY_ID::ATTACK, bot->locH->bases[3].getDefendPoint(1), 4.0F);
 			Trigger t(bot);
 			d.setIgnoreDistance(7.0F);
@@ -1123,10 +1145,10 @@ void Strategy::loadStrategies() {
 		// removing this extra grouping spot as it often caused the army to split up
 		/* 
 		{	// send all army units to the pre-group area outside of the base before sending the attack
-			Precept group_at_pre_prep_area(bot);
+			Precept group_at_pre_prep_area(bot, "group_at_pre_prep_area");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, sc2::ABILITY_ID::ATTACK, bot->locH->bases[3].getDefendPoint(1), 4.0F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->getRallyPointBeforeRallyPoint(); };
+			auto func = bot->locH->locationProvider("RALLY_POINT_BEFORE_RALLY_POINT");
 			d.setTargetLocationFunction(this, bot, func);
 			d.setIgnoreDistance(7.0F);
 			d.setOverrideOther(); // grab mobs who were on their way to attack the enemy
@@ -1139,10 +1161,10 @@ void Strategy::loadStrategies() {
 			bot->addStrat(group_at_pre_prep_area);
 		} */
 		{	// send all army units to group at a rally point en route to the attack location and wait for 850 gameloop steps
-			Precept group_at_prep_area(bot);
+			Precept group_at_prep_area(bot, "group_at_prep_area");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, sc2::ABILITY_ID::ATTACK, bot->locH->getCenterPathableLocation(), 4.0F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->getRallyPointTowardsThreat(); };
+			auto func = bot->locH->locationProvider("RALLY_POINT_TOWARDS_THREAT");
 			d.setTargetLocationFunction(this, bot, func);
 			d.setIgnoreDistance(7.0F);
 			d.setOverrideOther(); // grab mobs who were on their way to attack the enemy
@@ -1156,10 +1178,10 @@ void Strategy::loadStrategies() {
 
 		/*			This was the original but testing new grouping for now - also changed to 650 instead of 750
 		{	// send all army units to group at a rally point en route to the attack location and wait for 750 gameloop steps
-			Precept group_at_prep_area(bot);
+			Precept group_at_prep_area(bot, "group_at_prep_area");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, sc2::ABILITY_ID::ATTACK, bot->locH->getCenterPathableLocation(), 4.0F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->getRallyPointTowardsThreat(); };
+			auto func = bot->locH->locationProvider("RALLY_POINT_TOWARDS_THREAT");
 			d.setTargetLocationFunction(this, bot, func);
 			d.setIgnoreDistance(7.0F);
 			d.setOverrideOther(); // grab mobs who were on their way to attack the enemy
@@ -1172,13 +1194,13 @@ void Strategy::loadStrategies() {
 			bot->addStrat(group_at_prep_area);
 		} */
 		{	// after timer passes 750 gameloop steps, send in the attack 
-			Precept attack_and_explore(bot);
+			Precept attack_and_explore(bot, "attack_and_explore");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, sc2::ABILITY_ID::ATTACK, sc2::Point2D(1, 1), 4.0F);
 			Trigger t(bot);
 			bot->storeInt("ATTACK_DIR_ID", d.getID()); // identifier use to determine when first attack was launched
 			d.excludeFlag(FLAGS::IS_FLYING);
 			d.setContinuous();
-			auto func = [this]() { return bot->locH->smartPriorityAttack(); };
+			auto func = bot->locH->locationProvider("SMART_PRIORITY_ATTACK");
 			d.setTargetLocationFunction(this, bot, func);
 			attack_and_explore.addDirective(d);
 			t.addCondition(COND::TIMER_1_MIN_STEPS_PAST, 850);
@@ -1186,11 +1208,11 @@ void Strategy::loadStrategies() {
 			bot->addStrat(attack_and_explore);
 		}
 		{	// handle flyers during attack
-			Precept attack_and_explore_flying(bot); 
+			Precept attack_and_explore_flying(bot, "attack_and_explore_flying"); 
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_FLYING}, sc2::ABILITY_ID::ATTACK, sc2::Point2D(1, 1), 4.0F);
 			Trigger t(bot);
 			d.setContinuous();
-			auto func = [this]() { return bot->locH->getAttackingForceLocation(); }; //flyers stay with the army instead of taking shortcuts
+			auto func = bot->locH->locationProvider("ATTACKING_FORCE"); //flyers stay with the army instead of taking shortcuts
 			d.setTargetLocationFunction(this, bot, func);
 			attack_and_explore_flying.addDirective(d);
 			t.addCondition(COND::TIMER_1_MIN_STEPS_PAST, 850);
@@ -1199,12 +1221,12 @@ void Strategy::loadStrategies() {
 			bot->addStrat(attack_and_explore_flying);
 		}
 		{	// after 750 gameloop steps, send in the attack 
-			Precept attack_and_explore_late(bot); // if greater than 22,000 steps, flyers go their own way
+			Precept attack_and_explore_late(bot, "attack_and_explore_late"); // if greater than 22,000 steps, flyers go their own way
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, sc2::ABILITY_ID::ATTACK, sc2::Point2D(1, 1), 4.0F);
 			Trigger t(bot);
 			d.excludeFlag(FLAGS::IS_FLYING);
 			d.setContinuous();
-			auto func = [this]() { return bot->locH->smartPriorityAttack(); };
+			auto func = bot->locH->locationProvider("SMART_PRIORITY_ATTACK");
 			d.setTargetLocationFunction(this, bot, func);
 			attack_and_explore_late.addDirective(d);
 			t.addCondition(COND::MIN_TIME, 22000);
@@ -1212,7 +1234,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(attack_and_explore_late);
 		}
 		{	// if food usage drops below 90, stop sending units to join the attack, and build up another force first
-			Precept reset_group_timer(bot);
+			Precept reset_group_timer(bot, "reset_group_timer");
 			Directive d(Directive::GAME_VARIABLES, Directive::ACTION_TYPE::RESET_TIMER_1);
 			Trigger t(bot);
 			t.addCondition(COND::TIMER_1_SET);
@@ -1222,7 +1244,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(reset_group_timer);
 		}
 		{	// in case things don't end, start building up stuff to clean up
-			Precept stargate_1(bot);
+			Precept stargate_1(bot, "stargate_1");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_STARGATE, bot->locH->bases[0].getBuildArea(2));
 			Trigger t(bot);
 			t.addCondition(COND::MIN_UNIT_OF_TYPE, 1, sc2::UNIT_TYPEID::PROTOSS_CYBERNETICSCORE);
@@ -1247,7 +1269,7 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// train voidrays for cleanup
-			Precept train_void(bot);
+			Precept train_void(bot, "train_void");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_STARGATE, sc2::ABILITY_ID::TRAIN_VOIDRAY);
 			d.allowMultiple(); // more than one stargate can train at the same time
 			Trigger t(bot);
@@ -1268,9 +1290,9 @@ void Strategy::loadStrategies() {
 			bot->addStrat(train_void);
 		}
 		{	// void rays clean up
-			Precept flyers_search(bot);
+			Precept flyers_search(bot, "flyers_search");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_FLYING}, sc2::ABILITY_ID::ATTACK, bot->locH->getBestEnemyLocation(), 4.0F);
-			auto func = [this]() { return bot->locH->smartAttackFlyingLocation(); };
+			auto func = bot->locH->locationProvider("SMART_ATTACK_FLYING");
 			d.setTargetLocationFunction(this, bot, func);
 			Trigger t(bot); // after 22,000 timesteps, send flyers to search non-pathable areas
 			t.addCondition(COND::MIN_UNIT_WITH_FLAGS, 1, std::unordered_set<FLAGS>{FLAGS::IS_FLYING});
@@ -1307,7 +1329,7 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// send 1 probe to the proxy point
-			Precept assign_proxy(bot);
+			Precept assign_proxy(bot, "assign_proxy");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->getStoredLocation("PROXY_INITIAL_LOC"), Directive::ACTION_TYPE::SET_FLAG, sc2::UNIT_TYPEID::PROTOSS_PROBE, FLAGS::IS_PROXY, 4.0F);
 			assign_proxy.addDirective(d);
 			Trigger t(bot);
@@ -1317,7 +1339,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(assign_proxy);
 		}
 		{	// assign new proxy if the first is dead
-			Precept assign_proxy_2(bot);
+			Precept assign_proxy_2(bot, "assign_proxy_2");
 			Directive d(Directive::UNIT_TYPE, Directive::ACTION_TYPE::SET_FLAG, sc2::UNIT_TYPEID::PROTOSS_PROBE, FLAGS::IS_PROXY);
 			assign_proxy_2.addDirective(d);
 			Trigger t(bot);
@@ -1330,7 +1352,7 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// send the proxy probe in with the first wave of zealots
-			Precept send_decoy_home(bot);
+			Precept send_decoy_home(bot, "send_decoy_home");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->getStoredLocation("DECOY_LOC"), Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::ATTACK, bot->locH->bases[0].getTownhall(), 6.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_UNIT_OF_TYPE_NEAR_LOCATION, 1, sc2::UNIT_TYPEID::PROTOSS_PROBE, bot->getStoredLocation("DECOY_LOC"), 4.0F);
@@ -1340,7 +1362,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(send_decoy_home);
 		}
 		{
-			Precept disable_proxy_harvesting(bot);
+			Precept disable_proxy_harvesting(bot, "disable_proxy_harvesting");
 			Directive d(Directive::MATCH_FLAGS, Directive::DISABLE_DEFAULT_DIRECTIVE, std::unordered_set<FLAGS>{FLAGS::IS_PROXY});
 			Trigger t(bot);
 			d.excludeFlag(FLAGS::DEF_DIR_DISABLED);
@@ -1350,7 +1372,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(disable_proxy_harvesting);
 		}
 		{
-			Precept send_proxy(bot);
+			Precept send_proxy(bot, "send_proxy");
 			Directive d(Directive::MATCH_FLAGS_NEAR_LOCATION, Directive::EXACT_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_PROXY}, sc2::ABILITY_ID::ATTACK, bot->getStoredLocation("PROXY_INITIAL_LOC"), bot->locH->getProxyLocation(), 4.0F, 2.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_UNIT_WITH_FLAGS, 1, std::unordered_set<FLAGS>{FLAGS::IS_PROXY});
@@ -1360,7 +1382,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(send_proxy);
 		}
 		{
-			Precept send_proxy_if_home(bot);
+			Precept send_proxy_if_home(bot, "send_proxy_if_home");
 			Directive d(Directive::MATCH_FLAGS_NEAR_LOCATION, Directive::EXACT_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_PROXY}, sc2::ABILITY_ID::ATTACK, bot->locH->bases[0].getTownhall(), bot->locH->getProxyLocation(), 24.0F, 2.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_UNIT_WITH_FLAGS, 1, std::unordered_set<FLAGS>{FLAGS::IS_PROXY});
@@ -1371,7 +1393,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(send_proxy_if_home);
 		}
 		{	// build probes at nexus, but only a minimal amount
-			Precept base_probe(bot);
+			Precept base_probe(bot, "base_probe");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_NEXUS, sc2::ABILITY_ID::TRAIN_PROBE);
 			base_probe.addDirective(d);
 			Trigger t(bot);
@@ -1391,7 +1413,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(base_probe);
 		}
 		{	// build proxy pylon
-			Precept proxy_pylon(bot);
+			Precept proxy_pylon(bot, "proxy_pylon");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->getProxyLocation(), Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PYLON, bot->locH->getProxyLocation(), 15.0F, 4.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 100);
@@ -1407,7 +1429,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(proxy_pylon);
 		}
 		{	// build exactly 4 proxy gateways
-			Precept proxy_gateway(bot);
+			Precept proxy_gateway(bot, "proxy_gateway");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->getProxyLocation(), Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_GATEWAY, bot->locH->getProxyLocation());
 			Trigger t(bot); // handle case where 3 are built and none are under construction
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -1441,7 +1463,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(proxy_gateway);
 		}
 		{	// use chronoboost on gateways
-			Precept use_chrono(bot);
+			Precept use_chrono(bot, "use_chrono");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_NEXUS, sc2::ABILITY_ID::EFFECT_CHRONOBOOSTENERGYCOST, bot->locH->bases[0].getTownhall());
 			d.allowMultiple();
 			Trigger t(bot);
@@ -1452,7 +1474,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(use_chrono);
 		}
 		{	// train zealots at proxy point
-			Precept train_zealot(bot);
+			Precept train_zealot(bot, "train_zealot");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_GATEWAY, sc2::ABILITY_ID::TRAIN_ZEALOT);
 			d.allowMultiple(); // more than one gateway can train at the same time
 			Trigger t(bot);
@@ -1502,7 +1524,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(train_zealot);
 		}
 		{	// send the proxy probe in with the first wave of zealots
-			Precept send_probe_attack(bot);
+			Precept send_probe_attack(bot, "send_probe_attack");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->getProxyLocation(), Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::ATTACK, bot->locH->getBestEnemyLocation(), 20.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_UNIT_OF_TYPE, 3, sc2::UNIT_TYPEID::PROTOSS_ZEALOT);
@@ -1511,7 +1533,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(send_probe_attack);
 		}
 		{	// build more pylons if the game continues
-			Precept more_pylons(bot);
+			Precept more_pylons(bot, "more_pylons");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->bases[0].getTownhall(), Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PYLON, bot->locH->bases[0].getBuildArea(0), 20.0F, 16.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 105);
@@ -1528,7 +1550,7 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// build forge if the game continues
-			Precept main_forge(bot);
+			Precept main_forge(bot, "main_forge");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->bases[0].getTownhall(), Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_FORGE, bot->locH->bases[0].getBuildArea(0), 20.0F, 16.0F);
 			main_forge.addDirective(d);
 			Trigger t(bot);
@@ -1548,7 +1570,7 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// build cannons if the game continues
-			Precept main_cannon(bot);
+			Precept main_cannon(bot, "main_cannon");
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->bases[0].getTownhall(), Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_PHOTONCANNON, bot->locH->bases[0].getBuildArea(0), 20.0F, 16.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MIN_MINERALS, 150);
@@ -1562,7 +1584,7 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// start wrecking
-			Precept attack_enemy_base(bot);
+			Precept attack_enemy_base(bot, "attack_enemy_base");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, sc2::ABILITY_ID::ATTACK, bot->locH->getBestEnemyLocation(), 4.0F);
 			Trigger t(bot);
 			d.excludeFlag(FLAGS::IS_FLYING);
@@ -1582,10 +1604,10 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// keep wrecking
-			Precept attack_and_explore(bot);
+			Precept attack_and_explore(bot, "attack_and_explore");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_ATTACKER}, sc2::ABILITY_ID::ATTACK, bot->locH->getBestEnemyLocation(), 4.0F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->smartAttackLocation(); };
+			auto func = bot->locH->locationProvider("SMART_ATTACK");
 			d.setTargetLocationFunction(this, bot, func);
 			d.excludeFlag(FLAGS::IS_FLYING);
 			d.setContinuous();
@@ -1605,7 +1627,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(attack_and_explore);
 		}
 		{	// in case things don't end, start building up stuff to clean up
-			Precept assim_1(bot);
+			Precept assim_1(bot, "assim_1");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_ASSIMILATOR, bot->locH->bases[0].getTownhall());
 			assim_1.addDirective(d);
 			Trigger t(bot);
@@ -1620,7 +1642,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(assim_1);
 		}
 		{	// in case things don't end, start building up stuff to clean up
-			Precept cyber_1(bot);
+			Precept cyber_1(bot, "cyber_1");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_CYBERNETICSCORE, bot->locH->bases[0].getBuildArea(0));
 			Trigger t(bot);
 			d.allowMultiple();
@@ -1634,7 +1656,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(cyber_1);
 		}
 		{	// in case things don't end, start building up stuff to clean up
-			Precept stargate_1(bot);
+			Precept stargate_1(bot, "stargate_1");
 			Directive d(Directive::UNIT_TYPE, Directive::NEAR_LOCATION, sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::ABILITY_ID::BUILD_STARGATE, bot->locH->bases[0].getBuildArea(0));
 			Trigger t(bot);
 			d.allowMultiple();
@@ -1648,7 +1670,7 @@ void Strategy::loadStrategies() {
 			bot->addStrat(stargate_1);
 		}
 		{	// train void rays for cleanup
-			Precept train_voidray(bot);
+			Precept train_voidray(bot, "train_voidray");
 			Directive d(Directive::UNIT_TYPE, Directive::SIMPLE_ACTION, sc2::UNIT_TYPEID::PROTOSS_STARGATE, sc2::ABILITY_ID::TRAIN_VOIDRAY);
 			d.allowMultiple(); // more than one stargate can train at the same time
 			Trigger t(bot);
@@ -1661,10 +1683,10 @@ void Strategy::loadStrategies() {
 			bot->addStrat(train_voidray);
 		}
 		{	// void rays clean up
-			Precept flyers_search(bot);
+			Precept flyers_search(bot, "flyers_search");
 			Directive d(Directive::MATCH_FLAGS, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_FLYING}, sc2::ABILITY_ID::ATTACK, bot->locH->getBestEnemyLocation(), 4.0F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->smartAttackFlyingLocation(); };
+			auto func = bot->locH->locationProvider("SMART_ATTACK_FLYING");
 			d.setTargetLocationFunction(this, bot, func);
 			t.addCondition(COND::MIN_UNIT_WITH_FLAGS, 4, std::unordered_set<FLAGS>{FLAGS::IS_FLYING});
 			flyers_search.addDirective(d);
@@ -1677,7 +1699,7 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// designate 2 probes to not defend at all times, so our economy still runs
-			Precept assign_non_defender(bot); 
+			Precept assign_non_defender(bot, "assign_non_defender"); 
 			Directive d(Directive::UNIT_TYPE_NEAR_LOCATION, bot->locH->bases[0].getTownhall(), Directive::ACTION_TYPE::SET_FLAG, sc2::UNIT_TYPEID::PROTOSS_PROBE, FLAGS::NON_DEFENDER, 20.0F);
 			Trigger t(bot);
 			t.addCondition(COND::MAX_UNIT_WITH_FLAGS, 2, std::unordered_set<FLAGS>{FLAGS::NON_DEFENDER});
@@ -1687,10 +1709,10 @@ void Strategy::loadStrategies() {
 		}
 
 		{	// send workers to defend base
-			Precept workers_defend_base(bot);
+			Precept workers_defend_base(bot, "workers_defend_base");
 			Directive d(Directive::MATCH_FLAGS_NEAR_LOCATION, Directive::ACTION_TYPE::NEAR_LOCATION, std::unordered_set<FLAGS>{FLAGS::IS_WORKER}, sc2::ABILITY_ID::ATTACK, bot->locH->bases[0].getTownhall(), bot->locH->bases[1].getRallyPoint(), 8.0F, 3.0F);
 			Trigger t(bot);
-			auto func = [this]() { return bot->locH->smartStayHomeAndDefend(); };
+			auto func = bot->locH->locationProvider("SMART_STAY_HOME_AND_DEFEND");
 			d.setTargetLocationFunction(this, bot, func);
 			d.excludeFlag(FLAGS::NON_DEFENDER);
 			d.excludeFlag(FLAGS::IS_PROXY);
@@ -0,0 +1,1143 @@
+#include "StrategyFile.h"
+#include "BasicSc2Bot.h"
+#include "Directive.h"
+#include "LocationHandler.h"
+#include "Mob.h"
+#include "Profiler.h"
+#include "Strategy.h"
+#include "Triggers.h"
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+# define MAX_TYPE_ID 5000 // unit type, ability and upgrade ids are looked up by name below this
+
+static const char* flagName(FLAGS flag_) {
+	switch (flag_) {
+	case FLAGS::INVALID_FLAG:
+		return "INVALID_FLAG";
+	case FLAGS::IS_STRUCTURE:
+		return "IS_STRUCTURE";
+	case FLAGS::IS_CONSTRUCTING:
+		return "IS_CONSTRUCTING";
+	case FLAGS::IS_TOWNHALL:
+		return "IS_TOWNHALL";
+	case FLAGS::IS_SUPPLY:
+		return "IS_SUPPLY";
+	case FLAGS::IS_WORKER:
+		return "IS_WORKER";
+	case FLAGS::IS_MINERAL_GATHERER:
+		return "IS_MINERAL_GATHERER";
+	case FLAGS::IS_GAS_GATHERER:
+		return "IS_GAS_GATHERER";
+	case FLAGS::IS_DEFENSE:
+		return "IS_DEFENSE";
+	case FLAGS::IS_PROXY:
+		return "IS_PROXY";
+	case FLAGS::IS_SIEGE:
+		return "IS_SIEGE";
+	case FLAGS::IS_ALERT:
+		return "IS_ALERT";
+	case FLAGS::IS_ATTACKER:
+		return "IS_ATTACKER";
+	case FLAGS::IS_ATTACKING:
+		return "IS_ATTACKING";
+	case FLAGS::IS_FLYING:
+		return "IS_FLYING";
+	case FLAGS::IS_INVISIBLE:
+		return "IS_INVISIBLE";
+	case FLAGS::IS_SCOUT:
+		return "IS_SCOUT";
+	case FLAGS::NON_DEFENDER:
+		return "NON_DEFENDER";
+	case FLAGS::BUILDING_GAS:
+		return "BUILDING_GAS";
+	case FLAGS::IS_BUILDING_STRUCTURE:
+		return "IS_BUILDING_STRUCTURE";
+	case FLAGS::IS_IDLE:
+		return "IS_IDLE";
+	case FLAGS::IS_GAS_STRUCTURE:
+		return "IS_GAS_STRUCTURE";
+	case FLAGS::DEF_DIR_DISABLED:
+		return "DEF_DIR_DISABLED";
+	case FLAGS::SHORT_RANGE:
+		return "SHORT_RANGE";
+	case FLAGS::GROUND:
+		return "GROUND";
+	}
+	return "";
+}
+
+static const char* assigneeName(Directive::ASSIGNEE assignee_) {
+	switch (assignee_) {
+	case Directive::DEFAULT_DIRECTIVE:
+		return "DEFAULT_DIRECTIVE";
+	case Directive::UNIT_TYPE:
+		return "UNIT_TYPE";
+	case Directive::UNIT_TYPE_NEAR_LOCATION:
+		return "UNIT_TYPE_NEAR_LOCATION";
+	case Directive::MATCH_FLAGS:
+		return "MATCH_FLAGS";
+	case Directive::MATCH_FLAGS_NEAR_LOCATION:
+		return "MATCH_FLAGS_NEAR_LOCATION";
+	case Directive::UNITS_IN_GROUP:
+		return "UNITS_IN_GROUP";
+	case Directive::UNIT_TYPE_IN_GROUP:
+		return "UNIT_TYPE_IN_GROUP";
+	case Directive::GAME_VARIABLES:
+		return "GAME_VARIABLES";
+	}
+	return "";
+}
+
+static const char* actionName(Directive::ACTION_TYPE action_type_) {
+	switch (action_type_) {
+	case Directive::SIMPLE_ACTION:
+		return "SIMPLE_ACTION";
+	case Directive::EXACT_LOCATION:
+		return "EXACT_LOCATION";
+	case Directive::NEAR_LOCATION:
+		return "NEAR_LOCATION";
+	case Directive::TARGET_UNIT:
+		return "TARGET_UNIT";
+	case Directive::TARGET_UNIT_NEAR_LOCATION:
+		return "TARGET_UNIT_NEAR_LOCATION";
+	case Directive::GET_MINERALS_NEAR_LOCATION:
+		return "GET_MINERALS_NEAR_LOCATION";
+	case Directive::GET_GAS_NEAR_LOCATION:
+		return "GET_GAS_NEAR_LOCATION";
+	case Directive::DISABLE_DEFAULT_DIRECTIVE:
+		return "DISABLE_DEFAULT_DIRECTIVE";
+	case Directive::SET_FLAG:
+		return "SET_FLAG";
+	case Directive::ADD_TO_GROUP:
+		return "ADD_TO_GROUP";
+	case Directive::REMOVE_FROM_GROUP:
+		return "REMOVE_FROM_GROUP";
+	case Directive::SET_TIMER_1:
+		return "SET_TIMER_1";
+	case Directive::SET_TIMER_2:
+		return "SET_TIMER_2";
+	case Directive::SET_TIMER_3:
+		return "SET_TIMER_3";
+	case Directive::RESET_TIMER_1:
+		return "RESET_TIMER_1";
+	case Directive::RESET_TIMER_2:
+		return "RESET_TIMER_2";
+	case Directive::RESET_TIMER_3:
+		return "RESET_TIMER_3";
+	}
+	return "";
+}
+
+static uint32_t recordBytes() {
+	return sizeof(StrategyFile::LocationRecord) + sizeof(StrategyFile::SettingRecord) + sizeof(StrategyFile::ConditionRecord)
+		+ sizeof(StrategyFile::TriggerRecord) + sizeof(StrategyFile::DirectiveRecord) + sizeof(StrategyFile::PreceptRecord);
+}
+
+static void writeSection(std::ofstream& out_, StrategyImageHeader& header_, STRATEGY_SECTION section_, const void* data_, size_t bytes_, uint32_t count_) {
+	// append a section, padded so the next one starts on an 8 byte boundary
+	static const char padding[8] = {};
+	header_.section_offset[section_] = (uint64_t)out_.tellp();
+	header_.section_count[section_] = count_;
+	if (bytes_ > 0) {
+		out_.write((const char*)data_, bytes_);
+	}
+	out_.write(padding, (8 - bytes_ % 8) % 8);
+}
+
+StrategyFile::StrategyFile() {
+	line_number = 0;
+	current_maps = ALL_SCOPES;
+	current_starts = ALL_SCOPES;
+	in_precept = false;
+	load_us = 0;
+	source_hash = 0;
+	image = nullptr;
+	image_size = 0;
+#ifdef _WIN32
+	file_handle = INVALID_HANDLE_VALUE;
+	mapping_handle = nullptr;
+#else
+	fd = -1;
+#endif
+	useLoadedRecords();
+}
+
+StrategyFile::~StrategyFile() {
+	closeImage();
+}
+
+std::string StrategyFile::configuredPath() {
+	// empty when no strategy file is configured
+	const char* env_path = std::getenv(STRATEGY_FILE_ENV);
+	if (env_path && env_path[0] != '\0')
+		return env_path;
+	return STRATEGY_FILE;
+}
+
+std::string StrategyFile::imagePath(std::string path_, int map_index_, int p_id_) {
+	// where the compiled image of a strategy file for one map and start position is kept
+	return path_ + "." + std::to_string(map_index_) + "-" + std::to_string(p_id_) + ".img";
+}
+
+void StrategyFile::buildNameTables() {
+	for (int i = 0; i <= (int)COND::TIMER_3_MAX_STEPS_PAST; ++i) {
+		cond_names[Profiler::condName((COND)i)] = i;
+	}
+	for (int i = 0; i <= (int)FLAGS::GROUND; ++i) {
+		flag_names[flagName((FLAGS)i)] = i;
+	}
+	for (int i = 0; i <= (int)Directive::GAME_VARIABLES; ++i) {
+		assignee_names[assigneeName((Directive::ASSIGNEE)i)] = i;
+	}
+	for (int i = 0; i <= (int)Directive::RESET_TIMER_3; ++i) {
+		action_names[actionName((Directive::ACTION_TYPE)i)] = i;
+	}
+
+	// the api only maps ids to names, so walk the id range once
+	for (int i = 1; i < MAX_TYPE_ID; ++i) {
+		const char* unit_type = sc2::UnitTypeToName((sc2::UNIT_TYPEID)i);
+		if (std::strcmp(unit_type, "UNKNOWN") != 0)
+			unit_type_names.insert(std::make_pair(unit_type, i));
+		const char* ability = sc2::AbilityTypeToName((sc2::ABILITY_ID)i);
+		if (std::strcmp(ability, "UNKNOWN") != 0)
+			ability_names.insert(std::make_pair(ability, i));
+		const char* upgrade = sc2::UpgradeIDToName((sc2::UPGRADE_ID)i);
+		if (std::strcmp(upgrade, "UNKNOWN") != 0)
+			upgrade_names.insert(std::make_pair(upgrade, i));
+	}
+	unit_type_names["INVALID"] = (int)sc2::UNIT_TYPEID::INVALID;
+	ability_names["INVALID"] = (int)sc2::ABILITY_ID::INVALID;
+	upgrade_names["INVALID"] = (int)sc2::UPGRADE_ID::INVALID;
+}
+
+bool StrategyFile::load(std::string path_) {
+	// compile the file into records, false if it could not be read or has an error
+	auto start = std::chrono::steady_clock::now();
+	path = path_;
+	std::ifstream in(path_);
+	if (!in.is_open()) {
+		std::cout << "Could not open strategy file " << path_ << std::endl;
+		return false;
+	}
+	hashFile(path_, &source_hash);
+	buildNameTables();
+
+	std::string line;
+	std::vector<std::string> tokens;
+	line_number = 0;
+	while (std::getline(in, line)) {
+		line_number++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+		tokens.clear();
+		size_t pos = 0;
+		while (pos < line.size()) {
+			while (pos < line.size() && std::isspace((unsigned char)line[pos]))
+				pos++;
+			size_t word_end = pos;
+			while (word_end < line.size() && !std::isspace((unsigned char)line[word_end]))
+				word_end++;
+			if (word_end > pos) {
+				tokens.push_back(line.substr(pos, word_end - pos));
+			}
+			pos = word_end;
+		}
+		if (tokens.empty())
+			continue;
+		if (!parseLine(tokens))
+			return false;
+	}
+	if (in_precept)
+		return error("precept " + names[precepts.back().name] + " has no end");
+	if (!current_group.empty())
+		return error("conditions " + current_group + " has no end");
+
+	// the tables are only needed while loading
+	name_ids.clear();
+	condition_groups.clear();
+	unit_type_names.clear();
+	ability_names.clear();
+	upgrade_names.clear();
+	useLoadedRecords();
+	load_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+bool StrategyFile::writeImage(std::string path_, int map_index_, int p_id_) {
+	// save the settings and precepts for this map and start position, with their triggers, conditions and directives renumbered
+	if (image) {
+		std::cout << "Strategy image " << path_ << " can only be written from a strategy file" << std::endl;
+		return false;
+	}
+
+	std::vector<SettingRecord> out_settings;
+	std::vector<ConditionRecord> out_conditions;
+	std::vector<TriggerRecord> out_triggers;
+	std::vector<DirectiveRecord> out_directives;
+	std::vector<PreceptRecord> out_precepts;
+	for (auto& s : settings) {
+		if (inScope(s.maps, s.starts, map_index_, p_id_)) {
+			out_settings.push_back(s);
+		}
+	}
+	for (auto& p : precepts) {
+		if (!inScope(p.maps, p.starts, map_index_, p_id_))
+			continue;
+		PreceptRecord out_p = p;
+		out_p.first_directive = out_directives.size();
+		out_directives.insert(out_directives.end(), directives.begin() + p.first_directive, directives.begin() + p.first_directive + p.num_directives);
+		out_p.first_trigger = out_triggers.size();
+		for (int i = p.first_trigger; i < p.first_trigger + p.num_triggers; ++i) {
+			TriggerRecord out_t = triggers[i];
+			out_t.first_condition = out_conditions.size();
+			out_conditions.insert(out_conditions.end(), conditions.begin() + triggers[i].first_condition,
+				conditions.begin() + triggers[i].first_condition + triggers[i].num_conditions);
+			out_triggers.push_back(out_t);
+		}
+		out_precepts.push_back(out_p);
+	}
+
+	std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		std::cout << "Could not write strategy image " << path_ << std::endl;
+		return false;
+	}
+	StrategyImageHeader header = {};
+	std::memcpy(header.magic, "SC2STRAT", 8);
+	header.version = STRATEGY_IMAGE_VERSION;
+	header.record_bytes = recordBytes();
+	header.map_index = map_index_;
+	header.p_id = p_id_;
+	header.source_hash = source_hash;
+	out.write((const char*)&header, sizeof(header));
+
+	writeSection(out, header, STRATEGY_NAME_OFFSETS, name_offsets.data(), name_offsets.size() * sizeof(uint32_t), name_offsets.size());
+	writeSection(out, header, STRATEGY_NAMES, name_chars.data(), name_chars.size(), name_chars.size());
+	writeSection(out, header, STRATEGY_LOCATIONS, locations.data(), locations.size() * sizeof(LocationRecord), locations.size());
+	writeSection(out, header, STRATEGY_SETTINGS, out_settings.data(), out_settings.size() * sizeof(SettingRecord), out_settings.size());
+	writeSection(out, header, STRATEGY_CONDITIONS, out_conditions.data(), out_conditions.size() * sizeof(ConditionRecord), out_conditions.size());
+	writeSection(out, header, STRATEGY_TRIGGERS, out_triggers.data(), out_triggers.size() * sizeof(TriggerRecord), out_triggers.size());
+	writeSection(out, header, STRATEGY_DIRECTIVES, out_directives.data(), out_directives.size() * sizeof(DirectiveRecord), out_directives.size());
+	writeSection(out, header, STRATEGY_PRECEPTS, out_precepts.data(), out_precepts.size() * sizeof(PreceptRecord), out_precepts.size());
+
+	// the offsets are only known now
+	out.seekp(0);
+	out.write((const char*)&header, sizeof(header));
+	if (!out.good()) {
+		std::cout << "Could not write strategy image " << path_ << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool StrategyFile::loadImage(std::string path_, std::string source_path_, int map_index_, int p_id_) {
+	// map an image written by writeImage() for this map and start position, false if there is none,
+	// it does not fit this build, or the strategy file at source_path_ changed since it was written
+	auto start = std::chrono::steady_clock::now();
+	closeImage();
+	path = path_;
+#ifdef _WIN32
+	file_handle = CreateFileA(path_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_handle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(file_handle, &file_size);
+	image_size = (size_t)file_size.QuadPart;
+	if (image_size > 0) {
+		mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_handle) {
+			image = (const uint8_t*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+		}
+	}
+#else
+	fd = ::open(path_.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		image_size = (size_t)st.st_size;
+		void* mapped = mmap(nullptr, image_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (mapped != MAP_FAILED) {
+			image = (const uint8_t*)mapped;
+		}
+	}
+#endif
+	if (!image || image_size < sizeof(StrategyImageHeader)) {
+		std::cout << "Strategy image " << path_ << " is empty or unreadable" << std::endl;
+		closeImage();
+		return false;
+	}
+
+	const StrategyImageHeader* header = (const StrategyImageHeader*)image;
+	if (std::memcmp(header->magic, "SC2STRAT", 8) != 0 || header->version != STRATEGY_IMAGE_VERSION || header->record_bytes != recordBytes()) {
+		std::cout << "Strategy image " << path_ << " was written by another version" << std::endl;
+		closeImage();
+		return false;
+	}
+	if (header->map_index != map_index_ || header->p_id != p_id_) {
+		std::cout << "Strategy image " << path_ << " is for map " << header->map_index << " start " << header->p_id << std::endl;
+		closeImage();
+		return false;
+	}
+	uint64_t current_hash = 0;
+	if (!hashFile(source_path_, &current_hash) || current_hash != header->source_hash) {
+		std::cout << "Strategy image " << path_ << " is out of date, " << source_path_ << " changed since it was compiled" << std::endl;
+		closeImage();
+		return false;
+	}
+	static const size_t element_bytes[STRATEGY_NUM_SECTIONS] = { sizeof(uint32_t), 1, sizeof(LocationRecord), sizeof(SettingRecord),
+		sizeof(ConditionRecord), sizeof(TriggerRecord), sizeof(DirectiveRecord), sizeof(PreceptRecord) };
+	for (int i = 0; i < STRATEGY_NUM_SECTIONS; ++i) {
+		uint64_t offset = header->section_offset[i];
+		if (offset % 8 != 0 || offset > image_size || (uint64_t)header->section_count[i] * element_bytes[i] > image_size - offset) {
+			std::cout << "Strategy image " << path_ << " is damaged" << std::endl;
+			closeImage();
+			return false;
+		}
+	}
+
+	// every index and enum is checked once here, so apply() can trust them
+	if (!checkImageRecords(header)) {
+		std::cout << "Strategy image " << path_ << " is damaged" << std::endl;
+		closeImage();
+		return false;
+	}
+
+	name_offset_data = (const uint32_t*)(image + header->section_offset[STRATEGY_NAME_OFFSETS]);
+	name_data = (const char*)(image + header->section_offset[STRATEGY_NAMES]);
+	location_data = (const LocationRecord*)(image + header->section_offset[STRATEGY_LOCATIONS]);
+	setting_data = (const SettingRecord*)(image + header->section_offset[STRATEGY_SETTINGS]);
+	condition_data = (const ConditionRecord*)(image + header->section_offset[STRATEGY_CONDITIONS]);
+	trigger_data = (const TriggerRecord*)(image + header->section_offset[STRATEGY_TRIGGERS]);
+	directive_data = (const DirectiveRecord*)(image + header->section_offset[STRATEGY_DIRECTIVES]);
+	precept_data = (const PreceptRecord*)(image + header->section_offset[STRATEGY_PRECEPTS]);
+	num_settings = header->section_count[STRATEGY_SETTINGS];
+	num_conditions = header->section_count[STRATEGY_CONDITIONS];
+	num_precepts = header->section_count[STRATEGY_PRECEPTS];
+	load_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+bool StrategyFile::checkImageRecords(const StrategyImageHeader* header_) {
+	// whether every name, location and record an image refers to is inside it, and every enum in range
+	const uint32_t* count = header_->section_count;
+	const uint32_t* name_offsets_ = (const uint32_t*)(image + header_->section_offset[STRATEGY_NAME_OFFSETS]);
+	const char* names_ = (const char*)(image + header_->section_offset[STRATEGY_NAMES]);
+	const LocationRecord* locations_ = (const LocationRecord*)(image + header_->section_offset[STRATEGY_LOCATIONS]);
+	const SettingRecord* settings_ = (const SettingRecord*)(image + header_->section_offset[STRATEGY_SETTINGS]);
+	const ConditionRecord* conditions_ = (const ConditionRecord*)(image + header_->section_offset[STRATEGY_CONDITIONS]);
+	const TriggerRecord* triggers_ = (const TriggerRecord*)(image + header_->section_offset[STRATEGY_TRIGGERS]);
+	const DirectiveRecord* directives_ = (const DirectiveRecord*)(image + header_->section_offset[STRATEGY_DIRECTIVES]);
+	const PreceptRecord* precepts_ = (const PreceptRecord*)(image + header_->section_offset[STRATEGY_PRECEPTS]);
+
+	auto in_range = [](int value_, int first_, int last_) { return value_ >= first_ && value_ <= last_; };
+	auto is_name = [count](int name_) { return name_ >= 0 && (uint32_t)name_ < count[STRATEGY_NAME_OFFSETS]; };
+	auto is_location = [count](int location_) { return location_ == -1 || (location_ >= 0 && (uint32_t)location_ < count[STRATEGY_LOCATIONS]); };
+	auto is_bool = [](const bool& value_) { return *(const uint8_t*)&value_ <= 1; };
+	auto stored_int = [](const void* value_) { int v; std::memcpy(&v, value_, sizeof(v)); return v; };	// an enum read before it is known to be valid
+	auto is_range = [](int first_, int num_, uint32_t size_) { return first_ >= 0 && num_ >= 0 && (int64_t)first_ + num_ <= (int64_t)size_; };
+	FlagMask all_flags = (flagBit(FLAGS::GROUND) << 1) - 1;
+
+	// every name starts inside NAMES, and the last one is terminated, so none runs past it
+	if (count[STRATEGY_NAME_OFFSETS] > 0 && (count[STRATEGY_NAMES] == 0 || names_[count[STRATEGY_NAMES] - 1] != '\0'))
+		return false;
+	for (uint32_t i = 0; i < count[STRATEGY_NAME_OFFSETS]; ++i) {
+		if (name_offsets_[i] >= count[STRATEGY_NAMES])
+			return false;
+	}
+	for (uint32_t i = 0; i < count[STRATEGY_LOCATIONS]; ++i) {
+		const LocationRecord& l = locations_[i];
+		if (!in_range(stored_int(&l.kind), POINT, CENTER_PATHABLE))
+			return false;
+		if (l.kind == STORED && !is_name(l.name))
+			return false;
+		if (l.kind >= TOWNHALL && l.kind <= DEFEND_POINT && l.base < 0)
+			return false;
+	}
+	for (uint32_t i = 0; i < count[STRATEGY_SETTINGS]; ++i) {
+		const SettingRecord& s = settings_[i];
+		if (!in_range(stored_int(&s.kind), SettingRecord::LOCATION, SettingRecord::UNIT_TYPE) || !is_name(s.name))
+			return false;
+		if (s.kind == SettingRecord::LOCATION && (s.value < 0 || !is_location(s.value)))
+			return false;
+	}
+	for (uint32_t i = 0; i < count[STRATEGY_CONDITIONS]; ++i) {
+		const ConditionRecord& c = conditions_[i];
+		if (!in_range((int)c.type, 0, (int)COND::TIMER_3_MAX_STEPS_PAST) || !is_location(c.location) || (c.flags & ~all_flags) != 0 || !is_bool(c.is_true))
+			return false;
+	}
+	for (uint32_t i = 0; i < count[STRATEGY_TRIGGERS]; ++i) {
+		if (!is_range(triggers_[i].first_condition, triggers_[i].num_conditions, count[STRATEGY_CONDITIONS]) || !is_bool(triggers_[i].debug))
+			return false;
+	}
+	for (uint32_t i = 0; i < count[STRATEGY_DIRECTIVES]; ++i) {
+		const DirectiveRecord& d = directives_[i];
+		if (!in_range(d.assignee, 0, Directive::GAME_VARIABLES) || !in_range(d.action_type, 0, Directive::RESET_TIMER_3)
+			|| !in_range(d.set_flag, 0, (int)FLAGS::GROUND) || (d.flags & ~all_flags) != 0 || (d.exclude_flags & ~all_flags) != 0)
+			return false;
+		if (!is_location(d.assignee_location) || !is_location(d.target_location))
+			return false;
+		if ((d.group_name != -1 && !is_name(d.group_name)) || (d.target_provider != -1 && !is_name(d.target_provider))
+			|| (d.store_id != -1 && !is_name(d.store_id)))
+			return false;
+		if (!is_bool(d.allow_multiple) || !is_bool(d.continuous) || !is_bool(d.override_other) || !is_bool(d.debug))
+			return false;
+	}
+	for (uint32_t i = 0; i < count[STRATEGY_PRECEPTS]; ++i) {
+		const PreceptRecord& p = precepts_[i];
+		if (!is_name(p.name) || !is_bool(p.debug) || !is_range(p.first_trigger, p.num_triggers, count[STRATEGY_TRIGGERS])
+			|| !is_range(p.first_directive, p.num_directives, count[STRATEGY_DIRECTIVES]))
+			return false;
+	}
+	return true;
+}
+
+void StrategyFile::closeImage() {
+	// apply() goes back to the records loaded from text, if any
+#ifdef _WIN32
+	if (image) {
+		UnmapViewOfFile(image);
+	}
+	if (mapping_handle) {
+		CloseHandle(mapping_handle);
+	}
+	if (file_handle != INVALID_HANDLE_VALUE) {
+		CloseHandle(file_handle);
+	}
+	mapping_handle = nullptr;
+	file_handle = INVALID_HANDLE_VALUE;
+#else
+	if (image) {
+		munmap((void*)image, image_size);
+	}
+	if (fd >= 0) {
+		::close(fd);
+	}
+	fd = -1;
+#endif
+	bool was_mapped = image != nullptr;
+	image = nullptr;
+	image_size = 0;
+	if (was_mapped) {
+		useLoadedRecords();
+	}
+}
+
+bool StrategyFile::parseLine(const std::vector<std::string>& tokens_) {
+	const std::string& keyword = tokens_[0];
+
+	if (!current_group.empty()) {
+		// only conditions until the group ends
+		if (keyword == "end") {
+			current_group.clear();
+			return true;
+		}
+		if (!cond_names.count(keyword))
+			return error("expected a condition or end in conditions " + current_group);
+		if (!parseCondition(tokens_))
+			return false;
+		condition_groups[current_group].second++;
+		return true;
+	}
+
+	if (keyword == "conditions") {
+		if (in_precept)
+			return error("conditions inside a precept");
+		if (tokens_.size() != 2)
+			return error("expected conditions <name>");
+		if (condition_groups.count(tokens_[1]))
+			return error("conditions " + tokens_[1] + " defined twice");
+		current_group = tokens_[1];
+		condition_groups[current_group] = std::make_pair((int)conditions.size(), 0);
+		return true;
+	}
+
+	if (keyword == "map" || keyword == "start") {
+		if (in_precept)
+			return error(keyword + " inside a precept");
+		if (tokens_.size() != 2)
+			return error("expected " + keyword + " <index[,index...]|any>");
+		return parseScope(tokens_[1], keyword == "map" ? &current_maps : &current_starts);
+	}
+
+	if (keyword == "location" || keyword == "int" || keyword == "unit_type") {
+		if (in_precept)
+			return error(keyword + " inside a precept");
+		if (tokens_.size() != 3)
+			return error("expected " + keyword + " <NAME> <value>");
+		SettingRecord setting;
+		setting.maps = current_maps;
+		setting.starts = current_starts;
+		setting.name = internName(tokens_[1]);
+		if (keyword == "location") {
+			setting.kind = SettingRecord::LOCATION;
+			if (!parseLocation(tokens_[2], &setting.value))
+				return false;
+		}
+		else if (keyword == "int") {
+			setting.kind = SettingRecord::INT;
+			if (!parseInt(tokens_[2], &setting.value))
+				return false;
+		}
+		else {
+			setting.kind = SettingRecord::UNIT_TYPE;
+			if (!lookup(unit_type_names, tokens_[2], &setting.value))
+				return false;
+		}
+		settings.push_back(setting);
+		return true;
+	}
+
+	if (keyword == "precept") {
+		if (in_precept)
+			return error("precept " + names[precepts.back().name] + " has no end");
+		if (tokens_.size() < 2 || tokens_.size() > 3 || (tokens_.size() == 3 && tokens_[2] != "debug"))
+			return error("expected precept <name> [debug]");
+		PreceptRecord precept;
+		precept.name = internName(tokens_[1]);
+		precept.maps = current_maps;
+		precept.starts = current_starts;
+		precept.debug = tokens_.size() == 3;
+		precept.first_trigger = triggers.size();
+		precept.num_triggers = 0;
+		precept.first_directive = directives.size();
+		precept.num_directives = 0;
+		precepts.push_back(precept);
+		in_precept = true;
+		return true;
+	}
+
+	if (!in_precept)
+		return error(keyword + " outside a precept");
+
+	if (keyword == "end") {
+		if (precepts.back().num_directives == 0)
+			return error("precept " + names[precepts.back().name] + " has no directive");
+		in_precept = false;
+		return true;
+	}
+
+	if (keyword == "trigger") {
+		if (tokens_.size() > 2 || (tokens_.size() == 2 && tokens_[1] != "debug"))
+			return error("expected trigger [debug]");
+		TriggerRecord trigger;
+		trigger.first_condition = conditions.size();
+		trigger.num_conditions = 0;
+		trigger.debug = tokens_.size() == 2;
+		triggers.push_back(trigger);
+		precepts.back().num_triggers++;
+		return true;
+	}
+
+	if (keyword == "directive") {
+		if (!parseDirective(tokens_))
+			return false;
+		precepts.back().num_directives++;
+		return true;
+	}
+
+	if (keyword == "use") {
+		// copy a condition group into the trigger
+		if (precepts.back().num_triggers == 0)
+			return error("use outside a trigger");
+		if (tokens_.size() != 2 || !condition_groups.count(tokens_[1]))
+			return error("expected use <conditions name>");
+		std::pair<int, int> group = condition_groups[tokens_[1]];
+		for (int i = group.first; i < group.first + group.second; ++i) {
+			ConditionRecord cond = conditions[i];
+			conditions.push_back(cond);
+		}
+		triggers.back().num_conditions += group.second;
+		return true;
+	}
+
+	if (cond_names.count(keyword)) {
+		if (precepts.back().num_triggers == 0)
+			return error("condition " + keyword + " outside a trigger");
+		if (!parseCondition(tokens_))
+			return false;
+		triggers.back().num_conditions++;
+		return true;
+	}
+
+	return error("unknown keyword " + keyword);
+}
+
+bool StrategyFile::parseScope(const std::string& token_, int* scope_) {
+	// a comma separated list of map indexes or start positions, or any
+	if (token_ == "any") {
+		*scope_ = ALL_SCOPES;
+		return true;
+	}
+	*scope_ = 0;
+	std::istringstream items(token_);
+	std::string item;
+	while (std::getline(items, item, ',')) {
+		int index;
+		if (!parseInt(item, &index))
+			return false;
+		if (index < 0 || index >= 31)
+			return error("scope index out of range " + item);
+		*scope_ |= 1 << index;
+	}
+	return true;
+}
+
+bool StrategyFile::parseCondition(const std::vector<std::string>& tokens_) {
+	// <COND> [value] [not] [unit=] [ability=] [upgrade=] [flags=] [at=] [radius=]
+	ConditionRecord cond;
+	cond.type = (COND)cond_names[tokens_[0]];
+	cond.value = 0;
+	cond.is_true = true;
+	cond.unit_type = (int)sc2::UNIT_TYPEID::INVALID;
+	cond.ability = (int)sc2::ABILITY_ID::INVALID;
+	cond.upgrade = (int)sc2::UPGRADE_ID::INVALID;
+	cond.flags = 0;
+	cond.location = -1;
+	cond.radius = DEFAULT_RADIUS;
+
+	for (size_t i = 1; i < tokens_.size(); ++i) {
+		const std::string& token = tokens_[i];
+		size_t eq = token.find('=');
+		if (eq == std::string::npos) {
+			if (token == "not") {
+				cond.is_true = false;
+				continue;
+			}
+			if (i != 1)
+				return error("unexpected " + token + " in condition " + tokens_[0]);
+			if (!parseDouble(token, &cond.value))
+				return false;
+			continue;
+		}
+		std::string key = token.substr(0, eq);
+		std::string value = token.substr(eq + 1);
+		bool ok;
+		if (key == "unit")
+			ok = lookup(unit_type_names, value, &cond.unit_type);
+		else if (key == "ability")
+			ok = lookup(ability_names, value, &cond.ability);
+		else if (key == "upgrade")
+			ok = lookup(upgrade_names, value, &cond.upgrade);
+		else if (key == "flags")
+			ok = parseFlags(value, &cond.flags);
+		else if (key == "at")
+			ok = parseLocation(value, &cond.location);
+		else if (key == "radius")
+			ok = parseFloat(value, &cond.radius);
+		else
+			ok = error("unknown condition key " + key);
+		if (!ok)
+			return false;
+	}
+	conditions.push_back(cond);
+	return true;
+}
+
+bool StrategyFile::parseDirective(const std::vector<std::string>& tokens_) {
+	// directive <ASSIGNEE> <ACTION_TYPE> [key=value ...] [allow_multiple] [continuous] [override_other] [debug]
+	if (tokens_.size() < 3)
+		return error("expected directive <ASSIGNEE> <ACTION_TYPE> ...");
+
+	DirectiveRecord dir;
+	if (!lookup(assignee_names, tokens_[1], &dir.assignee) || !lookup(action_names, tokens_[2], &dir.action_type))
+		return false;
+	dir.unit_type = (int)sc2::UNIT_TYPEID::INVALID;
+	dir.ability = (int)sc2::ABILITY_ID::INVALID;
+	dir.assignee_location = -1;
+	dir.target_location = -1;
+	dir.assignee_proximity = INVALID_RADIUS;
+	dir.target_proximity = INVALID_RADIUS;
+	dir.flags = 0;
+	dir.exclude_flags = 0;
+	dir.set_flag = (int)FLAGS::INVALID_FLAG;
+	dir.steps = 0;
+	dir.group_name = -1;
+	dir.target_provider = -1;
+	dir.store_id = -1;
+	dir.ignore_distance = -1.0F;
+	dir.allow_multiple = false;
+	dir.continuous = false;
+	dir.override_other = false;
+	dir.debug = false;
+
+	bool assignee_radius_set = false;
+	bool target_radius_set = false;
+	for (size_t i = 3; i < tokens_.size(); ++i) {
+		const std::string& token = tokens_[i];
+		size_t eq = token.find('=');
+		if (eq == std::string::npos) {
+			if (token == "allow_multiple")
+				dir.allow_multiple = true;
+			else if (token == "continuous")
+				dir.continuous = true;
+			else if (token == "override_other")
+				dir.override_other = true;
+			else if (token == "debug")
+				dir.debug = true;
+			else
+				return error("unknown directive option " + token);
+			continue;
+		}
+		std::string key = token.substr(0, eq);
+		std::string value = token.substr(eq + 1);
+		bool ok;
+		if (key == "unit")
+			ok = lookup(unit_type_names, value, &dir.unit_type);
+		else if (key == "ability")
+			ok = lookup(ability_names, value, &dir.ability);
+		else if (key == "at")
+			ok = parseLocation(value, &dir.target_location);
+		else if (key == "radius")
+			ok = target_radius_set = parseFloat(value, &dir.target_proximity);
+		else if (key == "assignee_at")
+			ok = parseLocation(value, &dir.assignee_location);
+		else if (key == "assignee_radius")
+			ok = assignee_radius_set = parseFloat(value, &dir.assignee_proximity);
+		else if (key == "flags")
+			ok = parseFlags(value, &dir.flags);
+		else if (key == "exclude")
+			ok = parseFlags(value, &dir.exclude_flags);
+		else if (key == "set_flag")
+			ok = lookup(flag_names, value, &dir.set_flag);
+		else if (key == "steps")
+			ok = parseInt(value, &dir.steps);
+		else if (key == "group") {
+			dir.group_name = internName(value);
+			ok = true;
+		}
+		else if (key == "follow") {
+			dir.target_provider = internName(value);
+			ok = true;
+		}
+		else if (key == "store_id") {
+			dir.store_id = internName(value);
+			ok = true;
+		}
+		else if (key == "ignore_distance")
+			ok = parseFloat(value, &dir.ignore_distance);
+		else
+			ok = error("unknown directive key " + key);
+		if (!ok)
+			return false;
+	}
+
+	// a location given without a radius uses the default radius, as the constructors do
+	if (!assignee_radius_set && dir.assignee_location != -1)
+		dir.assignee_proximity = DEFAULT_RADIUS;
+	if (!target_radius_set && dir.target_location != -1)
+		dir.target_proximity = DEFAULT_RADIUS;
+	directives.push_back(dir);
+	return true;
+}
+
+bool StrategyFile::parseLocation(const std::string& token_, int* location_) {
+	// x,y | baseN.townhall | baseN.build_areaK | baseN.rally | baseN.defendK | proxy | best_enemy | center_pathable | NAME
+	LocationRecord loc;
+	loc.kind = POINT;
+	loc.base = 0;
+	loc.index = 0;
+	loc.x = 0;
+	loc.y = 0;
+	loc.name = -1;
+
+	size_t comma = token_.find(',');
+	size_t dot = token_.find('.');
+	if (comma != std::string::npos) {
+		if (!parseFloat(token_.substr(0, comma), &loc.x) || !parseFloat(token_.substr(comma + 1), &loc.y))
+			return false;
+	}
+	else if (token_.compare(0, 4, "base") == 0 && dot != std::string::npos) {
+		if (!parseInt(token_.substr(4, dot - 4), &loc.base))
+			return false;
+		std::string part = token_.substr(dot + 1);
+		if (part == "townhall") {
+			loc.kind = TOWNHALL;
+		}
+		else if (part == "rally") {
+			loc.kind = RALLY_POINT;
+		}
+		else if (part.compare(0, 10, "build_area") == 0) {
+			loc.kind = BUILD_AREA;
+			if (!parseInt(part.substr(10), &loc.index))
+				return false;
+		}
+		else if (part.compare(0, 6, "defend") == 0) {
+			loc.kind = DEFEND_POINT;
+			if (!parseInt(part.substr(6), &loc.index))
+				return false;
+		}
+		else {
+			return error("unknown base location " + token_);
+		}
+	}
+	else if (token_ == "proxy") {
+		loc.kind = PROXY;
+	}
+	else if (token_ == "best_enemy") {
+		loc.kind = BEST_ENEMY;
+	}
+	else if (token_ == "center_pathable") {
+		loc.kind = CENTER_PATHABLE;
+	}
+	else {
+		loc.kind = STORED;
+		loc.name = internName(token_);
+	}
+	*location_ = locations.size();
+	locations.push_back(loc);
+	return true;
+}
+
+bool StrategyFile::parseFlags(const std::string& token_, FlagMask* mask_) {
+	// a comma separated list of flag names
+	std::istringstream items(token_);
+	std::string item;
+	while (std::getline(items, item, ',')) {
+		int flag;
+		if (!lookup(flag_names, item, &flag))
+			return false;
+		*mask_ |= flagBit((FLAGS)flag);
+	}
+	return true;
+}
+
+bool StrategyFile::parseFloat(const std::string& token_, float* value_) {
+	char* end = nullptr;
+	float value = std::strtof(token_.c_str(), &end);
+	if (token_.empty() || *end != '\0')
+		return error("expected a number, got " + token_);
+	*value_ = value;
+	return true;
+}
+
+bool StrategyFile::parseDouble(const std::string& token_, double* value_) {
+	char* end = nullptr;
+	double value = std::strtod(token_.c_str(), &end);
+	if (token_.empty() || *end != '\0')
+		return error("expected a number, got " + token_);
+	*value_ = value;
+	return true;
+}
+
+bool StrategyFile::parseInt(const std::string& token_, int* value_) {
+	char* end = nullptr;
+	long value = std::strtol(token_.c_str(), &end, 10);
+	if (token_.empty() || *end != '\0')
+		return error("expected an integer, got " + token_);
+	*value_ = (int)value;
+	return true;
+}
+
+bool StrategyFile::lookup(const std::map<std::string, int>& table_, const std::string& token_, int* value_) {
+	// names, or raw ids for types the api does not name
+	auto it = table_.find(token_);
+	if (it != table_.end()) {
+		*value_ = it->second;
+		return true;
+	}
+	if (!token_.empty() && std::isdigit((unsigned char)token_[0]))
+		return parseInt(token_, value_);
+	return error("unknown name " + token_);
+}
+
+bool StrategyFile::error(std::string message_) {
+	std::cout << path << ":" << line_number << ": " << message_ << std::endl;
+	return false;
+}
+
+bool StrategyFile::hashFile(std::string path_, uint64_t* hash_) {
+	// 64 bit FNV-1a of the whole file, false if it cannot be read
+	std::ifstream in(path_, std::ios::binary);
+	if (!in.is_open())
+		return false;
+	uint64_t hash = 14695981039346656037ULL;
+	char chunk[4096];
+	while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0) {
+		for (std::streamsize i = 0; i < in.gcount(); ++i) {
+			hash = (hash ^ (uint8_t)chunk[i]) * 1099511628211ULL;
+		}
+	}
+	*hash_ = hash;
+	return true;
+}
+
+void StrategyFile::useLoadedRecords() {
+	// point apply() at the vectors, packing the names the same way an image does
+	name_offsets.clear();
+	name_chars.clear();
+	for (auto& n : names) {
+		name_offsets.push_back(name_chars.size());
+		name_chars.insert(name_chars.end(), n.begin(), n.end());
+		name_chars.push_back('\0');
+	}
+	name_offset_data = name_offsets.data();
+	name_data = name_chars.data();
+	location_data = locations.data();
+	setting_data = settings.data();
+	condition_data = conditions.data();
+	trigger_data = triggers.data();
+	directive_data = directives.data();
+	precept_data = precepts.data();
+	num_settings = settings.size();
+	num_conditions = conditions.size();
+	num_precepts = precepts.size();
+}
+
+const char* StrategyFile::name(int name_) {
+	return name_data + name_offset_data[name_];
+}
+
+int StrategyFile::internName(const std::string& name_) {
+	auto it = name_ids.find(name_);
+	if (it != name_ids.end())
+		return it->second;
+	int id = names.size();
+	names.push_back(name_);
+	name_ids[name_] = id;
+	return id;
+}
+
+bool StrategyFile::inScope(int maps_, int starts_, int map_index_, int p_id_) {
+	return (maps_ & (1 << map_index_)) != 0 && (starts_ & (1 << p_id_)) != 0;
+}
+
+sc2::Point2D StrategyFile::resolveLocation(BasicSc2Bot* bot_, int location_) {
+	if (location_ == -1)
+		return INVALID_POINT;
+	const LocationRecord& loc = location_data[location_];
+	if (loc.kind >= TOWNHALL && loc.kind <= DEFEND_POINT && (loc.base < 0 || loc.base >= (int)bot_->locH->bases.size())) {
+		std::cout << "Strategy file refers to base " << loc.base << ", this map has " << bot_->locH->bases.size() << std::endl;
+		return INVALID_POINT;
+	}
+	switch (loc.kind) {
+	case POINT:
+		return sc2::Point2D(loc.x, loc.y);
+	case STORED:
+		return bot_->getStoredLocation(name(loc.name));
+	case TOWNHALL:
+		return bot_->locH->bases[loc.base].getTownhall();
+	case BUILD_AREA:
+		return bot_->locH->bases[loc.base].getBuildArea(loc.index);
+	case RALLY_POINT:
+		return bot_->locH->bases[loc.base].getRallyPoint();
+	case DEFEND_POINT:
+		return bot_->locH->bases[loc.base].getDefendPoint(loc.index);
+	case PROXY:
+		return bot_->locH->getProxyLocation();
+	case BEST_ENEMY:
+		return bot_->locH->getBestEnemyLocation();
+	case CENTER_PATHABLE:
+		return bot_->locH->getCenterPathableLocation();
+	}
+	return INVALID_POINT;
+}
+
+int StrategyFile::apply(BasicSc2Bot* bot_, Strategy* strategy_, int map_index_, int p_id_) {
+	// add the settings and precepts for this map and start position, in file order, returning the number of precepts added
+
+	for (int i = 0; i < num_settings; ++i) {
+		const SettingRecord& s = setting_data[i];
+		if (!inScope(s.maps, s.starts, map_index_, p_id_))
+			continue;
+		if (s.kind == SettingRecord::LOCATION)
+			bot_->storeLocation(name(s.name), resolveLocation(bot_, s.value));
+		else if (s.kind == SettingRecord::INT)
+			bot_->storeInt(name(s.name), s.value);
+		else
+			bot_->storeUnitType(name(s.name), (sc2::UNIT_TYPEID)s.value);
+	}
+
+	int added = 0;
+	for (int n = 0; n < num_precepts; ++n) {
+		const PreceptRecord& p = precept_data[n];
+		if (!inScope(p.maps, p.starts, map_index_, p_id_))
+			continue;
+		Precept precept(bot_, name(p.name));
+		if (p.debug) {
+			precept.setDebug();
+		}
+
+		for (int i = p.first_directive; i < p.first_directive + p.num_directives; ++i) {
+			const DirectiveRecord& r = directive_data[i];
+			Directive d((Directive::ASSIGNEE)r.assignee, (Directive::ACTION_TYPE)r.action_type, (sc2::UNIT_TYPEID)r.unit_type, (sc2::ABILITY_ID)r.ability,
+				resolveLocation(bot_, r.assignee_location), resolveLocation(bot_, r.target_location), r.assignee_proximity, r.target_proximity,
+				flagSet(r.flags), nullptr, r.group_name == -1 ? "" : name(r.group_name), (FLAGS)r.set_flag, r.steps);
+			for (auto f : flagSet(r.exclude_flags)) {
+				d.excludeFlag(f);
+			}
+			if (r.target_provider != -1 && bot_->locH->getLocationProviderID(name(r.target_provider)) == -1) {
+				std::cout << "Strategy file refers to location provider " << name(r.target_provider) << ", which does not exist" << std::endl;
+			}
+			else if (r.target_provider != -1) {
+				d.setTargetLocationFunction(strategy_, bot_, bot_->locH->locationProvider(name(r.target_provider)));
+			}
+			if (r.ignore_distance >= 0) {
+				d.setIgnoreDistance(r.ignore_distance);
+			}
+			if (r.allow_multiple) {
+				d.allowMultiple();
+			}
+			if (r.continuous) {
+				d.setContinuous();
+			}
+			if (r.override_other) {
+				d.setOverrideOther();
+			}
+			if (r.debug) {
+				d.setDebug(true);
+			}
+			if (r.store_id != -1) {
+				bot_->storeInt(name(r.store_id), d.getID());
+			}
+			precept.addDirective(d);
+		}
+
+		for (int i = p.first_trigger; i < p.first_trigger + p.num_triggers; ++i) {
+			const TriggerRecord& r = trigger_data[i];
+			Trigger t(bot_);
+			if (r.debug) {
+				t.setDebug();
+			}
+			for (int j = r.first_condition; j < r.first_condition + r.num_conditions; ++j) {
+				const ConditionRecord& c = condition_data[j];
+				t.addCondition(Trigger::TriggerCondition(bot_, c.type, c.value, (sc2::UNIT_TYPEID)c.unit_type, (sc2::ABILITY_ID)c.ability,
+					(sc2::UPGRADE_ID)c.upgrade, flagSet(c.flags), resolveLocation(bot_, c.location), c.radius, c.is_true));
+			}
+			precept.addTrigger(t);
+		}
+
+		bot_->addStrat(precept);
+		added++;
+	}
+	return added;
+}
+
+long long StrategyFile::getLoadUs() {
+	return load_us;
+}
+
+int StrategyFile::getNumPrecepts() {
+	return num_precepts;
+}
+
+int StrategyFile::getNumConditions() {
+	return num_conditions;
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "sc2api/sc2_api.h"
+
+# define STRATEGY_FILE "" // strategy file loaded instead of the built-in strategy, empty uses the built-in strategy
+# define STRATEGY_FILE_ENV "BOT_STRATEGY" // environment variable naming a strategy file, takes precedence over STRATEGY_FILE
+# define ALL_SCOPES -1 // map or start position scope matching any, scopes are a bit per map index or start position
+# define STRATEGY_IMAGE_VERSION 2 // bumped whenever the record layout of strategy images changes
+
+class BasicSc2Bot;
+class Strategy;
+enum class COND;
+enum class FLAGS;
+typedef uint32_t FlagMask;	// one bit per FLAGS value, see flagBit() in Mob.h
+
+// Strategy image layout, written by writeImage() for one map and start position:
+//
+//   StrategyImageHeader
+//   section 0 ... section STRATEGY_NUM_SECTIONS-1		each section starts on an 8 byte boundary
+//
+// Sections are the record arrays of StrategyFile exactly as they are in memory, so a mapped
+// image is used in place. Records only refer to each other and to names by index, and names
+// are offsets into NAMES, so an image does not depend on where it is mapped. Images are only
+// read by the build that wrote them, record_bytes catches a change in the record layout, and
+// source_hash an image left over from before the strategy file was edited
+
+enum STRATEGY_SECTION {
+	STRATEGY_NAME_OFFSETS,	// uint32_t offset into NAMES of each name
+	STRATEGY_NAMES,			// nul terminated names
+	STRATEGY_LOCATIONS,
+	STRATEGY_SETTINGS,
+	STRATEGY_CONDITIONS,
+	STRATEGY_TRIGGERS,
+	STRATEGY_DIRECTIVES,
+	STRATEGY_PRECEPTS,
+	STRATEGY_NUM_SECTIONS
+};
+
+struct StrategyImageHeader {
+	char magic[8];			// "SC2STRAT"
+	uint32_t version;
+	uint32_t record_bytes;	// sum of the record sizes of the build that wrote the image
+	int32_t map_index;
+	int32_t p_id;
+	uint64_t source_hash;	// of the text of the strategy file the image was compiled from
+	uint64_t section_offset[STRATEGY_NUM_SECTIONS];
+	uint32_t section_count[STRATEGY_NUM_SECTIONS];	// elements, bytes for NAMES
+};
+
+class StrategyFile {
+// Declarative strategy, read from a text file at start-up instead of being compiled in.
+// load() compiles the file into flat arrays of records, in file order, and apply() turns the
+// records matching the current map and start position into the same precepts, triggers and
+// directives Strategy::loadStrategies() builds by hand, so they are evaluated exactly as fast.
+// writeImage() saves the records for one map and start position, and loadImage() maps such an
+// image read-only and applies it without parsing, so processes on the same host share its pages.
+// The format is described at the top of strategies/default.strat
+public:
+	enum LOCATION_KIND {
+		// how a location is worked out when the strategy is applied
+		POINT,
+		STORED,
+		TOWNHALL,
+		BUILD_AREA,
+		RALLY_POINT,
+		DEFEND_POINT,
+		PROXY,
+		BEST_ENEMY,
+		CENTER_PATHABLE,
+	};
+
+	struct LocationRecord {
+		LOCATION_KIND kind;
+		int base;		// index into LocationHandler::bases for the base kinds
+		int index;		// build area or defend point of the base
+		float x;
+		float y;
+		int name;		// index into names, for STORED
+	};
+
+	struct SettingRecord {
+		enum KIND { LOCATION, INT, UNIT_TYPE };
+		KIND kind;
+		int maps;
+		int starts;
+		int name;
+		int value;		// the int, the unit type, or the location record for LOCATION
+	};
+
+	struct ConditionRecord {
+		COND type;
+		double value;
+		bool is_true;
+		int unit_type;
+		int ability;
+		int upgrade;
+		FlagMask flags;
+		int location;	// location record, -1 for none
+		float radius;
+	};
+
+	struct TriggerRecord {
+		int first_condition;
+		int num_conditions;
+		bool debug;
+	};
+
+	struct DirectiveRecord {
+		int assignee;
+		int action_type;
+		int unit_type;
+		int ability;
+		int assignee_location;	// location record, -1 for none
+		int target_location;	// location record, -1 for none
+		float assignee_proximity;
+		float target_proximity;
+		FlagMask flags;
+		FlagMask exclude_flags;
+		int set_flag;
+		int steps;
+		int group_name;			// index into names, -1 for none
+		int target_provider;	// index into names of a LocationHandler location provider, -1 for none
+		int store_id;			// index into names of a stored int set to the directive's ID, -1 for none
+		float ignore_distance;
+		bool allow_multiple;
+		bool continuous;
+		bool override_other;
+		bool debug;
+	};
+
+	struct PreceptRecord {
+		int name;
+		int maps;
+		int starts;
+		bool debug;
+		int first_trigger;
+		int num_triggers;
+		int first_directive;
+		int num_directives;
+	};
+
+	StrategyFile();
+	~StrategyFile();
+	static std::string configuredPath();
+	static std::string imagePath(std::string path_, int map_index_, int p_id_);
+	bool load(std::string path_);
+	bool writeImage(std::string path_, int map_index_, int p_id_);
+	bool loadImage(std::string path_, std::string source_path_, int map_index_, int p_id_);
+	void closeImage();
+	int apply(BasicSc2Bot* bot_, Strategy* strategy_, int map_index_, int p_id_);
+	long long getLoadUs();
+	int getNumPrecepts();
+	int getNumConditions();
+
+private:
+	StrategyFile(const StrategyFile&);
+	StrategyFile& operator=(const StrategyFile&);
+	bool parseLine(const std::vector<std::string>& tokens_);
+	bool parseScope(const std::string& token_, int* scope_);
+	bool parseCondition(const std::vector<std::string>& tokens_);
+	bool parseDirective(const std::vector<std::string>& tokens_);
+	bool parseLocation(const std::string& token_, int* location_);
+	bool parseFlags(const std::string& token_, FlagMask* mask_);
+	bool parseFloat(const std::string& token_, float* value_);
+	bool parseDouble(const std::string& token_, double* value_);
+	bool parseInt(const std::string& token_, int* value_);
+	bool lookup(const std::map<std::string, int>& table_, const std::string& token_, int* value_);
+	bool error(std::string message_);
+	static bool hashFile(std::string path_, uint64_t* hash_);
+	int internName(const std::string& name_);
+	bool inScope(int maps_, int starts_, int map_index_, int p_id_);
+	sc2::Point2D resolveLocation(BasicSc2Bot* bot_, int location_);
+	void buildNameTables();
+	void useLoadedRecords();
+	bool checkImageRecords(const StrategyImageHeader* header_);
+	const char* name(int name_);
+
+	// what apply() reads, either the vectors below or a mapped image
+	const uint32_t* name_offset_data;
+	const char* name_data;
+	const LocationRecord* location_data;
+	const SettingRecord* setting_data;
+	const ConditionRecord* condition_data;
+	const TriggerRecord* trigger_data;
+	const DirectiveRecord* directive_data;
+	const PreceptRecord* precept_data;
+	int num_settings;
+	int num_conditions;
+	int num_precepts;
+
+	std::vector<std::string> names;
+	std::vector<uint32_t> name_offsets;
+	std::vector<char> name_chars;
+	std::vector<LocationRecord> locations;
+	std::vector<SettingRecord> settings;
+	std::vector<ConditionRecord> conditions;
+	std::vector<TriggerRecord> triggers;
+	std::vector<DirectiveRecord> directives;
+	std::vector<PreceptRecord> precepts;
+
+	// used while loading
+	std::map<std::string, int> name_ids;
+	std::map<std::string, std::pair<int, int>> condition_groups;	// first condition and number of conditions, copied into triggers that use them
+	std::map<std::string, int> cond_names;
+	std::map<std::string, int> flag_names;
+	std::map<std::string, int> assignee_names;
+	std::map<std::string, int> action_names;
+	std::map<std::string, int> unit_type_names;
+	std::map<std::string, int> ability_names;
+	std::map<std::string, int> upgrade_names;
+	std::string path;
+	uint64_t source_hash;	// of the strategy file the records were loaded from
+	int line_number;
+	int current_maps;
+	int current_starts;
+	bool in_precept;
+	std::string current_group;	// condition group being read, empty outside one
+	long long load_us;
+
+	// mapped image, nullptr when the records were loaded from text
+	const uint8_t* image;
+	size_t image_size;
+#ifdef _WIN32
+	void* file_handle;
+	void* mapping_handle;
+#else
+	int fd;
+#endif
+};
@@ -0,0 +1,159 @@
+#include "TargetAssigner.h"
+#include "BasicSc2Bot.h"
+#include "Mob.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+TargetAssigner::TargetAssigner(BasicSc2Bot* agent_) {
+	agent = agent_;
+	cols = 0;
+	rows = 0;
+}
+
+int TargetAssigner::registerRule(std::string name_, sc2::UNIT_TYPEID mob_type_, std::vector<sc2::UNIT_TYPEID> target_types_, float max_range_,
+	TargetAction action_, float min_range_) {
+	// mobs of mob_type_ with an enemy of target_types_ further than min_range_ and no further than max_range_
+	// are passed to action_ along with the closest such enemy within max_range_
+	TargetRule rule;
+	rule.name = name_;
+	rule.mob_type = mob_type_;
+	rule.target_types = target_types_;
+	rule.min_range = min_range_;
+	rule.max_range = max_range_;
+	rule.action = action_;
+	rules.push_back(rule);
+	for (auto t : target_types_) {
+		wanted_types.insert((int)t);
+	}
+	return rules.size() - 1;
+}
+
+int TargetAssigner::cellIndex(int col_, int row_) {
+	col_ = std::min(std::max(col_, 0), cols - 1);
+	row_ = std::min(std::max(row_, 0), rows - 1);
+	return col_ + row_ * cols;
+}
+
+void TargetAssigner::update(const sc2::Units& enemies_) {
+	// bucket every visible, living enemy that some rule targets, should be called once per step
+	const sc2::GameInfo& game_info = agent->getObservation()->GetGameInfo();
+	cols = std::max(1, (int)std::ceil(game_info.width / TARGET_GRID_CELL));
+	rows = std::max(1, (int)std::ceil(game_info.height / TARGET_GRID_CELL));
+
+	std::vector<const sc2::Unit*> targets;
+	std::vector<int> target_cells;
+	for (auto e : enemies_) {
+		if (e->display_type != sc2::Unit::DisplayType::Visible || !e->is_alive)
+			continue;
+		if (wanted_types.find((int)e->unit_type) == wanted_types.end())
+			continue;
+		targets.push_back(e);
+		target_cells.push_back(cellIndex((int)(e->pos.x / TARGET_GRID_CELL), (int)(e->pos.y / TARGET_GRID_CELL)));
+	}
+
+	// counting sort by cell, so each cell is one contiguous run of cell_units
+	cell_start.assign(cols * rows + 1, 0);
+	for (int c : target_cells) {
+		cell_start[c + 1]++;
+	}
+	for (size_t i = 1; i < cell_start.size(); ++i) {
+		cell_start[i] += cell_start[i - 1];
+	}
+	std::vector<int> next(cell_start.begin(), cell_start.end() - 1);
+	cell_units.resize(targets.size());
+	for (size_t i = 0; i < targets.size(); ++i) {
+		cell_units[next[target_cells[i]]++] = targets[i];
+	}
+}
+
+const sc2::Unit* TargetAssigner::nearestTarget(sc2::Point2D pos_, const std::vector<sc2::UNIT_TYPEID>& target_types_, float max_range_,
+	float min_range_, float* dist_sq_) {
+	// closest bucketed enemy of target_types_ within max_range_, or nullptr if none is further than min_range_
+	if (cell_units.empty())
+		return nullptr;
+
+	float max_sq = max_range_ * max_range_;
+	float min_sq = min_range_ * min_range_;
+	int col_min = (int)std::floor((pos_.x - max_range_) / TARGET_GRID_CELL);
+	int col_max = (int)std::floor((pos_.x + max_range_) / TARGET_GRID_CELL);
+	int row_min = (int)std::floor((pos_.y - max_range_) / TARGET_GRID_CELL);
+	int row_max = (int)std::floor((pos_.y + max_range_) / TARGET_GRID_CELL);
+	col_min = std::max(col_min, 0);
+	row_min = std::max(row_min, 0);
+	col_max = std::min(col_max, cols - 1);
+	row_max = std::min(row_max, rows - 1);
+
+	const sc2::Unit* closest = nullptr;
+	float closest_sq = std::numeric_limits<float>::max();
+	bool beyond_min = false;
+	for (int row = row_min; row <= row_max; ++row) {
+		for (int col = col_min; col <= col_max; ++col) {
+			int cell = col + row * cols;
+			for (int i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+				const sc2::Unit* t = cell_units[i];
+				if (std::find(target_types_.begin(), target_types_.end(), t->unit_type) == target_types_.end())
+					continue;
+				float dist = sc2::DistanceSquared2D(t->pos, pos_);
+				if (dist > max_sq)
+					continue;
+				if (dist > min_sq) {
+					beyond_min = true;
+				}
+				if (dist < closest_sq) {
+					closest_sq = dist;
+					closest = t;
+				}
+			}
+		}
+	}
+	if (!beyond_min)
+		return nullptr;
+	if (dist_sq_) {
+		*dist_sq_ = closest_sq;
+	}
+	return closest;
+}
+
+int TargetAssigner::resolve() {
+	// run every rule in order, returns the number of mobs that were given an order
+	if (cell_units.empty() || rules.empty())
+		return 0;
+
+	std::vector<std::vector<Mob*>> candidates(rules.size());
+	for (auto m : agent->mobH->getMobs()) {
+		for (size_t r = 0; r < rules.size(); ++r) {
+			if (m->unit.unit_type == rules[r].mob_type) {
+				candidates[r].push_back(m);
+			}
+		}
+	}
+
+	// searches only read the grid, so they run on the task pool; orders are then given in rule order
+	std::unordered_set<Mob*> assigned;
+	for (size_t r = 0; r < rules.size(); ++r) {
+		TargetRule& rule = rules[r];
+		std::vector<Mob*>& mobs = candidates[r];
+		std::vector<const sc2::Unit*> targets(mobs.size(), nullptr);
+		std::vector<float> dists(mobs.size(), 0.0F);
+		agent->pool->parallelFor(0, mobs.size(), TARGET_SEARCH_GRAIN, [this, &rule, &mobs, &targets, &dists](int begin_, int end_) {
+			for (int i = begin_; i < end_; ++i) {
+				targets[i] = nearestTarget(mobs[i]->unit.pos, rule.target_types, rule.max_range, rule.min_range, &dists[i]);
+			}
+		});
+
+		for (size_t i = 0; i < mobs.size(); ++i) {
+			Mob* m = mobs[i];
+			if (!targets[i] || assigned.find(m) != assigned.end() || m->isOnCooldown(agent))
+				continue;
+			if (rule.action(m, targets[i], dists[i])) {
+				assigned.insert(m);
+			}
+		}
+	}
+	return assigned.size();
+}
+
+int TargetAssigner::getNumTargets() {
+	return cell_units.size();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "sc2api/sc2_api.h"
+
+# define TARGET_GRID_CELL 4.0F // side of a target grid cell, small next to the 12-18 ranges micro routines search
+# define TARGET_SEARCH_GRAIN 16 // mobs searched per pool job in resolve()
+
+class BasicSc2Bot;
+class Mob;
+
+class TargetAssigner {
+// Pairs our units with nearby enemy units for micro routines. Enemies are bucketed into a grid
+// once per step, and each registered rule only looks at the cells within its range, so a step
+// costs roughly (our units x enemies in range) instead of (our units x all enemies)
+//
+// Rules are resolved in the order they were registered. A mob gets at most one assignment per
+// step, and mobs on cooldown are skipped
+public:
+	// returns true if the mob was given an order, which takes it out of the remaining rules this step
+	typedef std::function<bool(Mob* mob_, const sc2::Unit* target_, float dist_sq_)> TargetAction;
+
+	TargetAssigner(BasicSc2Bot* agent_);
+	int registerRule(std::string name_, sc2::UNIT_TYPEID mob_type_, std::vector<sc2::UNIT_TYPEID> target_types_, float max_range_,
+		TargetAction action_, float min_range_=0.0F);
+	void update(const sc2::Units& enemies_);
+	int resolve();
+	const sc2::Unit* nearestTarget(sc2::Point2D pos_, const std::vector<sc2::UNIT_TYPEID>& target_types_, float max_range_,
+		float min_range_=0.0F, float* dist_sq_=nullptr);
+	int getNumTargets();
+
+private:
+	struct TargetRule {
+		std::string name;
+		sc2::UNIT_TYPEID mob_type;
+		std::vector<sc2::UNIT_TYPEID> target_types;
+		float min_range;
+		float max_range;
+		TargetAction action;
+	};
+
+	int cellIndex(int col_, int row_);
+
+	BasicSc2Bot* agent;
+	std::vector<TargetRule> rules;
+	std::unordered_set<int> wanted_types;	// target types of every rule, other enemies are not bucketed
+
+	// enemies bucketed by cell, cell i holds cell_units[cell_start[i]] up to cell_units[cell_start[i + 1]]
+	int cols;
+	int rows;
+	std::vector<int> cell_start;
+	std::vector<const sc2::Unit*> cell_units;
+};
@@ -0,0 +1,186 @@
+#include "TaskPool.h"
+#include <algorithm>
+#include <cassert>
+
+// each worker knows its own queue, other threads submit to queue 0
+static thread_local TaskPool* local_pool = nullptr;
+static thread_local int local_queue = 0;
+
+int TaskGraph::add(std::function<void()> task_, std::vector<int> after_) {
+	// returns the id to pass in after_ of later tasks
+	Node node;
+	node.task = task_;
+	node.num_dependencies = after_.size();
+	int id = nodes.size();
+	for (auto a : after_) {
+		assert(a >= 0 && a < id);
+		nodes[a].dependents.push_back(id);
+	}
+	nodes.push_back(node);
+	return id;
+}
+
+int TaskGraph::size() {
+	return nodes.size();
+}
+
+TaskPool::TaskPool(int num_workers_) {
+	num_queued.store(0);
+	stopping.store(false);
+	queues.emplace_back(new WorkQueue());
+	for (int i = 0; i < num_workers_; ++i) {
+		queues.emplace_back(new WorkQueue());
+	}
+	for (int i = 0; i < num_workers_; ++i) {
+		workers.emplace_back(&TaskPool::workerLoop, this, i + 1);
+	}
+}
+
+TaskPool::~TaskPool() {
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping.store(true);
+	}
+	wake.notify_all();
+	for (auto& w : workers) {
+		w.join();
+	}
+}
+
+int TaskPool::getNumWorkers() {
+	return workers.size();
+}
+
+int TaskPool::localQueue() {
+	if (local_pool == this)
+		return local_queue;
+	return 0;
+}
+
+void TaskPool::submit(Job job_) {
+	{
+		WorkQueue& queue = *queues[localQueue()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job_);
+	}
+	{
+		// taking the lock orders this with a worker about to sleep, so the wake up is not lost
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		num_queued.fetch_add(1);
+	}
+	wake.notify_one();
+}
+
+bool TaskPool::runOne(int queue_) {
+	// run the newest job of our own queue, or steal the oldest job of another
+	Job job;
+	bool found = false;
+	{
+		WorkQueue& own = *queues[queue_];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty()) {
+			job = own.jobs.back();
+			own.jobs.pop_back();
+			found = true;
+		}
+	}
+	for (size_t i = 1; i < queues.size() && !found; ++i) {
+		WorkQueue& other = *queues[(queue_ + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.jobs.empty()) {
+			job = other.jobs.front();
+			other.jobs.pop_front();
+			found = true;
+		}
+	}
+	if (!found)
+		return false;
+
+	num_queued.fetch_sub(1);
+	job.func();
+	job.pending->fetch_sub(1, std::memory_order_acq_rel);
+	return true;
+}
+
+void TaskPool::wait(std::atomic<int>& pending_) {
+	// help with queued work until all of ours is done
+	int queue = localQueue();
+	while (pending_.load(std::memory_order_acquire) > 0) {
+		if (!runOne(queue)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void TaskPool::workerLoop(int queue_) {
+	local_pool = this;
+	local_queue = queue_;
+	while (true) {
+		if (runOne(queue_))
+			continue;
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		wake.wait(lock, [this]() { return stopping.load() || num_queued.load() > 0; });
+		if (stopping.load())
+			return;
+	}
+}
+
+void TaskPool::parallelFor(int begin_, int end_, int grain_, const std::function<void(int, int)>& body_) {
+	// calls body_ on consecutive ranges of at most grain_ indices covering [begin_, end_)
+	grain_ = std::max(grain_, 1);
+	if (workers.empty() || end_ - begin_ <= grain_) {
+		for (int b = begin_; b < end_; b += grain_) {
+			body_(b, std::min(b + grain_, end_));
+		}
+		return;
+	}
+
+	std::atomic<int> pending((end_ - begin_ + grain_ - 1) / grain_);
+	for (int b = begin_; b < end_; b += grain_) {
+		int e = std::min(b + grain_, end_);
+		Job job;
+		job.func = [&body_, b, e]() { body_(b, e); };
+		job.pending = &pending;
+		submit(job);
+	}
+	wait(pending);
+}
+
+void TaskPool::runNode(TaskGraph& graph_, int node_, std::atomic<int>* remaining_, std::atomic<int>* pending_) {
+	graph_.nodes[node_].task();
+	for (auto d : graph_.nodes[node_].dependents) {
+		if (remaining_[d].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			Job job;
+			job.func = [this, &graph_, d, remaining_, pending_]() { runNode(graph_, d, remaining_, pending_); };
+			job.pending = pending_;
+			submit(job);
+		}
+	}
+}
+
+void TaskPool::run(TaskGraph& graph_) {
+	// run every task of graph_, returning once all have finished
+	if (workers.empty()) {
+		for (auto& n : graph_.nodes) {
+			n.task();
+		}
+		return;
+	}
+
+	int num_nodes = graph_.nodes.size();
+	std::unique_ptr<std::atomic<int>[]> remaining(new std::atomic<int>[num_nodes]);
+	std::atomic<int> pending(num_nodes);
+	for (int i = 0; i < num_nodes; ++i) {
+		remaining[i].store(graph_.nodes[i].num_dependencies);
+	}
+	std::atomic<int>* remaining_ptr = remaining.get();
+	for (int i = 0; i < num_nodes; ++i) {
+		if (graph_.nodes[i].num_dependencies == 0) {
+			Job job;
+			job.func = [this, &graph_, i, remaining_ptr, &pending]() { runNode(graph_, i, remaining_ptr, &pending); };
+			job.pending = &pending;
+			submit(job);
+		}
+	}
+	wait(pending);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+# define TASK_POOL_WORKERS 2 // worker threads besides the game thread, 0 runs everything on the game thread in order
+
+class TaskGraph {
+// Tasks that may run in parallel, each only after the tasks it was added after.
+// A task can only depend on tasks added before it, so insertion order is always a valid order
+public:
+	int add(std::function<void()> task_, std::vector<int> after_ = std::vector<int>());
+	int size();
+
+private:
+	friend class TaskPool;
+	struct Node {
+		std::function<void()> task;
+		std::vector<int> dependents;
+		int num_dependencies;
+	};
+	std::vector<Node> nodes;
+};
+
+class TaskPool {
+// Work-stealing pool shared by the bot's subsystems. Each worker has its own queue, taking its
+// newest job first and stealing the oldest job of another queue when its own is empty. The thread
+// that waits on parallel work runs jobs too, so it is never idle while its work is queued.
+// Work is split the same way whatever the worker count, so callers that write each piece's
+// results to their own slot get the same results with any number of workers
+public:
+	TaskPool(int num_workers_);
+	~TaskPool();
+	int getNumWorkers();
+	void parallelFor(int begin_, int end_, int grain_, const std::function<void(int, int)>& body_);
+	void run(TaskGraph& graph_);
+
+private:
+	struct Job {
+		std::function<void()> func;
+		std::atomic<int>* pending;	// decremented once func has run
+	};
+
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	TaskPool(const TaskPool&);
+	TaskPool& operator=(const TaskPool&);
+	void submit(Job job_);
+	bool runOne(int queue_);
+	void wait(std::atomic<int>& pending_);
+	void workerLoop(int queue_);
+	void runNode(TaskGraph& graph_, int node_, std::atomic<int>* remaining_, std::atomic<int>* pending_);
+	int localQueue();
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;	// queue 0 is shared by threads that are not workers
+	std::vector<std::thread> workers;
+	std::mutex sleep_mutex;
+	std::condition_variable wake;
+	std::atomic<int> num_queued;
+	std::atomic<bool> stopping;
+};
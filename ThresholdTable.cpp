@@ -0,0 +1,206 @@
+#include "ThresholdTable.h"
+#include "Triggers.h"
+#include <algorithm>
+
+static bool resourceOf(COND cond_type_, ThresholdTable::RESOURCE* resource_, bool* is_min_) {
+	// which number a threshold condition reads, and whether it is a lower bound
+	switch (cond_type_) {
+	case COND::MIN_MINERALS:
+		*resource_ = ThresholdTable::MINERALS;
+		*is_min_ = true;
+		return true;
+	case COND::MAX_MINERALS:
+		*resource_ = ThresholdTable::MINERALS;
+		*is_min_ = false;
+		return true;
+	case COND::MIN_GAS:
+		*resource_ = ThresholdTable::GAS;
+		*is_min_ = true;
+		return true;
+	case COND::MAX_GAS:
+		*resource_ = ThresholdTable::GAS;
+		*is_min_ = false;
+		return true;
+	case COND::MIN_FOOD:
+		*resource_ = ThresholdTable::FOOD;
+		*is_min_ = true;
+		return true;
+	case COND::MAX_FOOD:
+		*resource_ = ThresholdTable::FOOD;
+		*is_min_ = false;
+		return true;
+	case COND::MIN_FOOD_USED:
+		*resource_ = ThresholdTable::FOOD_USED;
+		*is_min_ = true;
+		return true;
+	case COND::MAX_FOOD_USED:
+		*resource_ = ThresholdTable::FOOD_USED;
+		*is_min_ = false;
+		return true;
+	case COND::MIN_FOOD_CAP:
+		*resource_ = ThresholdTable::FOOD_CAP;
+		*is_min_ = true;
+		return true;
+	case COND::MAX_FOOD_CAP:
+		*resource_ = ThresholdTable::FOOD_CAP;
+		*is_min_ = false;
+		return true;
+	case COND::MIN_FOOD_ARMY:
+		*resource_ = ThresholdTable::FOOD_ARMY;
+		*is_min_ = true;
+		return true;
+	case COND::MAX_FOOD_ARMY:
+		*resource_ = ThresholdTable::FOOD_ARMY;
+		*is_min_ = false;
+		return true;
+	case COND::MIN_TIME:
+		*resource_ = ThresholdTable::GAME_LOOP;
+		*is_min_ = true;
+		return true;
+	case COND::MAX_TIME:
+		*resource_ = ThresholdTable::GAME_LOOP;
+		*is_min_ = false;
+		return true;
+	default:
+		return false;
+	}
+}
+
+ThresholdTable::ThresholdTable() {
+	for (auto& c : columns) {
+		c.min_passed = 0;
+		c.max_passed = 0;
+		c.value = 0;
+	}
+	dirty = false;
+	num_thresholds = 0;
+	num_flips = 0;
+}
+
+bool ThresholdTable::isThreshold(COND cond_type_) {
+	RESOURCE resource;
+	bool is_min;
+	return resourceOf(cond_type_, &resource, &is_min);
+}
+
+int ThresholdTable::addGroup() {
+	group_unmet.push_back(0);
+	return group_unmet.size() - 1;
+}
+
+void ThresholdTable::addCondition(int group_, COND cond_type_, double cond_value_, bool is_true_) {
+	// the table is sorted again at the next update
+	RESOURCE resource;
+	bool is_min;
+	if (!resourceOf(cond_type_, &resource, &is_min))
+		return;
+	Threshold threshold;
+	threshold.value = cond_value_;
+	threshold.group = group_;
+	threshold.is_true = is_true_;
+	if (is_min)
+		columns[resource].min_thresholds.push_back(threshold);
+	else
+		columns[resource].max_thresholds.push_back(threshold);
+	dirty = true;
+	num_thresholds++;
+}
+
+void ThresholdTable::update(const sc2::ObservationInterface* obs_) {
+	// read each resource the way the conditions do, and flip the thresholds it crossed since the last update
+	double values[NUM_RESOURCES];
+	values[MINERALS] = obs_->GetMinerals();
+	values[GAS] = obs_->GetVespene();
+	values[FOOD] = obs_->GetFoodCap() - obs_->GetFoodUsed();
+	values[FOOD_USED] = obs_->GetFoodUsed();
+	values[FOOD_CAP] = obs_->GetFoodCap();
+	values[FOOD_ARMY] = obs_->GetFoodArmy();
+	values[GAME_LOOP] = obs_->GetGameLoop();
+	if (dirty) {
+		rebuild(values);
+		return;
+	}
+
+	auto value_below = [](const Threshold& t_, double v_) { return t_.value < v_; };
+	auto value_above = [](double v_, const Threshold& t_) { return v_ < t_.value; };
+	for (int r = 0; r < NUM_RESOURCES; ++r) {
+		Column& c = columns[r];
+		if (values[r] == c.value)
+			continue;
+		c.value = values[r];
+
+		// MIN thresholds at or below the value pass
+		size_t min_passed = std::upper_bound(c.min_thresholds.begin(), c.min_thresholds.end(), c.value, value_above) - c.min_thresholds.begin();
+		for (size_t i = min_passed; i < c.min_passed; ++i) {
+			flip(c.min_thresholds[i], false);
+		}
+		for (size_t i = c.min_passed; i < min_passed; ++i) {
+			flip(c.min_thresholds[i], true);
+		}
+		c.min_passed = min_passed;
+
+		// MAX thresholds at or above the value pass
+		size_t max_passed = std::lower_bound(c.max_thresholds.begin(), c.max_thresholds.end(), c.value, value_below) - c.max_thresholds.begin();
+		for (size_t i = c.max_passed; i < max_passed; ++i) {
+			flip(c.max_thresholds[i], false);
+		}
+		for (size_t i = max_passed; i < c.max_passed; ++i) {
+			flip(c.max_thresholds[i], true);
+		}
+		c.max_passed = max_passed;
+	}
+}
+
+void ThresholdTable::rebuild(const double* values_) {
+	// sort every column and count the unmet thresholds of every group from scratch
+	auto by_value = [](const Threshold& a_, const Threshold& b_) { return a_.value < b_.value; };
+	std::fill(group_unmet.begin(), group_unmet.end(), 0);
+	for (int r = 0; r < NUM_RESOURCES; ++r) {
+		Column& c = columns[r];
+		c.value = values_[r];
+		std::stable_sort(c.min_thresholds.begin(), c.min_thresholds.end(), by_value);
+		std::stable_sort(c.max_thresholds.begin(), c.max_thresholds.end(), by_value);
+		c.min_passed = 0;
+		for (auto& t : c.min_thresholds) {
+			bool passed = c.value >= t.value;
+			if (passed)
+				c.min_passed++;
+			if (passed != t.is_true)
+				group_unmet[t.group]++;
+		}
+		c.max_passed = 0;
+		for (auto& t : c.max_thresholds) {
+			bool passed = c.value <= t.value;
+			if (!passed)
+				c.max_passed++;
+			if (passed != t.is_true)
+				group_unmet[t.group]++;
+		}
+	}
+	dirty = false;
+}
+
+void ThresholdTable::flip(const Threshold& threshold_, bool passed_) {
+	// the comparison of threshold_ now gives passed_, the opposite of before
+	if (passed_ == threshold_.is_true)
+		group_unmet[threshold_.group]--;
+	else
+		group_unmet[threshold_.group]++;
+	num_flips++;
+}
+
+bool ThresholdTable::isMet(int group_) {
+	return group_unmet[group_] == 0;
+}
+
+int ThresholdTable::getNumGroups() {
+	return group_unmet.size();
+}
+
+int ThresholdTable::getNumThresholds() {
+	return num_thresholds;
+}
+
+long long ThresholdTable::getNumFlips() {
+	return num_flips;
+}
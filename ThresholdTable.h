@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "sc2api/sc2_api.h"
+
+# define THRESHOLD_TABLES true // check resource, supply and game loop conditions through sorted threshold tables updated once per step
+# define NO_THRESHOLD_GROUP -1 // trigger whose conditions are not in the threshold table
+
+enum class COND;
+
+class ThresholdTable {
+// Conditions that compare one number from the observation against a constant (MIN_MINERALS, MAX_GAS,
+// MIN_FOOD, MIN_TIME...) are taken out of their triggers and kept here, in one sorted array of
+// thresholds per resource. The MIN thresholds a value meets are a prefix of their array and the
+// MAX thresholds a suffix, so when a resource changes a binary search finds the boundary, and only
+// the thresholds between the old and new boundary flip. Each trigger is a group that keeps a count
+// of its unmet thresholds, so asking whether all of them are met costs nothing
+public:
+	enum RESOURCE {
+		MINERALS,
+		GAS,
+		FOOD,		// food cap - food used
+		FOOD_USED,
+		FOOD_CAP,
+		FOOD_ARMY,
+		GAME_LOOP,
+		NUM_RESOURCES
+	};
+
+	ThresholdTable();
+	static bool isThreshold(COND cond_type_);
+	int addGroup();
+	void addCondition(int group_, COND cond_type_, double cond_value_, bool is_true_);
+	void update(const sc2::ObservationInterface* obs_);
+	bool isMet(int group_);
+	int getNumGroups();
+	int getNumThresholds();
+	long long getNumFlips();
+
+private:
+	struct Threshold {
+		double value;
+		int group;
+		bool is_true;		// false for a negated condition
+	};
+
+	struct Column {
+		std::vector<Threshold> min_thresholds;	// met while the value is >= threshold, sorted by value
+		std::vector<Threshold> max_thresholds;	// met while the value is <= threshold, sorted by value
+		size_t min_passed;		// min_thresholds[0, min_passed) are <= the value
+		size_t max_passed;		// max_thresholds[max_passed, end) are >= the value
+		double value;
+	};
+
+	void rebuild(const double* values_);
+	void flip(const Threshold& threshold_, bool passed_);
+
+	Column columns[NUM_RESOURCES];
+	std::vector<int> group_unmet;	// per group, thresholds not met at the last update
+	bool dirty;						// thresholds were added since the last update
+	int num_thresholds;
+	long long num_flips;
+};
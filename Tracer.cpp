@@ -0,0 +1,161 @@
+#include "Tracer.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// each thread caches the buffer it writes to, so recording a span never takes the lock
+static thread_local Tracer* local_owner = nullptr;
+static thread_local int local_owner_serial = -1;
+static thread_local Tracer::TraceBuffer* local_buffer = nullptr;
+
+Tracer::Tracer() {
+	static std::atomic<int> next_serial(0);
+	enabled = TRACING_ENABLED;
+	serial = next_serial++;
+	game_loop = 0;
+	origin = std::chrono::steady_clock::now();
+}
+
+Tracer::~Tracer() {
+	// other threads' caches no longer match once the serial is gone, this thread's is cleared outright
+	if (local_owner == this && local_owner_serial == serial) {
+		local_owner = nullptr;
+		local_owner_serial = -1;
+		local_buffer = nullptr;
+	}
+}
+
+void Tracer::setEnabled(bool is_true) {
+	enabled = is_true;
+}
+
+bool Tracer::isEnabled() {
+	return enabled;
+}
+
+void Tracer::setGameLoop(int game_loop_) {
+	game_loop = game_loop_;
+}
+
+long long Tracer::now() {
+	// microseconds since the tracer was created
+	if (!enabled)
+		return 0;
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Tracer::setPreceptName(int precept_id_, std::string name_) {
+	if (precept_id_ < 0)
+		return;
+	if (precept_id_ >= (int)precept_names.size()) {
+		precept_names.resize(precept_id_ + 1);
+	}
+	precept_names[precept_id_] = name_;
+}
+
+Tracer::TraceBuffer* Tracer::localBuffer() {
+	// the buffer is allocated once per thread, the first time that thread records a span
+	if (local_owner == this && local_owner_serial == serial && local_buffer) {
+		return local_buffer;
+	}
+
+	// the thread may already have a buffer, if it records with another tracer in between
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+	std::thread::id thread = std::this_thread::get_id();
+	TraceBuffer* found = nullptr;
+	for (auto& buffer : buffers) {
+		if (buffer->thread == thread) {
+			found = buffer.get();
+		}
+	}
+	if (!found) {
+		std::unique_ptr<TraceBuffer> buffer(new TraceBuffer());
+		buffer->events.resize(TRACE_BUFFER_EVENTS);
+		buffer->next = 0;
+		buffer->wrapped = false;
+		buffer->thread_id = buffers.size() + 1;
+		buffer->thread = thread;
+		found = buffer.get();
+		buffers.push_back(std::move(buffer));
+	}
+	local_owner = this;
+	local_owner_serial = serial;
+	local_buffer = found;
+	return local_buffer;
+}
+
+void Tracer::span(const char* name_, long long start_us_, int id_) {
+	// record a span that started at start_us_ (from now()) and ends now
+	if (!enabled)
+		return;
+
+	// take the end time first, so allocating a thread's buffer is not counted against the span
+	long long end_us = now();
+	TraceBuffer* buffer = localBuffer();
+	TraceEvent& e = buffer->events[buffer->next];
+	e.name = name_;
+	e.id = id_;
+	e.game_loop = game_loop;
+	e.start_us = start_us_;
+	e.dur_us = end_us - start_us_;
+
+	buffer->next++;
+	if (buffer->next == buffer->events.size()) {
+		buffer->next = 0;
+		buffer->wrapped = true;
+	}
+}
+
+bool Tracer::flush(std::string filename_) {
+	// write every buffered span as a trace-event JSON file
+	// should be called while no other thread is recording spans
+	if (!enabled)
+		return false;
+
+	std::ofstream out(filename_);
+	if (!out.is_open()) {
+		std::cout << "Unable to write trace output to " << filename_ << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+	out << "{\"traceEvents\":[" << std::endl;
+	bool first = true;
+	for (auto& buffer : buffers) {
+		size_t count = buffer->wrapped ? buffer->events.size() : buffer->next;
+		size_t start = buffer->wrapped ? buffer->next : 0;
+		for (size_t i = 0; i < count; ++i) {
+			const TraceEvent& e = buffer->events[(start + i) % buffer->events.size()];
+			if (!first) {
+				out << "," << std::endl;
+			}
+			first = false;
+			out << "{\"name\":\"" << e.name;
+			if (std::strcmp(e.name, "precept") == 0 || std::strcmp(e.name, "precept_execute") == 0) {
+				if (e.id >= 0 && e.id < (int)precept_names.size()) {
+					out << ":" << precept_names[e.id];
+				}
+			}
+			out << "\",\"cat\":\"bot\",\"ph\":\"X\",\"ts\":" << e.start_us << ",\"dur\":" << e.dur_us
+				<< ",\"pid\":1,\"tid\":" << buffer->thread_id
+				<< ",\"args\":{\"game_loop\":" << e.game_loop << ",\"id\":" << e.id << "}}";
+		}
+	}
+	out << std::endl << "]}" << std::endl;
+	return true;
+}
+
+void Tracer::sumSpans(std::map<std::string, long long>& totals_us_, int from_game_loop_) {
+	// add up the duration of every buffered span by name, ignoring those recorded before from_game_loop_
+	// should be called while no other thread is recording spans
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+	for (auto& buffer : buffers) {
+		size_t count = buffer->wrapped ? buffer->events.size() : buffer->next;
+		for (size_t i = 0; i < count; ++i) {
+			const TraceEvent& e = buffer->events[i];
+			if (e.game_loop >= from_game_loop_) {
+				totals_us_[e.name] += e.dur_us;
+			}
+		}
+	}
+}
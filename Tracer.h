@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+# define TRACING_ENABLED false // write a chrome://tracing timeline of OnStep phases, precepts, directives and queries
+# define TRACE_JSON "bot_trace.json" // file the timeline is written to at game end
+# define TRACE_BUFFER_EVENTS 262144 // events kept per thread before the oldest are overwritten
+# define NO_TRACE_ID -1 // span has no precept or directive id attached
+
+class Tracer {
+// Records timed spans into a preallocated ring buffer per thread, so that tracing
+// does not allocate during a step. Spans are written as Chrome trace-event JSON,
+// viewable in chrome://tracing or Perfetto
+public:
+	struct TraceEvent {
+		const char* name;	// must be a string literal, it is only read when flushing
+		int id;
+		int game_loop;
+		long long start_us;
+		long long dur_us;
+	};
+
+	struct TraceBuffer {
+		std::vector<TraceEvent> events;
+		size_t next;
+		bool wrapped;
+		int thread_id;
+		std::thread::id thread;
+	};
+
+	Tracer();
+	~Tracer();
+	void setEnabled(bool is_true=true);
+	bool isEnabled();
+	void setGameLoop(int game_loop_);
+	long long now();
+	void span(const char* name_, long long start_us_, int id_=NO_TRACE_ID);
+	void setPreceptName(int precept_id_, std::string name_);
+	bool flush(std::string filename_);
+	void sumSpans(std::map<std::string, long long>& totals_us_, int from_game_loop_=0);
+
+private:
+	TraceBuffer* localBuffer();
+
+	bool enabled;
+	int serial;					// tells apart tracers allocated at the same address
+	std::atomic<int> game_loop;
+	std::chrono::steady_clock::time_point origin;
+	std::mutex buffers_mutex;
+	std::vector<std::unique_ptr<TraceBuffer>> buffers;
+	std::vector<std::string> precept_names;		// indexed by precept id
+};
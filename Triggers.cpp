@@ -2,7 +2,10 @@
 
 #include "Directive.h"
 #include "Triggers.h"
+#include "ThresholdTable.h"
 #include "sc2api/sc2_api.h"
+#include <algorithm>
+#include <cmath>
 
 Trigger::TriggerCondition::TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, double cond_value_, bool is_true_) {
 	agent = agent_;
@@ -154,6 +157,68 @@ Trigger::TriggerCondition::TriggerCondition(BasicSc2Bot* agent_, COND cond_type_
 	upgrade_id = sc2::UPGRADE_ID::INVALID;
 }
 
+Trigger::TriggerCondition::TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, std::string group_name_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_) {
+	assert(cond_type_ == COND::MAX_UNITS_IN_GROUP || cond_type_ == COND::MIN_UNITS_IN_GROUP ||
+		cond_type_ == COND::MAX_UNITS_OF_TYPE_IN_GROUP || cond_type_ == COND::MIN_UNITS_OF_TYPE_IN_GROUP);
+	agent = agent_;
+	cond_type = cond_type_;
+	cond_value = cond_value_;
+	location = INVALID_POINT;
+	radius = DEFAULT_RADIUS;
+	debug = false;
+	is_true = true;
+	unit_of_type = unit_of_type_;
+	ability_id = sc2::ABILITY_ID::INVALID;
+	upgrade_id = sc2::UPGRADE_ID::INVALID;
+	group_name = group_name_;
+}
+
+Trigger::TriggerCondition::TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, std::string group_name_, double cond_value_, sc2::Point2D location_, float radius_) {
+	assert(cond_type_ == COND::MAX_UNITS_IN_GROUP_NEAR_LOCATION || cond_type_ == COND::MIN_UNITS_IN_GROUP_NEAR_LOCATION);
+	agent = agent_;
+	cond_type = cond_type_;
+	cond_value = cond_value_;
+	location = location_;
+	radius = radius_;
+	debug = false;
+	is_true = true;
+	unit_of_type = sc2::UNIT_TYPEID::INVALID;
+	ability_id = sc2::ABILITY_ID::INVALID;
+	upgrade_id = sc2::UPGRADE_ID::INVALID;
+	group_name = group_name_;
+}
+
+Trigger::TriggerCondition::TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_, sc2::ABILITY_ID ability_id_,
+	sc2::UPGRADE_ID upgrade_id_, std::unordered_set<FLAGS> flags_, sc2::Point2D location_, float radius_, bool is_true_) {
+	// takes every field, for conditions built from records such as those of a strategy file
+	agent = agent_;
+	cond_type = cond_type_;
+	cond_value = cond_value_;
+	location = location_;
+	radius = radius_;
+	filter_flags = flags_;
+	debug = false;
+	is_true = is_true_;
+	unit_of_type = unit_of_type_;
+	ability_id = ability_id_;
+	upgrade_id = upgrade_id_;
+}
+
+std::unordered_set<Mob*> Trigger::TriggerCondition::getMobsOfType(sc2::UNIT_TYPEID equivalent_type_) {
+	// our living mobs of unit_of_type or equivalent_type_, only those in group_name if it is set, found through the mob indexes
+
+	MobQuery query;
+	query.unit_type = unit_of_type;
+	query.group = group_name;
+	std::unordered_set<Mob*> mobs = agent->mobH->queryMobs(query);
+	if (equivalent_type_ != unit_of_type) {
+		query.unit_type = equivalent_type_;
+		std::unordered_set<Mob*> equivalent_mobs = agent->mobH->queryMobs(query);
+		mobs.insert(equivalent_mobs.begin(), equivalent_mobs.end());
+	}
+	return mobs;
+}
+
 bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 
 	// assign equivalent_type for the same units that might have an alternate ID
@@ -262,12 +327,7 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 		return agent->locH->PathableThreatExistsNearLocation(location, radius) == is_true;
 	case COND::MIN_UNITS_USING_ABILITY:
 	{
-		std::unordered_set<Mob*> mobs = agent->mobH->getMobs();
-		std::unordered_set<Mob*> filtered_mobs;
-		if (!mobs.empty()) { 
-			std::copy_if(mobs.begin(), mobs.end(), std::inserter(filtered_mobs, filtered_mobs.begin()),
-				[this](Mob* m) { return m->unit.unit_type == unit_of_type; });
-		}
+		std::unordered_set<Mob*> filtered_mobs = getMobsOfType(unit_of_type);
 		std::unordered_set<Mob*> using_order;
 		int count = 0;
 		if (!filtered_mobs.empty()) {
@@ -289,12 +349,7 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::MAX_UNITS_USING_ABILITY:
 	{
-		std::unordered_set<Mob*> mobs = agent->mobH->getMobs();
-		std::unordered_set<Mob*> filtered_mobs;
-		if (!mobs.empty()) {
-			std::copy_if(mobs.begin(), mobs.end(), std::inserter(filtered_mobs, filtered_mobs.begin()),
-				[this](Mob* m) { return m->unit.unit_type == unit_of_type; });
-		}
+		std::unordered_set<Mob*> filtered_mobs = getMobsOfType(unit_of_type);
 		std::unordered_set<Mob*> using_order;
 		int count = 0;
 		if (!filtered_mobs.empty()) {
@@ -313,9 +368,9 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::MIN_UNIT_WITH_FLAGS:
 	{
-		std::unordered_set<Mob*> mobs;
-		mobs = agent->mobH->filterByFlags(agent->mobH->getMobs(), filter_flags);
-		int num_units = mobs.size();
+		MobQuery query;
+		query.flags = flagMask(filter_flags);
+		int num_units = agent->mobH->countMobs(query);
 
 		// output to debug for checking conditions which are failing
 		if (debug && num_units < cond_value) {
@@ -325,9 +380,9 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::MAX_UNIT_WITH_FLAGS:
 	{
-		std::unordered_set<Mob*> mobs;
-		mobs = agent->mobH->filterByFlags(agent->mobH->getMobs(), filter_flags);
-		int num_units = mobs.size();
+		MobQuery query;
+		query.flags = flagMask(filter_flags);
+		int num_units = agent->mobH->countMobs(query);
 		
 		// output to debug for checking conditions which are failing
 		if (debug && num_units > cond_value) {
@@ -338,7 +393,7 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	case COND::MIN_UNIT_WITH_FLAGS_NEAR_LOCATION:
 	{
 		std::unordered_set<Mob*> mobs;
-		mobs = agent->mobH->filterByFlags(agent->mobH->getMobs(), filter_flags);
+		mobs = agent->mobH->getMobsWithFlags(filter_flags);
 		std::unordered_set<Mob*> filtered_mobs;
 		std::copy_if(mobs.begin(), mobs.end(), std::inserter(filtered_mobs, filtered_mobs.begin()),
 			[this, radius_sq](Mob* m) { return (
@@ -356,7 +411,7 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	case COND::MAX_UNIT_WITH_FLAGS_NEAR_LOCATION:
 	{
 		std::unordered_set<Mob*> mobs;
-		mobs = agent->mobH->filterByFlags(agent->mobH->getMobs(), filter_flags);
+		mobs = agent->mobH->getMobsWithFlags(filter_flags);
 		std::unordered_set<Mob*> filtered_mobs;
 		std::copy_if(mobs.begin(), mobs.end(), std::inserter(filtered_mobs, filtered_mobs.begin()),
 			[this, radius_sq](Mob* m) { return (
@@ -371,8 +426,66 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 		
 		return (num_units <= cond_value) == is_true;
 	}
+	case COND::MIN_UNITS_IN_GROUP:
+	case COND::MIN_UNITS_OF_TYPE_IN_GROUP:
+	{
+		// unit_of_type is INVALID for MIN_UNITS_IN_GROUP, which matches any type
+		MobQuery query;
+		query.unit_type = unit_of_type;
+		query.group = group_name;
+		int num_units = agent->mobH->countMobs(query);
+
+		// output to debug for checking conditions which are failing
+		if (debug && num_units < cond_value) {
+			std::cout << "MIN_U_IG(" << num_units << ">=" << cond_value << ") ";
+		}
+		return (num_units >= cond_value) == is_true;
+	}
+	case COND::MAX_UNITS_IN_GROUP:
+	case COND::MAX_UNITS_OF_TYPE_IN_GROUP:
+	{
+		MobQuery query;
+		query.unit_type = unit_of_type;
+		query.group = group_name;
+		int num_units = agent->mobH->countMobs(query);
+
+		// output to debug for checking conditions which are failing
+		if (debug && num_units > cond_value) {
+			std::cout << "MAX_U_IG(" << num_units << "<=" << cond_value << ") ";
+		}
+		return (num_units <= cond_value) == is_true;
+	}
+	case COND::MIN_UNITS_IN_GROUP_NEAR_LOCATION:
+	{
+		MobQuery query;
+		query.group = group_name;
+		std::unordered_set<Mob*> mobs = agent->mobH->queryMobs(query);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[this, radius_sq](Mob* m) { return sc2::DistanceSquared2D(m->unit.pos, location) <= radius_sq; });
+
+		// output to debug for checking conditions which are failing
+		if (debug && num_units < cond_value) {
+			std::cout << "MIN_U_IG_NL(" << num_units << ">=" << cond_value << ") ";
+		}
+		return (num_units >= cond_value) == is_true;
+	}
+	case COND::MAX_UNITS_IN_GROUP_NEAR_LOCATION:
+	{
+		MobQuery query;
+		query.group = group_name;
+		std::unordered_set<Mob*> mobs = agent->mobH->queryMobs(query);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[this, radius_sq](Mob* m) { return sc2::DistanceSquared2D(m->unit.pos, location) <= radius_sq; });
+
+		// output to debug for checking conditions which are failing
+		if (debug && num_units > cond_value) {
+			std::cout << "MAX_U_IG_NL(" << num_units << "<=" << cond_value << ") ";
+		}
+		return (num_units <= cond_value) == is_true;
+	}
 	case COND::MIN_ENEMY_UNITS_NEAR_LOCATION:
 	{
+		agent->prof->countGetUnits();
 		const sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Enemy);
 		int count = std::count_if(units.begin(), units.end(),
 			[this, radius_sq](const sc2::Unit* u) { 
@@ -390,6 +503,7 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::MAX_ENEMY_UNITS_NEAR_LOCATION:
 	{
+		agent->prof->countGetUnits();
 		const sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Enemy);
 		int count = std::count_if(units.begin(), units.end(),
 			[this, radius_sq](const sc2::Unit* u) { return (
@@ -520,6 +634,7 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 		return agent->haveUpgrade(upgrade_id) == is_true;
 	case COND::MIN_NEUTRAL_UNIT_OF_TYPE:
 	{
+		agent->prof->countGetUnits();
 		const sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Neutral);
 		int count = std::count_if(units.begin(), units.end(),
 			[this](const sc2::Unit* u) {
@@ -531,6 +646,7 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::MAX_NEUTRAL_UNIT_OF_TYPE:
 	{
+		agent->prof->countGetUnits();
 		const sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Neutral);
 		int count = std::count_if(units.begin(), units.end(),
 			[this](const sc2::Unit* u) {
@@ -542,11 +658,9 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::MIN_UNIT_OF_TYPE_UNDER_CONSTRUCTION:
 	{
-		const sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-		std::vector<const sc2::Unit*> filtered_units;
-		std::copy_if(units.begin(), units.end(), std::back_inserter(filtered_units),
-			[this](const sc2::Unit* u) { return (u->unit_type == unit_of_type) && (u->build_progress < 1.0 && u->build_progress > 0); });
-		int num_units = filtered_units.size();
+		std::unordered_set<Mob*> mobs = getMobsOfType(unit_of_type);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[](Mob* m) { return m->unit.build_progress < 1.0 && m->unit.build_progress > 0; });
 
 		// output to debug for checking conditions which are failing
 		if (debug && num_units < cond_value) {
@@ -558,11 +672,9 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	case COND::MIN_UNIT_OF_TYPE_TOTAL:
 		// include both under construction and constructed
 	{
-		const sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-		std::vector<const sc2::Unit*> filtered_units;
-		std::copy_if(units.begin(), units.end(), std::back_inserter(filtered_units),
-			[this](const sc2::Unit* u) { return (u->unit_type == unit_of_type) && (u->build_progress > 0); });
-		int num_units = filtered_units.size();
+		std::unordered_set<Mob*> mobs = getMobsOfType(unit_of_type);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[](Mob* m) { return m->unit.build_progress > 0; });
 
 		// output to debug for checking conditions which are failing
 		if (debug && num_units < cond_value) {
@@ -573,11 +685,9 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::MAX_UNIT_OF_TYPE_UNDER_CONSTRUCTION:
 		{
-			const sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-			std::vector<const sc2::Unit*> filtered_units;
-			std::copy_if(units.begin(), units.end(), std::back_inserter(filtered_units),
-				[this, equivalent_type](const sc2::Unit* u) { return (u->unit_type == unit_of_type || u->unit_type == equivalent_type) && (u->build_progress < 1.0 && u->build_progress > 0); });
-			int num_units = filtered_units.size();
+			std::unordered_set<Mob*> mobs = getMobsOfType(equivalent_type);
+			int num_units = std::count_if(mobs.begin(), mobs.end(),
+				[](Mob* m) { return m->unit.build_progress < 1.0 && m->unit.build_progress > 0; });
 		
 			// output to debug for checking conditions which are failing
 			if (debug && num_units > cond_value) {
@@ -589,11 +699,9 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	case COND::MAX_UNIT_OF_TYPE_TOTAL:
 		// include both under construction and constructed
 	{
-		const sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-		std::vector<const sc2::Unit*> filtered_units;
-		std::copy_if(units.begin(), units.end(), std::back_inserter(filtered_units),
-			[this, equivalent_type](const sc2::Unit* u) { return (u->unit_type == unit_of_type || u->unit_type == equivalent_type) && (u->build_progress >= 0); });
-		int num_units = filtered_units.size();
+		std::unordered_set<Mob*> mobs = getMobsOfType(equivalent_type);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[](Mob* m) { return m->unit.build_progress >= 0; });
 
 		// output to debug for checking conditions which are failing
 		if (debug && num_units > cond_value) {
@@ -604,12 +712,11 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::MAX_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION:
 		{
-			sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-			int num_units = count_if(units.begin(), units.end(),
-				[this, radius_sq](const sc2::Unit* u) {
-					return (u->unit_type == unit_of_type
-						&& sc2::DistanceSquared2D(u->pos, location) < radius_sq)
-						&& (u->build_progress > 0 && u->build_progress < 1.0F);
+			std::unordered_set<Mob*> mobs = getMobsOfType(unit_of_type);
+			int num_units = std::count_if(mobs.begin(), mobs.end(),
+				[this, radius_sq](Mob* m) {
+					return sc2::DistanceSquared2D(m->unit.pos, location) < radius_sq
+						&& (m->unit.build_progress > 0 && m->unit.build_progress < 1.0F);
 				});
 
 			// output to debug for checking conditions which are failing
@@ -622,12 +729,11 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	case COND::MAX_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION:
 		// include both under construction and constructed
 	{
-		sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-		int num_units = count_if(units.begin(), units.end(),
-			[this, radius_sq](const sc2::Unit* u) {
-				return (u->unit_type == unit_of_type
-					&& sc2::DistanceSquared2D(u->pos, location) < radius_sq)
-					&& (u->build_progress >= 0);
+		std::unordered_set<Mob*> mobs = getMobsOfType(unit_of_type);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[this, radius_sq](Mob* m) {
+				return sc2::DistanceSquared2D(m->unit.pos, location) < radius_sq
+					&& (m->unit.build_progress >= 0);
 			});
 
 		// output to debug for checking conditions which are failing
@@ -639,12 +745,11 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::MIN_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION:
 		{
-			sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-			int num_units = count_if(units.begin(), units.end(),
-				[this, radius_sq](const sc2::Unit* u) {
-					return (u->unit_type == unit_of_type
-						&& sc2::DistanceSquared2D(u->pos, location) < radius_sq)
-						&& (u->build_progress > 0 && u->build_progress < 1.0F);
+			std::unordered_set<Mob*> mobs = getMobsOfType(unit_of_type);
+			int num_units = std::count_if(mobs.begin(), mobs.end(),
+				[this, radius_sq](Mob* m) {
+					return sc2::DistanceSquared2D(m->unit.pos, location) < radius_sq
+						&& (m->unit.build_progress > 0 && m->unit.build_progress < 1.0F);
 				});
 
 			// output to debug for checking conditions which are failing
@@ -657,12 +762,11 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	case COND::MIN_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION:
 		// include both under construction and constructed
 	{
-		sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-		int num_units = count_if(units.begin(), units.end(),
-			[this, radius_sq](const sc2::Unit* u) {
-				return (u->unit_type == unit_of_type
-					&& sc2::DistanceSquared2D(u->pos, location) < radius_sq)
-					&& (u->build_progress > 0);
+		std::unordered_set<Mob*> mobs = getMobsOfType(unit_of_type);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[this, radius_sq](Mob* m) {
+				return sc2::DistanceSquared2D(m->unit.pos, location) < radius_sq
+					&& (m->unit.build_progress > 0);
 			});
 
 		// output to debug for checking conditions which are failing
@@ -674,7 +778,7 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	case COND::HAS_ABILITY_READY:
 	{
-		std::unordered_set<Mob*> structures = agent->mobH->filterByFlag(agent->mobH->getMobs(), FLAGS::IS_STRUCTURE);
+		std::unordered_set<Mob*> structures = agent->mobH->getMobsWithFlags({ FLAGS::IS_STRUCTURE });
 		bool found_one = false;
 		for (auto m : structures) {
 			if (agent->canUnitUseAbility(m->unit, ability_id)) {
@@ -709,12 +813,9 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	
 	if (cond_type == COND::MAX_UNIT_OF_TYPE) {
 		// only consider units that have completed construction
-		sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-
-		int num_units = count_if(units.begin(), units.end(),
-			[this, equivalent_type](const sc2::Unit* u) { 
-				return (u->unit_type == unit_of_type || u->unit_type == equivalent_type)
-					&& (u->build_progress == 1.0) && u->is_alive; });
+		std::unordered_set<Mob*> mobs = getMobsOfType(equivalent_type);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[](Mob* m) { return m->unit.build_progress == 1.0; });
 
 		// output to debug for checking conditions which are failing
 		if (debug && num_units > cond_value) {
@@ -725,12 +826,9 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 	if (cond_type == COND::MIN_UNIT_OF_TYPE) {
 		// only consider units that have completed construction
-		const sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-		std::vector<const sc2::Unit*> filtered_units;
-		std::copy_if(units.begin(), units.end(), std::back_inserter(filtered_units),
-			[this, equivalent_type](const sc2::Unit * u) { return (u->unit_type == unit_of_type || u->unit_type == equivalent_type) 
-			&& (u->build_progress == 1.0) && u->is_alive; });
-		int num_units = filtered_units.size();
+		std::unordered_set<Mob*> mobs = getMobsOfType(equivalent_type);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[](Mob* m) { return m->unit.build_progress == 1.0; });
 
 		// output to debug for checking conditions which are failing
 		if (debug && num_units < cond_value) {
@@ -741,13 +839,11 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	}
 
 	if (cond_type == COND::MAX_UNIT_OF_TYPE_NEAR_LOCATION) {
-		sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-		int num_units = count_if(units.begin(), units.end(),
-			[this, radius_sq](const sc2::Unit* u) {
-				return (u->unit_type == unit_of_type
-					&& u->is_alive
-					&& sc2::DistanceSquared2D(u->pos, location) < radius_sq)
-					&& (u->build_progress == 1.0);
+		std::unordered_set<Mob*> mobs = getMobsOfType(unit_of_type);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[this, radius_sq](Mob* m) {
+				return sc2::DistanceSquared2D(m->unit.pos, location) < radius_sq
+					&& (m->unit.build_progress == 1.0);
 			});
 
 		// output to debug for checking conditions which are failing
@@ -758,13 +854,11 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 		return (num_units <= cond_value) == is_true;
 	}
 	if (cond_type == COND::MIN_UNIT_OF_TYPE_NEAR_LOCATION) {
-		sc2::Units units = obs->GetUnits(sc2::Unit::Alliance::Self);
-		int num_units = count_if(units.begin(), units.end(),
-			[this, radius_sq](const sc2::Unit* u) {
-				return (u->unit_type == unit_of_type
-					&& u->is_alive
-					&& sc2::DistanceSquared2D(u->pos, location) < radius_sq)
-					&& (u->build_progress == 1.0);
+		std::unordered_set<Mob*> mobs = getMobsOfType(unit_of_type);
+		int num_units = std::count_if(mobs.begin(), mobs.end(),
+			[this, radius_sq](Mob* m) {
+				return sc2::DistanceSquared2D(m->unit.pos, location) < radius_sq
+					&& (m->unit.build_progress == 1.0);
 			});
 
 		// output to debug for checking conditions which are failing
@@ -777,13 +871,158 @@ bool Trigger::TriggerCondition::is_met(const sc2::ObservationInterface* obs) {
 	return false;
 }
 
+bool Trigger::TriggerCondition::onlyReadsObservation() {
+	// whether the result only depends on this step's observation, in which case executing
+	// a directive earlier in the step cannot change it
+	switch (cond_type) {
+	case COND::MIN_UNIT_WITH_FLAGS:
+	case COND::MAX_UNIT_WITH_FLAGS:
+	case COND::MIN_UNIT_WITH_FLAGS_NEAR_LOCATION:
+	case COND::MAX_UNIT_WITH_FLAGS_NEAR_LOCATION:
+	case COND::MAX_UNIT_OF_TYPE:
+	case COND::MIN_UNIT_OF_TYPE:
+	case COND::MAX_UNIT_OF_TYPE_NEAR_LOCATION:
+	case COND::MIN_UNIT_OF_TYPE_NEAR_LOCATION:
+	case COND::MAX_UNIT_OF_TYPE_TOTAL:
+	case COND::MIN_UNIT_OF_TYPE_TOTAL:
+	case COND::MAX_UNIT_OF_TYPE_UNDER_CONSTRUCTION:
+	case COND::MIN_UNIT_OF_TYPE_UNDER_CONSTRUCTION:
+	case COND::MAX_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION:
+	case COND::MIN_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION:
+	case COND::MAX_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION:
+	case COND::MIN_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION:
+	case COND::MAX_UNITS_IN_GROUP:
+	case COND::MIN_UNITS_IN_GROUP:
+	case COND::MAX_UNITS_OF_TYPE_IN_GROUP:
+	case COND::MIN_UNITS_OF_TYPE_IN_GROUP:
+	case COND::MAX_UNITS_IN_GROUP_NEAR_LOCATION:
+	case COND::MIN_UNITS_IN_GROUP_NEAR_LOCATION:
+	case COND::MAX_UNITS_USING_ABILITY:
+	case COND::MIN_UNITS_USING_ABILITY:
+	case COND::THREAT_EXISTS_NEAR_LOCATION:
+	case COND::BASE_IS_ACTIVE:
+	case COND::TIMER_1_SET:
+	case COND::TIMER_2_SET:
+	case COND::TIMER_3_SET:
+	case COND::TIMER_1_MIN_STEPS_PAST:
+	case COND::TIMER_1_MAX_STEPS_PAST:
+	case COND::TIMER_2_MIN_STEPS_PAST:
+	case COND::TIMER_2_MAX_STEPS_PAST:
+	case COND::TIMER_3_MIN_STEPS_PAST:
+	case COND::TIMER_3_MAX_STEPS_PAST:
+		return false;
+	case COND::HAS_ABILITY_READY:
+		// queries the game, which may only be done from the game thread
+		return false;
+	default:
+		return true;
+	}
+}
+
 void Trigger::TriggerCondition::setDebug(bool is_true) {
 	debug = is_true;
 }
 
+void Trigger::TriggerCondition::narrowTimeWindow(int* earliest_, int* latest_) {
+	// the game loops MIN_TIME and MAX_TIME allow, other conditions do not depend on the game loop alone
+	switch (cond_type) {
+	case COND::MIN_TIME:
+		if (is_true)
+			*earliest_ = std::max(*earliest_, (int)std::ceil(cond_value));
+		else
+			*latest_ = std::min(*latest_, (int)std::ceil(cond_value) - 1);
+		break;
+	case COND::MAX_TIME:
+		if (is_true)
+			*latest_ = std::min(*latest_, (int)std::floor(cond_value));
+		else
+			*earliest_ = std::max(*earliest_, (int)std::floor(cond_value) + 1);
+		break;
+	default:
+		break;
+	}
+}
+
+bool Trigger::TriggerCondition::addThreshold(ThresholdTable* table_, int group_) {
+	// false for conditions that are not a comparison of one number from the observation
+	if (!ThresholdTable::isThreshold(cond_type))
+		return false;
+	table_->addCondition(group_, cond_type, cond_value, is_true);
+	return true;
+}
+
+COND_COST Trigger::TriggerCondition::getCost() {
+	switch (cond_type) {
+	case COND::MIN_MINERALS:
+	case COND::MIN_GAS:
+	case COND::MIN_TIME:
+	case COND::MIN_FOOD:
+	case COND::MIN_FOOD_USED:
+	case COND::MIN_FOOD_CAP:
+	case COND::MIN_FOOD_ARMY:
+	case COND::MAX_FOOD_ARMY:
+	case COND::MAX_MINERALS:
+	case COND::MAX_GAS:
+	case COND::MAX_TIME:
+	case COND::MAX_FOOD:
+	case COND::MAX_FOOD_USED:
+	case COND::MAX_FOOD_CAP:
+	case COND::MIN_MINERALS_MINED:
+	case COND::MAX_MINERALS_MINED:
+	case COND::BASE_IS_ACTIVE:
+	case COND::HAVE_UPGRADE:
+	case COND::MAX_DEAD_MOBS:
+	case COND::MIN_DEAD_MOBS:
+	case COND::ENEMY_RACE_ZERG:
+	case COND::ENEMY_RACE_PROTOSS:
+	case COND::ENEMY_RACE_TERRAN:
+	case COND::ENEMY_RACE_UNKNOWN:
+	case COND::TIMER_1_SET:
+	case COND::TIMER_2_SET:
+	case COND::TIMER_3_SET:
+	case COND::TIMER_1_MIN_STEPS_PAST:
+	case COND::TIMER_1_MAX_STEPS_PAST:
+	case COND::TIMER_2_MIN_STEPS_PAST:
+	case COND::TIMER_2_MAX_STEPS_PAST:
+	case COND::TIMER_3_MIN_STEPS_PAST:
+	case COND::TIMER_3_MAX_STEPS_PAST:
+		return COND_COST::COUNTER;
+	case COND::MAX_UNIT_OF_TYPE_NEAR_LOCATION:
+	case COND::MIN_UNIT_OF_TYPE_NEAR_LOCATION:
+	case COND::MAX_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION:
+	case COND::MIN_UNIT_OF_TYPE_UNDER_CONSTRUCTION_NEAR_LOCATION:
+	case COND::MAX_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION:
+	case COND::MIN_UNIT_OF_TYPE_TOTAL_NEAR_LOCATION:
+	case COND::MIN_UNIT_WITH_FLAGS_NEAR_LOCATION:
+	case COND::MAX_UNIT_WITH_FLAGS_NEAR_LOCATION:
+	case COND::MAX_UNITS_IN_GROUP_NEAR_LOCATION:
+	case COND::MIN_UNITS_IN_GROUP_NEAR_LOCATION:
+	case COND::MAX_UNITS_USING_ABILITY:
+	case COND::MIN_UNITS_USING_ABILITY:
+	case COND::THREAT_EXISTS_NEAR_LOCATION:
+	case COND::MAX_ENEMY_UNITS_NEAR_LOCATION:
+	case COND::MIN_ENEMY_UNITS_NEAR_LOCATION:
+		return COND_COST::UNITS_NEAR;
+	case COND::HAS_ABILITY_READY:
+		return COND_COST::QUERY;
+	default:
+		return COND_COST::UNITS;
+	}
+}
+
+COND Trigger::TriggerCondition::getType() {
+	return cond_type;
+}
+
 Trigger::Trigger(BasicSc2Bot* agent_) {
 	agent = agent_;
 	debug = false;
+	threshold_group = NO_THRESHOLD_GROUP;
+	checks_until_rank = 0;
+	num_checks = 0;
+	num_threshold_rejected = 0;
+	num_evaluated = 0;
+	num_evaluated_declared = 0;
 };
 
 void Trigger::addCondition(TriggerCondition tc_) {
@@ -870,21 +1109,181 @@ void Trigger::addCondition(COND cond_type_, double cond_value_, sc2::UNIT_TYPEID
 	conditions.push_back(tc_);
 }
 
+void Trigger::addCondition(COND cond_type_, std::string group_name_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_) {
+	TriggerCondition tc_(agent, cond_type_, group_name_, cond_value_, unit_of_type_);
+	if (debug) {
+		tc_.setDebug(true);
+	}
+	conditions.push_back(tc_);
+}
+
+void Trigger::addCondition(COND cond_type_, std::string group_name_, double cond_value_, sc2::Point2D location_, float radius_) {
+	TriggerCondition tc_(agent, cond_type_, group_name_, cond_value_, location_, radius_);
+	if (debug) {
+		tc_.setDebug(true);
+	}
+	conditions.push_back(tc_);
+}
+
 
 bool Trigger::checkConditions() {
 	// Iterate through all conditions and return false if any are not met.
 	// Otherwise return true.
-	const sc2::ObservationInterface* obs = agent->Observation();
-	for (auto c_ : conditions) {
-		if (!c_.is_met(obs))
+	return checkConditions(true, true);
+}
+
+bool Trigger::checkObservationConditions() {
+	// only the conditions that depend on nothing but this step's observation,
+	// safe to check from the task pool
+	return checkConditions(true, false);
+}
+
+bool Trigger::checkBotStateConditions() {
+	// the conditions that read state a directive may change, or that need the game thread
+	return checkConditions(false, true);
+}
+
+bool Trigger::checkConditions(bool observation_, bool bot_state_) {
+	// all conditions must be met, so any order gives the same result, only the number checked changes.
+	// Every check starts with the observation conditions, so that is where checks are counted, and the
+	// order only changes between checks
+	if (check_order.size() != conditions.size()) {
+		rankConditions();
+	}
+	if (observation_) {
+		if (RANK_CONDITIONS_EVERY > 0 && !debug && checks_until_rank <= 0) {
+			rankConditions();
+		}
+		checks_until_rank--;
+		num_checks++;
+		if (threshold_group != NO_THRESHOLD_GROUP && !agent->thresholds->isMet(threshold_group)) {
+			num_threshold_rejected++;
 			return false;
+		}
+	}
+
+	const sc2::ObservationInterface* obs = agent->getObservation();
+	if (COUNT_DECLARED_ORDER) {
+		condition_met.assign(conditions.size(), -1);
+	}
+	bool passed = true;
+	for (int i : check_order) {
+		if (in_threshold_table[i])
+			continue;
+		TriggerCondition& c_ = conditions[i];
+		bool observation_only = c_.onlyReadsObservation();
+		if ((observation_only && !observation_) || (!observation_only && !bot_state_))
+			continue;
+		agent->prof->beginCondition(c_.getType());
+		bool met = c_.is_met(obs);
+		agent->prof->endCondition(met);
+		num_evaluated++;
+		condition_stats[i].evaluations++;
+		if (COUNT_DECLARED_ORDER) {
+			condition_met[i] = met;
+		}
+		if (!met) {
+			condition_stats[i].failures++;
+			passed = false;
+			break;
+		}
 	}
+	if (COUNT_DECLARED_ORDER) {
+		countDeclaredOrder(observation_, bot_state_);
+	}
+	if (!passed)
+		return false;
 	if (debug) {
 		std::cout << "[CONDS_PASSED]";
 	}
 	return true;
 }
 
+void Trigger::getTimeWindow(int* earliest_, int* latest_) {
+	// the first and last game loop all conditions can be met at, earliest_ is past latest_ if never
+	*earliest_ = 0;
+	*latest_ = NO_TIME_LIMIT;
+	for (auto& c_ : conditions) {
+		c_.narrowTimeWindow(earliest_, latest_);
+	}
+}
+
+void Trigger::countDeclaredOrder(bool observation_, bool bot_state_) {
+	// count what this phase of the check would have evaluated in the order the conditions were added,
+	// evaluating the ones the ranked order did not reach. Threshold conditions are left out of both counts
+	const sc2::ObservationInterface* obs = agent->getObservation();
+	for (size_t i = 0; i < conditions.size(); ++i) {
+		if (in_threshold_table[i])
+			continue;
+		bool observation_only = conditions[i].onlyReadsObservation();
+		if ((observation_only && !observation_) || (!observation_only && !bot_state_))
+			continue;
+		num_evaluated_declared++;
+		if (condition_met[i] == -1) {
+			condition_met[i] = conditions[i].is_met(obs);
+		}
+		if (!condition_met[i])
+			return;
+	}
+}
+
+void Trigger::rankConditions() {
+	// order by cost over the chance of failing, which minimizes the expected cost of finding one that fails.
+	// Debug triggers keep the order the conditions were added in, so their output reads the same
+	condition_stats.resize(conditions.size(), ConditionStats{ 0, 0 });
+	in_threshold_table.resize(conditions.size(), 0);
+	check_order.resize(conditions.size());
+	for (size_t i = 0; i < check_order.size(); ++i) {
+		check_order[i] = i;
+	}
+	checks_until_rank = RANK_CONDITIONS_EVERY;
+	if (RANK_CONDITIONS_EVERY <= 0 || debug)
+		return;
+
+	std::vector<double> rank(conditions.size());
+	for (size_t i = 0; i < conditions.size(); ++i) {
+		// a condition not seen yet counts as failing half the time
+		double fail_rate = (condition_stats[i].failures + 1.0) / (condition_stats[i].evaluations + 2.0);
+		rank[i] = (int)conditions[i].getCost() / fail_rate;
+		condition_stats[i].evaluations /= 2;
+		condition_stats[i].failures /= 2;
+	}
+	std::stable_sort(check_order.begin(), check_order.end(), [&rank](int a_, int b_) { return rank[a_] < rank[b_]; });
+}
+
+void Trigger::useThresholdTable(ThresholdTable* table_) {
+	// move the resource, supply and game loop conditions into one group of the table.
+	// Debug triggers keep checking them here, so their output still shows which failed
+	if (debug)
+		return;
+	in_threshold_table.assign(conditions.size(), 0);
+	for (size_t i = 0; i < conditions.size(); ++i) {
+		if (!ThresholdTable::isThreshold(conditions[i].getType()))
+			continue;
+		if (threshold_group == NO_THRESHOLD_GROUP) {
+			threshold_group = table_->addGroup();
+		}
+		conditions[i].addThreshold(table_, threshold_group);
+		in_threshold_table[i] = 1;
+	}
+}
+
+long long Trigger::getNumChecks() {
+	return num_checks;
+}
+
+long long Trigger::getNumThresholdRejected() {
+	return num_threshold_rejected;
+}
+
+long long Trigger::getNumEvaluated() {
+	return num_evaluated;
+}
+
+long long Trigger::getNumEvaluatedDeclared() {
+	return num_evaluated_declared;
+}
+
 void Trigger::setDebug(bool is_true)
 {
 	debug = is_true;
@@ -894,11 +1293,13 @@ BasicSc2Bot* Trigger::getAgent() {
 	return agent;
 }
 
-Precept::Precept(BasicSc2Bot* agent_) {
+Precept::Precept(BasicSc2Bot* agent_, std::string name_) {
 	agent = agent_;
 	debug = false;
 	has_directive = false;
 	has_trigger = false;
+	id = NO_SCOPE;
+	name = name_;
 }
 
 Precept::~Precept() {
@@ -911,10 +1312,14 @@ bool Precept::execute() {
 
 	assert(checkTriggerConditions());
 	bool any_executed = false;
+	long long trace_start = agent->tracer->now();
+	agent->prof->beginPreceptExecute(id);
 	for (auto d : directives) {
 		if (d->execute(agent))
 			any_executed = true;
 	}
+	agent->prof->endPreceptExecute(any_executed);
+	agent->tracer->span("precept_execute", trace_start, id);
 	return any_executed;
 }
 
@@ -940,11 +1345,46 @@ void Precept::addTrigger(Trigger trigger_) {
 	has_trigger = true;
 }
 
+void Precept::getTimeWindow(int* earliest_, int* latest_) {
+	// the first game loop any trigger can be met at, and the last, after which the precept can never execute again
+	*earliest_ = NO_TIME_LIMIT;
+	*latest_ = -1;
+	for (auto& t_ : triggers) {
+		int earliest;
+		int latest;
+		t_.getTimeWindow(&earliest, &latest);
+		if (earliest > latest)
+			continue;
+		*earliest_ = std::min(*earliest_, earliest);
+		*latest_ = std::max(*latest_, latest);
+	}
+}
+
+void Precept::countConditionChecks(long long* checks_, long long* rejected_, long long* evaluated_, long long* declared_) {
+	// adds the trigger checks of this precept, how many the threshold table rejected, and the conditions they evaluated
+	for (auto& t_ : triggers) {
+		*checks_ += t_.getNumChecks();
+		*rejected_ += t_.getNumThresholdRejected();
+		*evaluated_ += t_.getNumEvaluated();
+		*declared_ += t_.getNumEvaluatedDeclared();
+	}
+}
+
+void Precept::useThresholdTable(ThresholdTable* table_) {
+	for (auto& t_ : triggers) {
+		t_.useThresholdTable(table_);
+	}
+}
+
 void Precept::setDebug(bool is_true)
 {
 	debug = is_true;
 }
 
+bool Precept::isDebug() {
+	return debug;
+}
+
 bool Precept::hasDirective() {
 	return has_directive;
 }
@@ -953,10 +1393,62 @@ bool Precept::hasTrigger() {
 	return has_trigger;
 }
 
+void Precept::setID(int id_) {
+	id = id_;
+}
+
+int Precept::getID() {
+	return id;
+}
+
+std::string Precept::getName() {
+	return name;
+}
+
+void Precept::checkObservationConditions(std::vector<char>& passed_) {
+	// first phase of a two phase check, passed_ gets whether each trigger's
+	// observation conditions are met, which may be worked out on the task pool
+	long long trace_start = agent->tracer->now();
+	agent->prof->beginPreceptCheck(id);
+	passed_.assign(triggers.size(), 0);
+	bool any_passed = false;
+	for (size_t i = 0; i < triggers.size(); ++i) {
+		if (triggers[i].checkObservationConditions()) {
+			passed_[i] = 1;
+			any_passed = true;
+		}
+	}
+	agent->prof->endPreceptCheck(any_passed, false);
+	agent->tracer->span("precept_observe", trace_start, id);
+}
+
+bool Precept::checkTriggerConditions(const std::vector<char>& passed_) {
+	// second phase, on the game thread right before the precept would execute
+	long long trace_start = agent->tracer->now();
+	agent->prof->beginPreceptCheck(id);
+	for (size_t i = 0; i < triggers.size() && i < passed_.size(); ++i) {
+		if (passed_[i] && triggers[i].checkBotStateConditions()) {
+			agent->prof->endPreceptCheck(true);
+			agent->tracer->span("precept", trace_start, id);
+			return true;
+		}
+	}
+	agent->prof->endPreceptCheck(false);
+	agent->tracer->span("precept", trace_start, id);
+	return false;
+}
+
 bool Precept::checkTriggerConditions() {
-	for (Trigger t_ : triggers) {
-		if (t_.checkConditions())
+	long long trace_start = agent->tracer->now();
+	agent->prof->beginPreceptCheck(id);
+	for (auto& t_ : triggers) {
+		if (t_.checkConditions()) {
+			agent->prof->endPreceptCheck(true);
+			agent->tracer->span("precept", trace_start, id);
 			return true;
 		}
+	}
+	agent->prof->endPreceptCheck(false);
+	agent->tracer->span("precept", trace_start, id);
 	return false;
 }
\ No newline at end of file
@@ -7,11 +7,17 @@
 #include "sc2utils/sc2_arg_parser.h"
 #include "BasicSc2Bot.h"
 #include "Mob.h"
+#include <climits>
 
 # define DEFAULT_RADIUS 12.0f 
+# define NO_TIME_LIMIT INT_MAX // last game loop a trigger can be met at when it has no MAX_TIME
+# define RANK_CONDITIONS_EVERY 64 // checks of a trigger between reordering its conditions by cost and failure rate, 0 checks them in the order they were added
+# define COUNT_DECLARED_ORDER false // also count the conditions checking them in the order they were added would evaluate, evaluating any the ranked order skipped
 
 class BasicSc2Bot;
 class Directive;
+class Mob;
+class ThresholdTable;
 enum class FLAGS;
 
 enum class COND {
@@ -81,6 +87,14 @@ enum class COND {
 	TIMER_3_MAX_STEPS_PAST,
 };
 
+enum class COND_COST {
+	// rough relative cost of checking a kind of condition
+	COUNTER = 1,		// a number the observation or the bot already holds
+	UNITS = 8,			// walks our units or mobs once
+	UNITS_NEAR = 12,	// walks units and measures their distance to a location
+	QUERY = 32,			// asks the game
+};
+
 class Trigger {
 public:
 	class TriggerCondition;
@@ -97,7 +111,17 @@ public:
 	void addCondition(COND cond_type_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_, sc2::ABILITY_ID ability_, bool is_true_=true);
 	void addCondition(COND cond_type_, double cond_value_, std::unordered_set<FLAGS> flags_, sc2::Point2D location_, float radius_=DEFAULT_RADIUS);
 	void addCondition(COND cond_type_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_, sc2::Point2D location_, float radius_=DEFAULT_RADIUS);
+	void addCondition(COND cond_type_, std::string group_name_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_=sc2::UNIT_TYPEID::INVALID);
+	void addCondition(COND cond_type_, std::string group_name_, double cond_value_, sc2::Point2D location_, float radius_=DEFAULT_RADIUS);
 	bool checkConditions();
+	bool checkObservationConditions();
+	bool checkBotStateConditions();
+	void getTimeWindow(int* earliest_, int* latest_);
+	void useThresholdTable(ThresholdTable* table_);
+	long long getNumChecks();
+	long long getNumThresholdRejected();
+	long long getNumEvaluated();
+	long long getNumEvaluatedDeclared();
 	void setDebug(bool is_true=true);
 	BasicSc2Bot* getAgent();
 
@@ -113,11 +137,22 @@ public:
 		TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_, sc2::ABILITY_ID ability_, bool is_true_=true);
 		TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, double cond_value_, std::unordered_set<FLAGS> flags_, sc2::Point2D location_, float radius_=DEFAULT_RADIUS);
 		TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_, sc2::Point2D location_, float radius_=DEFAULT_RADIUS);
+		TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, std::string group_name_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_=sc2::UNIT_TYPEID::INVALID);
+		TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, std::string group_name_, double cond_value_, sc2::Point2D location_, float radius_=DEFAULT_RADIUS);
+		TriggerCondition(BasicSc2Bot* agent_, COND cond_type_, double cond_value_, sc2::UNIT_TYPEID unit_of_type_, sc2::ABILITY_ID ability_id_,
+			sc2::UPGRADE_ID upgrade_id_, std::unordered_set<FLAGS> flags_, sc2::Point2D location_, float radius_, bool is_true_);
 		bool is_met(const sc2::ObservationInterface* obs);
+		bool onlyReadsObservation();
+		void narrowTimeWindow(int* earliest_, int* latest_);
+		bool addThreshold(ThresholdTable* table_, int group_);
+		COND_COST getCost();
 		void setDebug(bool isTrue=true);
+		COND getType();
 
 
 	private:
+		std::unordered_set<Mob*> getMobsOfType(sc2::UNIT_TYPEID equivalent_type_);
+
 		COND cond_type;
 		double cond_value;
 		sc2::UNIT_TYPEID unit_of_type;
@@ -129,10 +164,30 @@ public:
 		sc2::UPGRADE_ID upgrade_id;
 		sc2::ABILITY_ID ability_id;
 		std::unordered_set<FLAGS> filter_flags;
+		std::string group_name;		// for the *_IN_GROUP conditions, see MobHandler::addMobToGroup()
 	};
 
 private:
-	std::vector<TriggerCondition> conditions;
+	bool checkConditions(bool observation_, bool bot_state_);
+	void rankConditions();
+	void countDeclaredOrder(bool observation_, bool bot_state_);
+
+	struct ConditionStats {
+		int evaluations;	// since the last ranking, halved at each ranking so older steps count for less
+		int failures;
+	};
+
+	std::vector<TriggerCondition> conditions;		// in the order they were added
+	std::vector<int> check_order;					// indices into conditions, cheapest and most likely to fail first
+	std::vector<ConditionStats> condition_stats;	// per condition
+	std::vector<char> in_threshold_table;			// per condition, checked through the threshold group instead
+	int threshold_group;
+	int checks_until_rank;
+	long long num_checks;
+	long long num_threshold_rejected;	// checks that failed in the threshold table, before any condition here was evaluated
+	long long num_evaluated;
+	long long num_evaluated_declared;	// what num_evaluated would be in the order the conditions were added, see COUNT_DECLARED_ORDER
+	std::vector<char> condition_met;	// per condition, 1 or 0 once evaluated in this phase of a check, -1 before
 	BasicSc2Bot* agent;
 	bool debug;
 };
@@ -141,15 +196,24 @@ class Precept {
 // Precepts are made up of one or more Directives
 // those of which get executed when all the TriggerConditions of the associated Trigger are satisfied
 public:
-	Precept(BasicSc2Bot* agent_);
+	Precept(BasicSc2Bot* agent_, std::string name_="");
 	~Precept();
 	bool execute();
 	bool checkTriggerConditions();
+	void checkObservationConditions(std::vector<char>& passed_);
+	bool checkTriggerConditions(const std::vector<char>& passed_);
+	void getTimeWindow(int* earliest_, int* latest_);
+	void countConditionChecks(long long* checks_, long long* rejected_, long long* evaluated_, long long* declared_);
+	void useThresholdTable(ThresholdTable* table_);
 	void setDebug(bool is_true=true);
+	bool isDebug();
 	void addTrigger(Trigger trigger_);
 	void addDirective(Directive directive_);
 	bool hasDirective();
 	bool hasTrigger();
+	void setID(int id_);
+	int getID();
+	std::string getName();
 
 protected:
 	BasicSc2Bot* agent;
@@ -158,4 +222,6 @@ protected:
 	bool has_directive;
 	bool has_trigger;
 	bool debug;
+	int id;	// assigned by the profiler when the precept is added to the bot
+	std::string name;
 };
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include "UnitCapture.h"
+#include "BasicSc2Bot.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+static uint64_t zigzag(int64_t v) {
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static void putVarint(std::vector<uint8_t>& out_, uint64_t v) {
+	while (v >= 0x80) {
+		out_.push_back((uint8_t)(v | 0x80));
+		v >>= 7;
+	}
+	out_.push_back((uint8_t)v);
+}
+
+class TokenColumn {
+// collapses runs of zero deltas into a single token, or into the value that follows them, see UnitCapture.h
+public:
+	TokenColumn() {
+		zeros = 0;
+	}
+	void put(int64_t v) {
+		if (v == 0) {
+			zeros++;
+			return;
+		}
+		if (zeros >> CAPTURE_GAP_BITS)
+			flush();
+		putVarint(bytes, ((zigzag(v) << CAPTURE_GAP_BITS) | zeros) << 1);
+		zeros = 0;
+	}
+	void flush() {
+		if (zeros > 0) {
+			putVarint(bytes, (zeros << 1) | 1);
+			zeros = 0;
+		}
+	}
+	std::vector<uint8_t> bytes;
+
+private:
+	uint64_t zeros;
+};
+
+static int64_t quantize(float v, float scale_) {
+	return (int64_t)std::lround(v * scale_);
+}
+
+UnitCapture::UnitCapture(BasicSc2Bot* agent_) {
+	agent = agent_;
+	offset = 0;
+	last_loop = 0;
+	steps_recorded = 0;
+}
+
+UnitCapture::~UnitCapture() {
+	finish();
+}
+
+bool UnitCapture::open(std::string filename_) {
+	out.open(filename_, std::ios::binary);
+	if (!out.is_open()) {
+		std::cout << "Unable to capture units to " << filename_ << std::endl;
+		return false;
+	}
+	CaptureFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "SC2CAP", 6);
+	header.version = CAPTURE_VERSION;
+	header.block_steps = CAPTURE_BLOCK_STEPS;
+	out.write((const char*)&header, sizeof(header));
+	offset = sizeof(header);
+	return true;
+}
+
+bool UnitCapture::isOpen() {
+	return out.is_open();
+}
+
+void UnitCapture::recordStep() {
+	// copy the units of this step into the current block, encoding only happens once the block is full
+	if (!out.is_open())
+		return;
+
+	const sc2::ObservationInterface* obs = agent->getObservation();
+	uint32_t game_loop = obs->GetGameLoop();
+	if (!step_loops.empty() && game_loop <= last_loop)
+		return;
+
+	sc2::Units units = obs->GetUnits();
+	size_t first_row = rows.size();
+	for (auto u : units) {
+		Row row;
+		row.tag = u->tag;
+		row.values[0] = (int64_t)u->unit_type;
+		row.values[1] = (int64_t)u->alliance;
+		row.values[2] = quantize(u->pos.x, CAPTURE_POS_SCALE);
+		row.values[3] = quantize(u->pos.y, CAPTURE_POS_SCALE);
+		row.values[4] = quantize(u->health, CAPTURE_HEALTH_SCALE);
+		row.values[5] = quantize(u->build_progress, CAPTURE_PROGRESS_SCALE);
+		row.first_order = (uint32_t)orders.size();
+		row.num_orders = (uint32_t)u->orders.size();
+		for (auto& o : u->orders) {
+			Order order;
+			order.ability = (uint32_t)o.ability_id;
+			order.target_tag = o.target_unit_tag;
+			order.x = (int32_t)quantize(o.target_pos.x, CAPTURE_POS_SCALE);
+			order.y = (int32_t)quantize(o.target_pos.y, CAPTURE_POS_SCALE);
+			orders.push_back(order);
+		}
+		rows.push_back(row);
+	}
+	std::sort(rows.begin() + first_row, rows.end(), [](const Row& a, const Row& b) { return a.tag < b.tag; });
+
+	step_loops.push_back(game_loop);
+	step_rows.push_back((uint32_t)(rows.size() - first_row));
+	last_loop = game_loop;
+	steps_recorded++;
+
+	if (step_loops.size() >= CAPTURE_BLOCK_STEPS) {
+		writeBlock();
+	}
+}
+
+void UnitCapture::finish() {
+	// write the last partial block and the block index, intended to be called OnGameEnd()
+	if (!out.is_open())
+		return;
+
+	writeBlock();
+
+	CaptureTrailer trailer;
+	std::memset(&trailer, 0, sizeof(trailer));
+	trailer.index_offset = offset;
+	trailer.num_blocks = (uint32_t)index.size();
+	std::memcpy(trailer.magic, "CAPX", 4);
+	if (!index.empty()) {
+		out.write((const char*)index.data(), index.size() * sizeof(CaptureBlockIndex));
+	}
+	out.write((const char*)&trailer, sizeof(trailer));
+	out.close();
+	std::cout << "Captured " << steps_recorded << " steps of units in " << index.size() << " blocks." << std::endl;
+}
+
+bool UnitCapture::sameOrders(const Row& a, const Row& b) {
+	if (a.num_orders != b.num_orders)
+		return false;
+	for (uint32_t i = 0; i < a.num_orders; ++i) {
+		const Order& oa = orders[a.first_order + i];
+		const Order& ob = orders[b.first_order + i];
+		if (oa.ability != ob.ability || oa.target_tag != ob.target_tag || oa.x != ob.x || oa.y != ob.y)
+			return false;
+	}
+	return true;
+}
+
+void UnitCapture::writeBlock() {
+	// encode the buffered steps column by column, deltas restart at every block
+	if (step_loops.empty())
+		return;
+
+	std::vector<uint64_t> tags;
+	tags.reserve(rows.size());
+	for (auto& r : rows) {
+		tags.push_back(r.tag);
+	}
+	std::sort(tags.begin(), tags.end());
+	tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+
+	TokenColumn columns[CAPTURE_NUM_COLUMNS - 1];
+	std::vector<uint8_t> order_bytes;
+	std::vector<int64_t> previous(tags.size() * 6, 0);
+	std::vector<Row> previous_orders(tags.size());
+	for (auto& p : previous_orders) {
+		p.num_orders = 0;
+		p.first_order = 0;
+	}
+
+	int64_t prev_loop = (int64_t)step_loops.front() - 1;
+	size_t row = 0;
+	for (size_t s = 0; s < step_loops.size(); ++s) {
+		columns[CAPTURE_STEP_LOOP].put(step_loops[s] - prev_loop - 1);
+		columns[CAPTURE_STEP_ROWS].put(step_rows[s]);
+		prev_loop = step_loops[s];
+
+		int64_t prev_index = -1;
+		for (uint32_t i = 0; i < step_rows[s]; ++i, ++row) {
+			const Row& r = rows[row];
+			int64_t t = std::lower_bound(tags.begin(), tags.end(), r.tag) - tags.begin();
+			columns[CAPTURE_TAG].put(t - prev_index - 1);
+			prev_index = t;
+
+			int64_t* prev = &previous[t * 6];
+			for (int v = 0; v < 6; ++v) {
+				columns[CAPTURE_TYPE + v].put(r.values[v] - prev[v]);
+				prev[v] = r.values[v];
+			}
+
+			if (sameOrders(r, previous_orders[t])) {
+				columns[CAPTURE_ORDERS_CHANGED].put(0);
+				continue;
+			}
+			columns[CAPTURE_ORDERS_CHANGED].put(1);
+			previous_orders[t] = r;
+			putVarint(order_bytes, r.num_orders);
+			for (uint32_t o = 0; o < r.num_orders; ++o) {
+				const Order& order = orders[r.first_order + o];
+				putVarint(order_bytes, order.ability);
+				putVarint(order_bytes, order.target_tag);
+				putVarint(order_bytes, zigzag(order.x));
+				putVarint(order_bytes, zigzag(order.y));
+			}
+		}
+	}
+
+	CaptureBlockHeader header;
+	std::memset(&header, 0, sizeof(header));
+	header.first_loop = step_loops.front();
+	header.num_steps = (uint32_t)step_loops.size();
+	header.num_rows = (uint32_t)rows.size();
+	header.num_tags = (uint32_t)tags.size();
+	for (int c = 0; c < CAPTURE_NUM_COLUMNS - 1; ++c) {
+		columns[c].flush();
+		header.column_bytes[c] = (uint32_t)columns[c].bytes.size();
+	}
+	header.column_bytes[CAPTURE_ORDERS] = (uint32_t)order_bytes.size();
+
+	CaptureBlockIndex entry;
+	entry.offset = offset;
+	entry.first_loop = step_loops.front();
+	entry.last_loop = step_loops.back();
+	entry.num_steps = header.num_steps;
+	entry.num_rows = header.num_rows;
+	index.push_back(entry);
+
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)tags.data(), tags.size() * sizeof(uint64_t));
+	offset += sizeof(header) + tags.size() * sizeof(uint64_t);
+	for (int c = 0; c < CAPTURE_NUM_COLUMNS - 1; ++c) {
+		out.write((const char*)columns[c].bytes.data(), columns[c].bytes.size());
+		offset += columns[c].bytes.size();
+	}
+	out.write((const char*)order_bytes.data(), order_bytes.size());
+	offset += order_bytes.size();
+
+	// the next block, or the index, starts 8 byte aligned so the reader can use it in place
+	static const char padding[8] = { 0 };
+	size_t pad = (8 - offset % 8) % 8;
+	out.write(padding, pad);
+	offset += pad;
+
+	step_loops.clear();
+	step_rows.clear();
+	rows.clear();
+	orders.clear();
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+# define CAPTURE_UNITS false // append a compact per-step unit snapshot to CAPTURE_FILE, readable with UnitCaptureReader
+# define CAPTURE_FILE "units.cap" // file unit snapshots are captured to
+# define CAPTURE_VERSION 2 // bumped whenever the capture layout changes
+# define CAPTURE_BLOCK_STEPS 256 // steps per block, a block is the unit of random access
+# define CAPTURE_GAP_BITS 3 // a value token also stands for up to 7 zeros in front of it
+# define CAPTURE_POS_SCALE 256.0F // positions are stored in 1/256ths of a cell
+# define CAPTURE_HEALTH_SCALE 16.0F // health is stored in 1/16ths of a hit point
+# define CAPTURE_PROGRESS_SCALE 10000.0F // build progress is stored in 1/10000ths
+
+class BasicSc2Bot;
+
+// Capture file layout, all integers little endian:
+//
+//   CaptureFileHeader
+//   block 0 ... block n-1		each block starts on an 8 byte boundary
+//   CaptureBlockIndex[n]
+//   CaptureTrailer
+//
+// A block holds CAPTURE_BLOCK_STEPS consecutive steps and is decoded on its own, so any
+// game loop can be reached by decoding at most one block. A block is laid out as
+//
+//   CaptureBlockHeader
+//   uint64_t tags[num_tags]		sorted tags of every unit seen in the block
+//   column 0 ... column CAPTURE_NUM_COLUMNS-1
+//
+// Each row of a step is one unit, sorted by tag. Values are deltas from the previous value of
+// the same unit in the block, so a unit that did not change costs nothing. Columns other than
+// ORDERS are sequences of varint tokens: an odd token t is a run of t>>1 zeros, an even token t
+// is the zigzag encoded value t>>(CAPTURE_GAP_BITS+1) after (t>>1) & 7 zeros, so a short run of
+// unchanged units costs no token of its own. ORDERS holds plain varints, and is only written for
+// rows whose ORDERS_CHANGED value is 1: count, then ability, target tag, x, y for each order.
+
+enum CAPTURE_COLUMN {
+	CAPTURE_STEP_LOOP,		// game loop - previous game loop - 1, per step
+	CAPTURE_STEP_ROWS,		// number of units, per step
+	CAPTURE_TAG,			// index into the block tags - previous index - 1, per row
+	CAPTURE_TYPE,
+	CAPTURE_ALLIANCE,
+	CAPTURE_X,
+	CAPTURE_Y,
+	CAPTURE_HEALTH,
+	CAPTURE_PROGRESS,
+	CAPTURE_ORDERS_CHANGED,
+	CAPTURE_ORDERS,
+	CAPTURE_NUM_COLUMNS
+};
+
+struct CaptureFileHeader {
+	char magic[8];			// "SC2CAP\0\0"
+	uint32_t version;
+	uint32_t block_steps;
+};
+
+struct CaptureBlockHeader {
+	uint32_t first_loop;
+	uint32_t num_steps;
+	uint32_t num_rows;
+	uint32_t num_tags;
+	uint32_t column_bytes[CAPTURE_NUM_COLUMNS];
+	uint32_t reserved;		// keeps the tags that follow 8 byte aligned
+};
+
+struct CaptureBlockIndex {
+	uint64_t offset;
+	uint32_t first_loop;
+	uint32_t last_loop;
+	uint32_t num_steps;
+	uint32_t num_rows;
+};
+
+struct CaptureTrailer {
+	uint64_t index_offset;
+	uint32_t num_blocks;
+	char magic[4];			// "CAPX"
+};
+
+class UnitCapture {
+// Appends the tag, type, alliance, position, health, build progress and orders of every
+// observed unit to a columnar, delta encoded capture file. Steps are copied into flat
+// buffers and only encoded once a block is full, so recordStep() does no i/o
+public:
+	UnitCapture(BasicSc2Bot* agent_);
+	~UnitCapture();
+	bool open(std::string filename_);
+	bool isOpen();
+	void recordStep();
+	void finish();
+
+private:
+	struct Row {
+		uint64_t tag;
+		int64_t values[6];	// type, alliance, x, y, health, progress
+		uint32_t first_order;
+		uint32_t num_orders;
+	};
+
+	struct Order {
+		uint32_t ability;
+		uint64_t target_tag;
+		int32_t x;
+		int32_t y;
+	};
+
+	void writeBlock();
+	bool sameOrders(const Row& a, const Row& b);
+
+	BasicSc2Bot* agent;
+	std::ofstream out;
+	uint64_t offset;					// bytes written so far
+	std::vector<CaptureBlockIndex> index;
+
+	// the block being filled
+	std::vector<uint32_t> step_loops;
+	std::vector<uint32_t> step_rows;
+	std::vector<Row> rows;
+	std::vector<Order> orders;
+	uint32_t last_loop;
+	int steps_recorded;
+};
@@ -0,0 +1,510 @@
+#include "UnitCaptureReader.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static int64_t unzigzag(uint64_t v) {
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+class VarintReader {
+// reads varints until end_, after which it returns zeros and reports an error
+public:
+	VarintReader(const uint8_t* begin_=nullptr, const uint8_t* end_=nullptr) {
+		p = begin_;
+		end = end_;
+		error = false;
+	}
+	uint64_t next() {
+		// most deltas fit in one or two bytes
+		if (p + 1 < end && p[1] < 0x80) {
+			if (*p < 0x80)
+				return *p++;
+			uint64_t v = (uint64_t)(p[0] & 0x7F) | ((uint64_t)p[1] << 7);
+			p += 2;
+			return v;
+		}
+		if (p < end && *p < 0x80)
+			return *p++;
+		uint64_t v = 0;
+		int shift = 0;
+		while (p < end && shift < 64) {
+			uint8_t b = *p++;
+			v |= (uint64_t)(b & 0x7F) << shift;
+			if (!(b & 0x80))
+				return v;
+			shift += 7;
+		}
+		error = true;
+		return 0;
+	}
+	bool error;
+
+private:
+	const uint8_t* p;
+	const uint8_t* end;
+};
+
+class TokenReader {
+// expands the zero runs written by TokenColumn in UnitCapture.cpp
+public:
+	TokenReader(const uint8_t* begin_=nullptr, const uint8_t* end_=nullptr) : in(begin_, end_) {
+		zeros = 0;
+		value = 0;
+		has_value = false;
+	}
+	int64_t next() {
+		if (zeros == 0 && !has_value)
+			readToken();
+		if (zeros > 0) {
+			zeros--;
+			return 0;
+		}
+		has_value = false;
+		return value;
+	}
+	size_t skipZeros(size_t n_) {
+		// consumes up to n_ zeros, stopping in front of the next non-zero value
+		size_t skipped = 0;
+		while (skipped < n_) {
+			if (zeros > 0) {
+				uint64_t k = std::min<uint64_t>(zeros, n_ - skipped);
+				zeros -= k;
+				skipped += (size_t)k;
+				continue;
+			}
+			if (has_value || in.error)
+				break;
+			readToken();
+		}
+		return skipped;
+	}
+	size_t addTo(int64_t* values_, const uint32_t* rows_, size_t n_, uint32_t* changed_) {
+		// adds the next n_ deltas to values_[rows_[i]] and lists each i that changed in changed_, returning how many did
+		// a run of zeros is skipped in one go
+		size_t i = 0;
+		size_t num_changed = 0;
+		while (i < n_) {
+			if (zeros == 0 && !has_value) {
+				if (in.error)
+					break;
+				readToken();
+			}
+			if (zeros >= n_ - i) {
+				zeros -= n_ - i;
+				break;
+			}
+			i += (size_t)zeros;
+			zeros = 0;
+			if (has_value) {
+				values_[rows_[i]] += value;
+				has_value = false;
+				changed_[num_changed++] = (uint32_t)i++;
+			}
+		}
+		return num_changed;
+	}
+	bool hasError() {
+		return in.error;
+	}
+
+private:
+	void readToken() {
+		// a run of zeros, or a value with the few zeros in front of it
+		uint64_t t = in.next();
+		if (t & 1) {
+			zeros = t >> 1;
+			return;
+		}
+		zeros = (t >> 1) & ((1 << CAPTURE_GAP_BITS) - 1);
+		value = unzigzag(t >> (CAPTURE_GAP_BITS + 1));
+		has_value = true;
+	}
+
+	VarintReader in;
+	uint64_t zeros;		// still to be returned before value
+	int64_t value;
+	bool has_value;
+};
+
+UnitCaptureReader::UnitCaptureReader() {
+	data = nullptr;
+	size = 0;
+	index = nullptr;
+	num_blocks = 0;
+	num_steps = 0;
+	num_changed = 0;
+#ifdef _WIN32
+	file_handle = INVALID_HANDLE_VALUE;
+	mapping_handle = nullptr;
+#else
+	fd = -1;
+#endif
+}
+
+UnitCaptureReader::~UnitCaptureReader() {
+	close();
+}
+
+bool UnitCaptureReader::open(std::string filename_) {
+	// map the whole file and check that the header, index and trailer agree
+	close();
+#ifdef _WIN32
+	file_handle = CreateFileA(filename_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file_handle == INVALID_HANDLE_VALUE) {
+		std::cout << "Unable to open capture " << filename_ << std::endl;
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(file_handle, &file_size);
+	size = (size_t)file_size.QuadPart;
+	if (size > 0) {
+		mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_handle) {
+			data = (const uint8_t*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+		}
+	}
+#else
+	fd = ::open(filename_.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cout << "Unable to open capture " << filename_ << std::endl;
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		size = (size_t)st.st_size;
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED) {
+			data = (const uint8_t*)mapped;
+		}
+	}
+#endif
+	if (!data || size < sizeof(CaptureFileHeader) + sizeof(CaptureTrailer)) {
+		std::cout << "Capture " << filename_ << " is empty or unreadable" << std::endl;
+		close();
+		return false;
+	}
+
+	const CaptureFileHeader* header = (const CaptureFileHeader*)data;
+	const CaptureTrailer* trailer = (const CaptureTrailer*)(data + size - sizeof(CaptureTrailer));
+	if (std::memcmp(header->magic, "SC2CAP", 6) != 0 || header->version != CAPTURE_VERSION || std::memcmp(trailer->magic, "CAPX", 4) != 0) {
+		std::cout << "Capture " << filename_ << " was not finished, or was written by another version" << std::endl;
+		close();
+		return false;
+	}
+	if (trailer->index_offset % 8 != 0 || trailer->index_offset + (uint64_t)trailer->num_blocks * sizeof(CaptureBlockIndex) + sizeof(CaptureTrailer) != size) {
+		std::cout << "Capture " << filename_ << " has a damaged block index" << std::endl;
+		close();
+		return false;
+	}
+
+	index = (const CaptureBlockIndex*)(data + trailer->index_offset);
+	num_blocks = (int)trailer->num_blocks;
+	num_steps = 0;
+	for (int b = 0; b < num_blocks; ++b) {
+		num_steps += index[b].num_steps;
+	}
+	return true;
+}
+
+void UnitCaptureReader::close() {
+#ifdef _WIN32
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mapping_handle) {
+		CloseHandle(mapping_handle);
+	}
+	if (file_handle != INVALID_HANDLE_VALUE) {
+		CloseHandle(file_handle);
+	}
+	mapping_handle = nullptr;
+	file_handle = INVALID_HANDLE_VALUE;
+#else
+	if (data) {
+		munmap((void*)data, size);
+	}
+	if (fd >= 0) {
+		::close(fd);
+	}
+	fd = -1;
+#endif
+	data = nullptr;
+	size = 0;
+	index = nullptr;
+	num_blocks = 0;
+	num_steps = 0;
+}
+
+bool UnitCaptureReader::isOpen() {
+	return data != nullptr;
+}
+
+size_t UnitCaptureReader::getFileSize() {
+	return size;
+}
+
+int UnitCaptureReader::getNumBlocks() {
+	return num_blocks;
+}
+
+int UnitCaptureReader::getNumSteps() {
+	return num_steps;
+}
+
+uint32_t UnitCaptureReader::getFirstLoop() {
+	if (num_blocks == 0)
+		return 0;
+	return index[0].first_loop;
+}
+
+uint32_t UnitCaptureReader::getLastLoop() {
+	if (num_blocks == 0)
+		return 0;
+	return index[num_blocks - 1].last_loop;
+}
+
+const CaptureBlockHeader* UnitCaptureReader::blockHeader(int block_) {
+	// nullptr if the block would run past the block index
+	uint64_t offset = index[block_].offset;
+	const uint8_t* index_start = (const uint8_t*)index;
+	if (offset % 8 != 0 || data + offset + sizeof(CaptureBlockHeader) > index_start)
+		return nullptr;
+	const CaptureBlockHeader* header = (const CaptureBlockHeader*)(data + offset);
+	uint64_t block_size = sizeof(CaptureBlockHeader) + (uint64_t)header->num_tags * sizeof(uint64_t);
+	for (int c = 0; c < CAPTURE_NUM_COLUMNS; ++c) {
+		block_size += header->column_bytes[c];
+	}
+	if (data + offset + block_size > index_start)
+		return nullptr;
+	return header;
+}
+
+bool UnitCaptureReader::blockHasTag(int block_, uint64_t tag_) {
+	// binary search over the tags of the block, straight from the mapping
+	const CaptureBlockHeader* header = blockHeader(block_);
+	if (!header)
+		return false;
+	const uint64_t* tags = (const uint64_t*)(header + 1);
+	return std::binary_search(tags, tags + header->num_tags, tag_);
+}
+
+bool UnitCaptureReader::decodeBlock(int block_, uint32_t columns_, std::function<bool(const CaptureStep&)> visit_) {
+	// calls visit_ with every step of the block in order, until it returns false
+	// columns not in columns_ are never decoded, and their fields are left zero
+	const CaptureBlockHeader* header = blockHeader(block_);
+	if (!header)
+		return false;
+
+	const uint64_t* tags = (const uint64_t*)(header + 1);
+	const uint8_t* p = (const uint8_t*)(tags + header->num_tags);
+	TokenReader columns[CAPTURE_NUM_COLUMNS - 1];
+	for (int c = 0; c < CAPTURE_NUM_COLUMNS - 1; ++c) {
+		columns[c] = TokenReader(p, p + header->column_bytes[c]);
+		p += header->column_bytes[c];
+	}
+	VarintReader order_bytes(p, p + header->column_bytes[CAPTURE_ORDERS]);
+
+	// values are kept column by column, so that each column is decoded for a whole step at a time
+	// the orders of the block are decoded once into the step's orders and referred to from there
+	size_t num_tags = header->num_tags;
+	previous.assign(num_tags * 6, 0);
+	previous_first.assign(num_tags, 0);
+	previous_count.assign(num_tags, 0);
+	scratch.units.clear();
+	scratch.orders.clear();
+
+	int64_t game_loop = (int64_t)header->first_loop - 1;
+	for (uint32_t s = 0; s < header->num_steps; ++s) {
+		game_loop += columns[CAPTURE_STEP_LOOP].next() + 1;
+		int64_t num_rows = columns[CAPTURE_STEP_ROWS].next();
+		if (num_rows < 0 || num_rows > header->num_rows)
+			return false;
+		size_t n = (size_t)num_rows;
+
+		// a zero tag delta is the next tag of the block, which is how most rows are stored
+		// while the rows are the same units as the last step, only the rows that changed are copied out below
+		bool same_rows = n == scratch.units.size();
+		row_tags.resize(n);
+		int64_t t = -1;
+		for (size_t r = 0; r < n;) {
+			size_t run = columns[CAPTURE_TAG].skipZeros(n - r);
+			if (t + (int64_t)run >= (int64_t)num_tags)
+				return false;
+			// row tags are increasing, so if both ends of the run are where they were the whole run is
+			if (same_rows && run > 0 && row_tags[r] == (uint32_t)(t + 1) && row_tags[r + run - 1] == (uint32_t)(t + run)) {
+				r += run;
+				t += run;
+				continue;
+			}
+			same_rows = same_rows && run == 0;
+			for (size_t i = 0; i < run; ++i) {
+				row_tags[r++] = (uint32_t)++t;
+			}
+			if (r < n) {
+				t += columns[CAPTURE_TAG].next() + 1;
+				if (t < 0 || t >= (int64_t)num_tags)
+					return false;
+				same_rows = same_rows && row_tags[r] == (uint32_t)t;
+				row_tags[r++] = (uint32_t)t;
+			}
+		}
+		changed_rows.resize(n);
+		for (int c = CAPTURE_TYPE; c < CAPTURE_ORDERS_CHANGED; ++c) {
+			if (!(columns_ & (1 << c)))
+				continue;
+			num_changed = columns[c].addTo(&previous[num_tags * (c - CAPTURE_TYPE)], row_tags.data(), n, changed_rows.data());
+			if (same_rows)
+				copyColumn(c, tags);
+		}
+
+		TokenReader& orders_changed = columns[CAPTURE_ORDERS_CHANGED];
+		size_t first_changed = (columns_ & (1 << CAPTURE_ORDERS)) ? orders_changed.skipZeros(n) : n;
+		for (size_t r = first_changed; r < n; r += 1 + orders_changed.skipZeros(n - r - 1)) {
+			if (!orders_changed.next())
+				continue;
+			uint32_t tag = row_tags[r];
+			previous_first[tag] = (uint32_t)scratch.orders.size();
+			previous_count[tag] = (uint32_t)order_bytes.next();
+			for (uint32_t o = 0; o < previous_count[tag] && !order_bytes.error; ++o) {
+				CapturedOrder order;
+				order.ability = (uint32_t)order_bytes.next();
+				order.target_tag = order_bytes.next();
+				order.x = unzigzag(order_bytes.next()) / CAPTURE_POS_SCALE;
+				order.y = unzigzag(order_bytes.next()) / CAPTURE_POS_SCALE;
+				scratch.orders.push_back(order);
+			}
+			if (order_bytes.error)
+				return false;
+			if (same_rows) {
+				scratch.units[r].first_order = previous_first[tag];
+				scratch.units[r].num_orders = previous_count[tag];
+			}
+		}
+
+		for (int c = 0; c < CAPTURE_NUM_COLUMNS - 1; ++c) {
+			if (columns[c].hasError())
+				return false;
+		}
+
+		scratch.game_loop = (uint32_t)game_loop;
+		if (!same_rows) {
+			scratch.units.resize(n);
+			num_changed = n;
+			for (size_t r = 0; r < n; ++r) {
+				changed_rows[r] = (uint32_t)r;
+				scratch.units[r].first_order = previous_first[row_tags[r]];
+				scratch.units[r].num_orders = previous_count[row_tags[r]];
+			}
+			for (int c = CAPTURE_TAG; c < CAPTURE_ORDERS_CHANGED; ++c) {
+				if (c == CAPTURE_TAG || (columns_ & (1 << c)))
+					copyColumn(c, tags);
+			}
+		}
+		for (auto& unit : scratch.units) {
+			unit.game_loop = (uint32_t)game_loop;
+		}
+
+		if (!visit_(scratch))
+			break;
+	}
+	return true;
+}
+
+void UnitCaptureReader::copyColumn(int column_, const uint64_t* tags_) {
+	// copies one column of the rows in changed_rows from previous into the step
+	size_t num_tags = previous_first.size();
+	const int64_t* values = column_ == CAPTURE_TAG ? nullptr : &previous[num_tags * (column_ - CAPTURE_TYPE)];
+	CapturedUnit* units = scratch.units.data();
+	const uint32_t* rows = changed_rows.data();
+	switch (column_) {
+	case CAPTURE_TAG:
+		for (size_t i = 0; i < num_changed; ++i)
+			units[rows[i]].tag = tags_[row_tags[rows[i]]];
+		break;
+	case CAPTURE_TYPE:
+		for (size_t i = 0; i < num_changed; ++i)
+			units[rows[i]].unit_type = (uint32_t)values[row_tags[rows[i]]];
+		break;
+	case CAPTURE_ALLIANCE:
+		for (size_t i = 0; i < num_changed; ++i)
+			units[rows[i]].alliance = (int)values[row_tags[rows[i]]];
+		break;
+	case CAPTURE_X:
+		for (size_t i = 0; i < num_changed; ++i)
+			units[rows[i]].x = values[row_tags[rows[i]]] / CAPTURE_POS_SCALE;
+		break;
+	case CAPTURE_Y:
+		for (size_t i = 0; i < num_changed; ++i)
+			units[rows[i]].y = values[row_tags[rows[i]]] / CAPTURE_POS_SCALE;
+		break;
+	case CAPTURE_HEALTH:
+		for (size_t i = 0; i < num_changed; ++i)
+			units[rows[i]].health = values[row_tags[rows[i]]] / CAPTURE_HEALTH_SCALE;
+		break;
+	case CAPTURE_PROGRESS:
+		for (size_t i = 0; i < num_changed; ++i)
+			units[rows[i]].build_progress = values[row_tags[rows[i]]] / CAPTURE_PROGRESS_SCALE;
+		break;
+	}
+}
+
+bool UnitCaptureReader::readStep(uint32_t game_loop_, CaptureStep& step_) {
+	// the last captured step at or before game_loop_, decoding only the block that holds it
+	if (num_blocks == 0 || game_loop_ < index[0].first_loop)
+		return false;
+	const CaptureBlockIndex* block = std::upper_bound(index, index + num_blocks, game_loop_,
+		[](uint32_t loop, const CaptureBlockIndex& b) { return loop < b.first_loop; }) - 1;
+
+	bool found = false;
+	bool ok = decodeBlock((int)(block - index), CAPTURE_ALL_COLUMNS, [&](const CaptureStep& step) {
+		if (step.game_loop > game_loop_)
+			return false;
+		step_ = step;
+		found = true;
+		return step.game_loop < game_loop_;
+	});
+	return ok && found;
+}
+
+bool UnitCaptureReader::readUnit(uint64_t tag_, std::vector<CapturedUnit>& history_, std::vector<CapturedOrder>& orders_) {
+	// every captured snapshot of one unit, blocks that never saw it are skipped without decoding
+	history_.clear();
+	orders_.clear();
+	for (int b = 0; b < num_blocks; ++b) {
+		if (!blockHasTag(b, tag_))
+			continue;
+		bool ok = decodeBlock(b, CAPTURE_ALL_COLUMNS, [&](const CaptureStep& step) {
+			auto it = std::lower_bound(step.units.begin(), step.units.end(), tag_,
+				[](const CapturedUnit& u, uint64_t tag) { return u.tag < tag; });
+			if (it == step.units.end() || it->tag != tag_)
+				return true;
+			CapturedUnit unit = *it;
+			unit.first_order = (uint32_t)orders_.size();
+			orders_.insert(orders_.end(), step.orders.begin() + it->first_order, step.orders.begin() + it->first_order + it->num_orders);
+			history_.push_back(unit);
+			return true;
+		});
+		if (!ok)
+			return false;
+	}
+	return !history_.empty();
+}
+
+void UnitCaptureReader::scan(std::function<void(const CaptureStep&)> visit_, uint32_t columns_) {
+	// every step of the game in order, with only the fields of columns_ filled in
+	for (int b = 0; b < num_blocks; ++b) {
+		decodeBlock(b, columns_, [&](const CaptureStep& step) {
+			visit_(step);
+			return true;
+		});
+	}
+}
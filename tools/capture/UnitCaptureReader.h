@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "UnitCapture.h"
+
+# define CAPTURE_ALL_COLUMNS ((1 << CAPTURE_NUM_COLUMNS) - 1) // column mask of UnitCaptureReader::scan(), bit 1 << CAPTURE_X for x and so on
+
+struct CapturedOrder {
+	uint32_t ability;
+	uint64_t target_tag;
+	float x;
+	float y;
+};
+
+struct CapturedUnit {
+	uint32_t game_loop;
+	uint64_t tag;
+	uint32_t unit_type;
+	int alliance;		// sc2::Unit::Alliance
+	float x;
+	float y;
+	float health;
+	float build_progress;
+	uint32_t first_order;	// index into the orders of the step, or of the history
+	uint32_t num_orders;
+};
+
+struct CaptureStep {
+	uint32_t game_loop;
+	std::vector<CapturedUnit> units;	// sorted by tag
+	std::vector<CapturedOrder> orders;	// referred to by the units, may also hold orders of earlier steps
+};
+
+class UnitCaptureReader {
+// Reads a file written by UnitCapture through a read-only memory mapping. The block index
+// and the tags of each block are used in place, and a block is only decoded when a step
+// inside it is asked for
+public:
+	UnitCaptureReader();
+	~UnitCaptureReader();
+	bool open(std::string filename_);
+	void close();
+	bool isOpen();
+	size_t getFileSize();
+	int getNumBlocks();
+	int getNumSteps();
+	uint32_t getFirstLoop();
+	uint32_t getLastLoop();
+
+	bool readStep(uint32_t game_loop_, CaptureStep& step_);
+	bool readUnit(uint64_t tag_, std::vector<CapturedUnit>& history_, std::vector<CapturedOrder>& orders_);
+	void scan(std::function<void(const CaptureStep&)> visit_, uint32_t columns_=CAPTURE_ALL_COLUMNS);
+
+private:
+	const CaptureBlockHeader* blockHeader(int block_);
+	bool blockHasTag(int block_, uint64_t tag_);
+	bool decodeBlock(int block_, uint32_t columns_, std::function<bool(const CaptureStep&)> visit_);
+	void copyColumn(int column_, const uint64_t* tags_);
+
+	const uint8_t* data;
+	size_t size;
+	const CaptureBlockIndex* index;
+	int num_blocks;
+	int num_steps;
+
+	// reused between blocks, so decoding does not allocate once they have grown
+	CaptureStep scratch;
+	std::vector<uint32_t> row_tags;			// index into the block tags of each row of the step
+	std::vector<uint32_t> changed_rows;		// rows of the step whose current column changed, the first num_changed of them
+	size_t num_changed;
+	std::vector<int64_t> previous;			// last value of each column for each tag of the block, column by column
+	std::vector<uint32_t> previous_first;	// last orders of each tag, as a range of scratch.orders
+	std::vector<uint32_t> previous_count;
+#ifdef _WIN32
+	void* file_handle;
+	void* mapping_handle;
+#else
+	int fd;
+#endif
+};
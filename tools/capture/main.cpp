@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include "UnitCaptureReader.h"
+
+// Summarises a capture made with CAPTURE_UNITS, timing a full scan, and optionally lists one step
+// usage: CaptureInspect <capture> [game_loop]
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cout << "usage: " << argv[0] << " <capture> [game_loop]" << std::endl;
+		return 1;
+	}
+
+	UnitCaptureReader reader;
+	if (!reader.open(argv[1]))
+		return 1;
+
+	long long rows = 0;
+	auto start = std::chrono::steady_clock::now();
+	reader.scan([&rows](const CaptureStep& step) { rows += step.units.size(); });
+	double scan_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// most analyses only need a few columns, the others are skipped without decoding
+	double sum_x = 0.0;
+	start = std::chrono::steady_clock::now();
+	reader.scan([&sum_x](const CaptureStep& step) {
+		for (auto& u : step.units) {
+			sum_x += u.x;
+		}
+	}, (1 << CAPTURE_X) | (1 << CAPTURE_Y));
+	double position_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << argv[1] << std::endl;
+	std::cout << "  size:       " << reader.getFileSize() << " bytes" << std::endl;
+	std::cout << "  game loops: " << reader.getFirstLoop() << " - " << reader.getLastLoop() << std::endl;
+	std::cout << "  steps:      " << reader.getNumSteps() << " in " << reader.getNumBlocks() << " blocks" << std::endl;
+	std::cout << "  units:      " << rows << " snapshots, " << (rows > 0 ? (double)reader.getFileSize() / rows : 0.0) << " bytes each" << std::endl;
+	std::cout << "  full scan:  " << scan_ms << " ms" << std::endl;
+	std::cout << "  positions:  " << position_ms << " ms" << std::endl;
+
+	if (argc >= 3) {
+		CaptureStep step;
+		if (!reader.readStep((uint32_t)std::atol(argv[2]), step)) {
+			std::cout << "No step at or before game loop " << argv[2] << std::endl;
+			return 1;
+		}
+		std::cout << "game loop " << step.game_loop << ", " << step.units.size() << " units" << std::endl;
+		for (auto& u : step.units) {
+			std::cout << "  " << u.tag << " type " << u.unit_type << " alliance " << u.alliance << " (" << u.x << ", " << u.y << ") health "
+				<< u.health << " progress " << u.build_progress << " orders " << u.num_orders;
+			for (uint32_t o = 0; o < u.num_orders; ++o) {
+				std::cout << " " << step.orders[u.first_order + o].ability;
+			}
+			std::cout << std::endl;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include "ReplayDriver.h"
+#include "BasicSc2Bot.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+ReplayDriver::ReplayDriver(std::string filename_) : file(filename_), in(&file), filename(filename_), query(&observation) {
+	total_us = 0.0;
+	wall_us = 0.0;
+	num_events = 0;
+}
+
+ReplayDriver::ReplayDriver(std::istream& in_, std::string name_) : in(&in_), filename(name_), query(&observation) {
+	// replays a recording that is already in memory, such as a generated scenario
+	total_us = 0.0;
+	wall_us = 0.0;
+	num_events = 0;
+}
+
+bool ReplayDriver::isOpen() {
+	return in->good();
+}
+
+void ReplayDriver::fireEvents(BasicSc2Bot* bot_, const std::vector<ReplayEvent>& events_) {
+	// callbacks are delivered in the order they were recorded
+	for (auto& e : events_) {
+		if (e.kind == "CREATED")
+			bot_->OnUnitCreated(e.unit);
+		else if (e.kind == "COMPLETE")
+			bot_->OnBuildingConstructionComplete(e.unit);
+		else if (e.kind == "DAMAGED")
+			bot_->OnUnitDamaged(e.unit, e.health, e.shields);
+		else if (e.kind == "IDLE")
+			bot_->OnUnitIdle(e.unit);
+		else if (e.kind == "DESTROYED")
+			bot_->OnUnitDestroyed(e.unit);
+		else if (e.kind == "VISION")
+			bot_->OnUnitEnterVision(e.unit);
+		num_events++;
+	}
+}
+
+bool ReplayDriver::run(BasicSc2Bot* bot_, int max_steps_) {
+	// replay every recorded step, or only the first max_steps_ when it is not negative
+	if (!isOpen()) {
+		std::cout << "Unable to open recording " << filename << std::endl;
+		return false;
+	}
+	if (!observation.readHeader(*in)) {
+		std::cout << "Recording " << filename << " has no steps" << std::endl;
+		return false;
+	}
+
+	bot_->setInterfaces(&observation, &query, &actions);
+	bot_->OnGameStart();
+
+	// reading the next step stands in for the game simulating it, which pipelined analysis overlaps
+	std::vector<ReplayEvent> events;
+	auto replay_start = std::chrono::steady_clock::now();
+	while ((max_steps_ < 0 || (int)step_us.size() < max_steps_) && observation.readStep(*in, events)) {
+		auto start = std::chrono::steady_clock::now();
+		fireEvents(bot_, events);
+		auto step_start = std::chrono::steady_clock::now();
+		bot_->OnStep();
+		actions.SendActions();
+		auto end = std::chrono::steady_clock::now();
+
+		step_us.push_back(std::chrono::duration<double, std::micro>(end - step_start).count());
+		total_us += std::chrono::duration<double, std::micro>(end - start).count();
+	}
+	wall_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - replay_start).count();
+
+	// read to the end so the recorded result is available
+	while (observation.readStep(*in, events)) {}
+	bot_->OnGameEnd();
+	bot_->setInterfaces(nullptr, nullptr, nullptr);
+	return true;
+}
+
+void ReplayDriver::printReport() {
+	if (step_us.empty()) {
+		std::cout << "No steps were replayed." << std::endl;
+		return;
+	}
+
+	std::vector<double> sorted = step_us;
+	std::sort(sorted.begin(), sorted.end());
+	auto percentile = [&sorted](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+	double sum = 0.0;
+	for (double s : sorted) {
+		sum += s;
+	}
+
+	std::cout << "Replayed " << step_us.size() << " steps from " << filename << std::endl;
+	std::cout << "  steps/sec:      " << (step_us.size() * 1000000.0) / total_us << std::endl;
+	std::cout << "  OnStep mean:    " << sum / sorted.size() << " us" << std::endl;
+	std::cout << "  OnStep p50:     " << percentile(0.50) << " us" << std::endl;
+	std::cout << "  OnStep p95:     " << percentile(0.95) << " us" << std::endl;
+	std::cout << "  OnStep p99:     " << percentile(0.99) << " us" << std::endl;
+	std::cout << "  OnStep max:     " << sorted.back() << " us" << std::endl;
+	std::cout << "  loop wall mean: " << wall_us / step_us.size() << " us (" << (PIPELINE_STEPS ? "pipelined" : "not pipelined") << ")" << std::endl;
+	std::cout << "  unit callbacks: " << num_events << std::endl;
+	std::cout << "  commands:       " << actions.getNumCommands() << " (" << actions.getNumUnitOrders() << " unit orders)" << std::endl;
+	std::cout << "  queries:        " << query.getNumQueries() << std::endl;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "ReplayInterfaces.h"
+
+class BasicSc2Bot;
+
+class ReplayDriver {
+// Feeds a recorded game into BasicSc2Bot as fast as possible, calling the unit callbacks
+// and OnStep in the same order as the client, and measures how long each OnStep takes
+public:
+	ReplayDriver(std::string filename_);
+	ReplayDriver(std::istream& in_, std::string name_);
+	bool isOpen();
+	bool run(BasicSc2Bot* bot_, int max_steps_=-1);
+	void printReport();
+
+private:
+	void fireEvents(BasicSc2Bot* bot_, const std::vector<ReplayEvent>& events_);
+
+	std::ifstream file;
+	std::istream* in;
+	std::string filename;	// or a description of the stream being replayed
+	ReplayObservation observation;
+	ReplayQuery query;
+	ReplayActions actions;
+	std::vector<double> step_us;	// wall time of each OnStep, in microseconds
+	double total_us;				// wall time of OnStep and the callbacks, excluding reading the recording
+	double wall_us;					// wall time of the whole replay, including reading the recording
+	int num_events;
+};
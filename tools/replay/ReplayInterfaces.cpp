@@ -0,0 +1,579 @@
+#include "ReplayInterfaces.h"
+#include "ObservationRecorder.h"
+#include <cmath>
+#include <iostream>
+
+ReplayObservation::ReplayObservation() {
+	has_pending_line = false;
+	player_id = 0;
+	game_loop = 0;
+	minerals = 0;
+	vespene = 0;
+	food_cap = 0;
+	food_used = 0;
+	food_army = 0;
+	food_workers = 0;
+}
+
+bool ReplayObservation::nextLine(std::istream& in, std::string& line_) {
+	if (has_pending_line) {
+		line_ = pending_line;
+		has_pending_line = false;
+		return true;
+	}
+	return (bool)std::getline(in, line_);
+}
+
+void ReplayObservation::readRunLength(std::istringstream& in, std::vector<char>& cells_) {
+	// expand <value> <count> pairs written by ObservationRecorder::writeRunLength
+	cells_.clear();
+	int value;
+	int count;
+	while (in >> value >> count) {
+		cells_.insert(cells_.end(), count, (char)value);
+	}
+}
+
+bool ReplayObservation::readHeader(std::istream& in) {
+	// read everything recorded once per game, stopping at the first STEP
+	std::string line;
+	while (nextLine(in, line)) {
+		std::istringstream ls(line);
+		std::string key;
+		ls >> key;
+
+		if (key == "SC2REC") {
+			int version;
+			ls >> version;
+			if (version != RECORDING_VERSION) {
+				std::cout << "Unsupported recording version " << version << std::endl;
+				return false;
+			}
+		}
+		else if (key == "MAP") {
+			std::getline(ls >> std::ws, game_info.map_name);
+		}
+		else if (key == "INFO") {
+			ls >> player_id >> game_info.width >> game_info.height
+				>> game_info.playable_min.x >> game_info.playable_min.y
+				>> game_info.playable_max.x >> game_info.playable_max.y
+				>> start_location.x >> start_location.y >> start_location.z;
+		}
+		else if (key == "START") {
+			sc2::Point2D s;
+			ls >> s.x >> s.y;
+			game_info.start_locations.push_back(s);
+		}
+		else if (key == "PATHING") {
+			readRunLength(ls, pathable);
+		}
+		else if (key == "PLACEMENT") {
+			readRunLength(ls, placable);
+		}
+		else if (key == "UNITTYPE") {
+			int id;
+			int race;
+			size_t num_attributes;
+			sc2::UnitTypeData t;
+			ls >> id >> t.mineral_cost >> t.vespene_cost >> t.food_required >> t.food_provided >> race >> num_attributes;
+			for (size_t i = 0; i < num_attributes; ++i) {
+				int a;
+				ls >> a;
+				t.attributes.push_back((sc2::Attribute)a);
+			}
+			ls >> t.name;
+			t.unit_type_id = id;
+			t.race = (sc2::Race)race;
+			t.available = true;
+			if (id >= (int)unit_types.size()) {
+				unit_types.resize(id + 1);
+			}
+			unit_types[id] = t;
+		}
+		else if (key == "ABILITY") {
+			int id;
+			sc2::AbilityData a;
+			ls >> id >> a.is_building >> a.footprint_radius;
+			a.ability_id = id;
+			a.available = true;
+			if (id >= (int)abilities.size()) {
+				abilities.resize(id + 1);
+			}
+			abilities[id] = a;
+		}
+		else if (key == "STEP") {
+			pending_line = line;
+			has_pending_line = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+sc2::Unit* ReplayObservation::readUnit(std::istringstream& in) {
+	// update the pooled unit in place, so pointers held by the bot stay valid
+	sc2::Tag tag;
+	in >> tag;
+	std::unique_ptr<sc2::Unit>& pooled = unit_pool[tag];
+	if (!pooled) {
+		pooled.reset(new sc2::Unit());
+	}
+	sc2::Unit* u = pooled.get();
+	u->tag = tag;
+
+	int unit_type, alliance, display_type, cloak;
+	size_t num_orders, num_buffs;
+	in >> unit_type >> alliance >> display_type >> u->owner >> u->pos.x >> u->pos.y >> u->pos.z >> u->facing >> u->radius
+		>> u->build_progress >> u->health >> u->health_max >> u->shield >> u->shield_max >> u->energy >> u->energy_max
+		>> u->is_flying >> u->is_burrowed >> u->is_alive >> u->weapon_cooldown >> u->last_seen_game_loop
+		>> u->mineral_contents >> u->vespene_contents >> u->assigned_harvesters >> u->ideal_harvesters >> cloak >> u->is_powered
+		>> u->add_on_tag >> u->engaged_target_tag >> num_orders;
+	u->unit_type = unit_type;
+	u->alliance = (sc2::Unit::Alliance)alliance;
+	u->display_type = (sc2::Unit::DisplayType)display_type;
+	u->cloak = (sc2::Unit::CloakState)cloak;
+
+	u->orders.clear();
+	for (size_t i = 0; i < num_orders; ++i) {
+		sc2::UnitOrder o;
+		int ability;
+		in >> ability >> o.target_unit_tag >> o.target_pos.x >> o.target_pos.y >> o.progress;
+		o.ability_id = ability;
+		u->orders.push_back(o);
+	}
+
+	in >> num_buffs;
+	u->buffs.clear();
+	for (size_t i = 0; i < num_buffs; ++i) {
+		int buff;
+		in >> buff;
+		u->buffs.push_back(buff);
+	}
+	return u;
+}
+
+bool ReplayObservation::readStep(std::istream& in, std::vector<ReplayEvent>& events_) {
+	// load the next recorded step, returns false once the recording is exhausted
+	events_.clear();
+	units.clear();
+	present.clear();
+	available_abilities.clear();
+
+	std::string line;
+	bool in_step = false;
+	while (nextLine(in, line)) {
+		std::istringstream ls(line);
+		std::string key;
+		ls >> key;
+
+		if (key == "STEP") {
+			ls >> game_loop >> minerals >> vespene >> food_cap >> food_used >> food_army >> food_workers;
+			in_step = true;
+		}
+		else if (key == "UPGRADES") {
+			size_t n;
+			ls >> n;
+			upgrades.clear();
+			for (size_t i = 0; i < n; ++i) {
+				int id;
+				ls >> id;
+				upgrades.push_back(id);
+			}
+		}
+		else if (key == "VIS") {
+			readRunLength(ls, visibility);
+		}
+		else if (key == "UNIT") {
+			sc2::Unit* u = readUnit(ls);
+			units.push_back(u);
+			present.insert(u->tag);
+		}
+		else if (key == "ABILITIES") {
+			sc2::Tag tag;
+			size_t n;
+			ls >> tag >> n;
+			std::vector<sc2::AbilityID>& list = available_abilities[tag];
+			for (size_t i = 0; i < n; ++i) {
+				int id;
+				ls >> id;
+				list.push_back(id);
+			}
+		}
+		else if (key == "EVENT") {
+			ReplayEvent e;
+			sc2::Tag tag;
+			ls >> e.kind >> tag >> e.health >> e.shields;
+			auto it = unit_pool.find(tag);
+			if (it == unit_pool.end())
+				continue;
+			e.unit = it->second.get();
+			if (e.kind == "DESTROYED") {
+				it->second->is_alive = false;
+			}
+			events_.push_back(e);
+		}
+		else if (key == "END") {
+			return in_step;
+		}
+		else if (key == "RESULT") {
+			sc2::PlayerResult r;
+			int result;
+			ls >> r.player_id >> result;
+			r.result = (sc2::GameResult)result;
+			results.push_back(r);
+		}
+	}
+	return false;
+}
+
+const std::vector<sc2::AbilityID>* ReplayObservation::getAvailableAbilities(sc2::Tag tag_) const {
+	auto it = available_abilities.find(tag_);
+	if (it == available_abilities.end())
+		return nullptr;
+	return &it->second;
+}
+
+int ReplayObservation::getNumUnits() const {
+	return units.size();
+}
+
+int ReplayObservation::cellIndex(const sc2::Point2D& point) const {
+	int x = (int)point.x;
+	int y = (int)point.y;
+	if (x < 0 || y < 0 || x >= game_info.width || y >= game_info.height)
+		return -1;
+	return x + y * game_info.width;
+}
+
+uint32_t ReplayObservation::GetPlayerID() const {
+	return player_id;
+}
+
+uint32_t ReplayObservation::GetGameLoop() const {
+	return game_loop;
+}
+
+sc2::Units ReplayObservation::GetUnits() const {
+	return units;
+}
+
+sc2::Units ReplayObservation::GetUnits(sc2::Unit::Alliance alliance, sc2::Filter filter) const {
+	sc2::Units matching;
+	for (auto u : units) {
+		if (u->alliance == alliance && (!filter || filter(*u))) {
+			matching.push_back(u);
+		}
+	}
+	return matching;
+}
+
+sc2::Units ReplayObservation::GetUnits(sc2::Filter filter) const {
+	sc2::Units matching;
+	for (auto u : units) {
+		if (!filter || filter(*u)) {
+			matching.push_back(u);
+		}
+	}
+	return matching;
+}
+
+const sc2::Unit* ReplayObservation::GetUnit(sc2::Tag tag) const {
+	// like the client, only units in the current observation are returned
+	if (present.find(tag) == present.end())
+		return nullptr;
+	return unit_pool.at(tag).get();
+}
+
+const sc2::RawActions& ReplayObservation::GetRawActions() const {
+	return raw_actions;
+}
+
+const sc2::SpatialActions& ReplayObservation::GetFeatureLayerActions() const {
+	return spatial_actions;
+}
+
+const sc2::SpatialActions& ReplayObservation::GetRenderedActions() const {
+	return spatial_actions;
+}
+
+const std::vector<sc2::ChatMessage>& ReplayObservation::GetChatMessages() const {
+	return chat_messages;
+}
+
+const std::vector<sc2::PowerSource>& ReplayObservation::GetPowerSources() const {
+	return power_sources;
+}
+
+const std::vector<sc2::Effect>& ReplayObservation::GetEffects() const {
+	return effects;
+}
+
+const std::vector<sc2::UpgradeID>& ReplayObservation::GetUpgrades() const {
+	return upgrades;
+}
+
+const sc2::Score& ReplayObservation::GetScore() const {
+	return score;
+}
+
+const sc2::Abilities& ReplayObservation::GetAbilityData(bool force_refresh) const {
+	return abilities;
+}
+
+const sc2::UnitTypes& ReplayObservation::GetUnitTypeData(bool force_refresh) const {
+	return unit_types;
+}
+
+const sc2::Upgrades& ReplayObservation::GetUpgradeData(bool force_refresh) const {
+	return upgrade_data;
+}
+
+const sc2::Buffs& ReplayObservation::GetBuffData(bool force_refresh) const {
+	return buff_data;
+}
+
+const sc2::Effects& ReplayObservation::GetEffectData(bool force_refresh) const {
+	return effect_data;
+}
+
+const sc2::GameInfo& ReplayObservation::GetGameInfo() const {
+	return game_info;
+}
+
+int32_t ReplayObservation::GetMinerals() const {
+	return minerals;
+}
+
+int32_t ReplayObservation::GetVespene() const {
+	return vespene;
+}
+
+int32_t ReplayObservation::GetFoodCap() const {
+	return food_cap;
+}
+
+int32_t ReplayObservation::GetFoodUsed() const {
+	return food_used;
+}
+
+int32_t ReplayObservation::GetFoodArmy() const {
+	return food_army;
+}
+
+int32_t ReplayObservation::GetFoodWorkers() const {
+	return food_workers;
+}
+
+int32_t ReplayObservation::GetIdleWorkerCount() const {
+	return 0;
+}
+
+int32_t ReplayObservation::GetArmyCount() const {
+	return 0;
+}
+
+int32_t ReplayObservation::GetWarpGateCount() const {
+	return 0;
+}
+
+int32_t ReplayObservation::GetLarvaCount() const {
+	return 0;
+}
+
+sc2::Point2D ReplayObservation::GetCameraPos() const {
+	return sc2::Point2D(start_location.x, start_location.y);
+}
+
+sc2::Point3D ReplayObservation::GetStartLocation() const {
+	return start_location;
+}
+
+const std::vector<sc2::PlayerResult>& ReplayObservation::GetResults() const {
+	return results;
+}
+
+bool ReplayObservation::HasCreep(const sc2::Point2D& point) const {
+	return false;
+}
+
+sc2::Visibility ReplayObservation::GetVisibility(const sc2::Point2D& point) const {
+	int i = cellIndex(point);
+	if (i < 0 || i >= (int)visibility.size())
+		return sc2::Visibility::Hidden;
+	return (sc2::Visibility)visibility[i];
+}
+
+bool ReplayObservation::IsPathable(const sc2::Point2D& point) const {
+	int i = cellIndex(point);
+	if (i < 0 || i >= (int)pathable.size())
+		return false;
+	return pathable[i] != 0;
+}
+
+bool ReplayObservation::IsPlacable(const sc2::Point2D& point) const {
+	int i = cellIndex(point);
+	if (i < 0 || i >= (int)placable.size())
+		return false;
+	return placable[i] != 0;
+}
+
+float ReplayObservation::TerrainHeight(const sc2::Point2D& point) const {
+	return start_location.z;
+}
+
+const SC2APIProtocol::Observation* ReplayObservation::GetRawObservation() const {
+	return nullptr;
+}
+
+ReplayQuery::ReplayQuery(const ReplayObservation* observation_) {
+	observation = observation_;
+	num_queries = 0;
+}
+
+int ReplayQuery::getNumQueries() {
+	return num_queries;
+}
+
+sc2::AvailableAbilities ReplayQuery::GetAbilitiesForUnit(const sc2::Unit* unit, bool ignore_resource_requirements, bool use_generalized_ability) {
+	// answered from the abilities recorded for this unit during the same step
+	num_queries++;
+	sc2::AvailableAbilities available;
+	if (!unit)
+		return available;
+	available.unit_tag = unit->tag;
+	available.unit_type_id = unit->unit_type;
+	const std::vector<sc2::AbilityID>* recorded = observation->getAvailableAbilities(unit->tag);
+	if (recorded) {
+		for (auto a : *recorded) {
+			sc2::AvailableAbility ability;
+			ability.ability_id = a;
+			available.abilities.push_back(ability);
+		}
+	}
+	return available;
+}
+
+std::vector<sc2::AvailableAbilities> ReplayQuery::GetAbilitiesForUnits(const sc2::Units& units, bool ignore_resource_requirements, bool use_generalized_ability) {
+	// one round trip for the whole batch
+	int queries_before = num_queries;
+	std::vector<sc2::AvailableAbilities> available;
+	for (auto u : units) {
+		available.push_back(GetAbilitiesForUnit(u, ignore_resource_requirements, use_generalized_ability));
+	}
+	num_queries = queries_before + 1;
+	return available;
+}
+
+float ReplayQuery::PathingDistance(const sc2::Point2D& start, const sc2::Point2D& end) {
+	// the client returns 0 when there is no path
+	num_queries++;
+	if (!observation->IsPathable(end))
+		return 0.0F;
+	return sc2::Distance2D(start, end);
+}
+
+float ReplayQuery::PathingDistance(const sc2::Unit* start, const sc2::Point2D& end) {
+	if (!start)
+		return 0.0F;
+	return PathingDistance(sc2::Point2D(start->pos.x, start->pos.y), end);
+}
+
+std::vector<float> ReplayQuery::PathingDistance(const std::vector<sc2::QueryInterface::PathingQuery>& queries) {
+	std::vector<float> distances;
+	for (auto& q : queries) {
+		distances.push_back(PathingDistance(q.start_, q.end_));
+	}
+	return distances;
+}
+
+bool ReplayQuery::Placement(const sc2::AbilityID& ability, const sc2::Point2D& target_pos, const sc2::Unit* unit) {
+	// placable terrain that no structure is standing on
+	num_queries++;
+	if (!observation->IsPlacable(target_pos))
+		return false;
+
+	float footprint = 1.0F;
+	const sc2::Abilities& abilities = observation->GetAbilityData();
+	if ((int)ability < (int)abilities.size() && abilities[(int)ability].footprint_radius > 0.0F) {
+		footprint = abilities[(int)ability].footprint_radius;
+	}
+	for (auto u : observation->GetUnits()) {
+		if (u == unit || u->is_flying)
+			continue;
+		float min_dist = footprint + u->radius;
+		if (sc2::DistanceSquared2D(u->pos, target_pos) < min_dist * min_dist) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<bool> ReplayQuery::Placement(const std::vector<sc2::QueryInterface::PlacementQuery>& queries) {
+	std::vector<bool> placeable;
+	for (auto& q : queries) {
+		placeable.push_back(Placement(q.ability, q.target_pos));
+	}
+	return placeable;
+}
+
+ReplayActions::ReplayActions() {
+	num_commands = 0;
+	num_unit_orders = 0;
+}
+
+int ReplayActions::getNumCommands() {
+	return num_commands;
+}
+
+int ReplayActions::getNumUnitOrders() {
+	return num_unit_orders;
+}
+
+void ReplayActions::UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, bool queued_command) {
+	num_commands++;
+	num_unit_orders++;
+	commands.push_back(unit->tag);
+}
+
+void ReplayActions::UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Point2D& point, bool queued_command) {
+	UnitCommand(unit, ability, queued_command);
+}
+
+void ReplayActions::UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Unit* target, bool queued_command) {
+	UnitCommand(unit, ability, queued_command);
+}
+
+void ReplayActions::UnitCommand(const sc2::Units& units, sc2::AbilityID ability, bool queued_move) {
+	num_commands++;
+	num_unit_orders += units.size();
+	for (auto u : units) {
+		commands.push_back(u->tag);
+	}
+}
+
+void ReplayActions::UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Point2D& point, bool queued_command) {
+	UnitCommand(units, ability, queued_command);
+}
+
+void ReplayActions::UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Unit* target, bool queued_command) {
+	UnitCommand(units, ability, queued_command);
+}
+
+const std::vector<sc2::Tag>& ReplayActions::Commands() const {
+	return commands;
+}
+
+void ReplayActions::ToggleAutocast(sc2::Tag unit_tag, sc2::AbilityID ability) {
+	num_commands++;
+}
+
+void ReplayActions::ToggleAutocast(const std::vector<sc2::Tag>& unit_tags, sc2::AbilityID ability) {
+	num_commands++;
+}
+
+void ReplayActions::SendChat(const std::string& message, sc2::ChatChannel channel) {
+}
+
+void ReplayActions::SendActions() {
+	commands.clear();
+}
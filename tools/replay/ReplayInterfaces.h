@@ -0,0 +1,162 @@
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "sc2api/sc2_api.h"
+
+// Stand-ins for the sc2 client interfaces, answering from a recording written by ObservationRecorder
+
+struct ReplayEvent {
+	std::string kind;	// CREATED, COMPLETE, DAMAGED, IDLE, DESTROYED, VISION
+	const sc2::Unit* unit;
+	float health;
+	float shields;
+};
+
+class ReplayObservation : public sc2::ObservationInterface {
+public:
+	ReplayObservation();
+	bool readHeader(std::istream& in);
+	bool readStep(std::istream& in, std::vector<ReplayEvent>& events_);
+	const std::vector<sc2::AbilityID>* getAvailableAbilities(sc2::Tag tag_) const;
+	int getNumUnits() const;
+
+	// sc2::ObservationInterface
+	uint32_t GetPlayerID() const override;
+	uint32_t GetGameLoop() const override;
+	sc2::Units GetUnits() const override;
+	sc2::Units GetUnits(sc2::Unit::Alliance alliance, sc2::Filter filter = {}) const override;
+	sc2::Units GetUnits(sc2::Filter filter) const override;
+	const sc2::Unit* GetUnit(sc2::Tag tag) const override;
+	const sc2::RawActions& GetRawActions() const override;
+	const sc2::SpatialActions& GetFeatureLayerActions() const override;
+	const sc2::SpatialActions& GetRenderedActions() const override;
+	const std::vector<sc2::ChatMessage>& GetChatMessages() const override;
+	const std::vector<sc2::PowerSource>& GetPowerSources() const override;
+	const std::vector<sc2::Effect>& GetEffects() const override;
+	const std::vector<sc2::UpgradeID>& GetUpgrades() const override;
+	const sc2::Score& GetScore() const override;
+	const sc2::Abilities& GetAbilityData(bool force_refresh = false) const override;
+	const sc2::UnitTypes& GetUnitTypeData(bool force_refresh = false) const override;
+	const sc2::Upgrades& GetUpgradeData(bool force_refresh = false) const override;
+	const sc2::Buffs& GetBuffData(bool force_refresh = false) const override;
+	const sc2::Effects& GetEffectData(bool force_refresh = false) const override;
+	const sc2::GameInfo& GetGameInfo() const override;
+	int32_t GetMinerals() const override;
+	int32_t GetVespene() const override;
+	int32_t GetFoodCap() const override;
+	int32_t GetFoodUsed() const override;
+	int32_t GetFoodArmy() const override;
+	int32_t GetFoodWorkers() const override;
+	int32_t GetIdleWorkerCount() const override;
+	int32_t GetArmyCount() const override;
+	int32_t GetWarpGateCount() const override;
+	int32_t GetLarvaCount() const override;
+	sc2::Point2D GetCameraPos() const override;
+	sc2::Point3D GetStartLocation() const override;
+	const std::vector<sc2::PlayerResult>& GetResults() const override;
+	bool HasCreep(const sc2::Point2D& point) const override;
+	sc2::Visibility GetVisibility(const sc2::Point2D& point) const override;
+	bool IsPathable(const sc2::Point2D& point) const override;
+	bool IsPlacable(const sc2::Point2D& point) const override;
+	float TerrainHeight(const sc2::Point2D& point) const override;
+	const SC2APIProtocol::Observation* GetRawObservation() const override;
+
+private:
+	bool nextLine(std::istream& in, std::string& line_);
+	int cellIndex(const sc2::Point2D& point) const;
+	void readRunLength(std::istringstream& in, std::vector<char>& cells_);
+	sc2::Unit* readUnit(std::istringstream& in);
+
+	std::string pending_line;	// a line read ahead while looking for the end of a section
+	bool has_pending_line;
+
+	// recorded once per game
+	uint32_t player_id;
+	sc2::Point3D start_location;
+	sc2::GameInfo game_info;
+	sc2::UnitTypes unit_types;	// indexed by unit type id
+	sc2::Abilities abilities;	// indexed by ability id
+	std::vector<char> pathable;
+	std::vector<char> placable;
+	std::vector<sc2::PlayerResult> results;
+
+	// recorded every step
+	uint32_t game_loop;
+	int32_t minerals;
+	int32_t vespene;
+	int32_t food_cap;
+	int32_t food_used;
+	int32_t food_army;
+	int32_t food_workers;
+	std::vector<sc2::UpgradeID> upgrades;
+	std::vector<char> visibility;
+	sc2::Units units;	// units present in the current step
+	std::unordered_map<sc2::Tag, std::vector<sc2::AbilityID>> available_abilities;
+
+	// units keep the same address for the whole replay, as Mobs hold references to them
+	std::unordered_map<sc2::Tag, std::unique_ptr<sc2::Unit>> unit_pool;
+	std::unordered_set<sc2::Tag> present;
+
+	// returned by reference but never recorded
+	sc2::RawActions raw_actions;
+	sc2::SpatialActions spatial_actions;
+	std::vector<sc2::ChatMessage> chat_messages;
+	std::vector<sc2::PowerSource> power_sources;
+	std::vector<sc2::Effect> effects;
+	sc2::Score score;
+	sc2::Upgrades upgrade_data;
+	sc2::Buffs buff_data;
+	sc2::Effects effect_data;
+};
+
+class ReplayQuery : public sc2::QueryInterface {
+// pathing distances are approximated by straight-line distance between pathable points
+public:
+	ReplayQuery(const ReplayObservation* observation_);
+	int getNumQueries();
+
+	// sc2::QueryInterface
+	sc2::AvailableAbilities GetAbilitiesForUnit(const sc2::Unit* unit, bool ignore_resource_requirements = false, bool use_generalized_ability = true) override;
+	std::vector<sc2::AvailableAbilities> GetAbilitiesForUnits(const sc2::Units& units, bool ignore_resource_requirements = false, bool use_generalized_ability = true) override;
+	float PathingDistance(const sc2::Point2D& start, const sc2::Point2D& end) override;
+	float PathingDistance(const sc2::Unit* start, const sc2::Point2D& end) override;
+	std::vector<float> PathingDistance(const std::vector<sc2::QueryInterface::PathingQuery>& queries) override;
+	bool Placement(const sc2::AbilityID& ability, const sc2::Point2D& target_pos, const sc2::Unit* unit = nullptr) override;
+	std::vector<bool> Placement(const std::vector<sc2::QueryInterface::PlacementQuery>& queries) override;
+
+private:
+	const ReplayObservation* observation;
+	int num_queries;
+};
+
+class ReplayActions : public sc2::ActionInterface {
+// orders are counted but go nowhere, the recording decides what happens next
+public:
+	ReplayActions();
+	int getNumCommands();
+	int getNumUnitOrders();
+
+	// sc2::ActionInterface
+	void UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, bool queued_command = false) override;
+	void UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Point2D& point, bool queued_command = false) override;
+	void UnitCommand(const sc2::Unit* unit, sc2::AbilityID ability, const sc2::Unit* target, bool queued_command = false) override;
+	void UnitCommand(const sc2::Units& units, sc2::AbilityID ability, bool queued_move = false) override;
+	void UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Point2D& point, bool queued_command = false) override;
+	void UnitCommand(const sc2::Units& units, sc2::AbilityID ability, const sc2::Unit* target, bool queued_command = false) override;
+	const std::vector<sc2::Tag>& Commands() const override;
+	void ToggleAutocast(sc2::Tag unit_tag, sc2::AbilityID ability) override;
+	void ToggleAutocast(const std::vector<sc2::Tag>& unit_tags, sc2::AbilityID ability) override;
+	void SendChat(const std::string& message, sc2::ChatChannel channel = sc2::ChatChannel::All) override;
+	void SendActions() override;
+
+private:
+	std::vector<sc2::Tag> commands;	// tags commanded since the last SendActions
+	int num_commands;
+	int num_unit_orders;
+};
@@ -0,0 +1,28 @@
+#include <cstdlib>
+#include <iostream>
+#include "BasicSc2Bot.h"
+#include "ReplayDriver.h"
+
+// Replays a game recorded with RECORD_OBSERVATIONS through the bot without the SC2 client
+// usage: ReplayDriver <recording> [max_steps]
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cout << "usage: " << argv[0] << " <recording> [max_steps]" << std::endl;
+		return 1;
+	}
+
+	int max_steps = -1;
+	if (argc >= 3) {
+		max_steps = std::atoi(argv[2]);
+	}
+
+	ReplayDriver driver(argv[1]);
+	BasicSc2Bot* bot = new BasicSc2Bot();
+	if (!driver.run(bot, max_steps)) {
+		delete bot;
+		return 1;
+	}
+	driver.printReport();
+	delete bot;
+	return 0;
+}
@@ -0,0 +1,54 @@
+#include <cstdlib>
+#include <iostream>
+#include "StrategyFile.h"
+
+// Compiles a strategy file into one image per map and start position, next to the file, which the
+// bot maps instead of parsing the file when it starts. Rerun after editing the strategy file
+// usage: StrategyCompile <strategy file> [map_index p_id]
+int main(int argc, char* argv[]) {
+	if (argc != 2 && argc != 4) {
+		std::cout << "usage: " << argv[0] << " <strategy file> [map_index p_id]" << std::endl;
+		return 1;
+	}
+
+	StrategyFile file;
+	if (!file.load(argv[1]))
+		return 1;
+	std::cout << argv[1] << ": " << file.getNumPrecepts() << " precepts and " << file.getNumConditions() << " conditions parsed in "
+		<< file.getLoadUs() << "us" << std::endl;
+
+	// start positions of each map, see LocationHandler::getPlayerIDForMap()
+	int num_starts[] = { 0, 4, 2, 2 };
+	int first_map = 1;
+	int last_map = 3;
+	int only_start = 0;
+	if (argc == 4) {
+		first_map = last_map = std::atoi(argv[2]);
+		only_start = std::atoi(argv[3]);
+		if (first_map < 1 || first_map > 3) {
+			std::cout << "Map index " << argv[2] << " is not 1-3" << std::endl;
+			return 1;
+		}
+		if (only_start < 1 || only_start > num_starts[first_map]) {
+			std::cout << "Map " << first_map << " has start positions 1-" << num_starts[first_map] << std::endl;
+			return 1;
+		}
+	}
+
+	for (int map_index = first_map; map_index <= last_map; ++map_index) {
+		for (int p_id = 1; p_id <= 4; ++p_id) {
+			if (only_start ? p_id != only_start : p_id > num_starts[map_index])
+				continue;
+			std::string image_path = StrategyFile::imagePath(argv[1], map_index, p_id);
+			if (!file.writeImage(image_path, map_index, p_id))
+				return 1;
+
+			StrategyFile image;
+			if (!image.loadImage(image_path, argv[1], map_index, p_id))
+				return 1;
+			std::cout << "  " << image_path << ": " << image.getNumPrecepts() << " precepts and " << image.getNumConditions()
+				<< " conditions, mapped in " << image.getLoadUs() << "us" << std::endl;
+		}
+	}
+	return 0;
+}
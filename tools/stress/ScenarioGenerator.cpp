@@ -0,0 +1,317 @@
+#include "ScenarioGenerator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct TypeInfo {
+	sc2::UNIT_TYPEID type;
+	int mineral_cost;
+	int vespene_cost;
+	float food_required;
+	float food_provided;
+	sc2::Race race;
+	std::vector<sc2::Attribute> attributes;
+	const char* name;
+	float radius;
+	float health;
+	float shield;
+	bool is_flying;
+};
+
+const std::vector<TypeInfo>& typeTable() {
+	// the unit types a scenario can use, with the data the bot reads from GetUnitTypeData()
+	using A = sc2::Attribute;
+	using T = sc2::UNIT_TYPEID;
+	static const std::vector<TypeInfo> table = {
+		{ T::PROTOSS_NEXUS, 400, 0, 0, 15, sc2::Race::Protoss, { A::Armored, A::Structure }, "Nexus", 2.75F, 1000, 1000, false },
+		{ T::PROTOSS_PYLON, 100, 0, 0, 8, sc2::Race::Protoss, { A::Armored, A::Structure }, "Pylon", 1.125F, 200, 200, false },
+		{ T::PROTOSS_GATEWAY, 150, 0, 0, 0, sc2::Race::Protoss, { A::Armored, A::Structure }, "Gateway", 1.8125F, 500, 500, false },
+		{ T::PROTOSS_PROBE, 50, 0, 1, 0, sc2::Race::Protoss, { A::Light, A::Mechanical }, "Probe", 0.375F, 20, 20, false },
+		{ T::PROTOSS_ZEALOT, 100, 0, 2, 0, sc2::Race::Protoss, { A::Light, A::Biological }, "Zealot", 0.5F, 100, 50, false },
+		{ T::PROTOSS_STALKER, 125, 50, 2, 0, sc2::Race::Protoss, { A::Armored, A::Mechanical }, "Stalker", 0.625F, 80, 80, false },
+		{ T::PROTOSS_SENTRY, 50, 100, 2, 0, sc2::Race::Protoss, { A::Light, A::Mechanical, A::Psionic }, "Sentry", 0.5F, 40, 40, false },
+		{ T::PROTOSS_IMMORTAL, 275, 100, 4, 0, sc2::Race::Protoss, { A::Armored, A::Mechanical }, "Immortal", 0.75F, 200, 100, false },
+		{ T::PROTOSS_COLOSSUS, 300, 200, 6, 0, sc2::Race::Protoss, { A::Armored, A::Mechanical, A::Massive }, "Colossus", 1.0F, 200, 150, false },
+		{ T::PROTOSS_PHOENIX, 150, 100, 2, 0, sc2::Race::Protoss, { A::Light, A::Mechanical }, "Phoenix", 0.75F, 120, 60, true },
+		{ T::PROTOSS_VOIDRAY, 250, 150, 4, 0, sc2::Race::Protoss, { A::Armored, A::Mechanical }, "VoidRay", 1.0F, 150, 100, true },
+		{ T::TERRAN_MARINE, 50, 0, 1, 0, sc2::Race::Terran, { A::Light, A::Biological }, "Marine", 0.375F, 45, 0, false },
+		{ T::TERRAN_MARAUDER, 100, 25, 2, 0, sc2::Race::Terran, { A::Armored, A::Biological }, "Marauder", 0.5625F, 125, 0, false },
+		{ T::TERRAN_SIEGETANK, 150, 125, 3, 0, sc2::Race::Terran, { A::Armored, A::Mechanical }, "SiegeTank", 0.875F, 175, 0, false },
+		{ T::TERRAN_SIEGETANKSIEGED, 150, 125, 3, 0, sc2::Race::Terran, { A::Armored, A::Mechanical }, "SiegeTankSieged", 0.875F, 175, 0, false },
+		{ T::TERRAN_THOR, 300, 200, 6, 0, sc2::Race::Terran, { A::Armored, A::Mechanical, A::Massive }, "Thor", 1.25F, 400, 0, false },
+		{ T::TERRAN_MEDIVAC, 100, 100, 2, 0, sc2::Race::Terran, { A::Armored, A::Mechanical }, "Medivac", 0.75F, 150, 0, true },
+		{ T::ZERG_ZERGLING, 25, 0, 0.5F, 0, sc2::Race::Zerg, { A::Light, A::Biological }, "Zergling", 0.375F, 35, 0, false },
+		{ T::ZERG_ROACH, 75, 25, 2, 0, sc2::Race::Zerg, { A::Armored, A::Biological }, "Roach", 0.625F, 145, 0, false },
+		{ T::ZERG_HYDRALISK, 100, 50, 2, 0, sc2::Race::Zerg, { A::Light, A::Biological }, "Hydralisk", 0.625F, 90, 0, false },
+		{ T::NEUTRAL_MINERALFIELD, 0, 0, 0, 0, sc2::Race::Random, { A::Structure }, "MineralField", 1.125F, 0, 0, false },
+	};
+	return table;
+}
+
+const TypeInfo* findType(sc2::UNIT_TYPEID type_) {
+	for (auto& t : typeTable()) {
+		if (t.type == type_)
+			return &t;
+	}
+	return nullptr;
+}
+
+std::vector<sc2::ABILITY_ID> availableAbilities(sc2::UNIT_TYPEID type_) {
+	// what GetAbilitiesForUnit() would report for one of our units with full energy and resources
+	using AB = sc2::ABILITY_ID;
+	switch (type_) {
+	case sc2::UNIT_TYPEID::PROTOSS_NEXUS:
+		return { AB::TRAIN_PROBE, AB::EFFECT_CHRONOBOOSTENERGYCOST };
+	case sc2::UNIT_TYPEID::PROTOSS_PROBE:
+		return { AB::ATTACK, AB::GENERAL_MOVE, AB::STOP, AB::HARVEST_GATHER, AB::BUILD_PYLON, AB::BUILD_GATEWAY, AB::BUILD_NEXUS, AB::BUILD_ASSIMILATOR };
+	case sc2::UNIT_TYPEID::PROTOSS_STALKER:
+		return { AB::ATTACK, AB::GENERAL_MOVE, AB::STOP, AB::EFFECT_BLINK };
+	case sc2::UNIT_TYPEID::PROTOSS_SENTRY:
+		return { AB::ATTACK, AB::GENERAL_MOVE, AB::STOP, AB::EFFECT_FORCEFIELD, AB::EFFECT_GUARDIANSHIELD };
+	case sc2::UNIT_TYPEID::PROTOSS_PHOENIX:
+		return { AB::ATTACK, AB::GENERAL_MOVE, AB::STOP, AB::EFFECT_GRAVITONBEAM };
+	default:
+		return { sc2::ABILITY_ID::ATTACK, sc2::ABILITY_ID::GENERAL_MOVE, sc2::ABILITY_ID::STOP };
+	}
+}
+
+}
+
+ScenarioGenerator::ScenarioGenerator(const Scenario& scenario_) : scenario(scenario_), rng(scenario_.seed) {
+	// lay out the base and both armies, units only move around the spot they are placed at
+	next_tag = 4300000000ULL;
+	start_location = sc2::Point3D(33.5F, 158.5F, 10.0F);
+
+	base_units.push_back(makeUnit(sc2::UNIT_TYPEID::PROTOSS_NEXUS, sc2::Unit::Alliance::Self, start_location));
+	for (int i = 0; i < 8; ++i) {
+		sc2::Point2D patch(start_location.x - 7.5F + (i % 2), start_location.y - 5.0F + i * 1.4F);
+		base_units.push_back(makeUnit(sc2::UNIT_TYPEID::NEUTRAL_MINERALFIELD, sc2::Unit::Alliance::Neutral, patch));
+	}
+	for (int i = 0; i < 12; ++i) {
+		sc2::Point2D spot(start_location.x - 3.5F, start_location.y - 3.0F + i * 0.5F);
+		base_units.push_back(makeUnit(sc2::UNIT_TYPEID::PROTOSS_PROBE, sc2::Unit::Alliance::Self, spot));
+	}
+
+	addUnits(scenario.own_units, scenario.own_composition, sc2::Unit::Alliance::Self, scenario.own_center, scenario.spread, own_army);
+	addUnits(scenario.enemy_units, scenario.enemy_composition, sc2::Unit::Alliance::Enemy, scenario.enemy_center, scenario.spread, enemy_army);
+}
+
+Scenario ScenarioGenerator::defaultScenario(int units_per_side_) {
+	// a mixed protoss army engaged with a mech heavy terran army in the middle of the map
+	Scenario s;
+	s.own_units = units_per_side_;
+	s.enemy_units = units_per_side_;
+	s.own_composition = { { sc2::UNIT_TYPEID::PROTOSS_STALKER, 4 }, { sc2::UNIT_TYPEID::PROTOSS_ZEALOT, 3 },
+		{ sc2::UNIT_TYPEID::PROTOSS_IMMORTAL, 2 }, { sc2::UNIT_TYPEID::PROTOSS_PHOENIX, 2 }, { sc2::UNIT_TYPEID::PROTOSS_SENTRY, 1 } };
+	s.enemy_composition = { { sc2::UNIT_TYPEID::TERRAN_MARINE, 6 }, { sc2::UNIT_TYPEID::TERRAN_MARAUDER, 3 },
+		{ sc2::UNIT_TYPEID::TERRAN_SIEGETANKSIEGED, 2 }, { sc2::UNIT_TYPEID::TERRAN_SIEGETANK, 1 }, { sc2::UNIT_TYPEID::TERRAN_THOR, 1 } };
+	s.own_center = sc2::Point2D(90.0F, 96.0F);
+	s.enemy_center = sc2::Point2D(102.0F, 96.0F);
+	s.spread = 6.0F + std::sqrt((float)units_per_side_);	// larger armies cover more ground
+	s.drift = 1.5F;
+	s.warmup_steps = 20;
+	s.measure_steps = 200;
+	s.seed = 1;
+	return s;
+}
+
+int ScenarioGenerator::getFirstMeasuredLoop() {
+	return scenario.warmup_steps;
+}
+
+void ScenarioGenerator::addUnits(int count_, const std::vector<std::pair<sc2::UNIT_TYPEID, int>>& composition_, sc2::Unit::Alliance alliance_,
+	sc2::Point2D center_, float spread_, std::vector<SyntheticUnit>& units_) {
+	// split count_ between the types by weight, scattered uniformly over a circle of radius spread_
+	int total_weight = 0;
+	for (auto& c : composition_) {
+		total_weight += c.second;
+	}
+	if (total_weight <= 0)
+		return;
+
+	std::uniform_real_distribution<float> unit_interval(0.0F, 1.0F);
+	for (int i = 0; i < count_; ++i) {
+		// cycle through the weights, so small armies keep roughly the same mix as large ones
+		int slot = i % total_weight;
+		sc2::UNIT_TYPEID type = composition_.front().first;
+		for (auto& c : composition_) {
+			if (slot < c.second) {
+				type = c.first;
+				break;
+			}
+			slot -= c.second;
+		}
+		float angle = unit_interval(rng) * 6.2831853F;
+		float dist = std::sqrt(unit_interval(rng)) * spread_;
+		sc2::Point2D home(center_.x + dist * std::cos(angle), center_.y + dist * std::sin(angle));
+		units_.push_back(makeUnit(type, alliance_, home));
+	}
+}
+
+ScenarioGenerator::SyntheticUnit ScenarioGenerator::makeUnit(sc2::UNIT_TYPEID type_, sc2::Unit::Alliance alliance_, sc2::Point2D home_) {
+	SyntheticUnit u;
+	u.tag = next_tag++;
+	u.type = type_;
+	u.alliance = alliance_;
+	u.home = home_;
+	u.phase = std::uniform_real_distribution<float>(0.0F, 6.2831853F)(rng);
+	u.radius = 0.5F;
+	u.health = 100.0F;
+	u.shield = 0.0F;
+	u.is_flying = false;
+	u.is_structure = false;
+	const TypeInfo* info = findType(type_);
+	if (info) {
+		u.radius = info->radius;
+		u.health = info->health;
+		u.shield = info->shield;
+		u.is_flying = info->is_flying;
+		u.is_structure = std::find(info->attributes.begin(), info->attributes.end(), sc2::Attribute::Structure) != info->attributes.end();
+	}
+	return u;
+}
+
+void ScenarioGenerator::write(std::ostream& out) {
+	out.precision(9);
+	writeHeader(out);
+	for (int loop = 0; loop < scenario.warmup_steps + scenario.measure_steps; ++loop) {
+		writeStep(out, loop);
+	}
+	out << "RESULT 1 " << (int)sc2::GameResult::Win << "\n";
+}
+
+void ScenarioGenerator::writeHeader(std::ostream& out) {
+	out << "SC2REC 1\n";
+	out << "MAP CactusValleyLE (synthetic)\n";
+	out << "INFO 1 " << SCENARIO_MAP_SIZE << " " << SCENARIO_MAP_SIZE << " "
+		<< SCENARIO_PLAYABLE_MIN << " " << SCENARIO_PLAYABLE_MIN << " " << SCENARIO_PLAYABLE_MAX << " " << SCENARIO_PLAYABLE_MAX << " "
+		<< start_location.x << " " << start_location.y << " " << start_location.z << "\n";
+	out << "START 158.5 158.5\n";
+	out << "START 158.5 33.5\n";
+	out << "START 33.5 33.5\n";
+
+	// pathable and placable everywhere inside the playable area, run-length encoded row by row as <value> <count>
+	std::string grid;
+	int run_value = 0;
+	int run_length = 0;
+	for (int y = 0; y < SCENARIO_MAP_SIZE; ++y) {
+		for (int x = 0; x < SCENARIO_MAP_SIZE; ++x) {
+			int v = x >= SCENARIO_PLAYABLE_MIN && x < SCENARIO_PLAYABLE_MAX && y >= SCENARIO_PLAYABLE_MIN && y < SCENARIO_PLAYABLE_MAX;
+			if (v == run_value) {
+				run_length++;
+				continue;
+			}
+			if (run_length > 0) {
+				grid += " " + std::to_string(run_value) + " " + std::to_string(run_length);
+			}
+			run_value = v;
+			run_length = 1;
+		}
+	}
+	grid += " " + std::to_string(run_value) + " " + std::to_string(run_length);
+	out << "PATHING" << grid << "\n";
+	out << "PLACEMENT" << grid << "\n";
+
+	for (auto& t : typeTable()) {
+		out << "UNITTYPE " << (int)t.type << " " << t.mineral_cost << " " << t.vespene_cost << " "
+			<< t.food_required << " " << t.food_provided << " " << (int)t.race << " " << t.attributes.size();
+		for (auto a : t.attributes) {
+			out << " " << (int)a;
+		}
+		out << " " << t.name << "\n";
+	}
+
+	// footprints of the structures the bot builds early, used to answer placement queries
+	std::vector<std::pair<sc2::ABILITY_ID, float>> footprints = { { sc2::ABILITY_ID::BUILD_PYLON, 1.0F },
+		{ sc2::ABILITY_ID::BUILD_GATEWAY, 1.5F }, { sc2::ABILITY_ID::BUILD_NEXUS, 2.5F }, { sc2::ABILITY_ID::BUILD_ASSIMILATOR, 1.5F },
+		{ sc2::ABILITY_ID::BUILD_FORGE, 1.5F }, { sc2::ABILITY_ID::BUILD_CYBERNETICSCORE, 1.5F }, { sc2::ABILITY_ID::BUILD_PHOTONCANNON, 1.0F },
+		{ sc2::ABILITY_ID::BUILD_SHIELDBATTERY, 1.0F }, { sc2::ABILITY_ID::BUILD_TWILIGHTCOUNCIL, 1.5F },
+		{ sc2::ABILITY_ID::BUILD_ROBOTICSFACILITY, 1.5F }, { sc2::ABILITY_ID::BUILD_STARGATE, 1.5F } };
+	for (auto& f : footprints) {
+		out << "ABILITY " << (int)f.first << " 1 " << f.second << "\n";
+	}
+}
+
+void ScenarioGenerator::writeStep(std::ostream& out, int game_loop_) {
+	bool armies_present = game_loop_ >= scenario.warmup_steps;
+	int food_workers = 12;
+	int food_army = armies_present ? scenario.own_units * 2 : 0;
+
+	out << "STEP " << game_loop_ << " 1000 500 200 " << food_workers + food_army << " " << food_army << " " << food_workers << "\n";
+	out << "UPGRADES 1 " << (int)sc2::UPGRADE_ID::BLINKTECH << "\n";
+	out << "VIS " << (int)sc2::Visibility::Visible << " " << SCENARIO_MAP_SIZE * SCENARIO_MAP_SIZE << "\n";
+
+	for (auto& u : base_units) {
+		writeUnit(out, u, game_loop_);
+	}
+	if (armies_present) {
+		for (auto& u : own_army) {
+			writeUnit(out, u, game_loop_);
+		}
+		for (auto& u : enemy_army) {
+			writeUnit(out, u, game_loop_);
+		}
+	}
+
+	for (auto& u : base_units) {
+		writeAbilities(out, u);
+	}
+	if (armies_present) {
+		for (auto& u : own_army) {
+			writeAbilities(out, u);
+		}
+	}
+
+	// both armies arrive in the same step, the way a large engagement starts
+	if (game_loop_ == scenario.warmup_steps) {
+		for (auto& u : own_army) {
+			out << "EVENT CREATED " << u.tag << " 0 0\n";
+		}
+		for (auto& u : enemy_army) {
+			out << "EVENT VISION " << u.tag << " 0 0\n";
+		}
+	}
+	out << "END\n";
+}
+
+void ScenarioGenerator::writeUnit(std::ostream& out, const SyntheticUnit& u, int game_loop_) {
+	// same field order as ObservationRecorder::writeUnit
+	bool moves = !u.is_structure;
+	float angle = u.phase + game_loop_ * (6.2831853F / 64.0F);
+	sc2::Point2D pos = u.home;
+	if (moves) {
+		pos.x += scenario.drift * std::cos(angle);
+		pos.y += scenario.drift * std::sin(angle);
+	}
+	pos.x = std::min(std::max(pos.x, SCENARIO_PLAYABLE_MIN + 1.0F), SCENARIO_PLAYABLE_MAX - 1.0F);
+	pos.y = std::min(std::max(pos.y, SCENARIO_PLAYABLE_MIN + 1.0F), SCENARIO_PLAYABLE_MAX - 1.0F);
+
+	int owner = 16;
+	if (u.alliance == sc2::Unit::Alliance::Self)
+		owner = 1;
+	if (u.alliance == sc2::Unit::Alliance::Enemy)
+		owner = 2;
+	float weapon_cooldown = moves ? std::fmod(u.phase * 10.0F + game_loop_, 22.0F) : 0.0F;
+	float energy = u.type == sc2::UNIT_TYPEID::PROTOSS_SENTRY || u.type == sc2::UNIT_TYPEID::PROTOSS_NEXUS ? 100.0F : 0.0F;
+	int minerals = u.type == sc2::UNIT_TYPEID::NEUTRAL_MINERALFIELD ? 1800 : 0;
+
+	out << "UNIT " << u.tag << " " << (int)u.type << " " << (int)u.alliance << " " << (int)sc2::Unit::DisplayType::Visible << " "
+		<< owner << " " << pos.x << " " << pos.y << " 10 " << angle << " " << u.radius << " "
+		<< "1 " << u.health << " " << u.health << " " << u.shield << " " << u.shield << " "
+		<< energy << " 200 " << u.is_flying << " 0 1 "
+		<< weapon_cooldown << " " << game_loop_ << " " << minerals << " 0 "
+		<< "0 0 " << (int)sc2::Unit::CloakState::NotCloaked << " 1 "
+		<< "0 0 0 0\n";
+}
+
+void ScenarioGenerator::writeAbilities(std::ostream& out, const SyntheticUnit& u) {
+	if (u.alliance != sc2::Unit::Alliance::Self)
+		return;
+	std::vector<sc2::ABILITY_ID> abilities = availableAbilities(u.type);
+	out << "ABILITIES " << u.tag << " " << abilities.size();
+	for (auto a : abilities) {
+		out << " " << (int)a;
+	}
+	out << "\n";
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <ostream>
+#include <random>
+#include <utility>
+#include <vector>
+#include "sc2api/sc2_api.h"
+
+# define SCENARIO_MAP_SIZE 192 // the synthetic map is square and fully pathable inside its playable area
+# define SCENARIO_PLAYABLE_MIN 16.0F
+# define SCENARIO_PLAYABLE_MAX 176.0F
+
+struct Scenario {
+	int own_units;		// army units on each side, split between the types of the composition by weight
+	int enemy_units;
+	std::vector<std::pair<sc2::UNIT_TYPEID, int>> own_composition;
+	std::vector<std::pair<sc2::UNIT_TYPEID, int>> enemy_composition;
+	sc2::Point2D own_center;
+	sc2::Point2D enemy_center;
+	float spread;		// radius each army is scattered over around its center
+	float drift;		// radius of the small circle each unit moves around, one lap every 64 steps
+	int warmup_steps;	// steps before the armies appear, which covers the bot's loading
+	int measure_steps;	// steps with both armies present
+	unsigned seed;
+};
+
+class ScenarioGenerator {
+// Writes a synthetic game in the text format of ObservationRecorder, so it can be driven through
+// the bot by ReplayDriver. The game is on a blank copy of Cactus Valley: our nexus, workers and
+// minerals at the top left start location, and after warmup_steps both armies appear at once
+public:
+	ScenarioGenerator(const Scenario& scenario_);
+	static Scenario defaultScenario(int units_per_side_);
+	void write(std::ostream& out);
+	int getFirstMeasuredLoop();
+
+private:
+	struct SyntheticUnit {
+		sc2::Tag tag;
+		sc2::UNIT_TYPEID type;
+		sc2::Unit::Alliance alliance;
+		sc2::Point2D home;
+		float phase;
+		float radius;
+		float health;
+		float shield;
+		bool is_flying;
+		bool is_structure;	// structures and minerals stay where they are
+	};
+
+	void addUnits(int count_, const std::vector<std::pair<sc2::UNIT_TYPEID, int>>& composition_, sc2::Unit::Alliance alliance_,
+		sc2::Point2D center_, float spread_, std::vector<SyntheticUnit>& units_);
+	SyntheticUnit makeUnit(sc2::UNIT_TYPEID type_, sc2::Unit::Alliance alliance_, sc2::Point2D home_);
+	void writeHeader(std::ostream& out);
+	void writeStep(std::ostream& out, int game_loop_);
+	void writeUnit(std::ostream& out, const SyntheticUnit& u, int game_loop_);
+	void writeAbilities(std::ostream& out, const SyntheticUnit& u);
+
+	Scenario scenario;
+	sc2::Point3D start_location;
+	std::vector<SyntheticUnit> base_units;	// present from the first step
+	std::vector<SyntheticUnit> own_army;	// appear after warmup_steps
+	std::vector<SyntheticUnit> enemy_army;
+	sc2::Tag next_tag;
+	std::mt19937 rng;
+};
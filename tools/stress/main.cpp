@@ -0,0 +1,108 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BasicSc2Bot.h"
+#include "ReplayDriver.h"
+#include "ScenarioGenerator.h"
+
+# define STRESS_CSV "stress_scaling.csv" // scaling curve, one row per army size
+
+// OnStep phases timed by the tracer, in the order they run
+static const char* phases[] = { "OnStep::scanChunks", "OnStep::enemyThreat", "OnStep::busyMobs", "OnStep::idleMobs",
+	"OnStep::precepts", "OnStep::preceptsObserve", "OnStep::structures", "OnStep::checkSiegeTanks", "OnStep::highestThreat", "OnStep::bookkeeping", "OnStep::flushActions", "OnStep" };
+
+// Drives the bot through synthetic engagements of increasing size and reports how long each
+// OnStep phase takes per step, so that phases which grow faster than linearly stand out
+// usage: StressTest [--steps n] [--spread r] [--separation d] [units_per_side ...]
+int main(int argc, char* argv[]) {
+	std::vector<int> sizes;
+	int steps = -1;
+	float spread = -1.0F;
+	float separation = -1.0F;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+			steps = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--spread") == 0 && i + 1 < argc) {
+			spread = (float)std::atof(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--separation") == 0 && i + 1 < argc) {
+			separation = (float)std::atof(argv[++i]);
+		}
+		else if (std::atoi(argv[i]) > 0) {
+			sizes.push_back(std::atoi(argv[i]));
+		}
+		else {
+			std::cout << "usage: " << argv[0] << " [--steps n] [--spread r] [--separation d] [units_per_side ...]" << std::endl;
+			return 1;
+		}
+	}
+	if (sizes.empty()) {
+		sizes = { 10, 25, 50, 100, 200, 400 };
+	}
+
+	std::ofstream csv(STRESS_CSV);
+	csv << "units_per_side";
+	for (auto p : phases) {
+		csv << "," << p << "_us";
+	}
+	csv << std::endl;
+
+	std::cout << std::setw(8) << "units";
+	for (auto p : phases) {
+		std::string name = p;
+		std::cout << std::setw(16) << name.substr(name.rfind(':') + 1);
+	}
+	std::cout << "   (us per step)" << std::endl;
+
+	for (int size : sizes) {
+		Scenario scenario = ScenarioGenerator::defaultScenario(size);
+		if (steps > 0) {
+			scenario.measure_steps = steps;
+		}
+		if (spread >= 0.0F) {
+			scenario.spread = spread;
+		}
+		if (separation >= 0.0F) {
+			sc2::Point2D middle = (scenario.own_center + scenario.enemy_center) / 2.0F;
+			scenario.own_center = sc2::Point2D(middle.x - separation / 2.0F, middle.y);
+			scenario.enemy_center = sc2::Point2D(middle.x + separation / 2.0F, middle.y);
+		}
+
+		ScenarioGenerator generator(scenario);
+		std::stringstream recording;
+		generator.write(recording);
+
+		// every size needs a bot with fresh game state. Tracers are told apart by serial rather than
+		// by address, so the tracer of this bot never picks up the buffer cached for the last one
+		ReplayDriver driver(recording, "scenario with " + std::to_string(size) + " units per side");
+		BasicSc2Bot* bot = new BasicSc2Bot();
+		bot->tracer->setEnabled(true);
+		if (!driver.run(bot)) {
+			delete bot;
+			return 1;
+		}
+
+		std::map<std::string, long long> totals;
+		bot->tracer->sumSpans(totals, generator.getFirstMeasuredLoop());
+		delete bot;
+
+		std::cout << std::setw(8) << size;
+		csv << size;
+		for (auto p : phases) {
+			double per_step = (double)totals[p] / scenario.measure_steps;
+			std::cout << std::setw(16) << std::fixed << std::setprecision(1) << per_step;
+			csv << "," << per_step;
+		}
+		std::cout << std::endl;
+		csv << std::endl;
+	}
+	std::cout << "Scaling curve written to " << STRESS_CSV << std::endl;
+	return 0;
+}